@@ -74,7 +74,7 @@ void cprop_functor::lpm_compare_eq_(Design*, NetCompare*)
 {
 }
 
-void cprop_functor::lpm_ff(Design*, NetFF*obj)
+void cprop_functor::lpm_ff(Design*des, NetFF*obj)
 {
 	// Look for and count unlinked FF outputs. Note that if the
 	// Data and Q pins are connected together, they can be removed
@@ -85,6 +85,7 @@ void cprop_functor::lpm_ff(Design*, NetFF*obj)
 	  && (! obj->pin_Sset().is_linked())
 	  && (! obj->pin_Aclr().is_linked())
 	  && (! obj->pin_Aset().is_linked())) {
+	    des->functor_queue_neighbors(obj);
 	    obj->pin_Data().unlink();
 	    obj->pin_Q().unlink();
 	    delete obj;
@@ -140,6 +141,9 @@ void cprop_functor::lpm_mux(Design*des, NetMux*obj)
       tmp->fall_time(obj->fall_time());
       tmp->decay_time(obj->decay_time());
 
+	// The nodes around the MUX may be able to use the change.
+      des->functor_queue_neighbors(obj);
+
       connect(tmp->pin(0), obj->pin_Result());
       if (sel_val == verinum::V1)
 	    connect(tmp->pin(1), obj->pin_Data(1));
@@ -249,17 +253,16 @@ void cprop_dc_functor::lpm_const(Design*, NetConst*obj)
 
 void cprop(Design*des)
 {
-	// Continually propagate constants until a scan finds nothing
-	// to do.
+	// Propagate constants until there is nothing left to do. The
+	// first pass scans the whole design, and after that only the
+	// neighbors of the nodes that were changed are revisited.
       cprop_functor prop;
-      do {
-	    prop.count = 0;
-	    des->functor(&prop);
-	    if (verbose_flag) {
-		  cout << " ... Iteration detected "
-		       << prop.count << " optimizations." << endl << flush;
-	    }
-      } while (prop.count > 0);
+      prop.count = 0;
+      des->functor_worklist(&prop);
+      if (verbose_flag) {
+	    cout << " ... Detected "
+		 << prop.count << " optimizations." << endl << flush;
+      }
 
       if (verbose_flag) {
 	    cout << " ... Look for dangling constants" << endl << flush;
@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2011 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA
+ */
+
+# include "config.h"
+
+/*
+ * This functor merges structurally identical nodes. Two nodes are
+ * identical if they are the same kind of node with the same
+ * parameters, and each of their input pins is connected to the same
+ * Nexus. The duplicate is removed and its outputs are connected to
+ * the outputs of the node that is kept.
+ *
+ * Connecting the outputs joins the nets that they drive, so a node
+ * is only merged if it is the sole driver of its outputs and those
+ * outputs are plain nets that are not assigned or forced, not inout
+ * ports and not part of a switch island.
+ *
+ * The nodes are hashed by a key made of the node kind, the node
+ * parameters and the input Nexus pointers. A merge may change the
+ * input Nexus of the nodes downstream, so those nodes are taken out
+ * of the table and queued on the Design functor worklist to be
+ * hashed again.
+ */
+# include  "functor.h"
+# include  "netlist.h"
+# include  "compiler.h"
+# include  <map>
+# include  <vector>
+
+struct cse_key_s {
+      unsigned kind;
+      vector<unsigned> parms;
+      vector<const Nexus*> inputs;
+
+      bool operator < (const cse_key_s&that) const
+      {
+	    if (kind != that.kind)
+		  return kind < that.kind;
+	    if (parms != that.parms)
+		  return parms < that.parms;
+	    return inputs < that.inputs;
+      }
+};
+
+enum cse_kind_t { CSE_LOGIC, CSE_COMPARE, CSE_PART_SELECT, CSE_CONCAT };
+
+struct cse_functor  : public functor_t {
+
+      unsigned count;
+
+      virtual void lpm_compare(Design*des, NetCompare*obj);
+      virtual void lpm_concat(Design*des, NetConcat*obj);
+      virtual void lpm_logic(Design*des, NetLogic*obj);
+      virtual void lpm_part_select(Design*des, NetPartSelect*obj);
+
+    private:
+      typedef map<cse_key_s,NetNode*> table_t;
+      table_t table_;
+	// Remember where each node is in the table, so that it can be
+	// removed when it is hashed again or deleted.
+      map<NetNode*,table_t::iterator> where_;
+
+      void hash_(Design*des, NetNode*obj, cse_key_s&key,
+		 unsigned out_base, unsigned out_count);
+      void forget_(NetNode*obj);
+      void requeue_(Design*des, Nexus*nex, const NetNode*skip);
+};
+
+/*
+ * Return true if the nexus can be joined with another nexus that
+ * carries the same value. The driver must be the only driver, and the
+ * other links must be inputs or simple nets.
+ */
+static bool output_is_mergeable(Nexus*nex, const NetNode*driver)
+{
+      if (nex->assign_lval())
+	    return false;
+
+      for (Link*cur = nex->first_nlink() ;  cur ;  cur = cur->next_nlink()) {
+	    switch (cur->get_dir()) {
+		case Link::INPUT:
+		  continue;
+		case Link::OUTPUT:
+		  if (cur->get_obj() != driver)
+			return false;
+		  continue;
+		case Link::PASSIVE:
+		  break;
+	    }
+
+	    const NetNet*sig = dynamic_cast<const NetNet*>(cur->get_obj());
+	    if (sig == 0)
+		  return false;
+
+	    switch (sig->type()) {
+		case NetNet::IMPLICIT:
+		case NetNet::WIRE:
+		case NetNet::TRI:
+		  break;
+		default:
+		  return false;
+	    }
+
+	    if (sig->port_type() == NetNet::PINOUT)
+		  return false;
+      }
+
+      return true;
+}
+
+/*
+ * Nodes with delays or attributes are left alone.
+ */
+static bool node_is_plain(const NetNode*obj)
+{
+      if (obj->rise_time() || obj->fall_time() || obj->decay_time())
+	    return false;
+      if (obj->attr_cnt() > 0)
+	    return false;
+
+      return true;
+}
+
+void cse_functor::requeue_(Design*des, Nexus*nex, const NetNode*skip)
+{
+      for (Link*cur = nex->first_nlink() ;  cur ;  cur = cur->next_nlink()) {
+	    NetNode*node = dynamic_cast<NetNode*>(cur->get_obj());
+	    if (node == 0 || node == skip)
+		  continue;
+
+	    forget_(node);
+	    des->functor_queue(node);
+      }
+}
+
+void cse_functor::forget_(NetNode*obj)
+{
+      map<NetNode*,table_t::iterator>::iterator cur = where_.find(obj);
+      if (cur == where_.end())
+	    return;
+
+      table_.erase(cur->second);
+      where_.erase(cur);
+}
+
+/*
+ * The caller fills in the key for the node, and the range of output
+ * pins. The input pins are all the other pins of the node, and are
+ * added to the key here.
+ */
+void cse_functor::hash_(Design*des, NetNode*obj, cse_key_s&key,
+			unsigned out_base, unsigned out_count)
+{
+	// The node may have been hashed before its inputs changed.
+      forget_(obj);
+
+      if (! node_is_plain(obj))
+	    return;
+
+      for (unsigned idx = 0 ;  idx < obj->pin_count() ;  idx += 1) {
+	    if (idx >= out_base && idx < out_base+out_count)
+		  continue;
+	    if (! obj->pin(idx).is_linked())
+		  return;
+	    key.inputs.push_back(obj->pin(idx).nexus());
+      }
+
+      for (unsigned idx = 0 ;  idx < out_count ;  idx += 1) {
+	    Link&pin = obj->pin(out_base+idx);
+	    if (pin.is_linked() && ! output_is_mergeable(pin.nexus(), obj))
+		  return;
+      }
+
+      table_t::iterator cur = table_.find(key);
+      if (cur == table_.end()) {
+	    where_[obj] = table_.insert(make_pair(key, obj)).first;
+	    return;
+      }
+
+      NetNode*keep = cur->second;
+      assert(keep != obj);
+
+	// The drive strengths of the outputs must match, and the
+	// outputs of the kept node must still be mergeable.
+      for (unsigned idx = 0 ;  idx < out_count ;  idx += 1) {
+	    Link&opin = obj->pin(out_base+idx);
+	    Link&kpin = keep->pin(out_base+idx);
+	    if (opin.drive0() != kpin.drive0())
+		  return;
+	    if (opin.drive1() != kpin.drive1())
+		  return;
+	    if (kpin.is_linked() && ! output_is_mergeable(kpin.nexus(), keep))
+		  return;
+      }
+
+      if (debug_optimizer)
+	    cerr << obj->get_fileline() << ": debug: "
+		 << "Merge " << obj->name() << " into identical node "
+		 << keep->name() << "." << endl;
+
+	// Connecting the outputs may delete or replace their Nexus
+	// objects, so first take all the nodes attached to them out
+	// of the table. They are queued to be hashed again with the
+	// merged Nexus.
+      for (unsigned idx = 0 ;  idx < out_count ;  idx += 1) {
+	    Link&opin = obj->pin(out_base+idx);
+	    if (! opin.is_linked())
+		  continue;
+	    Link&kpin = keep->pin(out_base+idx);
+	    requeue_(des, opin.nexus(), obj);
+	    if (kpin.is_linked())
+		  requeue_(des, kpin.nexus(), obj);
+	    connect(kpin, opin);
+      }
+
+      delete obj;
+      count += 1;
+}
+
+void cse_functor::lpm_compare(Design*des, NetCompare*obj)
+{
+      cse_key_s key;
+      key.kind = CSE_COMPARE;
+      key.parms.push_back(obj->width());
+      key.parms.push_back(obj->get_signed());
+	// Pins 0-5 are the outputs, pins 6-7 are DataA and DataB.
+      hash_(des, obj, key, 0, 6);
+}
+
+void cse_functor::lpm_concat(Design*des, NetConcat*obj)
+{
+      cse_key_s key;
+      key.kind = CSE_CONCAT;
+      key.parms.push_back(obj->width());
+      key.parms.push_back(obj->pin_count());
+      hash_(des, obj, key, 0, 1);
+}
+
+void cse_functor::lpm_logic(Design*des, NetLogic*obj)
+{
+      switch (obj->type()) {
+	  case NetLogic::AND:
+	  case NetLogic::BUF:
+	  case NetLogic::NAND:
+	  case NetLogic::NOR:
+	  case NetLogic::NOT:
+	  case NetLogic::OR:
+	  case NetLogic::XNOR:
+	  case NetLogic::XOR:
+	    break;
+	  default:
+	    return;
+      }
+
+      cse_key_s key;
+      key.kind = CSE_LOGIC;
+      key.parms.push_back(obj->type());
+      key.parms.push_back(obj->width());
+      key.parms.push_back(obj->pin_count());
+      hash_(des, obj, key, 0, 1);
+}
+
+void cse_functor::lpm_part_select(Design*des, NetPartSelect*obj)
+{
+	// Only the vector to part form has a single output that is
+	// fully driven by the node.
+      if (obj->dir() != NetPartSelect::VP)
+	    return;
+
+      cse_key_s key;
+      key.kind = CSE_PART_SELECT;
+      key.parms.push_back(obj->base());
+      key.parms.push_back(obj->width());
+      key.parms.push_back(obj->signed_flag());
+      key.parms.push_back(obj->pin_count());
+      hash_(des, obj, key, 0, 1);
+}
+
+void cse(Design*des)
+{
+      cse_functor fun;
+      fun.count = 0;
+      des->functor_worklist(&fun);
+
+      if (verbose_flag) {
+	    cout << " ... Merged " << fun.count
+		 << " duplicate nodes." << endl << flush;
+      }
+}
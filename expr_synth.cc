@@ -22,6 +22,7 @@
 
 # include  <cstdlib>
 # include  <iostream>
+# include  <map>
 
 # include  "netlist.h"
 # include  "netmisc.h"
@@ -1255,6 +1256,13 @@ NetNet* NetETernary::synthesize(Design *des, NetScope*scope, NetExpr*root)
       return osig;
 }
 
+/*
+ * While the body of a simple function is synthesized in line (see
+ * NetEUFunc::synthesize below) this maps the ports of the function
+ * to the nets of the arguments of the call.
+ */
+static std::map<const NetNet*,NetNet*> inline_func_ports;
+
 /*
  * When synthesizing a signal expression, it is usually fine to simply
  * return the NetNet that it refers to. If this is an array word though,
@@ -1263,8 +1271,13 @@ NetNet* NetETernary::synthesize(Design *des, NetScope*scope, NetExpr*root)
  */
 NetNet* NetESignal::synthesize(Design*des, NetScope*scope, NetExpr*root)
 {
-      if (word_ == 0)
+      if (word_ == 0) {
+	    std::map<const NetNet*,NetNet*>::const_iterator cur;
+	    cur = inline_func_ports.find(net_);
+	    if (cur != inline_func_ports.end())
+		  return cur->second;
 	    return net_;
+      }
 
       NetNet*tmp = new NetNet(scope, scope->local_symbol(),
 			      NetNet::IMPLICIT, net_->vector_width());
@@ -1384,6 +1397,119 @@ NetNet* NetESFunc::synthesize(Design*des, NetScope*scope, NetExpr*root)
       return osig;
 }
 
+/*
+ * Test that the expression is made only of the operators that
+ * synthesize to combinational nodes, constants and references to the
+ * (whole) ports of the function.
+ */
+static bool func_expr_is_simple(const NetFuncDef*def, const NetExpr*expr)
+{
+      if (expr == 0)
+	    return true;
+      if (expr->expr_type() == IVL_VT_REAL)
+	    return false;
+
+      if (dynamic_cast<const NetEConst*>(expr))
+	    return true;
+
+      if (const NetESignal*sig = dynamic_cast<const NetESignal*>(expr)) {
+	    if (sig->word_index())
+		  return false;
+	    for (unsigned idx = 0 ;  idx < def->port_count() ;  idx += 1) {
+		  if (sig->sig() == def->port(idx))
+			return true;
+	    }
+	    return false;
+      }
+
+      if (dynamic_cast<const NetEBAdd*>(expr)
+	  || dynamic_cast<const NetEBBits*>(expr)
+	  || dynamic_cast<const NetEBComp*>(expr)
+	  || dynamic_cast<const NetEBLogic*>(expr)
+	  || dynamic_cast<const NetEBShift*>(expr)) {
+	    const NetEBinary*bin = dynamic_cast<const NetEBinary*>(expr);
+	    return func_expr_is_simple(def, bin->left())
+		  && func_expr_is_simple(def, bin->right());
+      }
+
+      if (const NetEUnary*una = dynamic_cast<const NetEUnary*>(expr)) {
+	    if (! dynamic_cast<const NetEUBits*>(expr)
+		&& ! dynamic_cast<const NetEUReduce*>(expr)
+		&& una->op() != '+' && una->op() != '-' && una->op() != 'm')
+		  return false;
+	    return func_expr_is_simple(def, una->expr());
+      }
+
+      if (const NetETernary*tern = dynamic_cast<const NetETernary*>(expr)) {
+	    return func_expr_is_simple(def, tern->cond_expr())
+		  && func_expr_is_simple(def, tern->true_expr())
+		  && func_expr_is_simple(def, tern->false_expr());
+      }
+
+      if (const NetEConcat*cat = dynamic_cast<const NetEConcat*>(expr)) {
+	    for (unsigned idx = 0 ;  idx < cat->nparms() ;  idx += 1) {
+		  if (! func_expr_is_simple(def, cat->parm(idx)))
+			return false;
+	    }
+	    return true;
+      }
+
+      if (const NetESelect*sel = dynamic_cast<const NetESelect*>(expr)) {
+	    return func_expr_is_simple(def, sel->sub_expr())
+		  && func_expr_is_simple(def, sel->select());
+      }
+
+      return false;
+}
+
+/*
+ * A simple function has a body that is a single blocking assignment
+ * of an expression of its ports to its (whole) result, perhaps in a
+ * begin-end block. Such a function has no side effects and no state,
+ * so a call in a continuous assignment can be synthesized in line as
+ * a network of combinational nodes, instead of a .ufunc that runs the
+ * function in a thread for every change of its arguments. Return the
+ * expression, or nil if the function is not simple.
+ */
+static const NetExpr* simple_func_expr(const NetFuncDef*def)
+{
+      const NetProc*proc = def->proc();
+      const NetNet*res = def->return_sig();
+      if (proc == 0 || res == 0)
+	    return 0;
+	// Assignment to a bool variable changes x bits to 0, so only
+	// logic ports and results pass the values unchanged.
+      if (res->data_type() != IVL_VT_LOGIC)
+	    return 0;
+
+      if (const NetBlock*blk = dynamic_cast<const NetBlock*>(proc)) {
+	    if (blk->type() != NetBlock::SEQU)
+		  return 0;
+	    proc = blk->proc_first();
+	    if (proc == 0 || blk->proc_next(proc) != 0)
+		  return 0;
+      }
+
+      const NetAssign*asn = dynamic_cast<const NetAssign*>(proc);
+      if (asn == 0 || asn->l_val_count() != 1)
+	    return 0;
+
+      const NetAssign_*lval = asn->l_val(0);
+      if (lval->sig() != res || lval->word() || lval->get_base()
+	  || lval->lwidth() != res->vector_width() || lval->more)
+	    return 0;
+
+      for (unsigned idx = 0 ;  idx < def->port_count() ;  idx += 1) {
+	    if (def->port(idx)->data_type() != IVL_VT_LOGIC)
+		  return 0;
+      }
+
+      if (! func_expr_is_simple(def, asn->rval()))
+	    return 0;
+
+      return asn->rval();
+}
+
 NetNet* NetEUFunc::synthesize(Design*des, NetScope*scope, NetExpr*root)
 {
       svector<NetNet*> eparms (parms_.count());
@@ -1408,6 +1534,53 @@ NetNet* NetEUFunc::synthesize(Design*des, NetScope*scope, NetExpr*root)
       }
       if (errors) return 0;
 
+      NetFuncDef*def = func_->func_def();
+
+	/* Pad or crop the arguments to the widths of the ports. */
+      for (unsigned idx = 0; idx < eparms.count(); idx += 1) {
+	    unsigned width = def->port(idx)->vector_width();
+	    NetNet*tmp;
+	    if (eparms[idx]->get_signed()) {
+		  tmp = pad_to_width_signed(des, eparms[idx], width, *this);
+	    } else {
+		  tmp = pad_to_width(des, eparms[idx], width, *this);
+	    }
+	    eparms[idx] = crop_to_width(des, tmp, width);
+      }
+
+	/* If the function is simple, then synthesize its expression
+	   with the ports replaced by the arguments. This is not done
+	   for strict continuous assignment evaluation, which must
+	   evaluate the function as a whole. */
+      const NetExpr*simple = gn_strict_ca_eval_flag? 0 : simple_func_expr(def);
+      if (simple && inline_func_ports.empty()) {
+	      /* Each port is replaced by a net with the signedness of
+		 the port, connected to the argument. */
+	    for (unsigned idx = 0; idx < eparms.count(); idx += 1) {
+		  const NetNet*port = def->port(idx);
+		  NetNet*tmp = new NetNet(scope, scope->local_symbol(),
+					  NetNet::WIRE, port->vector_width());
+		  tmp->set_line(*this);
+		  tmp->local_flag(true);
+		  tmp->data_type(port->data_type());
+		  tmp->set_signed(port->get_signed());
+		  connect(tmp->pin(0), eparms[idx]->pin(0));
+		  inline_func_ports[port] = tmp;
+	    }
+
+	    NetNet*tmp = const_cast<NetExpr*>(simple)->synthesize(des, scope, root);
+	    inline_func_ports.clear();
+	    if (tmp == 0)
+		  return 0;
+
+	    unsigned width = result_sig_->vector_width();
+	    if (simple->has_sign())
+		  tmp = pad_to_width_signed(des, tmp, width, *this);
+	    else
+		  tmp = pad_to_width(des, tmp, width, *this);
+	    return crop_to_width(des, tmp, width);
+      }
+
       NetEvWait*trigger = 0;
       if (gn_strict_ca_eval_flag) {
               /* Ideally we would only do this for functions that have hidden
@@ -1431,18 +1604,8 @@ NetNet* NetEUFunc::synthesize(Design*des, NetScope*scope, NetExpr*root)
       connect(net->pin(0), osig->pin(0));
 
         /* Connect the pins to the arguments. */
-      NetFuncDef*def = func_->func_def();
-      for (unsigned idx = 0; idx < eparms.count(); idx += 1) {
-	    unsigned width = def->port(idx)->vector_width();
-	    NetNet*tmp;
-	    if (eparms[idx]->get_signed()) {
-		  tmp = pad_to_width_signed(des, eparms[idx], width, *this);
-	    } else {
-		  tmp = pad_to_width(des, eparms[idx], width, *this);
-	    }
-	    NetNet*tmpc = crop_to_width(des, tmp, width);
-	    connect(net->pin(idx+1), tmpc->pin(0));
-      }
+      for (unsigned idx = 0; idx < eparms.count(); idx += 1)
+	    connect(net->pin(idx+1), eparms[idx]->pin(0));
 
       return osig;
 }
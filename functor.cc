@@ -52,6 +52,10 @@ void functor_t::lpm_compare(class Design*, class NetCompare*)
 {
 }
 
+void functor_t::lpm_concat(class Design*, class NetConcat*)
+{
+}
+
 void functor_t::lpm_const(class Design*, class NetConst*)
 {
 }
@@ -84,6 +88,10 @@ void functor_t::lpm_mux(class Design*, class NetMux*)
 {
 }
 
+void functor_t::lpm_part_select(class Design*, class NetPartSelect*)
+{
+}
+
 void functor_t::lpm_pow(class Design*, class NetPow*)
 {
 }
@@ -165,6 +173,68 @@ void Design::functor(functor_t*fun)
       }
 }
 
+void Design::functor_scopes(functor_t*fun)
+{
+      for (list<NetScope*>::const_iterator scope = root_scopes_.begin();
+	   scope != root_scopes_.end(); ++ scope )
+	    (*scope)->run_functor(this, fun);
+}
+
+void Design::functor_queue(NetNode*net)
+{
+      assert(nodes_work_list_);
+      if (nodes_work_set_.insert(net).second)
+	    nodes_work_list_->push_back(net);
+}
+
+/*
+ * Queue all the nodes that share a nexus with any of the pins of the
+ * object. This must be called while the object is still connected,
+ * i.e. before a functor deletes it.
+ */
+void Design::functor_queue_neighbors(NetPins*obj)
+{
+      if (nodes_work_list_ == 0)
+	    return;
+
+      for (unsigned idx = 0 ;  idx < obj->pin_count() ;  idx += 1) {
+	    Nexus*nex = obj->pin(idx).nexus();
+	    for (Link*cur = nex->first_nlink()
+		       ; cur ;  cur = cur->next_nlink()) {
+		  NetNode*node = dynamic_cast<NetNode*>(cur->get_obj());
+		  if (node == 0 || node == obj)
+			continue;
+		  if (node->design_ != this)
+			continue;
+		  functor_queue(node);
+	    }
+      }
+}
+
+void Design::functor_worklist(functor_t*fun)
+{
+      assert(nodes_work_list_ == 0);
+      list<NetNode*> work;
+      nodes_work_list_ = &work;
+
+	// The first pass covers the whole design.
+      functor(fun);
+
+	// Now only revisit the nodes that were queued. Nodes that
+	// were deleted after they were queued are no longer in the
+	// work set, so they are skipped.
+      while (! work.empty()) {
+	    NetNode*cur = work.front();
+	    work.pop_front();
+	    if (nodes_work_set_.erase(cur) == 0)
+		  continue;
+
+	    cur->functor_node(this, fun);
+      }
+
+      nodes_work_list_ = 0;
+      nodes_work_set_.clear();
+}
 
 void NetNode::functor_node(Design*, functor_t*)
 {
@@ -185,6 +255,11 @@ void NetCompare::functor_node(Design*des, functor_t*fun)
       fun->lpm_compare(des, this);
 }
 
+void NetConcat::functor_node(Design*des, functor_t*fun)
+{
+      fun->lpm_concat(des, this);
+}
+
 void NetConst::functor_node(Design*des, functor_t*fun)
 {
       fun->lpm_const(des, this);
@@ -225,6 +300,11 @@ void NetMux::functor_node(Design*des, functor_t*fun)
       fun->lpm_mux(des, this);
 }
 
+void NetPartSelect::functor_node(Design*des, functor_t*fun)
+{
+      fun->lpm_part_select(des, this);
+}
+
 void NetPow::functor_node(Design*des, functor_t*fun)
 {
       fun->lpm_pow(des, this);
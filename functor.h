@@ -57,6 +57,9 @@ struct functor_t {
 	/* This method is called for each structural comparator. */
       virtual void lpm_compare(class Design*des, class NetCompare*);
 
+	/* This method is called for each structural concatenation. */
+      virtual void lpm_concat(class Design*des, class NetConcat*);
+
 	/* This method is called for each structural constant. */
       virtual void lpm_const(class Design*des, class NetConst*);
 
@@ -81,6 +84,9 @@ struct functor_t {
 	/* This method is called for each MUX. */
       virtual void lpm_mux(class Design*des, class NetMux*);
 
+	/* This method is called for each structural part select. */
+      virtual void lpm_part_select(class Design*des, class NetPartSelect*);
+
 	/* This method is called for each power. */
       virtual void lpm_pow(class Design*des, class NetPow*);
 
@@ -194,6 +194,7 @@ const bool CASE_SENSITIVE = true;
 bool synthesis = false;
 
 extern void cprop(Design*des);
+extern void cse(Design*des);
 extern void synth(Design*des);
 extern void synth2(Design*des);
 extern void syn_rules(Design*des);
@@ -205,6 +206,7 @@ static struct net_func_map {
       void (*func)(Design*);
 } func_table[] = {
       { "cprop",   &cprop },
+      { "cse",     &cse },
       { "nodangle",&nodangle },
       { "synth",   &synth },
       { "synth2",  &synth2 },
@@ -1090,9 +1092,28 @@ int main(int argc, char*argv[])
       while (!net_func_queue.empty()) {
 	    net_func func = net_func_queue.front();
 	    net_func_queue.pop();
-	    if (verbose_flag)
+	    unsigned nodes_before = des->node_count();
+	    struct tms func_cycles[2];
+	    if (verbose_flag) {
 		  cerr<<" -F "<<net_func_to_name(func)<< " ..." <<endl;
+		  if (times_flag)
+			times(func_cycles+0);
+	    }
 	    func(des);
+	    if (verbose_flag) {
+		  unsigned nodes_after = des->node_count();
+		  cerr<<" -F "<<net_func_to_name(func)<< " done, ";
+		  if (nodes_after <= nodes_before)
+			cerr<<(nodes_before-nodes_after)<<" nodes removed";
+		  else
+			cerr<<(nodes_after-nodes_before)<<" nodes added";
+		  if (times_flag) {
+			times(func_cycles+1);
+			cerr<<", "<<cycles_diff(func_cycles+1, func_cycles+0)
+			    <<" seconds";
+		  }
+		  cerr<<"."<<endl;
+	    }
       }
 
       if (verbose_flag) {
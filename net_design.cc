@@ -45,6 +45,9 @@ Design:: Design()
       des_precision_ = 0;
       nodes_functor_cur_ = 0;
       nodes_functor_nxt_ = 0;
+      nodes_count_ = 0;
+      nodes_work_list_ = 0;
+      scope_cache_changes_ = 0;
       des_delay_sel_ = Design::TYP;
 }
 
@@ -175,6 +178,59 @@ NetScope* Design::find_scope(NetScope*scope, const std::list<hname_t>&path,
       if (path.empty())
 	    return scope;
 
+      if (scope_cache_changes_ != NetScope::tree_changes()) {
+	    scope_cache_.clear();
+	    scope_cache_changes_ = NetScope::tree_changes();
+      }
+
+      scope_cache_key_t key;
+      key.scope = scope;
+      key.type = type;
+      key.path = path;
+
+      map<scope_cache_key_t,NetScope*>::const_iterator cur
+	    = scope_cache_.find(key);
+      if (cur != scope_cache_.end())
+	    return cur->second;
+
+      NetScope*res = find_scope_(scope, path, type);
+      scope_cache_[key] = res;
+      return res;
+}
+
+/*
+ * The hname_t operator< treats a name without a number as equal to
+ * the same name with any number, so compare the path components here
+ * strictly.
+ */
+bool Design::scope_cache_key_t::operator < (const scope_cache_key_t&that) const
+{
+      if (scope != that.scope)
+	    return scope < that.scope;
+      if (type != that.type)
+	    return type < that.type;
+      if (path.size() != that.path.size())
+	    return path.size() < that.path.size();
+
+      list<hname_t>::const_iterator lcur = path.begin();
+      list<hname_t>::const_iterator rcur = that.path.begin();
+      for ( ; lcur != path.end() ; ++ lcur, ++ rcur) {
+	    const char*lname = lcur->peek_name();
+	    const char*rname = rcur->peek_name();
+	    if (lname != rname)
+		  return lname < rname;
+	    if (lcur->has_number() != rcur->has_number())
+		  return rcur->has_number();
+	    if (lcur->peek_number() != rcur->peek_number())
+		  return lcur->peek_number() < rcur->peek_number();
+      }
+
+      return false;
+}
+
+NetScope* Design::find_scope_(NetScope*scope, const std::list<hname_t>&path,
+			      NetScope::TYPE type) const
+{
       for ( ; scope ;  scope = scope->parent()) {
 
 	    std::list<hname_t> tmp = path;
@@ -760,6 +816,10 @@ void Design::add_node(NetNode*net)
       }
       nodes_ = net;
       net->design_ = this;
+      nodes_count_ += 1;
+
+      if (nodes_work_list_)
+	    functor_queue(net);
 }
 
 void Design::del_node(NetNode*net)
@@ -777,6 +837,9 @@ void Design::del_node(NetNode*net)
       if (net == nodes_functor_cur_)
 	    nodes_functor_cur_ = 0;
 
+      if (nodes_work_list_)
+	    nodes_work_set_.erase(net);
+
 	/* Now perform the actual delete. */
       if (nodes_ == net)
 	    nodes_ = net->node_prev_;
@@ -789,6 +852,7 @@ void Design::del_node(NetNode*net)
       }
 
       net->design_ = 0;
+      nodes_count_ -= 1;
 }
 
 void Design::add_branch(NetBranch*bra)
@@ -38,9 +38,12 @@ class PExpr;
  * in question.
  */
 
+unsigned NetScope::tree_changes_ = 0;
+
 NetScope::NetScope(NetScope*up, const hname_t&n, NetScope::TYPE t)
 : type_(t), name_(n), up_(up)
 {
+      tree_changes_ += 1;
       events_ = 0;
       lcounter_ = 0;
       need_const_func_ = false;
@@ -162,6 +165,7 @@ bool NetScope::auto_name(const char*prefix, char pad, const char* suffix)
 		  name_ = new_name;
 		  up_->children_.erase(self);
 		  up_->children_[name_] = this;
+		  tree_changes_ += 1;
 		  return true;
 	    }
 	    tmp[pad_pos++] = pad;
@@ -355,6 +359,7 @@ void NetScope::set_module_name(perm_string n)
 {
       assert(type_ == MODULE);
       module_name_ = n; /* NOTE: n must have been permallocated. */
+      tree_changes_ += 1;
 }
 
 perm_string NetScope::module_name() const
@@ -423,6 +428,7 @@ void NetScope::add_event(NetEvent*ev)
       ev->scope_ = this;
       ev->snext_ = events_;
       events_ = ev;
+      events_map_[ev->name()] = ev;
 }
 
 void NetScope::rem_event(NetEvent*ev)
@@ -442,16 +448,27 @@ void NetScope::rem_event(NetEvent*ev)
       }
 
       ev->snext_ = 0;
+
+	/* Let the name find the next event by that name, if any. */
+      map<perm_string,NetEvent*>::iterator cur = events_map_.find(ev->name());
+      if (cur != events_map_.end() && cur->second == ev) {
+	    events_map_.erase(cur);
+	    for (NetEvent*tmp = events_;  tmp ;  tmp = tmp->snext_)
+		  if (tmp->name() == ev->name()) {
+			events_map_[tmp->name()] = tmp;
+			break;
+		  }
+      }
 }
 
 
 NetEvent* NetScope::find_event(perm_string name)
 {
-      for (NetEvent*cur = events_;  cur ;  cur = cur->snext_)
-	    if (cur->name() == name)
-		  return cur;
+      map<perm_string,NetEvent*>::const_iterator cur = events_map_.find(name);
+      if (cur == events_map_.end())
+	    return 0;
 
-      return 0;
+      return cur->second;
 }
 
 void NetScope::add_genvar(perm_string name, LineInfo *li)
@@ -486,10 +503,11 @@ void NetScope::rem_signal(NetNet*net)
  */
 NetNet* NetScope::find_signal(perm_string key)
 {
-      if (signals_map_.find(key)!=signals_map_.end())
-	    return signals_map_[key];
-      else
+      signals_map_iter_t cur = signals_map_.find(key);
+      if (cur == signals_map_.end())
 	    return 0;
+
+      return cur->second;
 }
 
 void NetScope::add_enumeration_set(netenum_t*enum_set)
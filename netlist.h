@@ -876,6 +876,11 @@ class NetScope : public Attrib {
 	   children of this node as well. */
       void run_functor(Design*des, functor_t*fun);
 
+	/* This counts the changes to the tree of scopes, i.e. scopes
+	   that are created, renamed or given a module name. Caches
+	   of scope lookups use this to tell when they are stale. */
+      static unsigned tree_changes() { return tree_changes_; }
+
 
 	/* This member is used during elaboration to pass defparam
 	   assignments from the scope pass to the parameter evaluation
@@ -966,6 +971,9 @@ class NetScope : public Attrib {
       bool time_from_timescale_;
 
       NetEvent *events_;
+	// The events_ list indexed by name, for find_event. If two
+	// events have the same name, this has the latest one added.
+      map<perm_string,NetEvent*> events_map_;
 
       map<perm_string,LineInfo*> genvars_;
 
@@ -992,6 +1000,8 @@ class NetScope : public Attrib {
 
       unsigned lcounter_;
       bool need_const_func_, is_const_func_, is_auto_, is_cell_;
+
+      static unsigned tree_changes_;
 };
 
 /*
@@ -1243,6 +1253,7 @@ class NetConcat  : public NetNode {
 
       void dump_node(ostream&, unsigned ind) const;
       bool emit_node(struct target_t*) const;
+      void functor_node(Design*des, functor_t*fun);
 
     private:
       unsigned width_;
@@ -1881,6 +1892,7 @@ class NetPartSelect  : public NetNode {
 
       virtual void dump_node(ostream&, unsigned ind) const;
       bool emit_node(struct target_t*tgt) const;
+      void functor_node(Design*des, functor_t*fun);
 
     private:
       unsigned off_;
@@ -4040,6 +4052,22 @@ class Design {
 	// Iterate over the design...
       void dump(ostream&) const;
       void functor(struct functor_t*);
+
+	/* The worklist functor runs the functor over the whole design
+	   once, like the functor method, then reruns it only on the
+	   nodes that were queued while it was running, until there
+	   are no more queued nodes. Functors queue the neighbors of
+	   a node that they change or delete, and nodes that are added
+	   to the design are queued automatically. */
+      void functor_worklist(struct functor_t*);
+      void functor_queue(NetNode*);
+      void functor_queue_neighbors(NetPins*);
+
+	/* Run the functor only on the events and signals of the
+	   scopes, skipping the processes and nodes. */
+      void functor_scopes(struct functor_t*);
+
+      unsigned node_count() const { return nodes_count_; }
       void join_islands(void);
       int emit(struct target_t*) const;
 
@@ -4052,11 +4080,33 @@ class Design {
 	// tree and per-hop searches for me.
       list<NetScope*>root_scopes_;
 
+      NetScope* find_scope_(NetScope*, const std::list<hname_t>&path,
+			    NetScope::TYPE type) const;
+
+	// Cache the results of relative scope lookups. Expressions
+	// make the same hierarchical references over and over from
+	// the same scope, so remember where each lookup went. The
+	// cache is flushed whenever the scope tree changes.
+      struct scope_cache_key_t {
+	    NetScope*scope;
+	    NetScope::TYPE type;
+	    std::list<hname_t> path;
+	    bool operator < (const scope_cache_key_t&that) const;
+      };
+      mutable map<scope_cache_key_t,NetScope*> scope_cache_;
+      mutable unsigned scope_cache_changes_;
+
 	// List the nodes in the design.
       NetNode*nodes_;
 	// These are in support of the node functor iterator.
       NetNode*nodes_functor_cur_;
       NetNode*nodes_functor_nxt_;
+      unsigned nodes_count_;
+	// The node worklist, active while functor_worklist runs. The
+	// set holds the nodes that are still queued, so that deleted
+	// nodes can be dropped from the list.
+      list<NetNode*>*nodes_work_list_;
+      set<NetNode*>nodes_work_set_;
 
 	// List the branches in the design.
       NetBranch*branches_;
@@ -210,7 +210,14 @@ void nodangle(Design*des)
 
             fun.scontinue = false;
             fun.econtinue = false;
-	    des->functor(&fun);
+	      /* Only the first pass needs to look at the whole
+		 design. After that, the signals and events are the
+		 only things that can change, so skip the processes
+		 and nodes. */
+	    if (fun.iteration == 0)
+		  des->functor(&fun);
+	    else
+		  des->functor_scopes(&fun);
 	    fun.iteration += 1;
             fun.scomplete = !fun.scontinue;
             fun.ecomplete = !fun.econtinue;
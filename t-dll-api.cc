@@ -1576,13 +1576,13 @@ extern "C" void ivl_nexus_set_private(ivl_nexus_t net, void*data)
 extern "C" unsigned ivl_nexus_ptrs(ivl_nexus_t net)
 {
       assert(net);
-      return net->ptrs_.size();
+      return net->nptrs_;
 }
 
 extern "C" ivl_nexus_ptr_t ivl_nexus_ptr(ivl_nexus_t net, unsigned idx)
 {
       assert(net);
-      assert(idx < net->ptrs_.size());
+      assert(idx < net->nptrs_);
       return & net->ptrs_[idx];
 }
 
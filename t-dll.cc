@@ -266,13 +266,77 @@ ivl_signal_t dll_target::find_signal(ivl_design_s &des, const NetNet*net)
       return 0;
 }
 
-static ivl_nexus_t nexus_sig_make(ivl_signal_t net, unsigned pin)
+/*
+ * The ivl_nexus_ptr_s arrays of all the nexus objects are allocated
+ * from a common arena. The arrays are never freed, so the arena is
+ * simply carved up in order. Very large arrays are allocated on their
+ * own so that they do not waste the tail of an arena block.
+ */
+static ivl_nexus_ptr_s* nexus_ptr_alloc(unsigned cnt)
+{
+      static ivl_nexus_ptr_s*pool_ptr = 0;
+      static unsigned pool_remaining = 0;
+      static const unsigned POOL_SIZE = 16384;
+
+      if (cnt > POOL_SIZE/8)
+	    return new ivl_nexus_ptr_s[cnt];
+
+      if (pool_remaining < cnt) {
+	    pool_ptr = new ivl_nexus_ptr_s[POOL_SIZE];
+	    pool_remaining = POOL_SIZE;
+      }
+
+      ivl_nexus_ptr_s*tmp = pool_ptr;
+      pool_ptr += cnt;
+      pool_remaining -= cnt;
+      return tmp;
+}
+
+/*
+ * Count the links of the Nexus. Every nexus pointer that is added to
+ * an ivl_nexus_t comes from a link of the Nexus, so this is the
+ * number of items to reserve when the ivl_nexus_t is made.
+ */
+static unsigned nexus_link_count(const Nexus*nex)
+{
+      unsigned cnt = 0;
+      for (const Link*cur = nex->first_nlink() ; cur ; cur = cur->next_nlink())
+	    cnt += 1;
+
+      return cnt? cnt : 1;
+}
+
+/*
+ * Return the next free nexus pointer of the nexus. If the reserved
+ * space is used up (this should not normally happen) move the array
+ * to a larger one. The abandoned array stays in the arena.
+ */
+static ivl_nexus_ptr_t nexus_ptr_next(ivl_nexus_t nex)
+{
+      if (nex->nptrs_ == nex->mptrs_) {
+	    unsigned cnt = nex->mptrs_? 2*nex->mptrs_ : 1;
+	    ivl_nexus_ptr_s*tmp = nexus_ptr_alloc(cnt);
+	    for (unsigned idx = 0 ;  idx < nex->nptrs_ ;  idx += 1)
+		  tmp[idx] = nex->ptrs_[idx];
+	    nex->ptrs_ = tmp;
+	    nex->mptrs_ = cnt;
+      }
+
+      nex->nptrs_ += 1;
+      return nex->ptrs_ + nex->nptrs_ - 1;
+}
+
+static ivl_nexus_t nexus_sig_make(ivl_signal_t net, unsigned pin,
+				  unsigned cnt)
 {
       ivl_nexus_t tmp = new struct ivl_nexus_s;
-      tmp->ptrs_.resize(1);
-      tmp->ptrs_[0].pin_   = pin;
-      tmp->ptrs_[0].type_  = __NEXUS_PTR_SIG;
-      tmp->ptrs_[0].l.sig  = net;
+      tmp->ptrs_ = nexus_ptr_alloc(cnt);
+      tmp->mptrs_ = cnt;
+
+      ivl_nexus_ptr_t ptr = nexus_ptr_next(tmp);
+      ptr->pin_   = pin;
+      ptr->type_  = __NEXUS_PTR_SIG;
+      ptr->l.sig  = net;
 
       ivl_drive_t drive = IVL_DR_HiZ;
       switch (ivl_signal_type(net)) {
@@ -282,16 +346,15 @@ static ivl_nexus_t nexus_sig_make(ivl_signal_t net, unsigned pin)
 	  default:
 	    break;
       }
-      tmp->ptrs_[0].drive0 = drive;
-      tmp->ptrs_[0].drive1 = drive;
+      ptr->drive0 = drive;
+      ptr->drive1 = drive;
 
       return tmp;
 }
 
 static void nexus_sig_add(ivl_nexus_t nex, ivl_signal_t net, unsigned pin)
 {
-      unsigned top = nex->ptrs_.size();
-      nex->ptrs_.resize(top+1);
+      ivl_nexus_ptr_t ptr = nexus_ptr_next(nex);
       ivl_drive_t drive = IVL_DR_HiZ;
       switch (ivl_signal_type(net)) {
 	  case IVL_SIT_REG:
@@ -301,83 +364,79 @@ static void nexus_sig_add(ivl_nexus_t nex, ivl_signal_t net, unsigned pin)
 	    break;
       }
 
-      nex->ptrs_[top].type_= __NEXUS_PTR_SIG;
-      nex->ptrs_[top].drive0 = drive;
-      nex->ptrs_[top].drive1 = drive;
-      nex->ptrs_[top].pin_ = pin;
-      nex->ptrs_[top].l.sig= net;
+      ptr->type_= __NEXUS_PTR_SIG;
+      ptr->drive0 = drive;
+      ptr->drive1 = drive;
+      ptr->pin_ = pin;
+      ptr->l.sig= net;
 }
 
 static void nexus_bra_add(ivl_nexus_t nex, ivl_branch_t net, unsigned pin)
 {
-      unsigned top = nex->ptrs_.size();
-      nex->ptrs_.resize(top+1);
-      nex->ptrs_[top].type_= __NEXUS_PTR_BRA;
-      nex->ptrs_[top].drive0 = 0;
-      nex->ptrs_[top].drive1 = 0;
-      nex->ptrs_[top].pin_ = pin;
-      nex->ptrs_[top].l.bra= net;
+      ivl_nexus_ptr_t ptr = nexus_ptr_next(nex);
+      ptr->type_= __NEXUS_PTR_BRA;
+      ptr->drive0 = 0;
+      ptr->drive1 = 0;
+      ptr->pin_ = pin;
+      ptr->l.bra= net;
 }
 
 /*
  * Add the pin of the logic object to the nexus, and return the nexus
  * pointer used for the pin.
  *
- * NOTE: This pointer is only valid until another pin is added to the
- * nexus.
+ * NOTE: The nexus pointer array is sized from the links of the
+ * Nexus, so the returned pointer normally stays valid. It is only
+ * moved if more pins are added than the Nexus has links.
  */
 static ivl_nexus_ptr_t nexus_log_add(ivl_nexus_t nex,
 				     ivl_net_logic_t net,
 				     unsigned pin)
 {
-      unsigned top = nex->ptrs_.size();
-      nex->ptrs_.resize(top+1);
+      ivl_nexus_ptr_t ptr = nexus_ptr_next(nex);
 
-      nex->ptrs_[top].type_= __NEXUS_PTR_LOG;
-      nex->ptrs_[top].drive0 = (pin == 0)? IVL_DR_STRONG : IVL_DR_HiZ;
-      nex->ptrs_[top].drive1 = (pin == 0)? IVL_DR_STRONG : IVL_DR_HiZ;
-      nex->ptrs_[top].pin_ = pin;
-      nex->ptrs_[top].l.log= net;
+      ptr->type_= __NEXUS_PTR_LOG;
+      ptr->drive0 = (pin == 0)? IVL_DR_STRONG : IVL_DR_HiZ;
+      ptr->drive1 = (pin == 0)? IVL_DR_STRONG : IVL_DR_HiZ;
+      ptr->pin_ = pin;
+      ptr->l.log= net;
 
-      return & (nex->ptrs_[top]);
+      return ptr;
 }
 
 static void nexus_con_add(ivl_nexus_t nex, ivl_net_const_t net, unsigned pin,
 			  ivl_drive_t drive0, ivl_drive_t drive1)
 {
-      unsigned top = nex->ptrs_.size();
-      nex->ptrs_.resize(top+1);
+      ivl_nexus_ptr_t ptr = nexus_ptr_next(nex);
 
-      nex->ptrs_[top].type_= __NEXUS_PTR_CON;
-      nex->ptrs_[top].drive0 = drive0;
-      nex->ptrs_[top].drive1 = drive1;
-      nex->ptrs_[top].pin_ = pin;
-      nex->ptrs_[top].l.con= net;
+      ptr->type_= __NEXUS_PTR_CON;
+      ptr->drive0 = drive0;
+      ptr->drive1 = drive1;
+      ptr->pin_ = pin;
+      ptr->l.con= net;
 }
 
 static void nexus_lpm_add(ivl_nexus_t nex, ivl_lpm_t net, unsigned pin,
 			  ivl_drive_t drive0, ivl_drive_t drive1)
 {
-      unsigned top = nex->ptrs_.size();
-      nex->ptrs_.resize(top+1);
+      ivl_nexus_ptr_t ptr = nexus_ptr_next(nex);
 
-      nex->ptrs_[top].type_= __NEXUS_PTR_LPM;
-      nex->ptrs_[top].drive0 = drive0;
-      nex->ptrs_[top].drive1 = drive1;
-      nex->ptrs_[top].pin_ = pin;
-      nex->ptrs_[top].l.lpm= net;
+      ptr->type_= __NEXUS_PTR_LPM;
+      ptr->drive0 = drive0;
+      ptr->drive1 = drive1;
+      ptr->pin_ = pin;
+      ptr->l.lpm= net;
 }
 
 static void nexus_switch_add(ivl_nexus_t nex, ivl_switch_t net, unsigned pin)
 {
-      unsigned top = nex->ptrs_.size();
-      nex->ptrs_.resize(top+1);
+      ivl_nexus_ptr_t ptr = nexus_ptr_next(nex);
 
-      nex->ptrs_[top].type_= __NEXUS_PTR_SWI;
-      nex->ptrs_[top].drive0 = IVL_DR_HiZ;
-      nex->ptrs_[top].drive1 = IVL_DR_HiZ;
-      nex->ptrs_[top].pin_ = pin;
-      nex->ptrs_[top].l.swi= net;
+      ptr->type_= __NEXUS_PTR_SWI;
+      ptr->drive0 = IVL_DR_HiZ;
+      ptr->drive1 = IVL_DR_HiZ;
+      ptr->pin_ = pin;
+      ptr->l.swi= net;
 }
 
 void scope_add_logic(ivl_scope_t scope, ivl_net_logic_t net)
@@ -2360,7 +2419,7 @@ void dll_target::convert_module_ports(const NetScope*net)
 	    scop->u_.nex = new ivl_nexus_t[scop->ports];
 	    for (unsigned idx = 0; idx < scop->ports; idx += 1) {
 		  ivl_signal_t sig = find_signal(des_, nets[idx]);
-		  scop->u_.nex[idx] = nexus_sig_make(sig, 0);
+		  scop->u_.nex[idx] = nexus_sig_make(sig, 0, 1);
 	    }
 	    delete [] nets;
       }
@@ -2521,7 +2580,7 @@ void dll_target::signal(const NetNet*net)
 		    // nothing. This can happen, for example, if the
 		    // variable is only used in behavioral
 		    // code. Create a stub nexus.
-		  ivl_nexus_t tmp = nexus_sig_make(obj, idx);
+		  ivl_nexus_t tmp = nexus_sig_make(obj, idx, 1);
 		  tmp->nexus_ = nex;
 		  tmp->name_ = 0;
 		  if (obj->array_words > 1)
@@ -2537,7 +2596,8 @@ void dll_target::signal(const NetNet*net)
 			nexus_sig_add(obj->pin, obj, idx);
 		  }
 	    } else {
-		  ivl_nexus_t tmp = nexus_sig_make(obj, idx);
+		  ivl_nexus_t tmp = nexus_sig_make(obj, idx,
+						   nexus_link_count(nex));
 		  tmp->nexus_ = nex;
 		  tmp->name_ = 0;
 		  nex->t_cookie(tmp);
@@ -564,10 +564,18 @@ struct ivl_nexus_ptr_s {
 
 /*
  * NOTE: ONLY allocate ivl_nexus_s objects with the included "new" operator.
+ *
+ * The ptrs_ array is allocated from a shared arena with room for
+ * mptrs_ items, of which nptrs_ are in use. The array is sized when
+ * the nexus is created by counting the links of the Nexus, so it
+ * normally does not need to be reallocated as the pins are added.
  */
 struct ivl_nexus_s {
-      ivl_nexus_s() : ptrs_(1), nexus_(0), name_(0), private_data(0) { }
-      vector<ivl_nexus_ptr_s>ptrs_;
+      ivl_nexus_s() : ptrs_(0), nptrs_(0), mptrs_(0),
+                      nexus_(0), name_(0), private_data(0) { }
+      ivl_nexus_ptr_s*ptrs_;
+      unsigned nptrs_;
+      unsigned mptrs_;
       const Nexus*nexus_;
       const char*name_;
       void*private_data;
@@ -198,3 +198,268 @@ int draw_ufunc_real(ivl_expr_t expr)
 
       return res;
 }
+
+/*
+ * A function is pure if its result depends only on the values of its
+ * inputs: it reads no signals outside the function, calls no system
+ * tasks or functions (and only pure user functions), does not wait
+ * and does not read a local variable (or the result) that was not
+ * assigned earlier in the same call. The last is needed because the
+ * variables of a static function keep their values between calls.
+ * The result must also be assigned in every call. The run time may
+ * then save the results of a .ufunc of a pure function, and skip the
+ * thread when the inputs repeat.
+ *
+ * The check tracks the variables that are certainly assigned as a
+ * bit mask over the variables of the function, so a function with
+ * too many variables is simply not pure.
+ */
+#define PURE_MAX_VARS 64
+#define PURE_MAX_DEPTH 8
+
+struct pure_info_s {
+      ivl_scope_t def;
+      unsigned nvars;
+      ivl_signal_t vars[PURE_MAX_VARS];
+      unsigned depth;
+};
+
+typedef unsigned long long pure_mask_t;
+
+static int scope_is_within(ivl_scope_t scope, ivl_scope_t def)
+{
+      while (scope) {
+	    if (scope == def)
+		  return 1;
+	    scope = ivl_scope_parent(scope);
+      }
+      return 0;
+}
+
+/*
+ * Get the index of the variable in the info, or -1 if the signal is
+ * not a variable of the function.
+ */
+static int pure_var_index(struct pure_info_s*info, ivl_signal_t sig)
+{
+      unsigned idx;
+
+      if (! scope_is_within(ivl_signal_scope(sig), info->def))
+	    return -1;
+      if (ivl_signal_dimensions(sig) > 0)
+	    return -1;
+
+      for (idx = 0 ;  idx < info->nvars ;  idx += 1) {
+	    if (info->vars[idx] == sig)
+		  return idx;
+      }
+
+      if (info->nvars >= PURE_MAX_VARS)
+	    return -1;
+
+      info->vars[info->nvars] = sig;
+      info->nvars += 1;
+      return idx;
+}
+
+static int function_is_pure_(ivl_scope_t def, unsigned depth);
+
+static int expr_is_pure(struct pure_info_s*info, ivl_expr_t expr,
+			pure_mask_t assigned)
+{
+      unsigned idx;
+      int var;
+
+      if (expr == 0)
+	    return 1;
+
+      switch (ivl_expr_type(expr)) {
+	  case IVL_EX_NUMBER:
+	  case IVL_EX_REALNUM:
+	  case IVL_EX_STRING:
+	  case IVL_EX_ULONG:
+	    return 1;
+
+	  case IVL_EX_SIGNAL:
+	    var = pure_var_index(info, ivl_expr_signal(expr));
+	    if (var < 0)
+		  return 0;
+	    if (! (assigned & (1ULL << var)))
+		  return 0;
+	    return expr_is_pure(info, ivl_expr_oper1(expr), assigned);
+
+	  case IVL_EX_UNARY:
+	    return expr_is_pure(info, ivl_expr_oper1(expr), assigned);
+
+	  case IVL_EX_BINARY:
+	  case IVL_EX_SELECT:
+	    return expr_is_pure(info, ivl_expr_oper1(expr), assigned)
+		  && expr_is_pure(info, ivl_expr_oper2(expr), assigned);
+
+	  case IVL_EX_TERNARY:
+	    return expr_is_pure(info, ivl_expr_oper1(expr), assigned)
+		  && expr_is_pure(info, ivl_expr_oper2(expr), assigned)
+		  && expr_is_pure(info, ivl_expr_oper3(expr), assigned);
+
+	  case IVL_EX_CONCAT:
+	    for (idx = 0 ;  idx < ivl_expr_parms(expr) ;  idx += 1) {
+		  if (! expr_is_pure(info, ivl_expr_parm(expr, idx), assigned))
+			return 0;
+	    }
+	    return 1;
+
+	  case IVL_EX_UFUNC:
+	    for (idx = 0 ;  idx < ivl_expr_parms(expr) ;  idx += 1) {
+		  if (! expr_is_pure(info, ivl_expr_parm(expr, idx), assigned))
+			return 0;
+	    }
+	    return function_is_pure_(ivl_expr_def(expr), info->depth+1);
+
+	  default:
+	    return 0;
+      }
+}
+
+static int stmt_is_pure(struct pure_info_s*info, ivl_statement_t net,
+			pure_mask_t*assigned)
+{
+      unsigned idx;
+      pure_mask_t tmp, all;
+      int var, have_default;
+
+      if (net == 0)
+	    return 1;
+
+      switch (ivl_statement_type(net)) {
+	  case IVL_ST_NOOP:
+	    return 1;
+
+	  case IVL_ST_ASSIGN:
+	    if (! expr_is_pure(info, ivl_stmt_rval(net), *assigned))
+		  return 0;
+	    for (idx = 0 ;  idx < ivl_stmt_lvals(net) ;  idx += 1) {
+		  ivl_lval_t lval = ivl_stmt_lval(net, idx);
+		  ivl_signal_t sig = ivl_lval_sig(lval);
+		  if (sig == 0)
+			return 0;
+		  var = pure_var_index(info, sig);
+		  if (var < 0)
+			return 0;
+		  if (! expr_is_pure(info, ivl_lval_idx(lval), *assigned))
+			return 0;
+		  if (! expr_is_pure(info, ivl_lval_mux(lval), *assigned))
+			return 0;
+		  if (! expr_is_pure(info, ivl_lval_part_off(lval), *assigned))
+			return 0;
+		    /* Only an assignment to the whole variable makes
+		       it certainly assigned. */
+		  if (ivl_lval_idx(lval) == 0 && ivl_lval_mux(lval) == 0
+		      && ivl_lval_part_off(lval) == 0
+		      && ivl_lval_width(lval) == ivl_signal_width(sig))
+			*assigned |= 1ULL << var;
+	    }
+	    return 1;
+
+	  case IVL_ST_BLOCK:
+	    for (idx = 0 ;  idx < ivl_stmt_block_count(net) ;  idx += 1) {
+		  ivl_statement_t cur = ivl_stmt_block_stmt(net, idx);
+		  if (! stmt_is_pure(info, cur, assigned))
+			return 0;
+	    }
+	    return 1;
+
+	  case IVL_ST_CONDIT:
+	    if (! expr_is_pure(info, ivl_stmt_cond_expr(net), *assigned))
+		  return 0;
+	    tmp = *assigned;
+	    all = *assigned;
+	    if (! stmt_is_pure(info, ivl_stmt_cond_true(net), &tmp))
+		  return 0;
+	    if (! stmt_is_pure(info, ivl_stmt_cond_false(net), &all))
+		  return 0;
+	    *assigned = tmp & all;
+	    return 1;
+
+	  case IVL_ST_CASE:
+	  case IVL_ST_CASER:
+	  case IVL_ST_CASEX:
+	  case IVL_ST_CASEZ:
+	    if (! expr_is_pure(info, ivl_stmt_cond_expr(net), *assigned))
+		  return 0;
+	    all = ~0ULL;
+	    have_default = 0;
+	    for (idx = 0 ;  idx < ivl_stmt_case_count(net) ;  idx += 1) {
+		  ivl_expr_t cex = ivl_stmt_case_expr(net, idx);
+		  if (cex == 0)
+			have_default = 1;
+		  else if (! expr_is_pure(info, cex, *assigned))
+			return 0;
+		  tmp = *assigned;
+		  if (! stmt_is_pure(info, ivl_stmt_case_stmt(net, idx), &tmp))
+			return 0;
+		  all &= tmp;
+	    }
+	      /* Without a default, maybe none of the cases run. */
+	    if (have_default)
+		  *assigned = all;
+	    return 1;
+
+	  case IVL_ST_REPEAT:
+	  case IVL_ST_WHILE:
+	      /* The body may not run at all, so it assigns nothing
+		 for certain. */
+	    if (! expr_is_pure(info, ivl_stmt_cond_expr(net), *assigned))
+		  return 0;
+	    tmp = *assigned;
+	    if (! stmt_is_pure(info, ivl_stmt_sub_stmt(net), &tmp))
+		  return 0;
+	      /* The condition of a while loop is evaluated again
+		 after the body. */
+	    if (! expr_is_pure(info, ivl_stmt_cond_expr(net), tmp))
+		  return 0;
+	    return 1;
+
+	  default:
+	    return 0;
+      }
+}
+
+static int function_is_pure_(ivl_scope_t def, unsigned depth)
+{
+      struct pure_info_s info;
+      pure_mask_t assigned = 0;
+      unsigned idx;
+      int var;
+
+      if (depth > PURE_MAX_DEPTH)
+	    return 0;
+      if (ivl_scope_type(def) != IVL_SCT_FUNCTION)
+	    return 0;
+
+      info.def = def;
+      info.nvars = 0;
+      info.depth = depth;
+
+	/* Port 0 is the result, and the rest are the inputs, which
+	   are assigned by the call. */
+      for (idx = 1 ;  idx < ivl_scope_ports(def) ;  idx += 1) {
+	    var = pure_var_index(&info, ivl_scope_port(def, idx));
+	    if (var < 0)
+		  return 0;
+	    assigned |= 1ULL << var;
+      }
+
+      var = pure_var_index(&info, ivl_scope_port(def, 0));
+      if (var < 0)
+	    return 0;
+
+      if (! stmt_is_pure(&info, ivl_scope_def(def), &assigned))
+	    return 0;
+
+      return (assigned & (1ULL << var)) != 0;
+}
+
+int function_is_pure(ivl_scope_t def)
+{
+      return function_is_pure_(def, 0);
+}
@@ -100,6 +100,13 @@ extern void draw_lpm_mux(ivl_lpm_t net);
 extern struct vector_info draw_ufunc_expr(ivl_expr_t expr, unsigned wid);
 extern int draw_ufunc_real(ivl_expr_t expr);
 
+/*
+ * Return true if the result of the function depends only on its
+ * inputs, so that the run time may reuse a result when the inputs
+ * repeat.
+ */
+extern int function_is_pure(ivl_scope_t def);
+
 extern void pad_expr_in_place(ivl_expr_t expr, struct vector_info res,
                               unsigned swid);
 
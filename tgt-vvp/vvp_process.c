@@ -1782,13 +1782,21 @@ static int show_stmt_utask(ivl_statement_t net)
       return 0;
 }
 
+/*
+ * This is the wait statement at the top of the always process being
+ * drawn, if any. It is drawn as a %wait/p so that the thread stays
+ * registered with the event.
+ */
+static ivl_statement_t persistent_wait = 0;
+
 static int show_stmt_wait(ivl_statement_t net, ivl_scope_t sscope)
 {
+      const char*wait_op = net == persistent_wait? "%wait/p" : "%wait";
       show_stmt_file_line(net, "Event wait (@) statement.");
 
       if (ivl_stmt_nevent(net) == 1) {
 	    ivl_event_t ev = ivl_stmt_events(net, 0);
-	    fprintf(vvp_out, "    %%wait E_%p;\n", ev);
+	    fprintf(vvp_out, "    %s E_%p;\n", wait_op, ev);
 
       } else {
 	    unsigned idx;
@@ -1800,7 +1808,7 @@ static int show_stmt_wait(ivl_statement_t net, ivl_scope_t sscope)
 		  ev = ivl_stmt_events(net, idx);
 		  fprintf(vvp_out, ", E_%p", ev);
 	    }
-	    fprintf(vvp_out, ";\n    %%wait Ewait_%u;\n", cascade_counter);
+	    fprintf(vvp_out, ";\n    %s Ewait_%u;\n", wait_op, cascade_counter);
 	    cascade_counter += 1;
       }
 	/* Always clear the expression lookaside after a
@@ -2425,8 +2433,24 @@ int draw_process(ivl_process_t net, void*x)
       fprintf(vvp_out, "T_%d ;\n", thread_count);
       clear_expression_lookaside();
 
+	/* An always process that starts with an event wait has a static
+	   sensitivity list, so its thread can stay registered with
+	   the event. The events must all be static. */
+      persistent_wait = 0;
+      if (ivl_process_type(net) == IVL_PR_ALWAYS
+	  && ivl_statement_type(stmt) == IVL_ST_WAIT
+	  && ivl_stmt_nevent(stmt) > 0) {
+	    persistent_wait = stmt;
+	    for (idx = 0 ;  idx < ivl_stmt_nevent(stmt) ;  idx += 1) {
+		  ivl_event_t ev = ivl_stmt_events(stmt, idx);
+		  if (ivl_scope_is_auto(ivl_event_scope(ev)))
+			persistent_wait = 0;
+	    }
+      }
+
 	/* Draw the contents of the thread. */
       rc += show_statement(stmt, scope);
+      persistent_wait = 0;
 
 
 	/* Terminate the thread with either an %end instruction (initial
@@ -0,0 +1,475 @@
+/*
+ * Copyright (c) 2007-2010 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA
+ */
+
+/*
+ * This is the lexical analyzer for SDF files. SDF files for a large
+ * design can be hundreds of megabytes, so the whole file is mapped
+ * into memory and the tokens are recognized directly from the mapped
+ * text without any copying except for the strings that are passed to
+ * the parser.
+ */
+
+# include  "vpi_config.h"
+# include  "sdf_priv.h"
+# include  "sdf_parse_priv.h"
+# include  "sdf_parse.h"
+# include  <stdlib.h>
+# include  <string.h>
+# include  <strings.h>
+# include  <ctype.h>
+# include  <assert.h>
+# include  <sys/types.h>
+# include  <sys/stat.h>
+#if !defined(__MINGW32__)
+# include  <sys/mman.h>
+#endif
+# include  "ivl_alloc.h"
+
+const char*sdf_parse_path = 0;
+
+  /* The text of the file being scanned and the current position. */
+static const char*sdf_text = 0;
+static const char*sdf_cur = 0;
+static const char*sdf_end = 0;
+static size_t sdf_text_size = 0;
+static int sdf_text_mapped = 0;
+
+  /* The lexor is in one of these states. The edge states are entered
+     by the parser where it expects an edge identifier. */
+enum sdf_lex_state { SDF_LEX_NORMAL, SDF_LEX_EDGE_ID, SDF_LEX_COND_EDGE_ID };
+static enum sdf_lex_state sdf_lex_state = SDF_LEX_NORMAL;
+
+static struct {
+      const char*name;
+      int code;
+} keywords[] = {
+      { "ABSOLUTE",   K_ABSOLUTE },
+      { "CELL",       K_CELL },
+      { "CELLTYPE",   K_CELLTYPE },
+      { "DATE",       K_DATE },
+      { "DELAY",      K_DELAY },
+      { "DELAYFILE",  K_DELAYFILE },
+      { "DESIGN",     K_DESIGN },
+      { "DIVIDER",    K_DIVIDER },
+      { "HOLD",       K_HOLD },
+      { "INCREMENT",  K_INCREMENT },
+      { "INTERCONNECT",K_INTERCONNECT },
+      { "INSTANCE",   K_INSTANCE },
+      { "IOPATH",     K_IOPATH },
+      { "PROCESS",    K_PROCESS },
+      { "PROGRAM",    K_PROGRAM },
+      { "RECREM",     K_RECREM },
+      { "RECOVERY",   K_RECOVERY },
+      { "REMOVAL",    K_REMOVAL },
+      { "SDFVERSION", K_SDFVERSION },
+      { "SETUP",      K_SETUP },
+      { "SETUPHOLD",  K_SETUPHOLD },
+      { "TEMPERATURE",K_TEMPERATURE },
+      { "TIMESCALE",  K_TIMESCALE },
+      { "TIMINGCHECK",K_TIMINGCHECK },
+      { "VENDOR",     K_VENDOR },
+      { "VERSION",    K_VERSION },
+      { "VOLTAGE",    K_VOLTAGE },
+      { "WIDTH",      K_WIDTH },
+      { 0, IDENTIFIER }
+};
+
+void start_edge_id(unsigned cond)
+{
+      sdf_lex_state = cond ? SDF_LEX_COND_EDGE_ID : SDF_LEX_EDGE_ID;
+}
+
+void stop_edge_id(void)
+{
+      sdf_lex_state = SDF_LEX_NORMAL;
+}
+
+static int is_ident_start(int ch)
+{
+      return isalpha(ch) || ch == '_';
+}
+
+static int is_ident_char(int ch)
+{
+      return isalnum(ch) || ch == '_' || ch == '$';
+}
+
+static int is_escape_char(int ch)
+{
+      return ch != ' ' && ch != '\t' && ch != '\b' && ch != '\f'
+	    && ch != '\r' && ch != '\n';
+}
+
+/*
+ * Return the length of the identifier (including any escapes) that
+ * starts at the current position, or 0 if there is none.
+ */
+static size_t ident_length(void)
+{
+      const char*cp = sdf_cur;
+
+      if (cp < sdf_end && is_ident_start((unsigned char)*cp)) {
+	    cp += 1;
+      } else if (cp+1 < sdf_end && *cp == '\\'
+		 && is_escape_char((unsigned char)cp[1])) {
+	    cp += 2;
+      } else {
+	    return 0;
+      }
+
+      while (cp < sdf_end) {
+	    if (is_ident_char((unsigned char)*cp)) {
+		  cp += 1;
+	    } else if (cp+1 < sdf_end && *cp == '\\'
+		       && is_escape_char((unsigned char)cp[1])) {
+		  cp += 2;
+	    } else {
+		  break;
+	    }
+      }
+
+      return cp - sdf_cur;
+}
+
+/*
+ * Return the length of the number at the current position, and set
+ * *real_flag if it has a fraction or an exponent.
+ */
+static size_t number_length(int*real_flag)
+{
+      const char*cp = sdf_cur;
+
+      *real_flag = 0;
+      while (cp < sdf_end && isdigit((unsigned char)*cp)) cp += 1;
+
+      if (cp+1 < sdf_end && cp[0] == '.' && isdigit((unsigned char)cp[1])) {
+	    *real_flag = 1;
+	    cp += 1;
+	    while (cp < sdf_end && isdigit((unsigned char)*cp)) cp += 1;
+      }
+
+      if (cp < sdf_end && (*cp == 'e' || *cp == 'E')) {
+	    const char*ep = cp + 1;
+	    if (ep < sdf_end && (*ep == '+' || *ep == '-')) ep += 1;
+	    if (ep < sdf_end && isdigit((unsigned char)*ep)) {
+		  *real_flag = 1;
+		  cp = ep;
+		  while (cp < sdf_end && isdigit((unsigned char)*cp)) cp += 1;
+	    }
+      }
+
+      return cp - sdf_cur;
+}
+
+static int text_is(const char*text, size_t len, const char*word)
+{
+      return strlen(word) == len && strncasecmp(text, word, len) == 0;
+}
+
+/*
+ * In the edge states the edge identifiers take precedence over the
+ * identifiers and numbers that are spelled the same.
+ */
+static int lex_edge_id(void)
+{
+      int real_flag;
+      size_t len = ident_length();
+      const char*text = sdf_cur;
+
+      if (len == 0 && isdigit((unsigned char)*sdf_cur)) {
+	    len = number_length(&real_flag);
+	      /* 0z and 1z are longer than the digit that starts them. */
+	    if (len == 1 && sdf_cur+1 < sdf_end
+		&& (sdf_cur[1] == 'z' || sdf_cur[1] == 'Z')) {
+		  if (sdf_cur[0] == '0') {
+			sdf_cur += 2;
+			return K_0Z;
+		  }
+		  if (sdf_cur[0] == '1') {
+			sdf_cur += 2;
+			return K_1Z;
+		  }
+	    }
+	    if (len == 2 && strncmp(text, "01", 2) == 0) {
+		  sdf_cur += 2;
+		  return K_01;
+	    }
+	    if (len == 2 && strncmp(text, "10", 2) == 0) {
+		  sdf_cur += 2;
+		  return K_10;
+	    }
+	    return 0;
+      }
+
+      if (len == 0) return 0;
+
+      if (text_is(text, len, "z1")) {
+	    sdf_cur += len;
+	    return K_Z1;
+      }
+      if (text_is(text, len, "z0")) {
+	    sdf_cur += len;
+	    return K_Z0;
+      }
+      if (text_is(text, len, "posedge")) {
+	    sdf_cur += len;
+	    return K_POSEDGE;
+      }
+      if (text_is(text, len, "negedge")) {
+	    sdf_cur += len;
+	    return K_NEGEDGE;
+      }
+      if (sdf_lex_state == SDF_LEX_COND_EDGE_ID && text_is(text, len, "cond")) {
+	    sdf_cur += len;
+	    return K_COND;
+      }
+
+      return 0;
+}
+
+static int lex_identifier(size_t len)
+{
+      const char*text = sdf_cur;
+      char*res;
+      size_t idx, skip;
+
+      sdf_cur += len;
+
+	/* All the keywords are plain upper or lower case letters. */
+      if (len <= 12 && isalpha((unsigned char)text[0])) {
+	    for (idx = 0 ;  keywords[idx].name ;  idx += 1) {
+		  if (text_is(text, len, keywords[idx].name))
+			return keywords[idx].code;
+	    }
+      }
+
+	/* Process any escaped characters. */
+      res = malloc(len + 1);
+      skip = 0;
+      for (idx = 0 ; idx < len ; idx += 1) {
+	    if (text[idx] == '\\') {
+		  skip += 1;
+		  idx += 1;
+	    }
+	    res[idx-skip] = text[idx];
+      }
+      res[idx-skip] = 0;
+
+      sdflval.string_val = res;
+      return IDENTIFIER;
+}
+
+/*
+ * Skip white space and comments, counting lines as they go by.
+ */
+static void skip_space(void)
+{
+      while (sdf_cur < sdf_end) {
+	    switch (*sdf_cur) {
+		case '\n':
+		  sdflloc.first_line += 1;
+		  sdf_cur += 1;
+		  break;
+		case ' ':
+		case '\t':
+		case '\r':
+		case '\f':
+		case '\v':
+		  sdf_cur += 1;
+		  break;
+		case '/':
+		  if (sdf_cur+1 < sdf_end && sdf_cur[1] == '/') {
+			while (sdf_cur < sdf_end && *sdf_cur != '\n')
+			      sdf_cur += 1;
+			break;
+		  }
+		  if (sdf_cur+1 < sdf_end && sdf_cur[1] == '*') {
+			sdf_cur += 2;
+			while (sdf_cur < sdf_end) {
+			      if (*sdf_cur == '\n') {
+				    sdflloc.first_line += 1;
+			      } else if (*sdf_cur == '*' && sdf_cur+1 < sdf_end
+					 && sdf_cur[1] == '/') {
+				    sdf_cur += 2;
+				    break;
+			      }
+			      sdf_cur += 1;
+			}
+			break;
+		  }
+		  return;
+		default:
+		  return;
+	    }
+      }
+}
+
+int sdflex(void)
+{
+      int real_flag, code;
+      size_t len;
+      char ch;
+
+      skip_space();
+      if (sdf_cur >= sdf_end) return 0;
+
+      if (sdf_lex_state != SDF_LEX_NORMAL) {
+	    code = lex_edge_id();
+	    if (code) return code;
+      }
+
+      ch = *sdf_cur;
+
+	/* Scalar constants: 'b0, 'b1, 1'b0 and 1'b1. */
+      if (ch == '\'' || (ch == '1' && sdf_cur+1 < sdf_end
+			 && sdf_cur[1] == '\'')) {
+	    const char*cp = sdf_cur + (ch == '1' ? 2 : 1);
+	    if (cp+1 < sdf_end && (cp[0] == 'b' || cp[0] == 'B')
+		&& (cp[1] == '0' || cp[1] == '1')) {
+		  sdf_cur = cp + 2;
+		  return cp[1] == '0' ? K_LOGICAL_ZERO : K_LOGICAL_ONE;
+	    }
+      }
+
+      if (isdigit((unsigned char)ch)) {
+	      /* The mapped text is not terminated, so convert a
+	         terminated copy of the number. */
+	    char text[64];
+	    len = number_length(&real_flag);
+	    if (len >= sizeof text) len = sizeof text - 1;
+	    memcpy(text, sdf_cur, len);
+	    text[len] = 0;
+	    sdf_cur += len;
+	    if (real_flag) {
+		  sdflval.real_val = strtod(text, 0);
+		  return REAL_NUMBER;
+	    }
+	    sdflval.int_val = strtoul(text, 0, 10);
+	    return INTEGER;
+      }
+
+      len = ident_length();
+      if (len > 0) return lex_identifier(len);
+
+      if (ch == '"') {
+	    const char*text = sdf_cur + 1;
+	    const char*cp = text;
+	    char*res;
+	    while (cp < sdf_end && *cp != '"') {
+		  if (*cp == '\n') sdflloc.first_line += 1;
+		  cp += 1;
+	    }
+	    res = malloc(cp - text + 1);
+	    memcpy(res, text, cp - text);
+	    res[cp - text] = 0;
+	    sdf_cur = cp < sdf_end ? cp + 1 : cp;
+	    sdflval.string_val = res;
+	    return QSTRING;
+      }
+
+	/* Equality operators. */
+      if ((ch == '=' || ch == '!') && sdf_cur+1 < sdf_end
+	  && sdf_cur[1] == '=') {
+	    int case_flag = sdf_cur+2 < sdf_end && sdf_cur[2] == '=';
+	    sdf_cur += case_flag ? 3 : 2;
+	    if (ch == '=') return case_flag ? K_CEQ : K_EQ;
+	    return case_flag ? K_CNE : K_NE;
+      }
+
+	/* The HCHAR (hierarchy separator) is set by the SDF file
+	   itself. */
+      sdf_cur += 1;
+      if ((ch == '.' || ch == '/') && sdf_use_hchar == ch)
+	    return HCHAR;
+
+      return (unsigned char)ch;
+}
+
+/*
+ * Make the contents of the file available in sdf_text. Regular files
+ * are mapped, anything else (or a failed map) is read into memory.
+ */
+static void load_text(FILE*fd)
+{
+      struct stat sb;
+      size_t cnt, rc;
+      char*buf;
+
+      sdf_text = 0;
+      sdf_text_size = 0;
+      sdf_text_mapped = 0;
+
+#if !defined(__MINGW32__)
+      if (fstat(fileno(fd), &sb) == 0 && S_ISREG(sb.st_mode)
+	  && sb.st_size > 0) {
+	    void*map = mmap(0, sb.st_size, PROT_READ, MAP_PRIVATE,
+			    fileno(fd), 0);
+	    if (map != MAP_FAILED) {
+		  sdf_text = (const char*) map;
+		  sdf_text_size = sb.st_size;
+		  sdf_text_mapped = 1;
+		  return;
+	    }
+      }
+#else
+      (void)sb;
+#endif
+
+      buf = 0;
+      cnt = 0;
+      for (;;) {
+	    buf = realloc(buf, cnt + 64*1024);
+	    rc = fread(buf + cnt, 1, 64*1024, fd);
+	    cnt += rc;
+	    if (rc < 64*1024) break;
+      }
+      sdf_text = buf;
+      sdf_text_size = cnt;
+}
+
+static void unload_text(void)
+{
+#if !defined(__MINGW32__)
+      if (sdf_text_mapped) {
+	    munmap((void*)sdf_text, sdf_text_size);
+      } else
+#endif
+      free((void*)sdf_text);
+
+      sdf_text = 0;
+      sdf_text_size = 0;
+      sdf_text_mapped = 0;
+}
+
+extern int sdfparse(void);
+void sdf_process_file(FILE*fd, const char*path)
+{
+      load_text(fd);
+      sdf_cur = sdf_text;
+      sdf_end = sdf_text + sdf_text_size;
+      sdf_lex_state = SDF_LEX_NORMAL;
+
+      sdf_parse_path = path;
+      sdfparse();
+      sdf_parse_path = 0;
+
+      unload_text();
+      sdf_cur = 0;
+      sdf_end = 0;
+}
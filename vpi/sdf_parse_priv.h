@@ -20,7 +20,7 @@
  */
 
 /*
- * This file is only included by sdf_parse.y and sdf_lexor.lex. It is
+ * This file is only included by sdf_parse.y and sdf_lexor.c. It is
  * used to share declarations between the parse and the lexor.
  */
 
@@ -27,25 +27,14 @@
 # include  <math.h>
 # include  "ivl_alloc.h"
 
-#define IS_MCD(mcd)     !((mcd)>>31&1)
-
-/* Printf wrapper to handle both MCD/FD */
-static PLI_INT32 my_mcd_printf(PLI_UINT32 mcd, const char *fmt, ...)
+/*
+ * Check that the MCD/FD is open. Writing nothing does this without
+ * waiting for the output that is queued for the file (vvp -a), as
+ * vpi_get_file would.
+ */
+static int is_valid_fd_mcd(PLI_UINT32 fd_mcd)
 {
-      int r = 0;
-
-      va_list ap;
-      va_start(ap, fmt);
-
-      if (IS_MCD(mcd)) {
-	    r = vpi_mcd_vprintf(mcd, fmt, ap);
-      } else {
-	    FILE *fp = vpi_get_file(mcd);
-	    if (fp) r = vfprintf(fp, fmt, ap);
-      }
-
-      va_end(ap);
-      return r;
+      return vpip_mcd_write(fd_mcd, "", 0) != EOF;
 }
 
 struct timeformat_info_s timeformat_info = { 0, 0, 0, 20 };
@@ -59,6 +48,8 @@ struct strobe_cb_info {
       vpiHandle*items;
       unsigned nitems;
       unsigned fd_mcd;
+	/* Precompiled format programs for the items, or nil. */
+      struct format_prog**formats;
 };
 
 /*
@@ -803,54 +794,183 @@ static unsigned int get_format_char(char **rtn, int ljust, int plus,
   return size - 1;
 }
 
-/* We can't use the normal str functions on the return value since
- * %u and %z can insert NULL characters into the stream. */
-static unsigned int get_format(char **rtn, char *fmt,
-                               const struct strobe_cb_info *info, unsigned int *idx)
+/*
+ * A format string is parsed once into a format program, which is a
+ * list of steps that are either literal text or a conversion with
+ * its flags. The program can then be run any number of times without
+ * looking at the format string again. The text steps point into the
+ * copy of the format string that the program keeps.
+ */
+struct format_step {
+  int is_text;
+  const char *text;
+  unsigned int len;
+  int ljust, plus, ld_zero, width, prec;
+  char fmt;
+};
+
+struct format_prog {
+  char *text;
+  unsigned int nsteps;
+  struct format_step *steps;
+};
+
+static struct format_prog *compile_format(const char *fmt)
 {
-  char *cp = fmt;
-  unsigned int size;
+  struct format_prog *prog = malloc(sizeof(struct format_prog));
+  char *cp;
 
-  *rtn = strdup("");
-  size = 1;
+  prog->text = strdup(fmt);
+  prog->nsteps = 0;
+  prog->steps = 0;
+
+  cp = prog->text;
   while (*cp) {
     size_t cnt = strcspn(cp, "%");
+    struct format_step *step;
+
+    prog->steps = realloc(prog->steps,
+                          (prog->nsteps+1)*sizeof(struct format_step));
+    step = prog->steps + prog->nsteps;
+    prog->nsteps += 1;
 
     if (cnt > 0) {
-      *rtn = realloc(*rtn, (size+cnt)*sizeof(char));
-      memcpy(*rtn+size-1, cp, cnt);
-      size += cnt;
+      step->is_text = 1;
+      step->text = cp;
+      step->len = cnt;
       cp += cnt;
     } else {
-      int ljust = 0, plus = 0, ld_zero = 0, width = -1, prec = -1;
-      char *result;
+      step->is_text = 0;
+      step->ljust = 0;
+      step->plus = 0;
+      step->ld_zero = 0;
+      step->width = -1;
+      step->prec = -1;
 
       cp += 1;
       while ((*cp == '-') || (*cp == '+')) {
-        if (*cp == '-') ljust = 1;
-        else plus = 1;
+        if (*cp == '-') step->ljust = 1;
+        else step->plus = 1;
         cp += 1;
       }
       if (*cp == '0') {
-        ld_zero = 1;
+        step->ld_zero = 1;
         cp += 1;
       }
-      if (isdigit((int)*cp)) width = strtoul(cp, &cp, 10);
+      if (isdigit((int)*cp)) step->width = strtoul(cp, &cp, 10);
       if (*cp == '.') {
         cp += 1;
-        prec = strtoul(cp, &cp, 10);
+        step->prec = strtoul(cp, &cp, 10);
       }
-      cnt = get_format_char(&result, ljust, plus, ld_zero, width, prec, *cp,
-                            info, idx);
-      *rtn = realloc(*rtn, (size+cnt)*sizeof(char));
-      memcpy(*rtn+size-1, result, cnt);
-      free(result);
-      size += cnt;
+      step->fmt = *cp;
       if (*cp) cp += 1;
     }
   }
-  *(*rtn+size-1) = '\0';
-  return size - 1;
+
+  return prog;
+}
+
+static void free_format(struct format_prog *prog)
+{
+  free(prog->text);
+  free(prog->steps);
+  free(prog);
+}
+
+/*
+ * The display result is built in a display_buf. The buffer is only
+ * grown, so a buffer that is kept between calls stops allocating
+ * once it is large enough. The text is always NULL terminated, but
+ * %u and %z can put NULL characters in it so len is the real size.
+ */
+struct display_buf {
+  char *text;
+  unsigned int len;
+  unsigned int size;
+};
+
+static char *buf_reserve(struct display_buf *buf, unsigned int cnt)
+{
+  if (buf->len + cnt + 1 > buf->size) {
+    if (buf->size == 0) buf->size = 256;
+    while (buf->len + cnt + 1 > buf->size) buf->size *= 2;
+    buf->text = realloc(buf->text, buf->size*sizeof(char));
+  }
+  return buf->text + buf->len;
+}
+
+static void buf_append(struct display_buf *buf, const char *text,
+                       unsigned int cnt)
+{
+  char *cp = buf_reserve(buf, cnt);
+  memcpy(cp, text, cnt);
+  buf->len += cnt;
+  buf->text[buf->len] = '\0';
+}
+
+static void run_format(struct display_buf *buf, const struct format_prog *prog,
+                       const struct strobe_cb_info *info, unsigned int *idx)
+{
+  unsigned int step;
+
+  for (step = 0; step < prog->nsteps; step += 1) {
+    const struct format_step *cur = prog->steps + step;
+    char *result;
+    unsigned int cnt;
+
+    if (cur->is_text) {
+      buf_append(buf, cur->text, cur->len);
+      continue;
+    }
+
+    cnt = get_format_char(&result, cur->ljust, cur->plus, cur->ld_zero,
+                          cur->width, cur->prec, cur->fmt, info, idx);
+    buf_append(buf, result, cnt);
+    free(result);
+  }
+}
+
+/*
+ * Compile the format programs for all the string constant arguments.
+ * Any of them may be used as a format, depending on the arguments
+ * consumed by the formats before it.
+ */
+static void compile_formats(struct strobe_cb_info *info)
+{
+  unsigned int idx;
+  s_vpi_value value;
+
+  info->formats = 0;
+  if (info->nitems == 0) return;
+
+  info->formats = calloc(info->nitems, sizeof(struct format_prog*));
+  for (idx = 0; idx < info->nitems; idx += 1) {
+    vpiHandle item = info->items[idx];
+    switch (vpi_get(vpiType, item)) {
+      case vpiConstant:
+      case vpiParameter:
+        if (vpi_get(vpiConstType, item) == vpiStringConst) {
+          value.format = vpiStringVal;
+          vpi_get_value(item, &value);
+          info->formats[idx] = compile_format(value.value.str);
+        }
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+static void free_formats(struct strobe_cb_info *info)
+{
+  unsigned int idx;
+
+  if (info->formats == 0) return;
+  for (idx = 0; idx < info->nitems; idx += 1) {
+    if (info->formats[idx]) free_format(info->formats[idx]);
+  }
+  free(info->formats);
+  info->formats = 0;
 }
 
 static unsigned int get_numeric(char **rtn, const struct strobe_cb_info *info,
@@ -876,17 +996,19 @@ static unsigned int get_numeric(char **rtn, const struct strobe_cb_info *info,
 }
 
 /* In many places we can't use the normal str functions since %u and %z
- * can insert NULL characters into the stream. */
-static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
+ * can insert NULL characters into the stream. The result is appended
+ * to the display buffer. */
+static void render_display(struct display_buf *out,
+                           const struct strobe_cb_info *info)
 {
-  char *result, *fmt, *rtn, *func_name;
+  char *result, *func_name, *cp;
   const char *cresult;
   s_vpi_value value;
-  unsigned int idx, size, width;
+  unsigned int idx, width;
   char buf[256];
 
-  rtn = strdup("");
-  size = 1;
+  buf_reserve(out, 0);
+  out->text[out->len] = '\0';
   for  (idx = 0; idx < info->nitems; idx += 1) {
     vpiHandle item = info->items[idx];
 
@@ -895,23 +1017,26 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
       case vpiConstant:
       case vpiParameter:
         if (vpi_get(vpiConstType, item) == vpiStringConst) {
-          value.format = vpiStringVal;
-          vpi_get_value(item, &value);
-          fmt = strdup(value.value.str);
-          width = get_format(&result, fmt, info, &idx);
-          free(fmt);
+          if (info->formats && info->formats[idx]) {
+            run_format(out, info->formats[idx], info, &idx);
+          } else {
+            struct format_prog *prog;
+            value.format = vpiStringVal;
+            vpi_get_value(item, &value);
+            prog = compile_format(value.value.str);
+            run_format(out, prog, info, &idx);
+            free_format(prog);
+          }
         } else if (vpi_get(vpiConstType, item) == vpiRealConst) {
           value.format = vpiRealVal;
           vpi_get_value(item, &value);
           sprintf(buf, "%#g", value.value.real);
-          result = strdup(buf);
-          width = strlen(result);
+          buf_append(out, buf, strlen(buf));
         } else {
           width = get_numeric(&result, info, item);
+          buf_append(out, result, width);
+          free(result);
         }
-        rtn = realloc(rtn, (size+width)*sizeof(char));
-        memcpy(rtn+size-1, result, width);
-        free(result);
         break;
 
       case vpiNet:
@@ -920,8 +1045,7 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
       case vpiMemoryWord:
       case vpiPartSelect:
         width = get_numeric(&result, info, item);
-        rtn = realloc(rtn, (size+width)*sizeof(char));
-        memcpy(rtn+size-1, result, width);
+        buf_append(out, result, width);
         free(result);
         break;
 
@@ -935,8 +1059,9 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
                  vpi_get(vpiTimeUnit, info->scope));
         width = strlen(buf);
         if (width  < timeformat_info.width) width = timeformat_info.width;
-        rtn = realloc(rtn, (size+width)*sizeof(char));
-        sprintf(rtn+size-1, "%*s", width, buf);
+        cp = buf_reserve(out, width);
+        sprintf(cp, "%*s", width, buf);
+        out->len += width;
         break;
 
       /* Realtime variables are also processed here. */
@@ -944,9 +1069,7 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
         value.format = vpiRealVal;
         vpi_get_value(item, &value);
         sprintf(buf, "%#g", value.value.real);
-        width = strlen(buf);
-        rtn = realloc(rtn, (size+width)*sizeof(char));
-        memcpy(rtn+size-1, buf, width);
+        buf_append(out, buf, strlen(buf));
         break;
 
       case vpiSysFuncCall:
@@ -956,24 +1079,27 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
           vpi_get_value(item, &value);
           width = strlen(value.value.str);
           if (width  < 20) width = 20;
-          rtn = realloc(rtn, (size+width)*sizeof(char));
-          sprintf(rtn+size-1, "%*s", width, value.value.str);
+          cp = buf_reserve(out, width);
+          sprintf(cp, "%*s", width, value.value.str);
+          out->len += width;
 
         } else if (strcmp(func_name, "$stime") == 0) {
           value.format = vpiDecStrVal;
           vpi_get_value(item, &value);
           width = strlen(value.value.str);
           if (width  < 10) width = 10;
-          rtn = realloc(rtn, (size+width)*sizeof(char));
-          sprintf(rtn+size-1, "%*s", width, value.value.str);
+          cp = buf_reserve(out, width);
+          sprintf(cp, "%*s", width, value.value.str);
+          out->len += width;
 
         } else if (strcmp(func_name, "$simtime") == 0) {
           value.format = vpiDecStrVal;
           vpi_get_value(item, &value);
           width = strlen(value.value.str);
           if (width  < 20) width = 20;
-          rtn = realloc(rtn, (size+width)*sizeof(char));
-          sprintf(rtn+size-1, "%*s", width, value.value.str);
+          cp = buf_reserve(out, width);
+          sprintf(cp, "%*s", width, value.value.str);
+          out->len += width;
 
         } else if (strcmp(func_name, "$realtime") == 0) {
           /* Use the local scope precision. */
@@ -983,17 +1109,13 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
           value.format = vpiRealVal;
           vpi_get_value(item, &value);
           sprintf(buf, "%.*f", use_prec, value.value.real);
-          width = strlen(buf);
-          rtn = realloc(rtn, (size+width)*sizeof(char));
-          sprintf(rtn+size-1, "%*s", width, buf);
+          buf_append(out, buf, strlen(buf));
 
         } else {
           vpi_printf("WARNING: %s:%d: %s does not support %s as an argument!\n",
                      info->filename, info->lineno, info->name, func_name);
           strcpy(buf, "<?>");
-          width = strlen(buf);
-          rtn = realloc(rtn, (size+width)*sizeof(char));
-          memcpy(rtn+size-1, buf, width);
+          buf_append(out, buf, strlen(buf));
         }
         break;
 
@@ -1002,16 +1124,37 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
                    info->filename, info->lineno, vpi_get_str(vpiType, item),
                    info->name);
         cresult = "<?>";
-        width = strlen(cresult);
-        rtn = realloc(rtn, (size+width)*sizeof(char));
-        memcpy(rtn+size-1, cresult, width);
+        buf_append(out, cresult, strlen(cresult));
         break;
     }
-    size += width;
   }
-  rtn[size-1] = '\0';
-  *rtnsz = size - 1;
-  return rtn;
+}
+
+/* Return the display result in a new buffer that the caller must
+ * free. Because %u and %z may put embedded NULL characters into the
+ * returned string strlen() may not match the real size! */
+static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
+{
+  struct display_buf out = { 0, 0, 0 };
+
+  render_display(&out, info);
+  *rtnsz = out.len;
+  return out.text;
+}
+
+/*
+ * Render the display result and write it to the fd/mcd in one block.
+ * The result buffer is reused by all the calls.
+ */
+static void emit_display(PLI_UINT32 fd_mcd, const struct strobe_cb_info *info,
+                         int newline)
+{
+  static struct display_buf out = { 0, 0, 0 };
+
+  out.len = 0;
+  render_display(&out, info);
+  if (newline) buf_append(&out, "\n", 1);
+  vpip_mcd_write(fd_mcd, out.text, out.len);
 }
 
 static int sys_check_args(vpiHandle callh, vpiHandle argv, const PLI_BYTE8*name,
@@ -1107,83 +1250,91 @@ static PLI_INT32 sys_common_compiletf(ICARUS_VPI_CONST PLI_BYTE8*name, int no_au
       return 0;
 }
 
+/*
+ * Each $display/$write based call site keeps its argument handles and
+ * the format programs for its format strings in the systf user data,
+ * so that the calltf does not need to iterate the arguments or parse
+ * the formats again. The fd is the file descriptor/MCD argument of
+ * the $f versions.
+ */
+struct display_site {
+      struct strobe_cb_info info;
+      vpiHandle fd;
+};
+
+static struct display_site*get_display_site(vpiHandle callh,
+                                            ICARUS_VPI_CONST PLI_BYTE8*name)
+{
+      struct display_site*site = vpi_get_userdata(callh);
+      vpiHandle argv;
+
+      if (site) return site;
+
+      argv = vpi_iterate(vpiArgument, callh);
+      site = calloc(1, sizeof(struct display_site));
+      if (name[1] == 'f' && argv) site->fd = vpi_scan(argv);
+	/* We could use vpi_get_str(vpiName, callh) to get the task name,
+	 * but name is already defined. */
+      site->info.name = name;
+      site->info.filename = strdup(vpi_get_str(vpiFile, callh));
+      site->info.lineno = (int)vpi_get(vpiLineNo, callh);
+      site->info.default_format = get_default_format(name);
+      site->info.scope = vpi_handle(vpiScope, callh);
+      assert(site->info.scope);
+      array_from_iterator(&site->info, argv);
+      compile_formats(&site->info);
+
+      vpi_put_userdata(callh, site);
+      return site;
+}
+
 /* Check the $display, $write, $fdisplay and $fwrite based tasks. */
 static PLI_INT32 sys_display_compiletf(ICARUS_VPI_CONST PLI_BYTE8*name)
 {
+      PLI_INT32 rc;
+
 	/* These tasks can have automatic variables and are not monitor. */
-      return sys_common_compiletf(name, 0, 0);
+      rc = sys_common_compiletf(name, 0, 0);
+      get_display_site(vpi_handle(vpiSysTfCall, 0), name);
+      return rc;
 }
 
 /* This implements the $display/$fdisplay and the $write/$fwrite based tasks. */
 static PLI_INT32 sys_display_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
 {
-      vpiHandle callh, argv, scope;
-      struct strobe_cb_info info;
-      char* result;
-      unsigned int size, location=0;
+      vpiHandle callh;
+      struct display_site*site;
       PLI_UINT32 fd_mcd;
 
       callh = vpi_handle(vpiSysTfCall, 0);
-      argv = vpi_iterate(vpiArgument, callh);
+      site = get_display_site(callh, name);
 
 	/* Get the file/MC descriptor and verify it is valid. */
       if(name[1] == 'f') {
 	      errno = 0;
-	      vpiHandle arg = vpi_scan(argv);
 	      s_vpi_value val;
 	      val.format = vpiIntVal;
-	      vpi_get_value(arg, &val);
+	      vpi_get_value(site->fd, &val);
 	      fd_mcd = val.value.integer;
 
 		/* If the MCD is zero we have nothing to do so just return. */
-	      if (fd_mcd == 0)  {
-		    vpi_free_object(argv);
-		    return 0;
-	      }
+	      if (fd_mcd == 0) return 0;
 
-	      if ((! IS_MCD(fd_mcd) && vpi_get_file(fd_mcd) == NULL) ||
-	          ( IS_MCD(fd_mcd) && my_mcd_printf(fd_mcd, "") == EOF)) {
-		    vpi_printf("WARNING: %s:%d: ", vpi_get_str(vpiFile, callh),
-		               (int)vpi_get(vpiLineNo, callh));
+	      if (! is_valid_fd_mcd(fd_mcd)) {
+		    vpi_printf("WARNING: %s:%d: ", site->info.filename,
+		               site->info.lineno);
 		    vpi_printf("invalid file descriptor/MCD (0x%x) given "
 		               "to %s.\n", (unsigned int)fd_mcd, name);
 		    errno = EBADF;
-		    vpi_free_object(argv);
 		    return 0;
 	      }
       } else {
 	      fd_mcd = 1;
       }
 
-      scope = vpi_handle(vpiScope, callh);
-      assert(scope);
-	/* We could use vpi_get_str(vpiName, callh) to get the task name,
-	 * but name is already defined. */
-      info.name = name;
-      info.filename = strdup(vpi_get_str(vpiFile, callh));
-      info.lineno = (int)vpi_get(vpiLineNo, callh);
-      info.default_format = get_default_format(name);
-      info.scope = scope;
-      array_from_iterator(&info, argv);
-
-	/* Because %u and %z may put embedded NULL characters into the
-	 * returned string strlen() may not match the real size! */
-      result = get_display(&size, &info);
-      while (location < size) {
-	    if (result[location] == '\0') {
-		  my_mcd_printf(fd_mcd, "%c", '\0');
-		  location += 1;
-	    } else {
-		  my_mcd_printf(fd_mcd, "%s", &result[location]);
-		  location += strlen(&result[location]);
-	    }
-      }
-      if ((strncmp(name,"$display",8) == 0) ||
-          (strncmp(name,"$fdisplay",9) == 0)) my_mcd_printf(fd_mcd, "\n");
-
-      free(info.filename);
-      free(info.items);
-      free(result);
+      emit_display(fd_mcd, &site->info,
+                   (strncmp(name,"$display",8) == 0) ||
+                   (strncmp(name,"$fdisplay",9) == 0));
       return 0;
 }
 
@@ -1201,24 +1352,8 @@ static PLI_INT32 strobe_cb(p_cb_data cb)
 	/* We really need to cancel any $fstrobe() calls for a file when it
 	 * is closed, but for now we will just skip processing the result.
 	 * Which has the same basic effect. */
-      if ((! IS_MCD(info->fd_mcd) && vpi_get_file(info->fd_mcd) != NULL) ||
-          ( IS_MCD(info->fd_mcd) && my_mcd_printf(info->fd_mcd, "") != EOF)) {
-	    char* result = NULL;
-	    unsigned int size, location=0;
-	      /* Because %u and %z may put embedded NULL characters into the
-	       * returned string strlen() may not match the real size! */
-	    result = get_display(&size, info);
-	    while (location < size) {
-		  if (result[location] == '\0') {
-			my_mcd_printf(info->fd_mcd, "%c", '\0');
-			location += 1;
-		  } else {
-			my_mcd_printf(info->fd_mcd, "%s", &result[location]);
-			location += strlen(&result[location]);
-		  }
-	    }
-	    my_mcd_printf(info->fd_mcd, "\n");
-	    free(result);
+      if (is_valid_fd_mcd(info->fd_mcd)) {
+	    emit_display(info->fd_mcd, info, 1);
       }
 
       free(info->filename);
@@ -1261,8 +1396,7 @@ static PLI_INT32 sys_strobe_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 		    return 0;
 	      }
 
-	      if ((! IS_MCD(fd_mcd) && vpi_get_file(fd_mcd) == NULL) ||
-	          ( IS_MCD(fd_mcd) && my_mcd_printf(fd_mcd, "") == EOF))  {
+	      if (! is_valid_fd_mcd(fd_mcd)) {
 		    vpi_printf("WARNING: %s:%d: ", vpi_get_str(vpiFile, callh),
 		               (int)vpi_get(vpiLineNo, callh));
 		    vpi_printf("invalid file descriptor/MCD (0x%x) given "
@@ -1311,31 +1445,15 @@ static PLI_INT32 sys_strobe_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
  * though that monitor may be watching many variables).
  */
 
-static struct strobe_cb_info monitor_info = { 0, 0, 0, 0, 0, 0, 0, 0 };
+static struct strobe_cb_info monitor_info = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 static vpiHandle *monitor_callbacks = 0;
 static int monitor_scheduled = 0;
 static int monitor_enabled = 1;
 
 static PLI_INT32 monitor_cb_2(p_cb_data cb)
 {
-      char* result;
-      unsigned int size, location=0;
-
-	/* Because %u and %z may put embedded NULL characters into the
-	 * returned string strlen() may not match the real size! */
-      result = get_display(&size, &monitor_info);
-      while (location < size) {
-	    if (result[location] == '\0') {
-		  my_mcd_printf(monitor_info.fd_mcd, "%c", '\0');
-		  location += 1;
-	    } else {
-		  my_mcd_printf(monitor_info.fd_mcd, "%s", &result[location]);
-		  location += strlen(&result[location]);
-	    }
-      }
-      my_mcd_printf(monitor_info.fd_mcd, "\n");
+      emit_display(monitor_info.fd_mcd, &monitor_info, 1);
       monitor_scheduled = 0;
-      free(result);
       return 0;
 }
 
@@ -1401,6 +1519,7 @@ static PLI_INT32 sys_monitor_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 	    monitor_callbacks = 0;
 
 	    free(monitor_info.filename);
+	    free_formats(&monitor_info);
 	    free(monitor_info.items);
 	    monitor_info.items = 0;
 	    monitor_info.nitems = 0;
@@ -1417,6 +1536,9 @@ static PLI_INT32 sys_monitor_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       monitor_info.default_format = get_default_format(name);
       monitor_info.scope = scope;
       monitor_info.fd_mcd = 1;
+	/* The monitor is displayed many times, so parse the formats
+	   only once. */
+      compile_formats(&monitor_info);
 
 	/* Attach callbacks to all the parameters that might change. */
       monitor_callbacks = calloc(monitor_info.nitems, sizeof(vpiHandle));
@@ -1521,6 +1643,7 @@ static PLI_INT32 sys_swrite_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
   info.lineno = (int)vpi_get(vpiLineNo, callh);
   info.default_format = get_default_format(name);
   info.scope = scope;
+  info.formats = 0;
   array_from_iterator(&info, argv);
 
   /* Because %u and %z may put embedded NULL characters into the returned
@@ -1592,6 +1715,8 @@ static PLI_INT32 sys_sformat_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
 {
   vpiHandle callh, argv, reg, scope;
   struct strobe_cb_info info;
+  struct display_buf out = { 0, 0, 0 };
+  struct format_prog *prog;
   s_vpi_value val;
   char *result, *fmt;
   unsigned int idx, size;
@@ -1612,10 +1737,16 @@ static PLI_INT32 sys_sformat_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
   info.lineno = (int)vpi_get(vpiLineNo, callh);
   info.default_format = get_default_format(name);
   info.scope = scope;
+  info.formats = 0;
   array_from_iterator(&info, argv);
   idx = -1;
-  size = get_format(&result, fmt, &info, &idx);
+  prog = compile_format(fmt);
+  run_format(&out, prog, &info, &idx);
+  free_format(prog);
   free(fmt);
+  buf_append(&out, "", 0);
+  result = out.text;
+  size = out.len;
 
   if (idx+1< info.nitems) {
     vpi_printf("WARNING: %s:%d: %s has %d extra argument(s).\n",
@@ -1888,8 +2019,7 @@ static PLI_INT32 sys_severity_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       struct strobe_cb_info info;
       struct t_vpi_time now;
       PLI_UINT64 now64;
-      char *sstr, *t, *dstr;
-      unsigned int size, location=0;
+      char *sstr, *t;
       s_vpi_value finish_number;
 
       /* Set the default finish number for $fatal. */
@@ -1922,20 +2052,11 @@ static PLI_INT32 sys_severity_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       info.lineno = (int)vpi_get(vpiLineNo, callh);
       info.default_format = vpiDecStrVal;
       info.scope = scope;
+      info.formats = 0;
       array_from_iterator(&info, argv);
 
       vpi_printf("%s: %s:%d: ", sstr, info.filename, info.lineno);
-
-      dstr = get_display(&size, &info);
-      while (location < size) {
-	    if (dstr[location] == '\0') {
-		  my_mcd_printf(1, "%c", '\0');
-		  location += 1;
-	    } else {
-		  my_mcd_printf(1, "%s", &dstr[location]);
-		  location += strlen(&dstr[location]);
-	    }
-      }
+      emit_display(1, &info, 0);
 
       now.type = vpiSimTime;
       vpi_get_time(0, &now);
@@ -1948,7 +2069,6 @@ static PLI_INT32 sys_severity_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       free(--sstr);  /* Get the $ back. */
       free(info.filename);
       free(info.items);
-      free(dstr);
 
       if (strncmp(name,"$fatal",6) == 0) {
             vpi_control(vpiFinish, finish_number.value.integer);
@@ -1963,6 +2083,7 @@ static PLI_INT32 sys_end_of_simulation(p_cb_data cb_data)
       free(monitor_callbacks);
       monitor_callbacks = 0;
       free(monitor_info.filename);
+      free_formats(&monitor_info);
       free(monitor_info.items);
       monitor_info.items = 0;
       monitor_info.nitems = 0;
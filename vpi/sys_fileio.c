@@ -223,9 +223,9 @@ static PLI_INT32 sys_fclose_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       vpi_get_value(fd, &val);
       fd_mcd = val.value.integer;
 
-      if ((! IS_MCD(fd_mcd) && vpi_get_file(fd_mcd) == NULL) ||
-          ( IS_MCD(fd_mcd) && vpi_mcd_printf(fd_mcd, "%s", "") == EOF) ||
-          (! fd_mcd)) {
+	/* Writing nothing checks the descriptor without waiting for
+	 * the output that is queued for the file (vvp -a). */
+      if ((! fd_mcd) || vpip_mcd_write(fd_mcd, "", 0) == EOF) {
 	    vpi_printf("WARNING: %s:%d: ", vpi_get_str(vpiFile, callh),
 	               (int)vpi_get(vpiLineNo, callh));
 	    vpi_printf("invalid file descriptor/MCD (0x%x) given to %s.\n",
@@ -252,12 +252,11 @@ static PLI_INT32 sys_fflush_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       vpiHandle arg;
       s_vpi_value val;
       PLI_UINT32 fd_mcd;
-      FILE *fp;
       errno = 0;
 
 	/* If we have no argument then flush all the streams. */
       if (argv == 0) {
-	    fflush(NULL);
+	    vpip_mcd_flush_all();
 	    return 0;
       }
 
@@ -271,9 +270,9 @@ static PLI_INT32 sys_fflush_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 	/* If the MCD is zero we have nothing to do so just return. */
       if (fd_mcd == 0) return 0;
 
-      if ((! IS_MCD(fd_mcd) && vpi_get_file(fd_mcd) == NULL) ||
-          ( IS_MCD(fd_mcd) && vpi_mcd_printf(fd_mcd, "%s", "") == EOF) ||
-          (! fd_mcd)) {
+	/* Writing nothing checks the descriptor without waiting for
+	 * the output that is queued for the file (vvp -a). */
+      if ((! fd_mcd) || vpip_mcd_write(fd_mcd, "", 0) == EOF) {
 	    vpi_printf("WARNING: %s:%d: ", vpi_get_str(vpiFile, callh),
 	               (int)vpi_get(vpiLineNo, callh));
 	    vpi_printf("invalid file descriptor/MCD (0x%x) given to %s.\n",
@@ -282,13 +281,7 @@ static PLI_INT32 sys_fflush_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 	    return 0;
       }
 
-      if (IS_MCD(fd_mcd)) {
-	    vpi_mcd_flush(fd_mcd);
-      } else {
-	      /* If we have a valid file descriptor flush the file. */
-	    fp = vpi_get_file(fd_mcd);
-	    if (fp) fflush(fp);
-      }
+      vpi_mcd_flush(fd_mcd);
 
       return 0;
 }
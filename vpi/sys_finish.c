@@ -18,6 +18,7 @@
  */
 
 #include "sys_priv.h"
+#include <stdlib.h>
 #include <string.h>
 
 static PLI_INT32 sys_finish_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
@@ -46,6 +47,30 @@ static PLI_INT32 sys_finish_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
       return 0;
 }
 
+/*
+ * $save and $restart only pass the file name to the run time, which
+ * writes or reads the checkpoint at the end of the current time step.
+ */
+static PLI_INT32 sys_save_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
+{
+      vpiHandle callh = vpi_handle(vpiSysTfCall, 0);
+      vpiHandle argv = vpi_iterate(vpiArgument, callh);
+      char *fname;
+
+      fname = get_filename(callh, name, vpi_scan(argv));
+      vpi_free_object(argv);
+      if (fname == 0) return 0;
+
+      if (strcmp((const char*)name, "$restart") == 0) {
+	    vpi_control(vpiRestartCheckpoint, fname);
+      } else {
+	    vpi_control(vpiSaveCheckpoint, fname);
+      }
+
+      free(fname);
+      return 0;
+}
+
 void sys_finish_register()
 {
       s_vpi_systf_data tf_data;
@@ -68,4 +93,22 @@ void sys_finish_register()
       tf_data.user_data = "$stop";
       res = vpi_register_systf(&tf_data);
       vpip_make_systf_system_defined(res);
+
+      tf_data.type      = vpiSysTask;
+      tf_data.tfname    = "$save";
+      tf_data.calltf    = sys_save_calltf;
+      tf_data.compiletf = sys_one_string_arg_compiletf;
+      tf_data.sizetf    = 0;
+      tf_data.user_data = "$save";
+      res = vpi_register_systf(&tf_data);
+      vpip_make_systf_system_defined(res);
+
+      tf_data.type      = vpiSysTask;
+      tf_data.tfname    = "$restart";
+      tf_data.calltf    = sys_save_calltf;
+      tf_data.compiletf = sys_one_string_arg_compiletf;
+      tf_data.sizetf    = 0;
+      tf_data.user_data = "$restart";
+      res = vpi_register_systf(&tf_data);
+      vpip_make_systf_system_defined(res);
 }
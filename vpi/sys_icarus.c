@@ -41,6 +41,36 @@ static PLI_INT32 finish_and_return_calltf(ICARUS_VPI_CONST PLI_BYTE8* name)
     return 0;
 }
 
+/*
+ * $ivl_fork_tests(count) forks the simulation into count children
+ * that continue from the current time with the state built up so
+ * far. It returns the index of the child (1..count) in each child,
+ * which can be used to select a test variation, and 0 in the parent
+ * once all the children are done (-1 if the fork failed).
+ */
+static PLI_INT32 fork_tests_calltf(ICARUS_VPI_CONST PLI_BYTE8* name)
+{
+    vpiHandle callh = vpi_handle(vpiSysTfCall, 0);
+    vpiHandle argv = vpi_iterate(vpiArgument, callh);
+    vpiHandle arg;
+    s_vpi_value val;
+    PLI_INT32 res;
+    (void) name;  /* Not used! */
+
+    arg = vpi_scan(argv);
+    vpi_free_object(argv);
+    val.format = vpiIntVal;
+    vpi_get_value(arg, &val);
+
+    res = vpip_fork_tests(val.value.integer);
+    if (res > 0) sys_random_fork_reseed(res);
+
+    val.format = vpiIntVal;
+    val.value.integer = res;
+    vpi_put_value(callh, &val, 0, vpiNoDelay);
+    return 0;
+}
+
 static PLI_INT32 task_not_implemented_compiletf(ICARUS_VPI_CONST PLI_BYTE8* name)
 {
       vpiHandle callh = vpi_handle(vpiSysTfCall, 0);
@@ -82,6 +112,16 @@ void sys_special_register(void)
       tf_data.tfname      = "$finish_and_return";
       tf_data.user_data   = "$finish_and_return";
       res = vpi_register_systf(&tf_data);
+      vpip_make_systf_system_defined(res);
+
+      tf_data.type        = vpiSysFunc;
+      tf_data.sysfunctype = vpiSysFuncInt;
+      tf_data.calltf      = fork_tests_calltf;
+      tf_data.compiletf   = sys_one_numeric_arg_compiletf;
+      tf_data.sizetf      = 0;
+      tf_data.tfname      = "$ivl_fork_tests";
+      tf_data.user_data   = "$ivl_fork_tests";
+      res = vpi_register_systf(&tf_data);
       vpip_make_systf_system_defined(res);
 
 	/* These tasks are not currently implemented. */
@@ -257,16 +297,6 @@ void sys_special_register(void)
       res = vpi_register_systf(&tf_data);
       vpip_make_systf_system_defined(res);
 
-      tf_data.tfname      = "$save";
-      tf_data.user_data   = "$save";
-      res = vpi_register_systf(&tf_data);
-      vpip_make_systf_system_defined(res);
-
-      tf_data.tfname      = "$restart";
-      tf_data.user_data   = "$restart";
-      res = vpi_register_systf(&tf_data);
-      vpip_make_systf_system_defined(res);
-
       tf_data.tfname      = "$incsave";
       tf_data.user_data   = "$incsave";
       res = vpi_register_systf(&tf_data);
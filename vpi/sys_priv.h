@@ -56,6 +56,9 @@ extern unsigned is_string_obj(vpiHandle obj);
 
 extern vpiHandle sys_func_module(vpiHandle obj);
 
+/* Give a forked child its own implicit $random/$urandom sequence. */
+extern void sys_random_fork_reseed(unsigned index);
+
 /*
  * The standard compiletf routines.
  */
@@ -507,11 +507,47 @@ PLI_INT32 sys_random_compiletf(ICARUS_VPI_CONST PLI_BYTE8 *name)
       return 0;
 }
 
+/*
+ * The implicit seeds of $random and $urandom are part of the state
+ * of the simulation, so they are saved in and restored from $save
+ * checkpoints.
+ */
+static long random_seed = 0;
+static long urandom_seed = 0;
+
+static PLI_INT32 sys_random_save_cb(p_cb_data cb_data)
+{
+      vpi_put_data(cb_data->index, (PLI_BYTE8*)&random_seed,
+                   sizeof random_seed);
+      vpi_put_data(cb_data->index, (PLI_BYTE8*)&urandom_seed,
+                   sizeof urandom_seed);
+      return 0;
+}
+
+static PLI_INT32 sys_random_restart_cb(p_cb_data cb_data)
+{
+      vpi_get_data(cb_data->index, (PLI_BYTE8*)&random_seed,
+                   sizeof random_seed);
+      vpi_get_data(cb_data->index, (PLI_BYTE8*)&urandom_seed,
+                   sizeof urandom_seed);
+      return 0;
+}
+
+/*
+ * Each child of $ivl_fork_tests starts from the same seeds, so move
+ * them apart by the index of the child.
+ */
+void sys_random_fork_reseed(unsigned index)
+{
+      random_seed = (long)((unsigned long)random_seed + 1000003UL*index);
+      urandom_seed = (long)((unsigned long)urandom_seed + 1000003UL*index);
+}
+
 static PLI_INT32 sys_random_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
 {
       vpiHandle callh, argv, seed = 0;
       s_vpi_value val;
-      static long i_seed = 0;
+      long i_seed = random_seed;
 
       /* Get the argument list and look for a seed. If it is there,
          get the value and reseed the random number generator. */
@@ -527,6 +563,7 @@ static PLI_INT32 sys_random_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
 
       /* Calculate and return the result. */
       val.value.integer = rtl_dist_uniform(&i_seed, INT_MIN, INT_MAX);
+      random_seed = i_seed;
       vpi_put_value(callh, &val, 0, vpiNoDelay);
 
       /* If it exists send the updated seed back to seed parameter. */
@@ -576,15 +613,14 @@ static PLI_INT32 sys_urandom_range_compiletf(ICARUS_VPI_CONST PLI_BYTE8 *name)
 /* From System Verilog 3.1a. */
 static unsigned long urandom(long *seed, unsigned long max, unsigned long min)
 {
-      static long i_seed = 0;
       unsigned long result;
       long max_i, min_i;
 
       max_i =  max + INT_MIN;
       min_i =  min + INT_MIN;
-      if (seed != 0) i_seed = *seed;
-      result = rtl_dist_uniform(&i_seed, min_i, max_i) - INT_MIN;
-      if (seed != 0) *seed = i_seed;
+      if (seed != 0) urandom_seed = *seed;
+      result = rtl_dist_uniform(&urandom_seed, min_i, max_i) - INT_MIN;
+      if (seed != 0) *seed = urandom_seed;
       return result;
 }
 
@@ -895,6 +931,7 @@ static PLI_INT32 sys_rand_func_sizetf(PLI_BYTE8 *x)
 void sys_random_register()
 {
       s_vpi_systf_data tf_data;
+      s_cb_data cb_data;
       vpiHandle res;
 
       tf_data.type = vpiSysFunc;
@@ -998,4 +1035,15 @@ void sys_random_register()
       tf_data.user_data = "$dist_erlang";
       res = vpi_register_systf(&tf_data);
       vpip_make_systf_system_defined(res);
+
+      cb_data.reason = cbStartOfSave;
+      cb_data.time = 0;
+      cb_data.cb_rtn = sys_random_save_cb;
+      cb_data.user_data = "system";
+      vpi_register_cb(&cb_data);
+
+      cb_data.reason = cbStartOfRestart;
+      cb_data.cb_rtn = sys_random_restart_cb;
+      cb_data.user_data = "system";
+      vpi_register_cb(&cb_data);
 }
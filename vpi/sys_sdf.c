@@ -19,9 +19,12 @@
 
 # include  "sys_priv.h"
 # include  "sdf_priv.h"
+# include  "stringheap.h"
 # include  <stdlib.h>
 # include  <string.h>
+# include  <time.h>
 # include  <assert.h>
+# include  "ivl_alloc.h"
 
 /*
  * These are static context
@@ -37,6 +40,235 @@ static vpiHandle sdf_callh = 0;
   /* The cell in process. */
 static vpiHandle sdf_cur_cell;
 
+  /* Annotation statistics reported with -sdf-info. */
+static unsigned long sdf_cell_count;
+static unsigned long sdf_path_count;
+
+/*
+ * The instance index maps the hierarchical name of every module below
+ * sdf_scope (relative to sdf_scope, using '.' as the separator) to
+ * its scope handle. It is built on the first CELL of an annotation so
+ * that each CELL is a single hash lookup instead of a walk of
+ * vpi_iterate(vpiModule) at every level of its path.
+ */
+struct sdf_inst_s {
+      const char*path;
+      vpiHandle scope;
+      unsigned next;
+};
+
+static struct sdf_inst_s*sdf_inst_list = 0;
+static unsigned sdf_inst_count = 0;
+static unsigned sdf_inst_alloc = 0;
+static unsigned*sdf_inst_hash = 0;
+static unsigned sdf_inst_hash_mask = 0;
+static int sdf_inst_ready = 0;
+static struct stringheap_s sdf_name_heap = {0, 0};
+
+  /* This is the maximum hierarchical path that is indexed. Deeper
+     instances are found by walking the scopes. */
+# define SDF_PATH_MAX 4096
+
+static unsigned sdf_hash_str(const char*str)
+{
+      unsigned hash = 2166136261U;
+      while (*str) {
+	    hash ^= (unsigned char) *str++;
+	    hash *= 16777619U;
+      }
+      return hash;
+}
+
+static void index_scope(vpiHandle scope, char*path, unsigned len)
+{
+      vpiHandle iter = vpi_iterate(vpiModule, scope);
+      vpiHandle cur;
+
+      if (iter == 0) return;
+
+      while ( (cur = vpi_scan(iter)) ) {
+	    const char*name = vpi_get_str(vpiName, cur);
+	    unsigned nlen = strlen(name);
+	    unsigned use = len;
+
+	    if (len + nlen + 2 > SDF_PATH_MAX) continue;
+	    if (len > 0) path[use++] = '.';
+	    strcpy(path+use, name);
+
+	    if (sdf_inst_count == sdf_inst_alloc) {
+		  sdf_inst_alloc = sdf_inst_alloc ? 2*sdf_inst_alloc : 256;
+		  sdf_inst_list = realloc(sdf_inst_list, sdf_inst_alloc *
+		                          sizeof(struct sdf_inst_s));
+	    }
+	    sdf_inst_list[sdf_inst_count].path =
+		  strdup_sh(&sdf_name_heap, path);
+	    sdf_inst_list[sdf_inst_count].scope = cur;
+	    sdf_inst_count += 1;
+
+	    index_scope(cur, path, use + nlen);
+      }
+}
+
+static void build_instance_index(void)
+{
+      char path[SDF_PATH_MAX];
+      unsigned size = 1, idx;
+
+      path[0] = 0;
+      index_scope(sdf_scope, path, 0);
+
+      while (size < 2*sdf_inst_count) size <<= 1;
+      sdf_inst_hash = calloc(size, sizeof(unsigned));
+      sdf_inst_hash_mask = size - 1;
+
+	/* Link the entries in reverse so that the first instance
+	   found with a given name is the first one in its chain, as
+	   the scope walk would have found it. */
+      for (idx = sdf_inst_count ; idx > 0 ; idx -= 1) {
+	    struct sdf_inst_s*cur = sdf_inst_list + idx - 1;
+	    unsigned bucket = sdf_hash_str(cur->path) & sdf_inst_hash_mask;
+	    cur->next = sdf_inst_hash[bucket];
+	    sdf_inst_hash[bucket] = idx;
+      }
+
+      sdf_inst_ready = 1;
+}
+
+static vpiHandle find_indexed_instance(const char*path)
+{
+      unsigned idx;
+
+      if (! sdf_inst_ready) build_instance_index();
+
+      idx = sdf_inst_hash[sdf_hash_str(path) & sdf_inst_hash_mask];
+      while (idx) {
+	    struct sdf_inst_s*cur = sdf_inst_list + idx - 1;
+	    if (strcmp(cur->path, path) == 0) return cur->scope;
+	    idx = cur->next;
+      }
+
+      return 0;
+}
+
+/*
+ * The modpaths of all the instances of a module definition are the
+ * same, so the names and edges of the paths are gathered once per
+ * cell type into a template. An instance only needs to collect its
+ * vpiModPath handles, which are in the same order as the template.
+ */
+struct sdf_path_s {
+      int edge;
+      const char*src;
+      const char*dst;
+};
+
+struct sdf_celltype_s {
+      struct sdf_celltype_s*next;
+      const char*name;
+      unsigned npaths;
+      struct sdf_path_s*paths;
+};
+
+# define SDF_CELLTYPE_HASH 256
+static struct sdf_celltype_s*sdf_celltype_hash[SDF_CELLTYPE_HASH];
+
+  /* The template and modpath handles of the cell in process. The
+     template is loaded by the first IOPATH of the cell. */
+static struct sdf_celltype_s*sdf_cur_type;
+static vpiHandle*sdf_cur_paths = 0;
+static unsigned sdf_cur_paths_alloc = 0;
+
+static struct sdf_celltype_s*find_celltype(const char*name, unsigned npaths)
+{
+      unsigned bucket = sdf_hash_str(name) % SDF_CELLTYPE_HASH;
+      struct sdf_celltype_s*cur;
+      unsigned idx;
+
+      for (cur = sdf_celltype_hash[bucket] ; cur ; cur = cur->next) {
+	    if (cur->npaths == npaths && strcmp(cur->name, name) == 0)
+		  return cur;
+      }
+
+	/* This is the first instance of this cell type, so get the
+	   path details from its modpath objects. */
+      cur = malloc(sizeof(struct sdf_celltype_s));
+      cur->name = strdup_sh(&sdf_name_heap, name);
+      cur->npaths = npaths;
+      cur->paths = malloc(npaths * sizeof(struct sdf_path_s));
+      for (idx = 0 ; idx < npaths ; idx += 1) {
+	    vpiHandle path = sdf_cur_paths[idx];
+	    vpiHandle path_t_in = vpi_handle(vpiModPathIn,path);
+	    vpiHandle path_t_out = vpi_handle(vpiModPathOut,path);
+
+	    vpiHandle path_in = vpi_handle(vpiExpr,path_t_in);
+	    vpiHandle path_out = vpi_handle(vpiExpr,path_t_out);
+
+	      /* The expressions for the path terms must be signals,
+	         vpiNet or vpiReg. */
+	    assert(vpi_get(vpiType,path_in) == vpiNet);
+	    assert(vpi_get(vpiType,path_out) == vpiNet
+		   || vpi_get(vpiType,path_out) == vpiReg);
+
+	    cur->paths[idx].edge = vpi_get(vpiEdge,path_t_in);
+	    cur->paths[idx].src = strdup_sh(&sdf_name_heap,
+	                                    vpi_get_str(vpiName,path_in));
+	    cur->paths[idx].dst = strdup_sh(&sdf_name_heap,
+	                                    vpi_get_str(vpiName,path_out));
+      }
+
+      cur->next = sdf_celltype_hash[bucket];
+      sdf_celltype_hash[bucket] = cur;
+      return cur;
+}
+
+static void load_cell_paths(void)
+{
+      vpiHandle iter = vpi_iterate(vpiModPath, sdf_cur_cell);
+      vpiHandle path;
+      unsigned npaths = 0;
+
+      if (iter) while ( (path = vpi_scan(iter)) ) {
+	    if (npaths == sdf_cur_paths_alloc) {
+		  sdf_cur_paths_alloc = sdf_cur_paths_alloc ?
+		                        2*sdf_cur_paths_alloc : 16;
+		  sdf_cur_paths = realloc(sdf_cur_paths, sdf_cur_paths_alloc *
+		                          sizeof(vpiHandle));
+	    }
+	    sdf_cur_paths[npaths++] = path;
+      }
+
+      sdf_cur_type = find_celltype(vpi_get_str(vpiDefName, sdf_cur_cell),
+                                   npaths);
+}
+
+static void sdf_annotate_cleanup(void)
+{
+      unsigned idx;
+
+      for (idx = 0 ; idx < SDF_CELLTYPE_HASH ; idx += 1) {
+	    while (sdf_celltype_hash[idx]) {
+		  struct sdf_celltype_s*cur = sdf_celltype_hash[idx];
+		  sdf_celltype_hash[idx] = cur->next;
+		  free(cur->paths);
+		  free(cur);
+	    }
+      }
+      free(sdf_cur_paths);
+      sdf_cur_paths = 0;
+      sdf_cur_paths_alloc = 0;
+      sdf_cur_type = 0;
+
+      free(sdf_inst_list);
+      free(sdf_inst_hash);
+      sdf_inst_list = 0;
+      sdf_inst_hash = 0;
+      sdf_inst_count = 0;
+      sdf_inst_alloc = 0;
+      sdf_inst_ready = 0;
+
+      string_heap_delete(&sdf_name_heap);
+}
+
 static vpiHandle find_scope(vpiHandle scope, const char*name)
 {
       vpiHandle idx = vpi_iterate(vpiModule, scope);
@@ -57,13 +289,14 @@ static vpiHandle find_scope(vpiHandle scope, const char*name)
 }
 
 /*
- * These functions are called by the SDF parser during parsing to
- * handling items discovered in the parse.
+ * Find the cell by following the hierarchical parts of the cellinst
+ * name one scope at a time. This is only used for names that are not
+ * in the instance index, and it reports where the path breaks.
  */
-
-void sdf_select_instance(const char*celltype, const char*cellinst)
+static vpiHandle walk_to_instance(const char*cellinst)
 {
       char buffer[128];
+      vpiHandle cell;
 
 	/* First follow the hierarchical parts of the cellinst name to
 	   get to the cell that I'm looking for. */
@@ -94,17 +327,39 @@ void sdf_select_instance(const char*celltype, const char*cellinst)
 
 	/* Now find the cell. */
       if (src[0] == 0)
-	    sdf_cur_cell = sdf_scope;
+	    cell = sdf_scope;
       else
-	    sdf_cur_cell = find_scope(scope, src);
-      if (sdf_cur_cell == 0) {
+	    cell = find_scope(scope, src);
+      if (cell == 0) {
 	    vpi_printf("SDF WARNING: %s:%d: ", vpi_get_str(vpiFile, sdf_callh),
 	               (int)vpi_get(vpiLineNo, sdf_callh));
 	    vpi_printf("Unable to find %s in scope %s.\n",
 		       cellinst, vpi_get_str(vpiFullName, scope));
-	    return;
       }
 
+      return cell;
+}
+
+/*
+ * These functions are called by the SDF parser during parsing to
+ * handling items discovered in the parse.
+ */
+
+void sdf_select_instance(const char*celltype, const char*cellinst)
+{
+      sdf_cur_type = 0;
+
+	/* Most instances are found with the index. */
+      sdf_cur_cell = 0;
+      if (cellinst[0] != 0)
+	    sdf_cur_cell = find_indexed_instance(cellinst);
+      if (sdf_cur_cell == 0)
+	    sdf_cur_cell = walk_to_instance(cellinst);
+      if (sdf_cur_cell == 0)
+	    return;
+
+      sdf_cell_count += 1;
+
 	/* The scope that matches should be a module. */
       if (vpi_get(vpiType,sdf_cur_cell) != vpiModule) {
 	    vpi_printf("SDF WARNING: %s:%d: ", vpi_get_str(vpiFile, sdf_callh),
@@ -138,46 +393,37 @@ static const char*edge_str(int vpi_edge)
 void sdf_iopath_delays(int vpi_edge, const char*src, const char*dst,
 		       const struct sdf_delval_list_s*delval_list)
 {
-      vpiHandle iter, path;
+      unsigned pidx;
       int match_count = 0;
 
       if (sdf_cur_cell == 0)
 	    return;
 
-      iter = vpi_iterate(vpiModPath, sdf_cur_cell);
+      if (sdf_cur_type == 0)
+	    load_cell_paths();
 
 	/* Search for the modpath that matches the IOPATH by looking
 	   for the modpath that uses the same ports as the ports that
 	   the parser has found. */
-      if (iter) while ( (path = vpi_scan(iter)) ) {
+      for (pidx = 0 ; pidx < sdf_cur_type->npaths ; pidx += 1) {
+	    const struct sdf_path_s*cur = sdf_cur_type->paths + pidx;
+	    vpiHandle path = sdf_cur_paths[pidx];
 	    s_vpi_delay delays;
 	    struct t_vpi_time delay_vals[12];
 	    int idx;
 
-	    vpiHandle path_t_in = vpi_handle(vpiModPathIn,path);
-	    vpiHandle path_t_out = vpi_handle(vpiModPathOut,path);
-
-	    vpiHandle path_in = vpi_handle(vpiExpr,path_t_in);
-	    vpiHandle path_out = vpi_handle(vpiExpr,path_t_out);
-
-	      /* The expressions for the path terms must be signals,
-	         vpiNet or vpiReg. */
-	    assert(vpi_get(vpiType,path_in) == vpiNet);
-	    assert(vpi_get(vpiType,path_out) == vpiNet
-		   || vpi_get(vpiType,path_out) == vpiReg);
-
 	      /* If the src name doesn't match, go on. */
-	    if (strcmp(src,vpi_get_str(vpiName,path_in)) != 0)
+	    if (strcmp(src,cur->src) != 0)
 		  continue;
 	      /* The edge type must match too. But note that if this
 	         IOPATH has no edge, then it matches with all edges of
 	         the modpath object. */
 /* --> Is this correct in the context of the 10, 01, etc. edges? */
-	    if (vpi_edge != vpiNoEdge && vpi_get(vpiEdge,path_t_in) != vpi_edge)
+	    if (vpi_edge != vpiNoEdge && cur->edge != vpi_edge)
 		  continue;
 
 	      /* If the dst name doesn't match, go on. */
-	    if (strcmp(dst,vpi_get_str(vpiName,path_out)) != 0)
+	    if (strcmp(dst,cur->dst) != 0)
 		  continue;
 
 	      /* Ah, this must be a match! */
@@ -199,6 +445,7 @@ void sdf_iopath_delays(int vpi_edge, const char*src, const char*dst,
 	    vpi_put_delays(path, &delays);
 	    match_count += 1;
       }
+      sdf_path_count += match_count;
 
       if (match_count == 0) {
 	    vpi_printf("SDF WARNING: %s:%d: ", vpi_get_str(vpiFile, sdf_callh),
@@ -287,6 +534,7 @@ static PLI_INT32 sys_sdf_annotate_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       vpiHandle callh = vpi_handle(vpiSysTfCall, 0);
       vpiHandle argv = vpi_iterate(vpiArgument, callh);
       FILE *sdf_fd;
+      clock_t start;
       char *fname = get_filename(callh, name, vpi_scan(argv));
 
       if (fname == 0) return 0;
@@ -309,10 +557,21 @@ static PLI_INT32 sys_sdf_annotate_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       sdf_min_typ_max = vpi_get(_vpiDelaySelection, 0);
 
       sdf_cur_cell = 0;
+      sdf_cell_count = 0;
+      sdf_path_count = 0;
       sdf_callh = callh;
+      start = clock();
       sdf_process_file(sdf_fd, fname);
+      sdf_annotate_cleanup();
       sdf_callh = 0;
 
+      if (sdf_flag_inform) {
+	    vpi_printf("%s:SDF INFO: Annotated %lu paths in %lu cells "
+	               "in %.3f seconds.\n", fname, sdf_path_count,
+	               sdf_cell_count,
+	               (double)(clock() - start) / CLOCKS_PER_SEC);
+      }
+
       fclose(sdf_fd);
       free(fname);
       return 0;
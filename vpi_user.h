@@ -550,6 +550,19 @@ extern PLI_INT32 vpi_compare_objects(vpiHandle obj1, vpiHandle obj2);
 extern PLI_INT32 vpi_put_userdata(vpiHandle obj, void*data);
 extern void*vpi_get_userdata(vpiHandle obj);
 
+/*
+ * These functions let an application save its own data in a
+ * checkpoint (from a cbStartOfSave or cbEndOfSave callback) and read
+ * it back when the checkpoint is restarted (from a cbStartOfRestart
+ * or cbEndOfRestart callback). The id identifies the block of data,
+ * and successive calls with the same id append to or read on from
+ * the previous call. Both return the number of bytes transferred.
+ */
+extern PLI_INT32 vpi_put_data(PLI_INT32 id, PLI_BYTE8*dataLoc,
+			      PLI_INT32 numOfBytes);
+extern PLI_INT32 vpi_get_data(PLI_INT32 id, PLI_BYTE8*dataLoc,
+			      PLI_INT32 numOfBytes);
+
 /*
  * Support for handling errors.
  */
@@ -598,6 +611,55 @@ extern void vpip_format_strength(char*str, s_vpi_value*value, unsigned bit);
 extern void vpip_set_return_value(int value);
 extern s_vpi_vecval vpip_calc_clog2(vpiHandle arg);
 extern void vpip_make_systf_system_defined(vpiHandle ref);
+  /* Write cnt characters of buf to the mcd or fd. The buffer may
+     contain NULL characters. */
+extern PLI_INT32 vpip_mcd_write(PLI_UINT32 mcd, const char*buf, PLI_INT32 cnt);
+  /* Flush all the open files, including the ones that are written
+     by the file output thread (vvp -a). */
+extern PLI_INT32 vpip_mcd_flush_all(void);
+
+/*
+ * These vpi_control operations implement $save and $restart. Each
+ * takes the path of the checkpoint file as a (const char*)
+ * argument. The operation is performed at the end of the current
+ * time step.
+ */
+#define vpiSaveCheckpoint    0x1000
+#define vpiRestartCheckpoint 0x1001
+
+/*
+ * Fork the simulation into count copies that continue from the
+ * current point. In each child this returns the index (1..count) of
+ * the child, and the child writes to its own copies of the output
+ * files (with ".<index>" added to the name). In the parent it returns
+ * 0 after all the children have exited, or -1 if no child could be
+ * made.
+ */
+extern PLI_INT32 vpip_fork_tests(PLI_INT32 count);
+
+/*
+ * The vpip_register_batch_cb function registers a single value change
+ * callback for a whole list of signals. Instead of a call for every
+ * change, the routine is called once at the ReadOnlySynch of each
+ * time step that had changes, with an array of the indices (into the
+ * registered list) of the handles that changed and their raw 4-state
+ * values. The changes array and the values it points to are only
+ * valid during the call. The returned handle is a vpiCallback that
+ * can be passed to vpi_remove_cb to cancel the whole batch.
+ */
+typedef struct t_vpip_batch_change {
+      PLI_INT32 index;		/* Index of the handle in the list */
+      PLI_INT32 size;		/* Width of the value in bits */
+      p_vpi_vecval value;	/* (size+31)/32 aval/bval words */
+} s_vpip_batch_change, *p_vpip_batch_change;
+
+typedef void (*vpip_batch_routine)(p_vpi_time time, PLI_INT32 count,
+				   p_vpip_batch_change changes,
+				   PLI_BYTE8*user_data);
+
+extern vpiHandle vpip_register_batch_cb(vpiHandle*handles, PLI_INT32 count,
+					vpip_batch_routine routine,
+					PLI_BYTE8*user_data);
 
 EXTERN_C_END
 
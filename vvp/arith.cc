@@ -19,6 +19,7 @@
 
 # include  "arith.h"
 # include  "schedule.h"
+# include  "checkpoint.h"
 # include  <climits>
 # include  <iostream>
 # include  <cassert>
@@ -51,6 +52,18 @@ void vvp_arith_::dispatch_operand_(vvp_net_ptr_t ptr, vvp_vector4_t bit)
       }
 }
 
+bool vvp_arith_::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_vec4(op_a_);
+      out.put_vec4(op_b_);
+      return true;
+}
+
+void vvp_arith_::restore_state(vvp_checkpoint_in&in)
+{
+      op_a_ = in.get_vec4();
+      op_b_ = in.get_vec4();
+}
 
 vvp_arith_abs::vvp_arith_abs()
 {
@@ -60,6 +73,11 @@ vvp_arith_abs::~vvp_arith_abs()
 {
 }
 
+bool vvp_arith_abs::save_state(vvp_checkpoint_out&) const
+{
+      return true;
+}
+
 void vvp_arith_abs::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
                               vvp_context_t)
 {
@@ -98,6 +116,11 @@ vvp_arith_cast_int::~vvp_arith_cast_int()
 {
 }
 
+bool vvp_arith_cast_int::save_state(vvp_checkpoint_out&) const
+{
+      return true;
+}
+
 void vvp_arith_cast_int::recv_real(vvp_net_ptr_t ptr, double bit,
                                    vvp_context_t)
 {
@@ -113,6 +136,11 @@ vvp_arith_cast_real::~vvp_arith_cast_real()
 {
 }
 
+bool vvp_arith_cast_real::save_state(vvp_checkpoint_out&) const
+{
+      return true;
+}
+
 void vvp_arith_cast_real::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
                                     vvp_context_t)
 {
@@ -130,6 +158,11 @@ vvp_arith_cast_vec2::~vvp_arith_cast_vec2()
 {
 }
 
+bool vvp_arith_cast_vec2::save_state(vvp_checkpoint_out&) const
+{
+      return true;
+}
+
 void vvp_arith_cast_vec2::recv_real(vvp_net_ptr_t ptr, double bit,
                                    vvp_context_t)
 {
@@ -857,6 +890,18 @@ void vvp_arith_real_::dispatch_operand_(vvp_net_ptr_t ptr, double bit)
       }
 }
 
+bool vvp_arith_real_::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_double(op_a_);
+      out.put_double(op_b_);
+      return true;
+}
+
+void vvp_arith_real_::restore_state(vvp_checkpoint_in&in)
+{
+      op_a_ = in.get_double();
+      op_b_ = in.get_double();
+}
 
 /* Real multiplication. */
 vvp_arith_mult_real::vvp_arith_mult_real()
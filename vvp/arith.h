@@ -37,6 +37,9 @@ class vvp_arith_  : public vvp_net_fun_t {
     public:
       explicit vvp_arith_(unsigned wid);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
     protected:
       void dispatch_operand_(vvp_net_ptr_t ptr, vvp_vector4_t bit);
 
@@ -59,6 +62,8 @@ class vvp_arith_abs : public vvp_net_fun_t {
       void recv_real(vvp_net_ptr_t ptr, double bit,
                      vvp_context_t);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+
     private:
 };
 
@@ -70,6 +75,8 @@ class vvp_arith_cast_int : public vvp_net_fun_t {
       void recv_real(vvp_net_ptr_t ptr, double bit,
                      vvp_context_t);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+
     private:
       unsigned wid_;
 };
@@ -82,6 +89,8 @@ class vvp_arith_cast_real : public vvp_net_fun_t {
       void recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
                      vvp_context_t);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+
     private:
       bool signed_;
 };
@@ -96,6 +105,8 @@ class vvp_arith_cast_vec2 : public vvp_net_fun_t {
       void recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
                      vvp_context_t);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+
     private:
       unsigned wid_;
 };
@@ -281,6 +292,9 @@ class vvp_arith_real_  : public vvp_net_fun_t {
     public:
       explicit vvp_arith_real_();
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
     protected:
       void dispatch_operand_(vvp_net_ptr_t ptr, double bit);
 
@@ -22,6 +22,8 @@
 #include  "schedule.h"
 #include  "vpi_priv.h"
 #include  "vvp_net_sig.h"
+#include  "checkpoint.h"
+#include  "lazy.h"
 #include  "config.h"
 #ifdef CHECK_WITH_VALGRIND
 #include  "vvp_cleanup.h"
@@ -42,6 +44,9 @@ unsigned long count_real_arrays = 0;
 unsigned long count_real_array_words = 0;
 
 static symbol_map_s<struct __vpiArray>* array_table =0;
+// All the arrays in the order they were created. Checkpoints refer
+// to arrays by their position in this list.
+static vector<vvp_array_t> array_list;
 
 class vvp_fun_arrayport;
 static void array_attach_port(vvp_array_t, vvp_fun_arrayport*);
@@ -101,6 +106,8 @@ struct __vpiArray {
       struct __vpiCallback *vpi_callbacks;
       bool signed_flag;
       bool swap_addr;
+	// Position in the array_list.
+      unsigned long list_index;
 };
 
 struct __vpiArrayIterator {
@@ -938,6 +945,8 @@ vvp_vector4_t array_get_word(vvp_array_t arr, unsigned address)
       vpiHandle word = arr->nets[address];
       struct __vpiSignal*vsig = vpip_signal_from_handle(word);
       assert(vsig);
+	// The words of a net array may be driven by lazy logic.
+      lazy_demand(vsig->node);
       vvp_signal_value*sig = dynamic_cast<vvp_signal_value*> (vsig->node->fil);
       assert(sig);
 
@@ -958,6 +967,7 @@ double array_get_word_r(vvp_array_t arr, unsigned address)
       vpiHandle word = arr->nets[address];
       struct __vpiRealVar*vsig = vpip_realvar_from_handle(word);
       assert(vsig);
+      lazy_demand(vsig->net);
       vvp_signal_value*sig = dynamic_cast<vvp_signal_value*> (vsig->net->fil);
       assert(sig);
 
@@ -1010,6 +1020,9 @@ static vpiHandle vpip_make_array(char*label, const char*name,
       obj->ports_ = 0;
       obj->vpi_callbacks = 0;
 
+      obj->list_index = array_list.size();
+      array_list.push_back(obj);
+
 	/* Add this symbol to the array_symbols table for later lookup. */
       if (!array_table)
 	    array_table = new symbol_map_s<struct __vpiArray>;
@@ -1140,6 +1153,9 @@ class vvp_fun_arrayport  : public vvp_net_fun_t {
 
       virtual void check_word_change(unsigned long addr) = 0;
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
     protected:
       vvp_array_t arr_;
       vvp_net_t  *net_;
@@ -1166,6 +1182,17 @@ vvp_fun_arrayport::~vvp_fun_arrayport()
 {
 }
 
+bool vvp_fun_arrayport::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_u64(addr_);
+      return true;
+}
+
+void vvp_fun_arrayport::restore_state(vvp_checkpoint_in&in)
+{
+      addr_ = in.get_u64();
+}
+
 class vvp_fun_arrayport_sa  : public vvp_fun_arrayport {
 
     public:
@@ -1507,6 +1534,31 @@ bool array_port_resolv_list_t::resolve(bool mes)
       return true;
 }
 
+bool array_is_watched(vvp_array_t array)
+{
+      return array->ports_ != 0 || array->vpi_callbacks != 0;
+}
+
+/*
+ * The words of a net array may be fed by lazy logic, which is no
+ * longer lazy once a callback watches the array.
+ */
+static void array_observe_words(vvp_array_t array)
+{
+      if (array->nets == 0)
+	    return;
+
+      for (unsigned idx = 0 ;  idx < array->array_count ;  idx += 1) {
+	    vpiHandle word = array->nets[idx];
+	    if (word == 0)
+		  continue;
+	    if (struct __vpiSignal*sig = vpip_signal_from_handle(word))
+		  lazy_observe(sig->node);
+	    else if (struct __vpiRealVar*rsig = vpip_realvar_from_handle(word))
+		  lazy_observe(rsig->net);
+      }
+}
+
 void vpip_array_word_change(struct __vpiCallback*cb, vpiHandle obj)
 {
       struct __vpiArray*parent = 0;
@@ -1520,6 +1572,7 @@ void vpip_array_word_change(struct __vpiCallback*cb, vpiHandle obj)
       }
 
       assert(parent);
+      array_observe_words(parent);
       cb->next = parent->vpi_callbacks;
       parent->vpi_callbacks = cb;
 }
@@ -1528,6 +1581,7 @@ void vpip_array_change(struct __vpiCallback*cb, vpiHandle obj)
 {
       struct __vpiArray*arr = ARRAY_HANDLE(obj);
       cb->extra_data = -1; // This is a callback for every element.
+      array_observe_words(arr);
       cb->next = arr->vpi_callbacks;
       arr->vpi_callbacks = cb;
 }
@@ -1588,6 +1642,9 @@ void compile_array_alias(char*label, char*name, char*src)
       obj->ports_ = 0;
       obj->vpi_callbacks = 0;
 
+      obj->list_index = array_list.size();
+      array_list.push_back(obj);
+
       assert(array_table);
       assert(!array_find(label));
       array_table->sym_set_value(label, obj);
@@ -1684,6 +1741,72 @@ vpiHandle vpip_make_vthr_A(char*label, vpiHandle handle)
       return &(obj->base);
 }
 
+unsigned long array_count_all(void)
+{
+      return array_list.size();
+}
+
+unsigned long array_to_index(vvp_array_t arr)
+{
+      return arr->list_index;
+}
+
+vvp_array_t array_from_index(unsigned long idx)
+{
+      if (idx >= array_list.size())
+	    return 0;
+      return array_list[idx];
+}
+
+/*
+ * Save the words of the variable arrays. The words of net arrays are
+ * saved with the nets, and the words of automatic arrays are in the
+ * scope contexts, so only the static variable arrays have state of
+ * their own. An alias shares its words with the source array, so
+ * its words are saved (and restored) twice, harmlessly.
+ */
+void array_save_state(vvp_checkpoint_out&out)
+{
+      for (unsigned long idx = 0 ;  idx < array_list.size() ;  idx += 1) {
+	    vvp_array_t arr = array_list[idx];
+	    if (arr->vals4 && dynamic_cast<vvp_vector4array_sa*>(arr->vals4)) {
+		  out.put_u8(1);
+		  out.put_u32(arr->vals4->words());
+		  for (unsigned adr = 0 ; adr < arr->vals4->words() ; adr += 1)
+			out.put_vec4(arr->vals4->get_word(adr));
+	    } else if (arr->valsr) {
+		  out.put_u8(2);
+		  out.put_u32(arr->valsr->words());
+		  for (unsigned adr = 0 ; adr < arr->valsr->words() ; adr += 1)
+			out.put_double(arr->valsr->get_word(adr));
+	    } else {
+		  out.put_u8(0);
+	    }
+      }
+}
+
+void array_restore_state(vvp_checkpoint_in&in)
+{
+      for (unsigned long idx = 0 ;  idx < array_list.size() ;  idx += 1) {
+	    vvp_array_t arr = array_list[idx];
+	    unsigned type = in.get_u8();
+	    if (type == 0)
+		  continue;
+
+	    unsigned long words = in.get_u32();
+	    if (type == 1 && arr->vals4 && words == arr->vals4->words()) {
+		  for (unsigned adr = 0 ; adr < words ; adr += 1)
+			arr->vals4->set_word(adr, in.get_vec4());
+	    } else if (type == 2 && arr->valsr && words == arr->valsr->words()) {
+		  for (unsigned adr = 0 ; adr < words ; adr += 1)
+			arr->valsr->set_word(adr, in.get_double());
+	    } else {
+		  in.error("array %s does not match the checkpoint", arr->name);
+		  return;
+	    }
+      }
+}
+
 void compile_array_cleanup(void)
 {
       delete array_table;
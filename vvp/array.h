@@ -34,6 +34,12 @@ extern vpiHandle array_index_iterate(int code, vpiHandle ref);
 
 extern void array_word_change(vvp_array_t array, unsigned long addr);
 
+/*
+ * True if something (an array port or a VPI callback on the array)
+ * sees every change of a word of the array.
+ */
+extern bool array_is_watched(vvp_array_t array);
+
 extern void array_attach_word(vvp_array_t array, unsigned addr, vpiHandle word);
 extern void array_alias_word(vvp_array_t array, unsigned long addr,
                              vpiHandle word, int msb, int lsb);
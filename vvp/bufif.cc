@@ -20,6 +20,7 @@
 # include  "bufif.h"
 # include  "schedule.h"
 # include  "statistics.h"
+# include  "checkpoint.h"
 # include  <iostream>
 # include  <cassert>
 
@@ -32,6 +33,19 @@ vvp_fun_bufif::vvp_fun_bufif(bool en_invert, bool out_invert,
       count_functors_bufif += 1;
 }
 
+bool vvp_fun_bufif::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_vec4(bit_);
+      out.put_vec4(en_);
+      return true;
+}
+
+void vvp_fun_bufif::restore_state(vvp_checkpoint_in&in)
+{
+      bit_ = in.get_vec4();
+      en_ = in.get_vec4();
+}
+
 void vvp_fun_bufif::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
                               vvp_context_t)
 {
@@ -40,6 +40,9 @@ class vvp_fun_bufif  : public vvp_net_fun_t {
       void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                      vvp_context_t);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
     private:
       vvp_vector4_t bit_;
       vvp_vector4_t en_;
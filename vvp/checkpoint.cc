@@ -0,0 +1,800 @@
+/*
+ * Copyright (c) 2011 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA
+ */
+
+# include  "checkpoint.h"
+# include  "codes.h"
+# include  "compile.h"
+# include  "schedule.h"
+# include  "statistics.h"
+# include  "vpi_priv.h"
+# include  "lazy.h"
+# include  <typeinfo>
+# include  <cassert>
+# include  <climits>
+# include  <cstdarg>
+# include  <cstdio>
+# include  <cstdlib>
+# include  <cstring>
+# include  "ivl_alloc.h"
+
+/*
+ * The file starts with this magic string and a format version, then
+ * a fingerprint of the design. A checkpoint can only be restarted
+ * into the same design: the fingerprint holds a hash of the .vvp
+ * source and a few object counts, and is checked before anything is
+ * changed.
+ */
+static const char checkpoint_magic[8] = { 'V','V','P','C','K','P','T', 4 };
+
+static unsigned long design_net_count = 0;
+static uint64_t design_hash = 0;
+
+/*
+ * This is the 64bit FNV-1a hash of the source file.
+ */
+void checkpoint_hash_design(FILE*fd)
+{
+      uint64_t hash = 0xcbf29ce484222325ULL;
+      char tmp[4096];
+      size_t cnt;
+      while ((cnt = fread(tmp, 1, sizeof tmp, fd)) > 0) {
+	    for (size_t idx = 0 ;  idx < cnt ;  idx += 1) {
+		  hash ^= (unsigned char)tmp[idx];
+		  hash *= 0x100000001b3ULL;
+	    }
+      }
+      rewind(fd);
+      design_hash = hash;
+}
+
+void checkpoint_design_complete(void)
+{
+      design_net_count = count_vvp_nets;
+}
+
+vvp_checkpoint_out::vvp_checkpoint_out()
+{
+}
+
+vvp_checkpoint_out::~vvp_checkpoint_out()
+{
+}
+
+void vvp_checkpoint_out::put_u8(unsigned val)
+{
+      buf_.push_back((char)(val & 0xff));
+}
+
+void vvp_checkpoint_out::put_u32(unsigned long val)
+{
+      char tmp[4];
+      for (unsigned idx = 0 ;  idx < 4 ;  idx += 1) {
+	    tmp[idx] = (char)(val & 0xff);
+	    val >>= 8;
+      }
+      buf_.append(tmp, 4);
+}
+
+void vvp_checkpoint_out::put_u64(uint64_t val)
+{
+      char tmp[8];
+      for (unsigned idx = 0 ;  idx < 8 ;  idx += 1) {
+	    tmp[idx] = (char)(val & 0xff);
+	    val >>= 8;
+      }
+      buf_.append(tmp, 8);
+}
+
+void vvp_checkpoint_out::put_double(double val)
+{
+      uint64_t tmp;
+      memcpy(&tmp, &val, sizeof tmp);
+      put_u64(tmp);
+}
+
+void vvp_checkpoint_out::put_str(const char*val)
+{
+      size_t len = strlen(val);
+      put_u32(len);
+      buf_.append(val, len);
+}
+
+void vvp_checkpoint_out::put_bytes(const void*val, size_t cnt)
+{
+      buf_.append((const char*)val, cnt);
+}
+
+void vvp_checkpoint_out::put_vec2(const vvp_vector2_t&val)
+{
+      unsigned wid = val.size();
+      put_u32(wid);
+      for (unsigned idx = 0 ;  idx < wid ;  idx += 32) {
+	    unsigned long word = 0;
+	    for (unsigned bit = 0 ;  bit < 32 && idx+bit < wid ;  bit += 1)
+		  if (val.value(idx+bit)) word |= 1UL << bit;
+	    put_u32(word);
+      }
+}
+
+/*
+ * Vectors are written 32 bits at a time, as the abits word followed
+ * by the bbits word, so that the format does not depend on the size
+ * of a long.
+ */
+void vvp_checkpoint_out::put_vec4(const vvp_vector4_t&val)
+{
+      unsigned wid = val.size();
+      put_u32(wid);
+      for (unsigned idx = 0 ;  idx < wid ;  idx += 32) {
+	    unsigned long abits, bbits;
+	    val.subword(idx, wid-idx < 32? wid-idx : 32, abits, bbits);
+	    put_u32(abits);
+	    put_u32(bbits);
+      }
+}
+
+void vvp_checkpoint_out::put_vec8(const vvp_vector8_t&val)
+{
+      unsigned wid = val.size();
+      put_u32(wid);
+      for (unsigned idx = 0 ;  idx < wid ;  idx += 1)
+	    put_u8(val.value(idx).raw());
+}
+
+void vvp_checkpoint_out::put_net(const vvp_net_t*net)
+{
+      if (net == 0) {
+	    put_u32(0);
+	    return;
+      }
+
+      unsigned long idx = vvp_net_to_index(net);
+      if (idx >= design_net_count) {
+	    refuse("a net created during simulation is referenced");
+	    put_u32(0);
+	    return;
+      }
+
+      put_u32(idx+1);
+}
+
+void vvp_checkpoint_out::put_ptr(vvp_net_ptr_t ptr)
+{
+      put_net(ptr.ptr());
+      put_u8(ptr.port());
+}
+
+void vvp_checkpoint_out::put_code(vvp_code_t code)
+{
+      if (code == 0) {
+	    put_u32(0);
+	    return;
+      }
+
+      unsigned long idx = codespace_index(code);
+      if (idx == ULONG_MAX) {
+	    refuse("a thread is executing code that is not in the code space");
+	    put_u32(0);
+	    return;
+      }
+
+      put_u32(idx+1);
+}
+
+void vvp_checkpoint_out::put_scope(struct __vpiScope*scope)
+{
+      if (scope == 0) {
+	    put_u32(0);
+	    return;
+      }
+
+      std::map<struct __vpiScope*,unsigned long>::const_iterator cur
+	    = scope_map_.find(scope);
+      if (cur == scope_map_.end()) {
+	    refuse("an unknown scope is referenced");
+	    put_u32(0);
+	    return;
+      }
+
+      put_u32(cur->second+1);
+}
+
+void vvp_checkpoint_out::put_array(vvp_array_t array)
+{
+      if (array == 0) {
+	    put_u32(0);
+	    return;
+      }
+
+      unsigned long idx = array_to_index(array);
+      if (idx == ULONG_MAX) {
+	    refuse("an unknown array is referenced");
+	    put_u32(0);
+	    return;
+      }
+
+      put_u32(idx+1);
+}
+
+void vvp_checkpoint_out::put_thread(vthread_t thr)
+{
+      if (thr == 0) {
+	    put_u32(0);
+	    return;
+      }
+
+      std::map<vthread_t,unsigned long>::const_iterator cur
+	    = thread_map_.find(thr);
+      if (cur != thread_map_.end()) {
+	    put_u32(cur->second+1);
+	    return;
+      }
+
+      unsigned long idx = threads_.size();
+      threads_.push_back(thr);
+      thread_map_[thr] = idx;
+      put_u32(idx+1);
+}
+
+void vvp_checkpoint_out::refuse(const char*fmt, ...)
+{
+	// Keep the first reason, it is usually the most useful.
+      if (refused())
+	    return;
+
+      char buffer[1024];
+      va_list ap;
+      va_start(ap, fmt);
+      vsnprintf(buffer, sizeof buffer, fmt, ap);
+      va_end(ap);
+      refusal_ = buffer;
+}
+
+void vvp_checkpoint_out::set_scopes(const std::vector<struct __vpiScope*>&scopes)
+{
+      scope_map_.clear();
+      for (unsigned long idx = 0 ;  idx < scopes.size() ;  idx += 1)
+	    scope_map_[scopes[idx]] = idx;
+}
+
+vvp_checkpoint_in::vvp_checkpoint_in(const char*data, size_t size)
+: cur_(data), end_(data+size), net_(0)
+{
+}
+
+vvp_checkpoint_in::~vvp_checkpoint_in()
+{
+}
+
+bool vvp_checkpoint_in::take_(void*dst, size_t cnt)
+{
+      if (failed() || (size_t)(end_-cur_) < cnt) {
+	    error("the checkpoint is truncated");
+	    memset(dst, 0, cnt);
+	    return false;
+      }
+
+      memcpy(dst, cur_, cnt);
+      cur_ += cnt;
+      return true;
+}
+
+unsigned vvp_checkpoint_in::get_u8()
+{
+      unsigned char tmp;
+      take_(&tmp, 1);
+      return tmp;
+}
+
+unsigned long vvp_checkpoint_in::get_u32()
+{
+      unsigned char tmp[4];
+      take_(tmp, 4);
+      unsigned long val = 0;
+      for (unsigned idx = 4 ;  idx > 0 ;  idx -= 1)
+	    val = (val << 8) | tmp[idx-1];
+      return val;
+}
+
+uint64_t vvp_checkpoint_in::get_u64()
+{
+      unsigned char tmp[8];
+      take_(tmp, 8);
+      uint64_t val = 0;
+      for (unsigned idx = 8 ;  idx > 0 ;  idx -= 1)
+	    val = (val << 8) | tmp[idx-1];
+      return val;
+}
+
+double vvp_checkpoint_in::get_double()
+{
+      uint64_t tmp = get_u64();
+      double val;
+      memcpy(&val, &tmp, sizeof val);
+      return val;
+}
+
+char* vvp_checkpoint_in::get_str()
+{
+      unsigned long len = get_u32();
+      if (len > remaining()) {
+	    error("the checkpoint is truncated");
+	    len = 0;
+      }
+
+      char*val = (char*)malloc(len+1);
+      take_(val, len);
+      val[len] = 0;
+      return val;
+}
+
+void vvp_checkpoint_in::get_bytes(void*val, size_t cnt)
+{
+      take_(val, cnt);
+}
+
+vvp_vector2_t vvp_checkpoint_in::get_vec2()
+{
+      unsigned wid = get_u32();
+      if (wid/32 > remaining()/4) {
+	    error("the checkpoint is truncated");
+	    return vvp_vector2_t();
+      }
+
+      vvp_vector2_t val (vvp_vector2_t::FILL0, wid);
+      for (unsigned idx = 0 ;  idx < wid ;  idx += 32) {
+	    unsigned long word = get_u32();
+	    for (unsigned bit = 0 ;  bit < 32 && idx+bit < wid ;  bit += 1)
+		  if (word & (1UL << bit)) val.set_bit(idx+bit, 1);
+      }
+      return val;
+}
+
+vvp_vector4_t vvp_checkpoint_in::get_vec4()
+{
+      static const vvp_bit4_t bit_map[4] = { BIT4_0, BIT4_1, BIT4_Z, BIT4_X };
+
+      unsigned wid = get_u32();
+      if (wid/32 > remaining()/8) {
+	    error("the checkpoint is truncated");
+	    return vvp_vector4_t();
+      }
+
+      vvp_vector4_t val (wid, BIT4_0);
+      for (unsigned idx = 0 ;  idx < wid ;  idx += 32) {
+	    unsigned long abits = get_u32();
+	    unsigned long bbits = get_u32();
+	    if (abits == 0 && bbits == 0)
+		  continue;
+	    for (unsigned bit = 0 ;  bit < 32 && idx+bit < wid ;  bit += 1) {
+		  unsigned code = ((abits >> bit) & 1) | ((bbits >> bit) & 1) << 1;
+		  if (code) val.set_bit(idx+bit, bit_map[code]);
+	    }
+      }
+      return val;
+}
+
+vvp_vector8_t vvp_checkpoint_in::get_vec8()
+{
+      unsigned wid = get_u32();
+      if (wid > remaining()) {
+	    error("the checkpoint is truncated");
+	    return vvp_vector8_t();
+      }
+
+      vvp_vector8_t val (wid);
+      for (unsigned idx = 0 ;  idx < wid ;  idx += 1)
+	    val.set_bit(idx, vvp_scalar_t(get_u8()));
+      return val;
+}
+
+vvp_net_t* vvp_checkpoint_in::get_net()
+{
+      unsigned long idx = get_u32();
+      if (idx == 0)
+	    return 0;
+
+      vvp_net_t*net = idx <= design_net_count? vvp_net_from_index(idx-1) : 0;
+      if (net == 0)
+	    error("invalid net reference");
+      return net;
+}
+
+vvp_net_ptr_t vvp_checkpoint_in::get_ptr()
+{
+      vvp_net_t*net = get_net();
+      unsigned port = get_u8();
+      if (port > 3) {
+	    error("invalid port reference");
+	    port = 0;
+      }
+      return vvp_net_ptr_t(net, port);
+}
+
+vvp_code_t vvp_checkpoint_in::get_code()
+{
+      unsigned long idx = get_u32();
+      if (idx == 0)
+	    return 0;
+
+      vvp_code_t code = codespace_from_index(idx-1);
+      if (code == 0)
+	    error("invalid code reference");
+      return code;
+}
+
+struct __vpiScope* vvp_checkpoint_in::get_scope()
+{
+      unsigned long idx = get_u32();
+      if (idx == 0)
+	    return 0;
+
+      if (idx > scopes_.size()) {
+	    error("invalid scope reference");
+	    return 0;
+      }
+      return scopes_[idx-1];
+}
+
+vvp_array_t vvp_checkpoint_in::get_array()
+{
+      unsigned long idx = get_u32();
+      if (idx == 0)
+	    return 0;
+
+      vvp_array_t array = array_from_index(idx-1);
+      if (array == 0)
+	    error("invalid array reference");
+      return array;
+}
+
+vthread_t vvp_checkpoint_in::get_thread()
+{
+      unsigned long idx = get_u32();
+      if (idx == 0)
+	    return 0;
+
+	// The saver numbers the threads as it first writes them, so
+	// a new number is always the next one.
+      if (idx > threads_.size()+1) {
+	    error("invalid thread reference");
+	    return 0;
+      }
+      return thread(idx-1);
+}
+
+vthread_t vvp_checkpoint_in::thread(unsigned long idx)
+{
+      while (threads_.size() <= idx)
+	    threads_.push_back(vthread_restore_new());
+      return threads_[idx];
+}
+
+void vvp_checkpoint_in::error(const char*fmt, ...)
+{
+      if (failed())
+	    return;
+
+      char buffer[1024];
+      va_list ap;
+      va_start(ap, fmt);
+      vsnprintf(buffer, sizeof buffer, fmt, ap);
+      va_end(ap);
+      error_ = buffer;
+}
+
+void vvp_checkpoint_in::set_scopes(const std::vector<struct __vpiScope*>&scopes)
+{
+      scopes_ = scopes;
+}
+
+/*
+ * This writes the part of the checkpoint that describes the running
+ * simulation. The order here must match restore_body below.
+ */
+static void save_body(vvp_checkpoint_out&out,
+		      const std::vector<struct __vpiScope*>&scopes)
+{
+      vthread_flush_persistent();
+	// Bring the nets that lazy gates feed up to date, since the
+	// gates do not save that they are dirty.
+      lazy_flush();
+
+      for (unsigned long idx = 0 ;  idx < scopes.size() ;  idx += 1) {
+	    if (scopes[idx]->live_contexts) {
+		  out.refuse("automatic task or function %s is active",
+			     vpip_get_str(vpiFullName, scopes[idx]));
+		  return;
+	    }
+      }
+
+      for (unsigned long idx = 0 ;  idx < design_net_count ;  idx += 1) {
+	    vvp_net_t*net = vvp_net_from_index(idx);
+	    out.put_u8((net->fun? 1 : 0) | (net->fil? 2 : 0));
+	    if (net->fun && ! net->fun->save_state(out)) {
+		  out.refuse("the state of a %s cannot be saved",
+			     typeid(*net->fun).name());
+	    }
+	    if (net->fil && ! net->fil->save_filter_state(out)) {
+		  out.refuse("the state of a %s cannot be saved",
+			     typeid(*net->fil).name());
+	    }
+	    if (out.refused())
+		  return;
+      }
+
+      array_save_state(out);
+
+      for (unsigned long idx = 0 ;  idx < scopes.size() ;  idx += 1) {
+	    const std::set<vthread_t>&threads = scopes[idx]->threads;
+	    out.put_u32(threads.size());
+	    for (std::set<vthread_t>::const_iterator cur = threads.begin()
+		       ; cur != threads.end() ; ++ cur)
+		  out.put_thread(*cur);
+      }
+
+      schedule_save_state(out);
+      vpip_mcd_save_state(out);
+
+	// Write the threads last. A thread may refer to threads that
+	// have not been numbered yet, so keep going until all the
+	// numbered threads are written.
+      for (unsigned long idx = 0 ;  idx < out.thread_count() ;  idx += 1) {
+	    out.put_bool(true);
+	    vthread_save_state(out, out.thread(idx));
+	    if (out.refused())
+		  return;
+      }
+      out.put_bool(false);
+}
+
+static void restore_body(vvp_checkpoint_in&in,
+			 const std::vector<struct __vpiScope*>&scopes)
+{
+      for (unsigned long idx = 0 ;  idx < design_net_count ;  idx += 1) {
+	    vvp_net_t*net = vvp_net_from_index(idx);
+	    unsigned flags = in.get_u8();
+	    if (flags != ((net->fun? 1U : 0U) | (net->fil? 2U : 0U))) {
+		  in.error("the checkpoint does not match the design");
+		  return;
+	    }
+	    in.set_net(net);
+	    if (net->fun) net->fun->restore_state(in);
+	    if (net->fil) net->fil->restore_filter_state(in);
+	    if (in.failed())
+		  return;
+      }
+      in.set_net(0);
+
+      array_restore_state(in);
+
+      for (unsigned long idx = 0 ;  idx < scopes.size() ;  idx += 1) {
+	    unsigned long count = in.get_u32();
+	    for (unsigned long cnt = 0 ;  cnt < count && !in.failed() ;  cnt += 1)
+		  scopes[idx]->threads.insert(in.get_thread());
+      }
+
+      schedule_restore_state(in);
+      vpip_mcd_restore_state(in);
+
+      unsigned long idx = 0;
+      while (!in.failed() && in.get_bool()) {
+	    vthread_restore_state(in, in.thread(idx));
+	    idx += 1;
+      }
+
+      if (!in.failed() && idx != in.thread_count())
+	    in.error("a thread record is missing");
+}
+
+static void put_fingerprint(vvp_checkpoint_out&out, unsigned long nscopes)
+{
+      out.put_u32(design_net_count);
+      out.put_u32(count_opcodes);
+      out.put_u32(nscopes);
+      out.put_u32(array_count_all());
+      out.put_u64(design_hash);
+}
+
+static bool save_checkpoint(const char*path)
+{
+      std::vector<struct __vpiScope*> scopes;
+      vpip_collect_scopes(scopes);
+
+      vpiStartOfSave();
+
+      vvp_checkpoint_out body;
+      body.set_scopes(scopes);
+      save_body(body, scopes);
+
+      vpiEndOfSave();
+
+      vvp_checkpoint_out out;
+      out.put_bytes(checkpoint_magic, sizeof checkpoint_magic);
+      put_fingerprint(out, scopes.size());
+      out.put_u64(body.image().size());
+      out.put_bytes(body.image().data(), body.image().size());
+	// This also discards the VPI data if the save is refused.
+      vpip_data_save_state(out);
+
+      if (body.refused()) {
+	    vpi_mcd_printf(1, "Error: Unable to save checkpoint %s: %s.\n",
+			   path, body.refusal());
+	    return false;
+      }
+
+      FILE*fd = fopen(path, "wb");
+      if (fd == 0) {
+	    vpi_mcd_printf(1, "Error: Unable to save checkpoint %s: "
+			   "cannot open the file.\n", path);
+	    return false;
+      }
+
+      size_t rc = fwrite(out.image().data(), 1, out.image().size(), fd);
+      if (fclose(fd) != 0 || rc != out.image().size()) {
+	    vpi_mcd_printf(1, "Error: Unable to save checkpoint %s: "
+			   "write failed.\n", path);
+	    return false;
+      }
+
+      if (verbose_flag)
+	    vpi_mcd_printf(1, " ...saved checkpoint %s at time %" TIME_FMT_U
+			   " (%lu threads)\n", path, schedule_simtime(),
+			   body.thread_count());
+      return true;
+}
+
+static void delete_threads(std::set<vthread_t>&threads)
+{
+      for (std::set<vthread_t>::iterator cur = threads.begin()
+		 ; cur != threads.end() ; ++ cur)
+	    vthread_delete(*cur);
+      threads.clear();
+}
+
+static bool restart_checkpoint(const char*path)
+{
+      FILE*fd = fopen(path, "rb");
+      if (fd == 0) {
+	    vpi_mcd_printf(1, "Error: Unable to restart checkpoint %s: "
+			   "cannot open the file.\n", path);
+	    return false;
+      }
+
+      std::string data;
+      char tmp[65536];
+      size_t cnt;
+      while ((cnt = fread(tmp, 1, sizeof tmp, fd)) > 0)
+	    data.append(tmp, cnt);
+      fclose(fd);
+
+      std::vector<struct __vpiScope*> scopes;
+      vpip_collect_scopes(scopes);
+
+	// Check the header and load the VPI data before anything in
+	// the running simulation is changed.
+      vvp_checkpoint_in head (data.data(), data.size());
+      char magic[sizeof checkpoint_magic];
+      head.get_bytes(magic, sizeof magic);
+      if (!head.failed() && memcmp(magic, checkpoint_magic, sizeof magic) != 0)
+	    head.error("this is not a checkpoint file of this version");
+
+      vvp_checkpoint_out expect;
+      put_fingerprint(expect, scopes.size());
+      char print[24];
+      assert(expect.image().size() == sizeof print);
+      head.get_bytes(print, sizeof print);
+      if (!head.failed() && memcmp(print, expect.image().data(), sizeof print) != 0)
+	    head.error("the checkpoint was saved from a different design");
+
+      uint64_t body_size = head.get_u64();
+      if (!head.failed() && body_size > head.remaining())
+	    head.error("the checkpoint is truncated");
+
+      if (head.failed()) {
+	    vpi_mcd_printf(1, "Error: Unable to restart checkpoint %s: %s.\n",
+			   path, head.error_text());
+	    return false;
+      }
+
+      const char*body_data = data.data() + (data.size() - head.remaining());
+      vvp_checkpoint_in vpi_data (body_data + body_size,
+				  head.remaining() - body_size);
+      vpip_data_restore_state(vpi_data);
+      if (vpi_data.failed()) {
+	    vpi_mcd_printf(1, "Error: Unable to restart checkpoint %s: %s.\n",
+			   path, vpi_data.error_text());
+	    return false;
+      }
+
+      vpiStartOfRestart();
+
+	// Throw away the current event queue and threads, then load
+	// the saved ones.
+      std::set<vthread_t> threads;
+      vthread_flush_persistent();
+      schedule_clear_state(threads);
+      vthreads_clear(scopes, threads);
+      delete_threads(threads);
+
+      vvp_checkpoint_in in (body_data, body_size);
+      in.set_scopes(scopes);
+      restore_body(in, scopes);
+
+      if (in.failed()) {
+	      // The design is now in a mixed state, so the only safe
+	      // thing to do is to stop.
+	    vpi_mcd_printf(1, "Error: Unable to restart checkpoint %s: %s.\n",
+			   path, in.error_text());
+	    schedule_clear_state(threads);
+	    vthreads_clear(scopes, threads);
+	    for (unsigned long idx = 0 ;  idx < in.thread_count() ;  idx += 1)
+		  threads.insert(in.thread(idx));
+	    delete_threads(threads);
+	    schedule_finish(1);
+	    return false;
+      }
+
+      vpiEndOfRestart();
+
+      if (verbose_flag)
+	    vpi_mcd_printf(1, " ...restarted checkpoint %s at time %" TIME_FMT_U
+			   " (%lu threads)\n", path, schedule_simtime(),
+			   in.thread_count());
+      return true;
+}
+
+/*
+ * The requests are only noted here. The scheduler calls
+ * schedule_checkpoints between time steps, when nothing is running.
+ */
+static std::string save_path;
+static std::string restart_path;
+static bool save_requested = false;
+static bool restart_requested = false;
+
+void checkpoint_request_save(const char*path)
+{
+      save_path = path;
+      save_requested = true;
+}
+
+void checkpoint_request_restart(const char*path)
+{
+      restart_path = path;
+      restart_requested = true;
+}
+
+bool checkpoint_pending(void)
+{
+      return save_requested || restart_requested;
+}
+
+void schedule_checkpoints(void)
+{
+      if (save_requested) {
+	    save_requested = false;
+	    save_checkpoint(save_path.c_str());
+      }
+
+      if (restart_requested) {
+	    restart_requested = false;
+	    restart_checkpoint(restart_path.c_str());
+      }
+}
@@ -0,0 +1,239 @@
+#ifndef __checkpoint_H
+#define __checkpoint_H
+/*
+ * Copyright (c) 2011 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA
+ */
+
+# include  "vvp_net.h"
+# include  "vthread.h"
+# include  "array.h"
+# include  <cstdio>
+# include  <map>
+# include  <set>
+# include  <string>
+# include  <vector>
+
+/*
+ * A checkpoint is a binary image of the complete state of a running
+ * simulation: the simulation time, the event queue, the threads, the
+ * values held by the functors and filters of every vvp_net_t, the
+ * variable arrays and the open VPI files. It is written by $save (at
+ * the end of the current time step) and read back into a freshly
+ * compiled copy of the same design by $restart or the -r flag.
+ *
+ * Objects in the design are not saved by address, but by their index
+ * in the order that the compiler created them. Nets, code words,
+ * scopes and arrays are all created in a deterministic order from
+ * the same input file, so the indices refer to the same objects in
+ * the restarted simulation. Threads are created at run time, so they
+ * are numbered as the checkpoint finds them, and recreated from that
+ * numbering on restart.
+ *
+ * The vvp_checkpoint_out object collects the image in memory. The
+ * objects being saved write their state with the put_* methods and
+ * the matching vvp_checkpoint_in object reads them back in exactly
+ * the same order with the get_* methods. An object that cannot be
+ * saved calls refuse() with an explanation and the save is
+ * abandoned. Values are written in a fixed (little endian) byte
+ * order, so that checkpoints can be moved between machines.
+ */
+class vvp_checkpoint_out {
+
+    public:
+      vvp_checkpoint_out();
+      ~vvp_checkpoint_out();
+
+      void put_u8(unsigned val);
+      void put_u32(unsigned long val);
+      void put_u64(uint64_t val);
+      void put_double(double val);
+      void put_bool(bool val) { put_u8(val? 1 : 0); }
+      void put_str(const char*val);
+      void put_bytes(const void*val, size_t cnt);
+
+      void put_vec2(const vvp_vector2_t&val);
+      void put_vec4(const vvp_vector4_t&val);
+      void put_vec8(const vvp_vector8_t&val);
+
+	// References to design objects are written as 1+index, so
+	// that 0 is a nil reference.
+      void put_net(const vvp_net_t*net);
+      void put_ptr(vvp_net_ptr_t ptr);
+      void put_code(vvp_code_t code);
+      void put_scope(struct __vpiScope*scope);
+      void put_array(vvp_array_t array);
+      void put_thread(vthread_t thr);
+
+      void refuse(const char*fmt, ...) __attribute__((format (printf,2,3)));
+      bool refused() const { return ! refusal_.empty(); }
+      const char* refusal() const { return refusal_.c_str(); }
+
+      const std::string& image() const { return buf_; }
+
+	// Threads are numbered as they are referenced. The saver uses
+	// these to write the thread records after everything else,
+	// and a thread record may reference still more threads.
+      unsigned long thread_count() const { return threads_.size(); }
+      vthread_t thread(unsigned long idx) const { return threads_[idx]; }
+
+      void set_scopes(const std::vector<struct __vpiScope*>&scopes);
+
+    private:
+      std::string buf_;
+      std::string refusal_;
+      std::map<vthread_t,unsigned long> thread_map_;
+      std::vector<vthread_t> threads_;
+      std::map<struct __vpiScope*,unsigned long> scope_map_;
+};
+
+class vvp_checkpoint_in {
+
+    public:
+      vvp_checkpoint_in(const char*data, size_t size);
+      ~vvp_checkpoint_in();
+
+      unsigned get_u8();
+      unsigned long get_u32();
+      uint64_t get_u64();
+      double get_double();
+      bool get_bool() { return get_u8() != 0; }
+	// The returned string is allocated with malloc.
+      char* get_str();
+      void get_bytes(void*val, size_t cnt);
+
+      vvp_vector2_t get_vec2();
+      vvp_vector4_t get_vec4();
+      vvp_vector8_t get_vec8();
+
+      vvp_net_t* get_net();
+      vvp_net_ptr_t get_ptr();
+      vvp_code_t get_code();
+      struct __vpiScope* get_scope();
+      vvp_array_t get_array();
+	// Thread references may come before the thread records, so
+	// this creates (empty) threads as new numbers are seen.
+      vthread_t get_thread();
+
+	// A malformed or truncated image sets the error flag. The
+	// get_* methods then return zero values.
+      void error(const char*fmt, ...) __attribute__((format (printf,2,3)));
+      bool failed() const { return ! error_.empty(); }
+      const char* error_text() const { return error_.c_str(); }
+
+      size_t remaining() const { return end_ - cur_; }
+
+	// The net whose functor and filter state is being read.
+      vvp_net_t* net() const { return net_; }
+      void set_net(vvp_net_t*net) { net_ = net; }
+
+      unsigned long thread_count() const { return threads_.size(); }
+      vthread_t thread(unsigned long idx);
+
+      void set_scopes(const std::vector<struct __vpiScope*>&scopes);
+
+    private:
+      bool take_(void*dst, size_t cnt);
+
+    private:
+      const char*cur_;
+      const char*end_;
+      vvp_net_t*net_;
+      std::string error_;
+      std::vector<struct __vpiScope*> scopes_;
+      std::vector<vthread_t> threads_;
+};
+
+/*
+ * The $save and $restart system tasks (through vpi_control) and the
+ * -r command line flag only request the operation. The scheduler
+ * performs it at the end of the current time step (or, for -r,
+ * before the simulation starts) by calling schedule_checkpoints.
+ */
+extern void checkpoint_request_save(const char*path);
+extern void checkpoint_request_restart(const char*path);
+extern bool checkpoint_pending(void);
+extern void schedule_checkpoints(void);
+
+/*
+ * The scheduler calls this before the simulation starts to note the
+ * number of nets in the compiled design. Nets created after that
+ * (for example the links made by force statements) are not saved.
+ */
+extern void checkpoint_design_complete(void);
+
+/*
+ * The compiler calls this with the open .vvp source before parsing
+ * it. The contents are hashed into the checkpoint fingerprint, so a
+ * checkpoint is only accepted by exactly the design that wrote it.
+ * The file is rewound before returning.
+ */
+extern void checkpoint_hash_design(FILE*fd);
+
+/*
+ * These are the pieces of the checkpoint that live in the scheduler,
+ * thread, array and VPI modules. Each writes and reads its own
+ * private data structures. The clear functions discard the current
+ * event queue and threads before a restart; the threads that the
+ * event queue refers to are collected in the set so that the caller
+ * can delete them all once.
+ */
+/*
+ * Nets are referenced by their allocation index.
+ */
+extern unsigned long vvp_net_to_index(const vvp_net_t*net);
+extern vvp_net_t* vvp_net_from_index(unsigned long idx);
+
+extern void schedule_save_state(vvp_checkpoint_out&out);
+extern void schedule_restore_state(vvp_checkpoint_in&in);
+extern void schedule_clear_state(std::set<vthread_t>&threads);
+
+extern void vthread_save_state(vvp_checkpoint_out&out, vthread_t thr);
+extern vthread_t vthread_restore_new(void);
+extern void vthread_restore_state(vvp_checkpoint_in&in, vthread_t thr);
+extern void vthreads_clear(const std::vector<struct __vpiScope*>&scopes,
+			   std::set<vthread_t>&threads);
+
+extern unsigned long array_count_all(void);
+extern unsigned long array_to_index(vvp_array_t arr);
+extern vvp_array_t array_from_index(unsigned long idx);
+extern void array_save_state(vvp_checkpoint_out&out);
+extern void array_restore_state(vvp_checkpoint_in&in);
+
+extern void vpip_mcd_save_state(vvp_checkpoint_out&out);
+extern void vpip_mcd_restore_state(vvp_checkpoint_in&in);
+
+/*
+ * VPI applications save their own data with vpi_put_data from the
+ * cbStartOfSave and cbEndOfSave callbacks, and read it back with
+ * vpi_get_data from the cbStartOfRestart and cbEndOfRestart
+ * callbacks. These callbacks are not removed when they are called.
+ * Each is numbered (from 1) in the order that callbacks with that
+ * reason were registered, and the number is passed to the callback
+ * in the index member of the s_cb_data. An application that
+ * registers its save and restart callbacks in the same order can
+ * use that number as the id for vpi_put_data/vpi_get_data.
+ */
+extern void vpiStartOfSave(void);
+extern void vpiEndOfSave(void);
+extern void vpiStartOfRestart(void);
+extern void vpiEndOfRestart(void);
+
+extern void vpip_data_save_state(vvp_checkpoint_out&out);
+extern void vpip_data_restore_state(vvp_checkpoint_in&in);
+
+#endif
@@ -24,7 +24,9 @@
 # include  "vvp_cleanup.h"
 #endif
 # include  <cstring>
+# include  <climits>
 # include  <cassert>
+# include  <vector>
 
 /*
  * The code space is broken into chunks, to make for efficient
@@ -38,6 +40,7 @@ const unsigned code_chunk_size = 1024;
 static struct vvp_code_s *first_chunk = 0;
 static struct vvp_code_s *current_chunk = 0;
 static unsigned current_within_chunk = 0;
+static std::vector<struct vvp_code_s*> chunk_list;
 
 /*
  * This initializes the code space. It sets up the first code chunk,
@@ -48,6 +51,7 @@ void codespace_init(void)
       assert(current_chunk == 0);
       first_chunk = new struct vvp_code_s [code_chunk_size];
       current_chunk = first_chunk;
+      chunk_list.push_back(first_chunk);
 
       current_chunk[0].opcode = &of_ZOMBIE;
 
@@ -66,6 +70,7 @@ vvp_code_t codespace_next(void)
 	    current_chunk[code_chunk_size-1].cptr
 		  = new struct vvp_code_s [code_chunk_size];
 	    current_chunk = current_chunk[code_chunk_size-1].cptr;
+	    chunk_list.push_back(current_chunk);
 
 	      /* Put a link opcode on the end of the chunk. */
 	    current_chunk[code_chunk_size-1].opcode = &of_CHUNK_LINK;
@@ -96,6 +101,23 @@ vvp_code_t codespace_null(void)
       return first_chunk + 0;
 }
 
+unsigned long codespace_index(vvp_code_t code)
+{
+      for (unsigned idx = 0 ;  idx < chunk_list.size() ;  idx += 1) {
+	    vvp_code_t base = chunk_list[idx];
+	    if (code >= base && code < base+code_chunk_size)
+		  return idx*code_chunk_size + (code-base);
+      }
+      return ULONG_MAX;
+}
+
+vvp_code_t codespace_from_index(unsigned long idx)
+{
+      if (idx/code_chunk_size >= chunk_list.size())
+	    return 0;
+      return chunk_list[idx/code_chunk_size] + idx%code_chunk_size;
+}
+
 #ifdef CHECK_WITH_VALGRIND
 void codespace_delete(void)
 {
@@ -163,6 +163,7 @@ extern bool of_SUB_WR(vthread_t thr, vvp_code_t code);
 extern bool of_SUBI(vthread_t thr, vvp_code_t code);
 extern bool of_VPI_CALL(vthread_t thr, vvp_code_t code);
 extern bool of_WAIT(vthread_t thr, vvp_code_t code);
+extern bool of_WAIT_P(vthread_t thr, vvp_code_t code);
 extern bool of_XNOR(vthread_t thr, vvp_code_t code);
 extern bool of_XNORR(vthread_t thr, vvp_code_t code);
 extern bool of_XOR(vthread_t thr, vvp_code_t code);
@@ -215,4 +216,13 @@ extern vvp_code_t codespace_allocate(void);
 extern vvp_code_t codespace_next(void);
 extern vvp_code_t codespace_null(void);
 
+/*
+ * Convert between code pointers and their position in the code
+ * space. The position is stable across runs of the same design, so
+ * checkpoints use it to save program counters. The codespace_index
+ * function returns ULONG_MAX for a pointer outside the code space.
+ */
+extern unsigned long codespace_index(vvp_code_t code);
+extern vvp_code_t codespace_from_index(unsigned long idx);
+
 #endif
@@ -203,6 +203,7 @@ static const struct opcode_table_s opcode_table[] = {
       { "%sub/wr", of_SUB_WR, 2,  {OA_BIT1,     OA_BIT2,     OA_NONE} },
       { "%subi",   of_SUBI,   3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
       { "%wait",   of_WAIT,   1,  {OA_FUNC_PTR, OA_NONE,     OA_NONE} },
+      { "%wait/p", of_WAIT_P, 1,  {OA_FUNC_PTR, OA_NONE,     OA_NONE} },
       { "%xnor",   of_XNOR,   3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
       { "%xnor/r", of_XNORR,  3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
       { "%xor",    of_XOR,    3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
@@ -682,6 +683,7 @@ void compile_cleanup(void)
 
       compile_island_cleanup();
       compile_array_cleanup();
+      compile_fuse_parts();
 
       if (verbose_flag) {
 	    fprintf(stderr, " ... Compiletf functions\n");
@@ -1454,28 +1456,34 @@ void compile_shiftr(char*label, long wid, bool signed_flag,
       make_arith(arith, label, argc, argv);
 }
 
+/*
+ * A resolver takes any number of inputs. The first 4 are connected
+ * to the resolver net itself, and the rest to resolv_extend functors
+ * that pass the values to the resolver.
+ */
 void compile_resolver(char*label, char*type, unsigned argc, struct symb_s*argv)
 {
-      assert(argc <= 4);
-      vvp_net_fun_t* obj = 0;
+      vvp_net_t*net = new vvp_net_t;
+      resolv_core* obj = 0;
 
       if (strcmp(type,"tri") == 0) {
-	    obj = new resolv_functor(vvp_scalar_t(BIT4_Z, 0,0));
+	    obj = new resolv_functor(net, argc, vvp_scalar_t(BIT4_Z, 0,0));
 
       } else if (strncmp(type,"tri$",4) == 0) {
-	    obj = new resolv_functor(vvp_scalar_t(BIT4_Z, 0,0), strdup(type+4));
+	    obj = new resolv_functor(net, argc, vvp_scalar_t(BIT4_Z, 0,0),
+				     strdup(type+4));
 
       } else if (strcmp(type,"tri0") == 0) {
-	    obj = new resolv_functor(vvp_scalar_t(BIT4_0, 5,5));
+	    obj = new resolv_functor(net, argc, vvp_scalar_t(BIT4_0, 5,5));
 
       } else if (strcmp(type,"tri1") == 0) {
-	    obj = new resolv_functor(vvp_scalar_t(BIT4_1, 5,5));
+	    obj = new resolv_functor(net, argc, vvp_scalar_t(BIT4_1, 5,5));
 
       } else if (strcmp(type,"triand") == 0) {
-	    obj = new resolv_triand;
+	    obj = new resolv_triand(net, argc);
 
       } else if (strcmp(type,"trior") == 0) {
-	    obj = new resolv_trior;
+	    obj = new resolv_trior(net, argc);
 
       } else {
 	    fprintf(stderr, "invalid resolver type: %s\n", type);
@@ -1483,10 +1491,21 @@ void compile_resolver(char*label, char*type, unsigned argc, struct symb_s*argv)
       }
 
       if (obj) {
-	    vvp_net_t*net = new vvp_net_t;
 	    net->fun = obj;
 	    define_functor_symbol(label, net);
-	    inputs_connect(net, argc, argv);
+
+	    unsigned trans = argc < 4? argc : 4;
+	    inputs_connect(net, trans, argv);
+
+	    for (unsigned base = 4 ;  base < argc ;  base += 4) {
+		  trans = argc - base;
+		  if (trans > 4)
+			trans = 4;
+
+		  vvp_net_t*ptr = new vvp_net_t;
+		  ptr->fun = new resolv_extend(obj, base);
+		  inputs_connect(ptr, trans, argv+base);
+	    }
       }
       free(type);
       free(label);
@@ -147,6 +147,13 @@ extern void compile_part_select_pv(char*label, char*src,
 extern void compile_part_select_var(char*label, char*src,
                                     char*var, unsigned wid, bool is_signed);
 
+/*
+ * This is called after the netlist is linked to replace trees of
+ * static part selects, concatenations and replications with single
+ * routing nodes.
+ */
+extern void compile_fuse_parts(void);
+
 /*
  * This is called by the parser to make the various arithmetic and
  * comparison functors.
@@ -357,13 +364,14 @@ extern void compile_array_port(char*label, char*name, long addr);
 extern void compile_array_cleanup(void);
 
 /*
- * Compile the .ufunc statement.
+ * Compile the .ufunc statement. The pure flag is set for .ufunc/p,
+ * whose results depend only on the inputs and may be reused.
  */
 extern void compile_ufunc(char*label, char*code, unsigned wid,
 			  unsigned argc, struct symb_s*argv,
 			  unsigned portc, struct symb_s*portv,
 			  struct symb_s retv, char*scope_label,
-                          char*trigger_label);
+                          char*trigger_label, bool pure);
 
 /*
  * The compile_event function takes the parts of the event statement
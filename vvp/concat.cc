@@ -19,6 +19,7 @@
 
 # include  "compile.h"
 # include  "vvp_net.h"
+# include  "checkpoint.h"
 # include  <cstdlib>
 # include  <iostream>
 # include  <cassert>
@@ -33,8 +34,13 @@ vvp_fun_concat::vvp_fun_concat(unsigned w0, unsigned w1,
       wid_[2] = w2;
       wid_[3] = w3;
 
-      for (unsigned idx = 0 ;  idx < val_.size() ;  idx += 1)
-	    val_.set_bit(idx, BIT4_Z);
+      unsigned off = 0;
+      for (unsigned idx = 0 ;  idx < 4 ;  idx += 1) {
+	    off_[idx] = off;
+	    off += wid_[idx];
+      }
+
+      val_ = vvp_vector4_t(val_.size(), BIT4_Z);
 }
 
 vvp_fun_concat::~vvp_fun_concat()
@@ -53,13 +59,7 @@ void vvp_fun_concat::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 	    assert(0);
       }
 
-      unsigned off = 0;
-      for (unsigned idx = 0 ;  idx < pdx ;  idx += 1)
-	    off += wid_[idx];
-
-      for (unsigned idx = 0 ;  idx < wid_[pdx] ;  idx += 1) {
-	    val_.set_bit(off+idx, bit.value(idx));
-      }
+      val_.set_vec(off_[pdx], bit);
 
       port.ptr()->send_vec4(val_, 0);
 }
@@ -79,21 +79,30 @@ void vvp_fun_concat::recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 	    assert(0);
       }
 
-      unsigned off = 0;
-      for (unsigned idx = 0 ;  idx < pdx ;  idx += 1)
-	    off += wid_[idx];
-
-      unsigned limit = off + wid_[pdx];
+      unsigned off = off_[pdx] + base;
+      unsigned limit = off_[pdx] + wid_[pdx];
 
-      off += base;
-      for (unsigned idx = 0 ;  idx < wid ;  idx += 1) {
-            if (off+idx >= limit) break;
-	    val_.set_bit(off+idx, bit.value(idx));
+      if (off + wid <= limit) {
+	    val_.set_vec(off, bit);
+      } else {
+	    for (unsigned idx = 0 ;  off+idx < limit ;  idx += 1)
+		  val_.set_bit(off+idx, bit.value(idx));
       }
 
       port.ptr()->send_vec4(val_, 0);
 }
 
+bool vvp_fun_concat::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_vec4(val_);
+      return true;
+}
+
+void vvp_fun_concat::restore_state(vvp_checkpoint_in&in)
+{
+      val_ = in.get_vec4();
+}
+
 void compile_concat(char*label, unsigned w0, unsigned w1,
 		    unsigned w2, unsigned w3,
 		    unsigned argc, struct symb_s*argv)
@@ -119,6 +128,11 @@ vvp_fun_repeat::~vvp_fun_repeat()
 {
 }
 
+bool vvp_fun_repeat::save_state(vvp_checkpoint_out&) const
+{
+      return true;
+}
+
 void vvp_fun_repeat::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                                vvp_context_t)
 {
@@ -126,13 +140,8 @@ void vvp_fun_repeat::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 
       vvp_vector4_t val (wid_);
 
-      for (unsigned rdx = 0 ;  rdx < rep_ ;  rdx += 1) {
-	    unsigned off = rdx * bit.size();
-
-	    for (unsigned idx = 0 ; idx < bit.size() ;  idx += 1)
-		  val.set_bit(off+idx, bit.value(idx));
-
-      }
+      for (unsigned rdx = 0 ;  rdx < rep_ ;  rdx += 1)
+	    val.set_vec(rdx * bit.size(), bit);
 
       port.ptr()->send_vec4(val, 0);
 }
@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2011 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA
+ */
+
+# include  "cycle.h"
+# include  "compile.h"
+# include  "checkpoint.h"
+# include  "statistics.h"
+# include  "dff.h"
+# include  "delay.h"
+# include  "vvp_island.h"
+# include  <cstdio>
+# include  <climits>
+# include  <algorithm>
+# include  <map>
+# include  <vector>
+
+bool cycle_mode = false;
+
+/*
+ * The ordered gates, indexed by rank, and the table that finds the
+ * rank of a gate from its event object. The table is sorted by the
+ * object address for a binary search.
+ */
+typedef std::pair<vvp_gen_event_t,unsigned long> cycle_rank_t;
+static std::vector<cycle_rank_t> rank_table;
+static std::vector<vvp_gen_event_t> gates;
+static std::vector<bool> dirty;
+
+/*
+ * The dirty gates are all within [dirty_lo, dirty_hi). The range is
+ * empty when dirty_lo >= dirty_hi.
+ */
+static unsigned long dirty_lo = ULONG_MAX;
+static unsigned long dirty_hi = 0;
+
+/*
+ * The flip-flop outputs that are waiting for the design to settle.
+ */
+static std::vector<std::pair<vvp_net_t*,vvp_vector4_t> > flops;
+
+static void cycle_settle(void);
+
+/*
+ * The settle event is pending from the first disturbance of the
+ * design until the design has settled. Gates that become dirty while
+ * the design settles are taken by the same pass.
+ */
+struct cycle_settle_s : public vvp_gen_event_s {
+      cycle_settle_s() : pending(false) { }
+      ~cycle_settle_s() { }
+      void run_run() { cycle_settle(); pending = false; }
+      bool pending;
+};
+
+static cycle_settle_s settle_event;
+
+static void request_settle(void)
+{
+      if (settle_event.pending)
+	    return;
+      settle_event.pending = true;
+      schedule_functor(&settle_event);
+}
+
+static bool rank_less(const cycle_rank_t&a, const cycle_rank_t&b)
+{
+      return a.first < b.first;
+}
+
+bool cycle_schedule_functor(vvp_gen_event_t obj)
+{
+      std::vector<cycle_rank_t>::const_iterator cur
+	    = std::lower_bound(rank_table.begin(), rank_table.end(),
+			       cycle_rank_t(obj, 0), rank_less);
+      if (cur == rank_table.end() || cur->first != obj)
+	    return false;
+
+      unsigned long rank = cur->second;
+      if (dirty[rank])
+	    return true;
+
+      dirty[rank] = true;
+      if (rank < dirty_lo)
+	    dirty_lo = rank;
+      if (rank >= dirty_hi)
+	    dirty_hi = rank + 1;
+      request_settle();
+      return true;
+}
+
+void cycle_schedule_flop(vvp_net_t*net, const vvp_vector4_t&val)
+{
+      flops.push_back(std::make_pair(net, val));
+      request_settle();
+}
+
+/*
+ * Send the sampled flip-flop outputs, then evaluate the dirty gates
+ * in rank order. A gate only makes gates of higher rank dirty, so a
+ * single pass is enough, unless a gate output reaches the clock of
+ * the flip-flops (or a VPI callback disturbs the design) and starts
+ * the whole thing over.
+ */
+static void cycle_settle(void)
+{
+      static std::vector<std::pair<vvp_net_t*,vvp_vector4_t> > sending;
+
+      for (;;) {
+	    sending.swap(flops);
+	    for (unsigned idx = 0 ;  idx < sending.size() ;  idx += 1)
+		  sending[idx].first->send_vec4(sending[idx].second, 0);
+	    sending.clear();
+
+	    while (dirty_lo < dirty_hi) {
+		  unsigned long rank = dirty_lo++;
+		  if (! dirty[rank])
+			continue;
+		  dirty[rank] = false;
+		  gates[rank]->run_run();
+	    }
+	    dirty_lo = ULONG_MAX;
+	    dirty_hi = 0;
+
+	    if (flops.empty())
+		  break;
+      }
+}
+
+static bool not_eligible(const char*why)
+{
+      fprintf(stderr, "Design is not eligible for cycle based "
+	      "simulation: %s.\n", why);
+      fprintf(stderr, "Simulating it event driven instead.\n");
+      return false;
+}
+
+bool vvp_cycle_setup(void)
+{
+      unsigned long nets = count_vvp_nets;
+
+      std::map<vvp_net_t*,unsigned long> index;
+      for (unsigned long idx = 0 ;  idx < nets ;  idx += 1)
+	    index[vvp_net_from_index(idx)] = idx;
+
+	// Find the flip-flops and their clock, and count the inputs
+	// of every net that come from nets other than flip-flops.
+      std::vector<unsigned long> fanin (nets, 0);
+      std::vector<vvp_dff*> dffs;
+      vvp_net_t*clock = 0;
+      for (unsigned long idx = 0 ;  idx < nets ;  idx += 1) {
+	    vvp_net_t*net = vvp_net_from_index(idx);
+	    vvp_net_fun_t*fun = net->fun;
+
+	    if (dynamic_cast<vvp_fun_delay*>(fun))
+		  return not_eligible("it has delays");
+	    if (dynamic_cast<vvp_fun_modpath*>(fun)
+		|| dynamic_cast<vvp_fun_modpath_src*>(fun))
+		  return not_eligible("it has specify paths");
+	    if (dynamic_cast<vvp_island_port*>(fun))
+		  return not_eligible("it has switches");
+
+	    bool is_dff = dynamic_cast<vvp_dff*>(fun) != 0;
+	    if (is_dff)
+		  dffs.push_back(static_cast<vvp_dff*>(fun));
+
+	    for (vvp_net_ptr_t cur = net->fanout() ; ! cur.nil()
+		       ; cur = cur.ptr()->port[cur.port()]) {
+		  if (cur.port() == 1 && dynamic_cast<vvp_dff*>(cur.ptr()->fun)) {
+			if (clock && clock != net)
+			      return not_eligible("it has more than one clock");
+			clock = net;
+		  }
+		    // The asynchronous input of a flip-flop changes the
+		    // output between clocks. It is only allowed to be a
+		    // constant, which is not linked.
+		  if (cur.port() == 3 && dynamic_cast<vvp_dff*>(cur.ptr()->fun))
+			return not_eligible("it has asynchronous flip-flop inputs");
+		  std::map<vvp_net_t*,unsigned long>::const_iterator dst
+			= index.find(cur.ptr());
+		  if (! is_dff && dst != index.end())
+			fanin[dst->second] += 1;
+	    }
+      }
+
+      if (dffs.empty())
+	    return not_eligible("it has no flip-flops");
+
+	// Order the nets so that each comes after the nets that feed
+	// it, except that flip-flops do not feed anything. Nets left
+	// over are in a combinational loop.
+      std::vector<unsigned long> order;
+      order.reserve(nets);
+      for (unsigned long idx = 0 ;  idx < nets ;  idx += 1) {
+	    if (fanin[idx] == 0)
+		  order.push_back(idx);
+      }
+
+      for (unsigned long pos = 0 ;  pos < order.size() ;  pos += 1) {
+	    vvp_net_t*net = vvp_net_from_index(order[pos]);
+	    if (dynamic_cast<vvp_dff*>(net->fun))
+		  continue;
+	    for (vvp_net_ptr_t cur = net->fanout() ; ! cur.nil()
+		       ; cur = cur.ptr()->port[cur.port()]) {
+		  std::map<vvp_net_t*,unsigned long>::const_iterator dst
+			= index.find(cur.ptr());
+		  if (dst == index.end())
+			continue;
+		  if (--fanin[dst->second] == 0)
+			order.push_back(dst->second);
+	    }
+      }
+
+      if (order.size() < nets)
+	    return not_eligible("it has a combinational loop");
+
+	// The gates are the nets whose functor schedules itself. They
+	// are ranked in the order of the nets.
+      for (unsigned long pos = 0 ;  pos < order.size() ;  pos += 1) {
+	    vvp_net_t*net = vvp_net_from_index(order[pos]);
+	    if (net->fun == 0)
+		  continue;
+	    vvp_gen_event_t obj = net->fun->checkpoint_event();
+	    if (obj == 0)
+		  continue;
+	    rank_table.push_back(cycle_rank_t(obj, gates.size()));
+	    gates.push_back(obj);
+      }
+      std::sort(rank_table.begin(), rank_table.end(), rank_less);
+      dirty.assign(gates.size(), false);
+
+      for (unsigned idx = 0 ;  idx < dffs.size() ;  idx += 1)
+	    dffs[idx]->set_cycle(true);
+
+      cycle_mode = true;
+
+      if (verbose_flag) {
+	    fprintf(stderr, " ... Cycle based: %lu flip-flops, %lu ordered gates\n",
+		    (unsigned long)dffs.size(), (unsigned long)gates.size());
+	    fflush(stderr);
+      }
+
+      return true;
+}
@@ -0,0 +1,71 @@
+#ifndef __cycle_H
+#define __cycle_H
+/*
+ * Copyright (c) 2011 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA
+ */
+
+# include  "vvp_net.h"
+# include  "schedule.h"
+
+/*
+ * Cycle based evaluation of synchronous designs. The flip-flops of a
+ * synthesized design (the .dff nodes) and the gates between them are
+ * taken out of the event driven delta cycles:
+ *
+ *  - The gates are ordered once, before the simulation starts, so
+ *    that every gate comes after the gates that feed it. A gate whose
+ *    inputs change is only marked dirty, and the marked gates are
+ *    evaluated in that order, each at most once, when the design
+ *    settles.
+ *
+ *  - On the clock edge each flip-flop samples its D input, but its
+ *    new output is only sent when the design settles, so that all the
+ *    flip-flops sample the values from before the edge.
+ *
+ * The design settles in one event at the end of the active events of
+ * the time step that disturbed it, so a clock edge costs one pass
+ * over the dirty gates instead of an event per gate evaluation.
+ *
+ * A design is eligible if all its flip-flops have the same clock, it
+ * has no combinational loops (loops that do not pass through a
+ * flip-flop) and it has no delays, specify paths or switches. The
+ * vvp_cycle_setup function checks that after the design is compiled,
+ * and returns false (after printing the reason) if the design is not
+ * eligible, in which case the simulation is event driven as usual.
+ */
+extern bool vvp_cycle_setup(void);
+
+/*
+ * This is true once the cycle engine has been set up.
+ */
+extern bool cycle_mode;
+
+/*
+ * The scheduler calls this from schedule_functor. If the object is a
+ * gate that the cycle engine ordered, it is marked dirty and this
+ * returns true. Otherwise, the object is scheduled as usual.
+ */
+extern bool cycle_schedule_functor(vvp_gen_event_t obj);
+
+/*
+ * A flip-flop calls this on the clock edge to send its new output
+ * when the design settles.
+ */
+extern void cycle_schedule_flop(vvp_net_t*net, const vvp_vector4_t&val);
+
+#endif
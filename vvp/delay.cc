@@ -21,12 +21,14 @@
 #include "schedule.h"
 #include "vpi_priv.h"
 #include "config.h"
+#include "checkpoint.h"
 #ifdef CHECK_WITH_VALGRIND
 #include "vvp_cleanup.h"
 #endif
 #include <iostream>
 #include <cstdlib>
-#include <list>
+#include <algorithm>
+#include <vector>
 #include <cassert>
 #include <cmath>
 #include "ivl_alloc.h"
@@ -71,6 +73,27 @@ vvp_delay_t::~vvp_delay_t()
 {
 }
 
+/*
+ * The delays are saved because they may have been changed at run
+ * time, for example by SDF annotation.
+ */
+void vvp_delay_t::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_u64(rise_);
+      out.put_u64(fall_);
+      out.put_u64(decay_);
+      out.put_bool(ignore_decay_);
+}
+
+void vvp_delay_t::restore_state(vvp_checkpoint_in&in)
+{
+      rise_ = in.get_u64();
+      fall_ = in.get_u64();
+      decay_ = in.get_u64();
+      ignore_decay_ = in.get_bool();
+      calculate_min_delay_();
+}
+
 vvp_time64_t vvp_delay_t::get_delay(vvp_bit4_t from, vvp_bit4_t to)
 {
       switch (from) {
@@ -470,6 +493,95 @@ void vvp_fun_delay::run_run()
       delete cur;
 }
 
+/*
+ * Each pending output value has its own entry in the list_ and its
+ * own generic event in the scheduler. The checkpoint saves the list,
+ * and the scheduler saves the events (by referring to net_) in order
+ * to restore both.
+ */
+bool vvp_fun_delay::save_state(vvp_checkpoint_out&out) const
+{
+      delay_.save_state(out);
+      out.put_u8(type_);
+      out.put_bool(initial_);
+      out.put_vec4(cur_vec4_);
+      out.put_vec8(cur_vec8_);
+      out.put_double(cur_real_);
+
+      unsigned long count = 0;
+      if (list_) {
+	    struct event_*cur = list_;
+	    do {
+		  count += 1;
+		  cur = cur->next;
+	    } while (cur != list_);
+      }
+      out.put_u32(count);
+
+      if (list_ == 0)
+	    return true;
+
+      struct event_*cur = list_->next;
+      for (unsigned long idx = 0 ;  idx < count ;  idx += 1) {
+	    out.put_u64(cur->sim_time);
+	    if (cur->run_run_ptr == &vvp_fun_delay::run_run_vec4_) {
+		  out.put_u8(VEC4_DELAY);
+		  out.put_vec4(cur->ptr_vec4);
+	    } else if (cur->run_run_ptr == &vvp_fun_delay::run_run_vec8_) {
+		  out.put_u8(VEC8_DELAY);
+		  out.put_vec8(cur->ptr_vec8);
+	    } else {
+		  out.put_u8(REAL_DELAY);
+		  out.put_double(cur->ptr_real);
+	    }
+	    cur = cur->next;
+      }
+      return true;
+}
+
+void vvp_fun_delay::restore_state(vvp_checkpoint_in&in)
+{
+      delay_.restore_state(in);
+      type_ = (delay_type_t)in.get_u8();
+      initial_ = in.get_bool();
+      cur_vec4_ = in.get_vec4();
+      cur_vec8_ = in.get_vec8();
+      cur_real_ = in.get_double();
+
+      while (struct event_*cur = dequeue_())
+	    delete cur;
+
+      unsigned long count = in.get_u32();
+      for (unsigned long idx = 0 ;  idx < count && !in.failed() ;  idx += 1) {
+	    struct event_*cur = new struct event_(in.get_u64());
+	    switch (in.get_u8()) {
+		case VEC4_DELAY:
+		  cur->run_run_ptr = &vvp_fun_delay::run_run_vec4_;
+		  cur->ptr_vec4 = in.get_vec4();
+		  break;
+		case VEC8_DELAY:
+		  cur->run_run_ptr = &vvp_fun_delay::run_run_vec8_;
+		  cur->ptr_vec8 = in.get_vec8();
+		  break;
+		default:
+		  cur->run_run_ptr = &vvp_fun_delay::run_run_real_;
+		  cur->ptr_real = in.get_double();
+		  break;
+	    }
+	    enqueue_(cur);
+      }
+}
+
+vvp_gen_event_t vvp_fun_delay::checkpoint_event()
+{
+      return this;
+}
+
+vvp_net_t* vvp_fun_delay::checkpoint_net(void) const
+{
+      return net_;
+}
+
 void vvp_fun_delay::run_run_vec4_(struct event_*cur)
 {
       cur_vec4_ = cur->ptr_vec4;
@@ -489,7 +601,7 @@ void vvp_fun_delay::run_run_real_(struct vvp_fun_delay::event_*cur)
 }
 
 vvp_fun_modpath::vvp_fun_modpath(vvp_net_t*net, unsigned width)
-: net_(net), src_list_(0), ifnone_list_(0)
+: net_(net), src_list_(0), ifnone_list_(0), sort_needed_(false)
 {
       cur_vec4_ = vvp_vector4_t(width, BIT4_X);
       schedule_init_propagate(net_, cur_vec4_);
@@ -512,18 +624,92 @@ vvp_fun_modpath::~vvp_fun_modpath()
 
 void vvp_fun_modpath::add_modpath_src(vvp_fun_modpath_src*that, bool ifnone)
 {
-      assert(that->next_ == 0);
-      if (ifnone) {
-	    that->next_ = ifnone_list_;
-	    ifnone_list_ = that;
-      } else {
-	    that->next_ = src_list_;
-	    src_list_ = that;
+      assert(that->next_ == 0 && that->owner_ == 0);
+      vvp_fun_modpath_src*&head = ifnone? ifnone_list_ : src_list_;
+
+	/* Sources are added before the simulation starts, so the
+	   wake times are all still 0 and the list remains sorted. */
+      that->owner_ = this;
+      that->ifnone_ = ifnone;
+      that->next_ = head;
+      if (head) head->prev_ = that;
+      head = that;
+}
+
+/*
+ * The source has just been given the latest wake time, so moving it
+ * to the front of its list keeps the list sorted by wake time.
+ */
+void vvp_fun_modpath::src_woke_(vvp_fun_modpath_src*src)
+{
+      vvp_fun_modpath_src*&head = src->ifnone_? ifnone_list_ : src_list_;
+      if (head == src)
+	    return;
+
+      assert(src->prev_);
+      src->prev_->next_ = src->next_;
+      if (src->next_) src->next_->prev_ = src->prev_;
+
+      src->prev_ = 0;
+      src->next_ = head;
+      head->prev_ = src;
+      head = src;
+}
+
+bool vvp_fun_modpath::src_wakes_later_(const vvp_fun_modpath_src*a,
+				       const vvp_fun_modpath_src*b)
+{
+      return a->wake_time_ > b->wake_time_;
+}
+
+void vvp_fun_modpath::sort_src_list_(vvp_fun_modpath_src*&head)
+{
+      vector<vvp_fun_modpath_src*> tmp;
+      for (vvp_fun_modpath_src*cur = head ;  cur ;  cur = cur->next_)
+	    tmp.push_back(cur);
+
+      stable_sort(tmp.begin(), tmp.end(), src_wakes_later_);
+
+      head = 0;
+      for (size_t idx = tmp.size() ;  idx > 0 ;  idx -= 1) {
+	    vvp_fun_modpath_src*cur = tmp[idx-1];
+	    cur->prev_ = 0;
+	    cur->next_ = head;
+	    if (head) head->prev_ = cur;
+	    head = cur;
       }
 }
 
-static vvp_time64_t delay_from_edge(vvp_bit4_t a, vvp_bit4_t b,
-                                           vvp_time64_t array[12])
+void vvp_fun_modpath::sort_src_lists_()
+{
+      sort_src_list_(src_list_);
+      sort_src_list_(ifnone_list_);
+      sort_needed_ = false;
+}
+
+/*
+ * Return the minimum delay to the given output edge from all the
+ * candidate sources from cand up to (but not including) end. Sources
+ * that are disabled by their condition are skipped, unless these are
+ * the ifnone sources.
+ */
+vvp_time64_t vvp_fun_modpath::candidate_delay_(unsigned edge,
+					       vvp_fun_modpath_src*cand,
+					       vvp_fun_modpath_src*end,
+					       bool ifnone, vvp_time64_t now)
+{
+      vvp_time64_t use_delay = cand->out_delay_(edge, now);
+      for (cand = cand->next_ ;  cand != end ;  cand = cand->next_) {
+	    if (!ifnone && cand->condition_flag_ == false)
+		  continue;
+	    vvp_time64_t tmp = cand->out_delay_(edge, now);
+	    if (tmp < use_delay)
+		  use_delay = tmp;
+      }
+      return use_delay;
+}
+
+static delay_edge_t edge_from_bits(vvp_bit4_t a, vvp_bit4_t b)
 {
       typedef delay_edge_t bit4_table4[4];
       static const bit4_table4 edge_table[4] = {
@@ -533,7 +719,7 @@ static vvp_time64_t delay_from_edge(vvp_bit4_t a, vvp_bit4_t b,
 	    { DELAY_EDGE_z0, DELAY_EDGE_z1, DELAY_EDGE_zx, DELAY_EDGE_z0 }
       };
 
-      return array[ edge_table[a][b] ];
+      return edge_table[a][b];
 }
 
 void vvp_fun_modpath::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
@@ -546,103 +732,78 @@ void vvp_fun_modpath::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
       if (cur_vec4_.eeq(bit))
 	    return;
 
-	/* Select a time delay source that applies. Notice that there
-	   may be multiple delay sources that apply, so collect all
-	   the candidates into a list first. */
-      list<vvp_fun_modpath_src*>candidate_list;
+      if (sort_needed_)
+	    sort_src_lists_();
+
+	/* Select the time delay sources that apply. These are the
+	   enabled sources with the latest wake time. There may be
+	   several sources with the same wake time, so collect all of
+	   them. The list is sorted by wake time, so stop at the first
+	   enabled source that woke earlier. */
+      vvp_fun_modpath_src*cand_list = 0;
+      vvp_fun_modpath_src*cand_end = 0;
       vvp_time64_t candidate_wake_time = 0;
       for (vvp_fun_modpath_src*cur = src_list_ ;  cur ;  cur=cur->next_) {
 	      /* Skip paths that are disabled by conditions. */
 	    if (cur->condition_flag_ == false)
 		  continue;
 
-	    if (candidate_list.empty()) {
-		  candidate_list.push_back(cur);
+	    if (cand_list == 0) {
+		  cand_list = cur;
 		  candidate_wake_time = cur->wake_time_;
-	    } else if (cur->wake_time_ == candidate_wake_time) {
-		  candidate_list.push_back(cur);
-	    } else if (cur->wake_time_ > candidate_wake_time) {
-		  candidate_list.assign(1, cur);
-		  candidate_wake_time = cur->wake_time_;
-	    } else {
-		  continue; /* Skip this entry. */
+	    } else if (cur->wake_time_ != candidate_wake_time) {
+		  break;
 	    }
+	    cand_end = cur->next_;
       }
 
-	/* Only add the ifnone delay if it has a later wake_time_ or
-	 * if there are no normal delays. */
-      vvp_time64_t ifnone_wake_time = candidate_wake_time;
-      for (vvp_fun_modpath_src*cur = ifnone_list_ ;  cur ;  cur=cur->next_) {
-	    if (candidate_list.empty()) {
-		  candidate_list.push_back(cur);
-		  ifnone_wake_time = cur->wake_time_;
-	    } else if (cur->wake_time_ == ifnone_wake_time &&
-	               ifnone_wake_time > candidate_wake_time) {
-		  candidate_list.push_back(cur);
-	    } else if (cur->wake_time_ > ifnone_wake_time) {
-		  candidate_list.assign(1, cur);
-		  ifnone_wake_time = cur->wake_time_;
-	    } else {
-		  continue; /* Skip this entry. */
-	    }
+	/* Only use the ifnone delays if they have a later wake_time_
+	 * or if there are no normal delays. The ifnone delays are
+	 * not conditional, so the candidates are the front of the
+	 * list up to the first with an earlier wake time. */
+      bool use_ifnone = false;
+      if (ifnone_list_ && (cand_list == 0 ||
+			   ifnone_list_->wake_time_ > candidate_wake_time)) {
+	    use_ifnone = true;
+	    cand_list = ifnone_list_;
+	    candidate_wake_time = ifnone_list_->wake_time_;
+	    cand_end = ifnone_list_->next_;
+	    while (cand_end && cand_end->wake_time_ == candidate_wake_time)
+		  cand_end = cand_end->next_;
       }
 
 	/* Handle the special case that there are no delays that
 	   match. This may happen, for example, if the set of
 	   conditional delays is incomplete, leaving some cases
 	   uncovered. In that case, just pass the data without delay */
-      if (candidate_list.empty()) {
+      if (cand_list == 0) {
 	    cur_vec4_ = bit;
 	    schedule_generic(this, 0, false);
 	    return;
       }
 
-	/* Now given that we have a list of candidate delays, find for
-	   each if the 12 numbers the minimum from all the
-	   candidates. This minimum set becomes the chosen delay to
-	   use. */
-      vvp_time64_t out_at[12];
+	/* The edge delay is based on only the least bit, so only that
+	   one of the 12 delays is needed. The delay to use is the
+	   minimum of that delay from all the candidates. */
       vvp_time64_t now = schedule_simtime();
+      unsigned edge = edge_from_bits(cur_vec4_.value(0), bit.value(0));
 
-      typedef list<vvp_fun_modpath_src*>::const_iterator iter_t;
-
-      iter_t cur = candidate_list.begin();
-      vvp_fun_modpath_src*src = *cur;
-
-      for (unsigned idx = 0 ;  idx < 12 ;  idx += 1) {
-	    out_at[idx] = src->wake_time_ + src->delay_[idx];
-	    if (out_at[idx] <= now)
-		  out_at[idx] = 0;
-	    else
-		  out_at[idx] -= now;
-      }
-
-      for (cur ++ ; cur != candidate_list.end() ; ++ cur ) {
-	    src = *cur;
-	    for (unsigned idx = 0 ;  idx < 12 ;  idx += 1) {
-		  vvp_time64_t tmp = src->wake_time_ + src->delay_[idx];
-		  if (tmp <= now)
-			tmp = 0;
-		  else
-			tmp -= now;
-		  if (tmp < out_at[idx])
-			out_at[idx] = tmp;
-	    }
-      }
-
-	/* Given the scheduled output time, create an output event. */
-      vvp_time64_t use_delay = delay_from_edge(cur_vec4_.value(0),
-					       bit.value(0),
-					       out_at);
+      vvp_time64_t use_delay;
+      if (cand_list->next_ == cand_end)
+	    use_delay = cand_list->out_delay_(edge, now);
+      else
+	    use_delay = candidate_delay_(edge, cand_list, cand_end,
+					 use_ifnone, now);
 
 	/* FIXME: This bases the edge delay on only the least
 	   bit. This is WRONG! I need to find all the possible delays,
 	   and schedule an event for each partial change. Hard! */
       for (unsigned idx = 1 ;  idx < bit.size() ;  idx += 1) {
-	    vvp_time64_t tmp = delay_from_edge(cur_vec4_.value(idx),
-					       bit.value(0),
-					       out_at);
-	    assert(tmp == use_delay);
+	    unsigned tmp = edge_from_bits(cur_vec4_.value(idx), bit.value(0));
+	    if (tmp == edge)
+		  continue;
+	    assert(candidate_delay_(tmp, cand_list, cand_end,
+				    use_ifnone, now) == use_delay);
       }
 
       cur_vec4_ = bit;
@@ -654,12 +815,36 @@ void vvp_fun_modpath::run_run()
       net_->send_vec4(cur_vec4_, 0);
 }
 
+bool vvp_fun_modpath::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_vec4(cur_vec4_);
+      return true;
+}
+
+void vvp_fun_modpath::restore_state(vvp_checkpoint_in&in)
+{
+      cur_vec4_ = in.get_vec4();
+}
+
+vvp_gen_event_t vvp_fun_modpath::checkpoint_event()
+{
+      return this;
+}
+
+vvp_net_t* vvp_fun_modpath::checkpoint_net(void) const
+{
+      return net_;
+}
+
 vvp_fun_modpath_src::vvp_fun_modpath_src(vvp_time64_t del[12])
 {
       for (unsigned idx = 0 ;  idx < 12 ;  idx += 1)
 	    delay_[idx] = del[idx];
 
+      owner_ = 0;
       next_ = 0;
+      prev_ = 0;
+      ifnone_ = false;
       wake_time_ = 0;
       condition_flag_ = true;
 }
@@ -680,13 +865,25 @@ void vvp_fun_modpath_src::put_delay12(const vvp_time64_t val[12])
 	    delay_[idx] = val[idx];
 }
 
+vvp_time64_t vvp_fun_modpath_src::out_delay_(unsigned edge,
+					     vvp_time64_t now) const
+{
+      vvp_time64_t tmp = wake_time_ + delay_[edge];
+      if (tmp <= now)
+	    return 0;
+      else
+	    return tmp - now;
+}
+
 void vvp_fun_modpath_src::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                                     vvp_context_t)
 {
       if (port.port() == 0) {
 	      // The modpath input...
-	    if (test_vec4(bit))
+	    if (test_vec4(bit)) {
 		  wake_time_ = schedule_simtime();
+		  if (owner_) owner_->src_woke_(this);
+	    }
 
       } else if (port.port() == 1) {
 	      // The modpath condition input...
@@ -702,6 +899,24 @@ bool vvp_fun_modpath_src::test_vec4(const vvp_vector4_t&)
       return true;
 }
 
+bool vvp_fun_modpath_src::save_state(vvp_checkpoint_out&out) const
+{
+      for (unsigned idx = 0 ;  idx < 12 ;  idx += 1)
+	    out.put_u64(delay_[idx]);
+      out.put_u64(wake_time_);
+      out.put_bool(condition_flag_);
+      return true;
+}
+
+void vvp_fun_modpath_src::restore_state(vvp_checkpoint_in&in)
+{
+      for (unsigned idx = 0 ;  idx < 12 ;  idx += 1)
+	    delay_[idx] = in.get_u64();
+      wake_time_ = in.get_u64();
+      condition_flag_ = in.get_bool();
+      if (owner_) owner_->sort_needed_ = true;
+}
+
 vvp_fun_modpath_edge::vvp_fun_modpath_edge(vvp_time64_t del[12],
 					   bool pos, bool neg)
 : vvp_fun_modpath_src(del)
@@ -722,6 +937,19 @@ bool vvp_fun_modpath_edge::test_vec4(const vvp_vector4_t&bit)
       return false;
 }
 
+bool vvp_fun_modpath_edge::save_state(vvp_checkpoint_out&out) const
+{
+      vvp_fun_modpath_src::save_state(out);
+      out.put_u8(old_value_);
+      return true;
+}
+
+void vvp_fun_modpath_edge::restore_state(vvp_checkpoint_in&in)
+{
+      vvp_fun_modpath_src::restore_state(in);
+      old_value_ = (vvp_bit4_t)in.get_u8();
+}
+
 
 /*
  * All the below routines that begin with
@@ -50,6 +50,9 @@ class vvp_delay_t {
       void set_decay(vvp_time64_t val);
       void set_ignore_decay();
 
+      void save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
     private:
       vvp_time64_t rise_, fall_, decay_;
       vvp_time64_t min_delay_;
@@ -98,8 +101,13 @@ class vvp_fun_delay  : public vvp_net_fun_t, private vvp_gen_event_s {
                      vvp_context_t);
 	//void recv_long(vvp_net_ptr_t port, long bit);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+      vvp_gen_event_t checkpoint_event();
+
     private:
       virtual void run_run();
+      vvp_net_t* checkpoint_net(void) const;
 
 
       void run_run_vec4_(struct vvp_fun_delay::event_*cur);
@@ -154,6 +162,13 @@ class vvp_fun_delay  : public vvp_net_fun_t, private vvp_gen_event_s {
 * inputs to enable delays, and the vvp_fun_modpath, when it's time to
 * schedule, looks at the associated modpath_src objects for which
 * paths are active.
+*
+* The vvp_fun_modpath keeps its modpath_src objects in two lists (the
+* conditional/unconditional paths and the ifnone paths) ordered by
+* wake time, the most recently woken first. Simulation time only moves
+* forward, so a source that wakes is simply moved to the front of its
+* list, and the path selection only needs to look at the front of the
+* lists instead of scanning every source for each output change.
 */
 class vvp_fun_modpath;
 class vvp_fun_modpath_src;
@@ -169,8 +184,25 @@ class vvp_fun_modpath  : public vvp_net_fun_t, private vvp_gen_event_s {
       void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                      vvp_context_t);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+      vvp_gen_event_t checkpoint_event();
+
     private:
       virtual void run_run();
+      vvp_net_t* checkpoint_net(void) const;
+
+      friend class vvp_fun_modpath_src;
+	// Called by a modpath_src when its wake time changes.
+      void src_woke_(vvp_fun_modpath_src*src);
+      void sort_src_lists_();
+      static void sort_src_list_(vvp_fun_modpath_src*&head);
+      static bool src_wakes_later_(const vvp_fun_modpath_src*a,
+				   const vvp_fun_modpath_src*b);
+      static vvp_time64_t candidate_delay_(unsigned edge,
+					   vvp_fun_modpath_src*cand,
+					   vvp_fun_modpath_src*end,
+					   bool ifnone, vvp_time64_t now);
 
     private:
       vvp_net_t*net_;
@@ -179,6 +211,10 @@ class vvp_fun_modpath  : public vvp_net_fun_t, private vvp_gen_event_s {
 
       vvp_fun_modpath_src*src_list_;
       vvp_fun_modpath_src*ifnone_list_;
+	// Set when the wake times of the sources are changed other
+	// than by the simulation (i.e. restored from a checkpoint) so
+	// that the lists must be sorted again.
+      bool sort_needed_;
 
     private: // not implemented
       vvp_fun_modpath(const vvp_fun_modpath&);
@@ -202,11 +238,21 @@ class vvp_fun_modpath_src  : public vvp_net_fun_t {
       void get_delay12(vvp_time64_t out[12]) const;
       void put_delay12(const vvp_time64_t in[12]);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
+    private:
+	// The delay to the output edge, relative to the current time.
+      vvp_time64_t out_delay_(unsigned edge, vvp_time64_t now) const;
+
     private:
 	// FIXME: Needs to be a 12-value array
       vvp_time64_t delay_[12];
 	// Used by vvp_fun_modpath to keep a list of modpath_src objects.
+      vvp_fun_modpath*owner_;
       vvp_fun_modpath_src*next_;
+      vvp_fun_modpath_src*prev_;
+      bool ifnone_;
 
       vvp_time64_t wake_time_;
       bool condition_flag_;
@@ -223,6 +269,9 @@ class vvp_fun_modpath_edge  : public vvp_fun_modpath_src {
 
       bool test_vec4(const vvp_vector4_t&bit);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
     private:
       vvp_bit4_t old_value_;
       bool posedge_;
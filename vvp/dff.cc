@@ -20,6 +20,8 @@
 # include  "compile.h"
 # include  "schedule.h"
 # include  "dff.h"
+# include  "cycle.h"
+# include  "checkpoint.h"
 # include  <climits>
 # include  <cstdio>
 # include  <cassert>
@@ -27,7 +29,7 @@
 # include  <iostream>
 
 vvp_dff::vvp_dff(bool invert_clk, bool invert_ce)
-: iclk_(invert_clk), ice_(invert_ce)
+: iclk_(invert_clk), ice_(invert_ce), cycle_(false)
 {
       clk_cur_ = BIT4_X;
       enable_ = BIT4_X;
@@ -37,6 +39,21 @@ vvp_dff::~vvp_dff()
 {
 }
 
+bool vvp_dff::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_u8(clk_cur_);
+      out.put_u8(enable_);
+      out.put_vec4(d_);
+      return true;
+}
+
+void vvp_dff::restore_state(vvp_checkpoint_in&in)
+{
+      clk_cur_ = (vvp_bit4_t)in.get_u8();
+      enable_ = (vvp_bit4_t)in.get_u8();
+      d_ = in.get_vec4();
+}
+
 void vvp_dff::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                         vvp_context_t)
 {
@@ -55,7 +72,11 @@ void vvp_dff::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 		  break;
 	    tmp = clk_cur_;
 	    clk_cur_ = bit.value(0);
-	    if (clk_cur_ == BIT4_1 && tmp != BIT4_1)
+	    if (clk_cur_ != BIT4_1 || tmp == BIT4_1)
+		  break;
+	    if (cycle_)
+		  cycle_schedule_flop(port.ptr(), d_);
+	    else
 		  port.ptr()->send_vec4(d_, 0);
 	    break;
 
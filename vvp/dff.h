@@ -42,8 +42,17 @@ class vvp_dff  : public vvp_net_fun_t {
       void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                      vvp_context_t);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
+	// In cycle based mode (see cycle.h) the clock edge only
+	// samples the D input, and the output is sent when the design
+	// settles.
+      void set_cycle(bool flag) { cycle_ = flag; }
+
     private:
       bool iclk_, ice_;
+      bool cycle_;
       vvp_bit4_t clk_cur_;
       vvp_bit4_t enable_;
       vvp_vector4_t d_;
@@ -22,6 +22,7 @@
 # include  "vthread.h"
 # include  "schedule.h"
 # include  "vpi_priv.h"
+# include  "checkpoint.h"
 # include  "config.h"
 #ifdef CHECK_WITH_VALGRIND
 # include  "vvp_cleanup.h"
@@ -49,12 +50,20 @@ void waitable_hooks_s::run_waiting_threads_(vthread_t&threads)
       }
 
       vthread_t tmp = threads;
-      if (tmp == 0) return;
       threads = 0;
+      if (persistent_threads)
+	    tmp = vthread_wake_persistent(persistent_threads, tmp);
+      if (tmp == 0) return;
 
       vthread_schedule_list(tmp);
 }
 
+void waitable_hooks_s::check_event_ctls_(vvp_checkpoint_out&out) const
+{
+      if (event_ctls)
+	    out.refuse("a nonblocking assignment is waiting on an event");
+}
+
 evctl::evctl(unsigned long ecount)
 {
       ecount_ = ecount;
@@ -226,6 +235,20 @@ vvp_fun_edge::~vvp_fun_edge()
 {
 }
 
+bool vvp_fun_edge::save_state(vvp_checkpoint_out&out) const
+{
+      check_event_ctls_(out);
+      for (unsigned idx = 0 ;  idx < 4 ;  idx += 1)
+	    out.put_u8(bits_[idx]);
+      return true;
+}
+
+void vvp_fun_edge::restore_state(vvp_checkpoint_in&in)
+{
+      for (unsigned idx = 0 ;  idx < 4 ;  idx += 1)
+	    bits_[idx] = (vvp_bit4_t)in.get_u8();
+}
+
 bool vvp_fun_edge::recv_vec4_(const vvp_vector4_t&bit,
                               vvp_bit4_t&old_bit, vthread_t&threads)
 {
@@ -251,6 +274,19 @@ vvp_fun_edge_sa::~vvp_fun_edge_sa()
 {
 }
 
+bool vvp_fun_edge_sa::save_state(vvp_checkpoint_out&out) const
+{
+      vvp_fun_edge::save_state(out);
+      out.put_thread(threads_);
+      return true;
+}
+
+void vvp_fun_edge_sa::restore_state(vvp_checkpoint_in&in)
+{
+      vvp_fun_edge::restore_state(in);
+      threads_ = in.get_thread();
+}
+
 vthread_t vvp_fun_edge_sa::add_waiting_thread(vthread_t thread)
 {
       vthread_t tmp = threads_;
@@ -368,6 +404,24 @@ vvp_fun_anyedge::~vvp_fun_anyedge()
 {
 }
 
+bool vvp_fun_anyedge::save_state(vvp_checkpoint_out&out) const
+{
+      check_event_ctls_(out);
+      for (unsigned idx = 0 ;  idx < 4 ;  idx += 1) {
+	    out.put_vec4(bits_[idx]);
+	    out.put_double(bitsr_[idx]);
+      }
+      return true;
+}
+
+void vvp_fun_anyedge::restore_state(vvp_checkpoint_in&in)
+{
+      for (unsigned idx = 0 ;  idx < 4 ;  idx += 1) {
+	    bits_[idx] = in.get_vec4();
+	    bitsr_[idx] = in.get_double();
+      }
+}
+
 bool vvp_fun_anyedge::recv_vec4_(const vvp_vector4_t&bit,
                                  vvp_vector4_t&old_bits, vthread_t&threads)
 {
@@ -426,6 +480,19 @@ vvp_fun_anyedge_sa::~vvp_fun_anyedge_sa()
 {
 }
 
+bool vvp_fun_anyedge_sa::save_state(vvp_checkpoint_out&out) const
+{
+      vvp_fun_anyedge::save_state(out);
+      out.put_thread(threads_);
+      return true;
+}
+
+void vvp_fun_anyedge_sa::restore_state(vvp_checkpoint_in&in)
+{
+      vvp_fun_anyedge::restore_state(in);
+      threads_ = in.get_thread();
+}
+
 vthread_t vvp_fun_anyedge_sa::add_waiting_thread(vthread_t thread)
 {
       vthread_t tmp = threads_;
@@ -568,6 +635,12 @@ vvp_fun_event_or::~vvp_fun_event_or()
 {
 }
 
+bool vvp_fun_event_or::save_state(vvp_checkpoint_out&out) const
+{
+      check_event_ctls_(out);
+      return true;
+}
+
 vvp_fun_event_or_sa::vvp_fun_event_or_sa()
 : threads_(0)
 {
@@ -577,6 +650,18 @@ vvp_fun_event_or_sa::~vvp_fun_event_or_sa()
 {
 }
 
+bool vvp_fun_event_or_sa::save_state(vvp_checkpoint_out&out) const
+{
+      vvp_fun_event_or::save_state(out);
+      out.put_thread(threads_);
+      return true;
+}
+
+void vvp_fun_event_or_sa::restore_state(vvp_checkpoint_in&in)
+{
+      threads_ = in.get_thread();
+}
+
 vthread_t vvp_fun_event_or_sa::add_waiting_thread(vthread_t thread)
 {
       vthread_t tmp = threads_;
@@ -664,6 +749,12 @@ vvp_named_event::~vvp_named_event()
 {
 }
 
+bool vvp_named_event::save_state(vvp_checkpoint_out&out) const
+{
+      check_event_ctls_(out);
+      return true;
+}
+
 vvp_named_event_sa::vvp_named_event_sa(struct __vpiHandle*h)
 : vvp_named_event(h), threads_(0)
 {
@@ -673,6 +764,18 @@ vvp_named_event_sa::~vvp_named_event_sa()
 {
 }
 
+bool vvp_named_event_sa::save_state(vvp_checkpoint_out&out) const
+{
+      vvp_named_event::save_state(out);
+      out.put_thread(threads_);
+      return true;
+}
+
+void vvp_named_event_sa::restore_state(vvp_checkpoint_in&in)
+{
+      threads_ = in.get_thread();
+}
+
 vthread_t vvp_named_event_sa::add_waiting_thread(vthread_t thread)
 {
       vthread_t tmp = threads_;
@@ -121,16 +121,23 @@ extern void schedule_evctl(vvp_array_t memory, unsigned index,
 struct waitable_hooks_s {
 
     public:
-      waitable_hooks_s() : event_ctls(0) { last = &event_ctls; }
+      waitable_hooks_s() : event_ctls(0), persistent_threads(0)
+      { last = &event_ctls; }
       virtual ~waitable_hooks_s() {}
 
       virtual vthread_t add_waiting_thread(vthread_t thread) = 0;
 
       evctl*event_ctls;
       evctl**last;
+	// The threads that wait here with %wait/p. These stay in the
+	// list, and are woken whenever they are actually waiting.
+      vthread_t persistent_threads;
 
     protected:
       void run_waiting_threads_(vthread_t&threads);
+	// The event controls of nonblocking assignments cannot be
+	// saved in a checkpoint, so this refuses if there are any.
+      void check_event_ctls_(vvp_checkpoint_out&out) const;
 };
 
 /*
@@ -156,6 +163,9 @@ class vvp_fun_edge : public vvp_net_fun_t, public waitable_hooks_s {
       explicit vvp_fun_edge(edge_t e);
       virtual ~vvp_fun_edge();
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
     protected:
       bool recv_vec4_(const vvp_vector4_t&bit,
                       vvp_bit4_t&old_bit, vthread_t&threads);
@@ -187,6 +197,9 @@ class vvp_fun_edge_sa : public vvp_fun_edge {
 			unsigned base, unsigned wid, unsigned vwid,
 			vvp_context_t context);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
     private:
       vthread_t threads_;
 };
@@ -232,6 +245,9 @@ class vvp_fun_anyedge : public vvp_net_fun_t, public waitable_hooks_s {
       explicit vvp_fun_anyedge();
       virtual ~vvp_fun_anyedge();
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
     protected:
       bool recv_vec4_(const vvp_vector4_t&bit,
                       vvp_vector4_t&old_bits, vthread_t&threads);
@@ -263,6 +279,9 @@ class vvp_fun_anyedge_sa : public vvp_fun_anyedge {
       void recv_real(vvp_net_ptr_t port, double bit,
                      vvp_context_t context);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
     private:
       vthread_t threads_;
 };
@@ -304,6 +323,8 @@ class vvp_fun_event_or : public vvp_net_fun_t, public waitable_hooks_s {
     public:
       explicit vvp_fun_event_or();
       ~vvp_fun_event_or();
+
+      bool save_state(vvp_checkpoint_out&out) const;
 };
 
 /*
@@ -320,6 +341,9 @@ class vvp_fun_event_or_sa : public vvp_fun_event_or {
       void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                      vvp_context_t context);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
     private:
       vthread_t threads_;
 };
@@ -360,6 +384,8 @@ class vvp_named_event : public vvp_net_fun_t, public waitable_hooks_s {
       explicit vvp_named_event(struct __vpiHandle*eh);
       ~vvp_named_event();
 
+      bool save_state(vvp_checkpoint_out&out) const;
+
     protected:
       struct __vpiHandle*handle_;
 };
@@ -378,6 +404,9 @@ class vvp_named_event_sa : public vvp_named_event {
       void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                      vvp_context_t);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
     private:
       vthread_t threads_;
 };
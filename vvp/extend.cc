@@ -32,6 +32,11 @@ vvp_fun_extend_signed::~vvp_fun_extend_signed()
 {
 }
 
+bool vvp_fun_extend_signed::save_state(vvp_checkpoint_out&) const
+{
+      return true;
+}
+
 void vvp_fun_extend_signed::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                                       vvp_context_t)
 {
@@ -0,0 +1,333 @@
+/*
+ * Copyright (c) 2011 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA
+ */
+
+# include  "lazy.h"
+# include  "compile.h"
+# include  "checkpoint.h"
+# include  "statistics.h"
+# include  "logic.h"
+# include  "part.h"
+# include  "arith.h"
+# include  "resolv.h"
+# include  "delay.h"
+# include  "vvp_net_sig.h"
+# include  <cstdio>
+# include  <climits>
+# include  <algorithm>
+# include  <map>
+# include  <vector>
+
+bool lazy_mode = false;
+
+/*
+ * The lazy gates, indexed by rank, and the table that finds the rank
+ * of a gate from its event object. The table is sorted by the object
+ * address for a binary search. A gate that something started to
+ * watch is no longer lazy, but keeps its rank.
+ */
+typedef std::pair<vvp_gen_event_t,unsigned long> lazy_rank_t;
+static std::vector<lazy_rank_t> rank_table;
+static std::vector<vvp_gen_event_t> gates;
+static std::vector<bool> gate_lazy;
+static std::vector<bool> dirty;
+
+/*
+ * The dirty gates are all within [dirty_lo, dirty_hi).
+ */
+static unsigned long dirty_lo = ULONG_MAX;
+static unsigned long dirty_hi = 0;
+
+/*
+ * These are the nets that no one watches, sorted by address. Lazy
+ * gates may feed them. Each lists the nets of the same kind that
+ * drive it, so that an observer can find the gates that feed a net. The rank is the rank
+ * of the gate of the net, or ULONG_MAX if it is not a gate.
+ */
+struct lazy_net_s {
+      vvp_net_t*net;
+      bool fed;
+      unsigned long rank;
+      std::vector<vvp_net_t*> drivers;
+};
+static std::vector<lazy_net_s> lazy_nets;
+
+static bool rank_less(const lazy_rank_t&a, const lazy_rank_t&b)
+{
+      return a.first < b.first;
+}
+
+static bool lazy_net_less(const lazy_net_s&a, const lazy_net_s&b)
+{
+      return a.net < b.net;
+}
+
+static lazy_net_s* find_lazy_net(vvp_net_t*net)
+{
+      lazy_net_s key;
+      key.net = net;
+      std::vector<lazy_net_s>::iterator cur
+	    = std::lower_bound(lazy_nets.begin(), lazy_nets.end(),
+			       key, lazy_net_less);
+      if (cur == lazy_nets.end() || cur->net != net)
+	    return 0;
+      return &*cur;
+}
+
+bool lazy_schedule_functor(vvp_gen_event_t obj)
+{
+      std::vector<lazy_rank_t>::const_iterator cur
+	    = std::lower_bound(rank_table.begin(), rank_table.end(),
+			       lazy_rank_t(obj, 0), rank_less);
+      if (cur == rank_table.end() || cur->first != obj)
+	    return false;
+
+      unsigned long rank = cur->second;
+      if (! gate_lazy[rank])
+	    return false;
+
+      if (! dirty[rank]) {
+	    dirty[rank] = true;
+	    if (rank < dirty_lo)
+		  dirty_lo = rank;
+	    if (rank >= dirty_hi)
+		  dirty_hi = rank + 1;
+      }
+      return true;
+}
+
+void lazy_flush(void)
+{
+      while (dirty_lo < dirty_hi) {
+	    unsigned long rank = dirty_lo++;
+	    if (! dirty[rank])
+		  continue;
+	    dirty[rank] = false;
+	    gates[rank]->run_run();
+      }
+      dirty_lo = ULONG_MAX;
+      dirty_hi = 0;
+}
+
+void lazy_demand_(vvp_net_t*net)
+{
+      if (dirty_lo >= dirty_hi)
+	    return;
+
+      lazy_net_s*cur = find_lazy_net(net);
+      if (cur && cur->fed)
+	    lazy_flush();
+}
+
+void lazy_observe_(vvp_net_t*net)
+{
+      lazy_net_s*cur = find_lazy_net(net);
+      if (cur == 0 || ! cur->fed)
+	    return;
+
+      lazy_flush();
+
+      std::vector<lazy_net_s*> work;
+      work.push_back(cur);
+      while (! work.empty()) {
+	    cur = work.back();
+	    work.pop_back();
+	    if (! cur->fed)
+		  continue;
+	    cur->fed = false;
+	    if (cur->rank != ULONG_MAX)
+		  gate_lazy[cur->rank] = false;
+	    for (unsigned idx = 0 ;  idx < cur->drivers.size() ;  idx += 1) {
+		  lazy_net_s*drv = find_lazy_net(cur->drivers[idx]);
+		  if (drv)
+			work.push_back(drv);
+	    }
+      }
+}
+
+/*
+ * A gate is a functor that schedules its own output event, other
+ * than the delay nodes, whose events are in the future.
+ */
+static bool is_gate(vvp_net_fun_t*fun)
+{
+      if (fun == 0 || fun->checkpoint_event() == 0)
+	    return false;
+      if (dynamic_cast<vvp_fun_delay*>(fun) || dynamic_cast<vvp_fun_modpath*>(fun))
+	    return false;
+      return true;
+}
+
+/*
+ * These functors pass their (combinational) result on as soon as an
+ * input changes, and have no other effects, so a lazy gate may feed
+ * them. Anything else watches its inputs.
+ */
+static bool is_transparent(vvp_net_fun_t*fun)
+{
+      return dynamic_cast<vvp_fun_bufz*>(fun)
+	    || dynamic_cast<vvp_fun_signal_base*>(fun)
+	    || dynamic_cast<vvp_fun_concat*>(fun)
+	    || dynamic_cast<vvp_fun_repeat*>(fun)
+	    || dynamic_cast<vvp_fun_extend_signed*>(fun)
+	    || dynamic_cast<vvp_fun_drive*>(fun)
+	    || dynamic_cast<vvp_fun_part_pv*>(fun)
+	    || dynamic_cast<vvp_fun_route*>(fun)
+	    || dynamic_cast<vvp_fun_part_var_sa*>(fun)
+	    || dynamic_cast<vvp_arith_*>(fun)
+	    || dynamic_cast<vvp_arith_real_*>(fun)
+	    || dynamic_cast<resolv_core*>(fun)
+	    || dynamic_cast<resolv_extend*>(fun);
+}
+
+/*
+ * Mark the nets observed, and everything that drives them.
+ */
+static void observe_drivers(std::vector<unsigned long>&work,
+			    std::vector<bool>&observed,
+			    const std::vector<std::vector<unsigned long> >&drivers)
+{
+      while (! work.empty()) {
+	    unsigned long idx = work.back();
+	    work.pop_back();
+	    for (unsigned pdx = 0 ;  pdx < drivers[idx].size() ;  pdx += 1) {
+		  unsigned long drv = drivers[idx][pdx];
+		  if (observed[drv])
+			continue;
+		  observed[drv] = true;
+		  work.push_back(drv);
+	    }
+      }
+}
+
+void vvp_lazy_setup(void)
+{
+      unsigned long nets = count_vvp_nets;
+
+      std::map<vvp_net_t*,unsigned long> index;
+      for (unsigned long idx = 0 ;  idx < nets ;  idx += 1)
+	    index[vvp_net_from_index(idx)] = idx;
+
+	// Find what drives each net, and the nets that are watched.
+      std::vector<std::vector<unsigned long> > drivers (nets);
+      std::vector<bool> observed (nets, false);
+      std::vector<unsigned long> work;
+      for (unsigned long idx = 0 ;  idx < nets ;  idx += 1) {
+	    vvp_net_t*net = vvp_net_from_index(idx);
+
+	    if (net->fil && net->fil->has_vpi_callbacks())
+		  observed[idx] = true;
+	    else if (! is_gate(net->fun) && ! is_transparent(net->fun))
+		  observed[idx] = true;
+	    if (observed[idx])
+		  work.push_back(idx);
+
+	    for (vvp_net_ptr_t cur = net->fanout() ; ! cur.nil()
+		       ; cur = cur.ptr()->port[cur.port()]) {
+		  std::map<vvp_net_t*,unsigned long>::const_iterator dst
+			= index.find(cur.ptr());
+		  if (dst != index.end())
+			drivers[dst->second].push_back(idx);
+	    }
+      }
+      observe_drivers(work, observed, drivers);
+
+	// Order the rest so that each net comes after the nets that
+	// feed it. Nets that cannot be ordered are in or after a
+	// combinational loop, and are left eager.
+      std::vector<unsigned long> fanin (nets, 0);
+      for (unsigned long idx = 0 ;  idx < nets ;  idx += 1) {
+	    if (observed[idx])
+		  continue;
+	    for (unsigned pdx = 0 ;  pdx < drivers[idx].size() ;  pdx += 1) {
+		  if (! observed[drivers[idx][pdx]])
+			fanin[idx] += 1;
+	    }
+      }
+
+      std::vector<unsigned long> order;
+      for (unsigned long idx = 0 ;  idx < nets ;  idx += 1) {
+	    if (! observed[idx] && fanin[idx] == 0)
+		  order.push_back(idx);
+      }
+      for (unsigned long pos = 0 ;  pos < order.size() ;  pos += 1) {
+	    vvp_net_t*net = vvp_net_from_index(order[pos]);
+	    for (vvp_net_ptr_t cur = net->fanout() ; ! cur.nil()
+		       ; cur = cur.ptr()->port[cur.port()]) {
+		  std::map<vvp_net_t*,unsigned long>::const_iterator dst
+			= index.find(cur.ptr());
+		  if (dst == index.end() || observed[dst->second])
+			continue;
+		  if (--fanin[dst->second] == 0)
+			order.push_back(dst->second);
+	    }
+      }
+
+      for (unsigned long idx = 0 ;  idx < nets ;  idx += 1) {
+	    if (! observed[idx] && fanin[idx] != 0) {
+		  observed[idx] = true;
+		  work.push_back(idx);
+	    }
+      }
+      observe_drivers(work, observed, drivers);
+
+	// The gates left are lazy, and are ranked in order.
+      unsigned long count_gates = 0;
+      for (unsigned long pos = 0 ;  pos < order.size() ;  pos += 1) {
+	    unsigned long idx = order[pos];
+	    if (observed[idx])
+		  continue;
+
+	    vvp_net_t*net = vvp_net_from_index(idx);
+	    lazy_net_s cur;
+	    cur.net = net;
+	    cur.fed = true;
+	    cur.rank = ULONG_MAX;
+	    for (unsigned pdx = 0 ;  pdx < drivers[idx].size() ;  pdx += 1) {
+		  unsigned long drv = drivers[idx][pdx];
+		  if (! observed[drv])
+			cur.drivers.push_back(vvp_net_from_index(drv));
+	    }
+
+	    if (is_gate(net->fun)) {
+		  vvp_gen_event_t obj = net->fun->checkpoint_event();
+		  cur.rank = gates.size();
+		  rank_table.push_back(lazy_rank_t(obj, cur.rank));
+		  gates.push_back(obj);
+	    }
+	    lazy_nets.push_back(cur);
+      }
+
+      for (unsigned long idx = 0 ;  idx < nets ;  idx += 1) {
+	    if (is_gate(vvp_net_from_index(idx)->fun))
+		  count_gates += 1;
+      }
+
+      std::sort(rank_table.begin(), rank_table.end(), rank_less);
+      std::sort(lazy_nets.begin(), lazy_nets.end(), lazy_net_less);
+      gate_lazy.assign(gates.size(), true);
+      dirty.assign(gates.size(), false);
+
+      lazy_mode = ! gates.empty();
+
+      if (verbose_flag) {
+	    fprintf(stderr, " ... Lazy: %lu of %lu gates are not observed\n",
+		    (unsigned long)gates.size(), count_gates);
+	    fflush(stderr);
+      }
+}
@@ -0,0 +1,84 @@
+#ifndef __lazy_H
+#define __lazy_H
+/*
+ * Copyright (c) 2011 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA
+ */
+
+# include  "vvp_net.h"
+# include  "schedule.h"
+
+/*
+ * Demand driven evaluation of unobserved logic. Much of a netlist
+ * (debug muxes, unused outputs, observability logic) feeds nothing
+ * that watches it: no event that a thread waits on, no flip-flop,
+ * no VPI callback (and so no dump file). Such a gate is marked lazy.
+ * When its inputs change, it is only marked dirty, and the dirty
+ * gates are evaluated (in order, so that each gate is evaluated once
+ * after the gates that feed it) when something reads a net that a
+ * lazy gate feeds. The readers are the thread load instructions and
+ * vpi_get_value.
+ *
+ * A VPI callback or a continuous assign/force link that is attached
+ * to such a net while the simulation runs makes the gates that feed
+ * the net eager again, after they are brought up to date.
+ *
+ * vvp_lazy_setup finds the lazy gates after the design is compiled.
+ */
+extern void vvp_lazy_setup(void);
+
+/*
+ * This is true once some gates have been marked lazy.
+ */
+extern bool lazy_mode;
+
+/*
+ * The scheduler calls this from schedule_functor. If the object is a
+ * lazy gate, it is marked dirty and this returns true.
+ */
+extern bool lazy_schedule_functor(vvp_gen_event_t obj);
+
+extern void lazy_demand_(vvp_net_t*net);
+extern void lazy_observe_(vvp_net_t*net);
+
+/*
+ * Call this before reading the value of the net. If it is fed by lazy
+ * gates, the dirty gates are evaluated.
+ */
+inline void lazy_demand(vvp_net_t*net)
+{
+      if (lazy_mode)
+	    lazy_demand_(net);
+}
+
+/*
+ * Call this when something starts watching the net. The gates that
+ * feed the net are brought up to date and are no longer lazy.
+ */
+inline void lazy_observe(vvp_net_t*net)
+{
+      if (lazy_mode)
+	    lazy_observe_(net);
+}
+
+/*
+ * Evaluate all the dirty gates. The checkpoint calls this so that the
+ * saved net values are up to date.
+ */
+extern void lazy_flush(void);
+
+#endif
@@ -24,6 +24,7 @@
 # include  "schedule.h"
 # include  "delay.h"
 # include  "statistics.h"
+# include  "checkpoint.h"
 # include  <iostream>
 # include  <cstring>
 # include  <cassert>
@@ -73,6 +74,29 @@ void vvp_fun_boolean_::recv_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       }
 }
 
+/*
+ * The gates only schedule themselves for the current time step, so
+ * there is never an event pending when a checkpoint is taken. Only
+ * the input values are saved.
+ */
+bool vvp_fun_boolean_::save_state(vvp_checkpoint_out&out) const
+{
+      for (unsigned idx = 0 ;  idx < 4 ;  idx += 1)
+	    out.put_vec4(input_[idx]);
+      return true;
+}
+
+void vvp_fun_boolean_::restore_state(vvp_checkpoint_in&in)
+{
+      for (unsigned idx = 0 ;  idx < 4 ;  idx += 1)
+	    input_[idx] = in.get_vec4();
+}
+
+vvp_gen_event_t vvp_fun_boolean_::checkpoint_event()
+{
+      return this;
+}
+
 vvp_fun_and::vvp_fun_and(unsigned wid, bool invert)
 : vvp_fun_boolean_(wid), invert_(invert)
 {
@@ -109,6 +133,125 @@ void vvp_fun_and::run_run()
       ptr->send_vec4(result, 0);
 }
 
+/*
+ * The truth tables are indexed by the packed inputs, port 0 in the
+ * low two bits, and hold the vvp_bit4_t of the result. They are built
+ * with the same bit operators the vector gates use, so both forms give
+ * the same result for every combination of 0, 1, x and z inputs.
+ */
+static unsigned char scalar_gate_tables[3][2][256];
+
+static const unsigned char* scalar_gate_table(vvp_fun_scalar_gate::op_t op,
+					      bool invert)
+{
+      static bool built = false;
+
+      if (! built) {
+	    for (unsigned idx = 0 ;  idx < 256 ;  idx += 1) {
+		  vvp_bit4_t and_bit = (vvp_bit4_t) (idx & 3);
+		  vvp_bit4_t or_bit  = and_bit;
+		  vvp_bit4_t xor_bit = and_bit;
+		  for (unsigned pdx = 1 ;  pdx < 4 ;  pdx += 1) {
+			vvp_bit4_t bit = (vvp_bit4_t) ((idx >> 2*pdx) & 3);
+			and_bit = and_bit & bit;
+			or_bit  = or_bit  | bit;
+			xor_bit = xor_bit ^ bit;
+		  }
+		  scalar_gate_tables[vvp_fun_scalar_gate::AND][0][idx] = and_bit;
+		  scalar_gate_tables[vvp_fun_scalar_gate::AND][1][idx] = ~and_bit;
+		  scalar_gate_tables[vvp_fun_scalar_gate::OR][0][idx]  = or_bit;
+		  scalar_gate_tables[vvp_fun_scalar_gate::OR][1][idx]  = ~or_bit;
+		  scalar_gate_tables[vvp_fun_scalar_gate::XOR][0][idx] = xor_bit;
+		  scalar_gate_tables[vvp_fun_scalar_gate::XOR][1][idx] = ~xor_bit;
+	    }
+	    built = true;
+      }
+
+      return scalar_gate_tables[op][invert? 1 : 0];
+}
+
+vvp_fun_scalar_gate::vvp_fun_scalar_gate(op_t op, bool invert)
+{
+      table_ = scalar_gate_table(op, invert);
+      net_ = 0;
+	// All four inputs start out as BIT4_Z.
+      inputs_ = 0xaa;
+      count_functors_logic += 1;
+      count_functors_scalar += 1;
+}
+
+vvp_fun_scalar_gate::~vvp_fun_scalar_gate()
+{
+}
+
+/*
+ * The vector gates keep inputs of any width, and their output takes
+ * the width of the port 0 input. A one bit gate only has room for bit
+ * 0 of each input and always sends a single bit, which is also all
+ * that a one bit net will accept. An empty input is x.
+ */
+void vvp_fun_scalar_gate::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
+                                    vvp_context_t)
+{
+      recv_bit_(ptr, bit.size() > 0 ? bit.value(0) : BIT4_X);
+}
+
+/*
+ * A part of a wider input vector. Only bit 0 of the input reaches a
+ * one bit gate, so a part that does not start there changes nothing.
+ */
+void vvp_fun_scalar_gate::recv_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
+				       unsigned base, unsigned wid, unsigned vwid,
+                                       vvp_context_t)
+{
+      assert(bit.size() == wid);
+      assert(base + wid <= vwid);
+
+      if (base != 0 || wid == 0)
+	    return;
+
+      recv_bit_(ptr, bit.value(0));
+}
+
+void vvp_fun_scalar_gate::recv_bit_(vvp_net_ptr_t ptr, vvp_bit4_t bit)
+{
+      unsigned shift = 2 * ptr.port();
+      unsigned char val = (inputs_ & ~(3 << shift)) | (bit << shift);
+      if (val == inputs_)
+	    return;
+
+      inputs_ = val;
+      if (net_ == 0) {
+	    net_ = ptr.ptr();
+	    schedule_functor(this);
+      }
+}
+
+void vvp_fun_scalar_gate::run_run()
+{
+      vvp_net_t*ptr = net_;
+      net_ = 0;
+
+      vvp_vector4_t result (1, (vvp_bit4_t) table_[inputs_]);
+      ptr->send_vec4(result, 0);
+}
+
+bool vvp_fun_scalar_gate::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_u8(inputs_);
+      return true;
+}
+
+void vvp_fun_scalar_gate::restore_state(vvp_checkpoint_in&in)
+{
+      inputs_ = in.get_u8();
+}
+
+vvp_gen_event_t vvp_fun_scalar_gate::checkpoint_event()
+{
+      return this;
+}
+
 vvp_fun_buf::vvp_fun_buf(unsigned wid)
 : input_(wid, BIT4_Z)
 {
@@ -171,6 +314,22 @@ void vvp_fun_buf::run_run()
       ptr->send_vec4(tmp, 0);
 }
 
+bool vvp_fun_buf::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_vec4(input_);
+      return true;
+}
+
+void vvp_fun_buf::restore_state(vvp_checkpoint_in&in)
+{
+      input_ = in.get_vec4();
+}
+
+vvp_gen_event_t vvp_fun_buf::checkpoint_event()
+{
+      return this;
+}
+
 vvp_fun_bufz::vvp_fun_bufz()
 {
       count_functors_logic += 1;
@@ -220,6 +379,11 @@ void vvp_fun_buft::recv_vec8(vvp_net_ptr_t ptr, const vvp_vector8_t&bit)
       ptr.ptr()->send_vec8(bit);
 }
 
+bool vvp_fun_bufz::save_state(vvp_checkpoint_out&) const
+{
+      return true;
+}
+
 vvp_fun_muxr::vvp_fun_muxr()
 : a_(0.0), b_(0.0)
 {
@@ -311,6 +475,26 @@ void vvp_fun_muxr::run_run()
       }
 }
 
+bool vvp_fun_muxr::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_double(a_);
+      out.put_double(b_);
+      out.put_u8(select_);
+      return true;
+}
+
+void vvp_fun_muxr::restore_state(vvp_checkpoint_in&in)
+{
+      a_ = in.get_double();
+      b_ = in.get_double();
+      select_ = (sel_type)in.get_u8();
+}
+
+vvp_gen_event_t vvp_fun_muxr::checkpoint_event()
+{
+      return this;
+}
+
 vvp_fun_muxz::vvp_fun_muxz(unsigned wid)
 : a_(wid, BIT4_Z), b_(wid, BIT4_Z)
 {
@@ -434,6 +618,28 @@ void vvp_fun_muxz::run_run()
       }
 }
 
+bool vvp_fun_muxz::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_vec4(a_);
+      out.put_vec4(b_);
+      out.put_u8(select_);
+      out.put_bool(has_run_);
+      return true;
+}
+
+void vvp_fun_muxz::restore_state(vvp_checkpoint_in&in)
+{
+      a_ = in.get_vec4();
+      b_ = in.get_vec4();
+      select_ = (sel_type)in.get_u8();
+      has_run_ = in.get_bool();
+}
+
+vvp_gen_event_t vvp_fun_muxz::checkpoint_event()
+{
+      return this;
+}
+
 vvp_fun_not::vvp_fun_not(unsigned wid)
 : input_(wid, BIT4_Z)
 {
@@ -494,6 +700,22 @@ void vvp_fun_not::run_run()
       ptr->send_vec4(result, 0);
 }
 
+bool vvp_fun_not::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_vec4(input_);
+      return true;
+}
+
+void vvp_fun_not::restore_state(vvp_checkpoint_in&in)
+{
+      input_ = in.get_vec4();
+}
+
+vvp_gen_event_t vvp_fun_not::checkpoint_event()
+{
+      return this;
+}
+
 vvp_fun_or::vvp_fun_or(unsigned wid, bool invert)
 : vvp_fun_boolean_(wid), invert_(invert)
 {
@@ -580,10 +802,16 @@ void compile_functor(char*label, char*type, unsigned width,
       bool strength_aware = false;
 
       if (strcmp(type, "OR") == 0) {
-	    obj = new vvp_fun_or(width, false);
+	    if (width == 1)
+		  obj = new vvp_fun_scalar_gate(vvp_fun_scalar_gate::OR, false);
+	    else
+		  obj = new vvp_fun_or(width, false);
 
       } else if (strcmp(type, "AND") == 0) {
-	    obj = new vvp_fun_and(width, false);
+	    if (width == 1)
+		  obj = new vvp_fun_scalar_gate(vvp_fun_scalar_gate::AND, false);
+	    else
+		  obj = new vvp_fun_and(width, false);
 
       } else if (strcmp(type, "BUF") == 0) {
 	    obj = new vvp_fun_buf(width);
@@ -597,10 +825,16 @@ void compile_functor(char*label, char*type, unsigned width,
 	    strength_aware = true;
 
       } else if (strcmp(type, "NAND") == 0) {
-	    obj = new vvp_fun_and(width, true);
+	    if (width == 1)
+		  obj = new vvp_fun_scalar_gate(vvp_fun_scalar_gate::AND, true);
+	    else
+		  obj = new vvp_fun_and(width, true);
 
       } else if (strcmp(type, "NOR") == 0) {
-	    obj = new vvp_fun_or(width, true);
+	    if (width == 1)
+		  obj = new vvp_fun_scalar_gate(vvp_fun_scalar_gate::OR, true);
+	    else
+		  obj = new vvp_fun_or(width, true);
 
       } else if (strcmp(type, "NOTIF0") == 0) {
 	    obj = new vvp_fun_bufif(true,true, ostr0, ostr1);
@@ -644,10 +878,16 @@ void compile_functor(char*label, char*type, unsigned width,
 	    obj = new vvp_fun_not(width);
 
       } else if (strcmp(type, "XNOR") == 0) {
-	    obj = new vvp_fun_xor(width, true);
+	    if (width == 1)
+		  obj = new vvp_fun_scalar_gate(vvp_fun_scalar_gate::XOR, true);
+	    else
+		  obj = new vvp_fun_xor(width, true);
 
       } else if (strcmp(type, "XOR") == 0) {
-	    obj = new vvp_fun_xor(width, false);
+	    if (width == 1)
+		  obj = new vvp_fun_scalar_gate(vvp_fun_scalar_gate::XOR, false);
+	    else
+		  obj = new vvp_fun_xor(width, false);
 
       } else {
 	    yyerror("invalid functor type.");
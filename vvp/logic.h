@@ -38,6 +38,10 @@ class vvp_fun_boolean_ : public vvp_net_fun_t, protected vvp_gen_event_s {
 			unsigned base, unsigned wid, unsigned vwid,
                         vvp_context_t);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+      vvp_gen_event_t checkpoint_event();
+
     protected:
       vvp_vector4_t input_[4];
       vvp_net_t*net_;
@@ -54,6 +58,47 @@ class vvp_fun_and  : public vvp_fun_boolean_ {
       bool invert_;
 };
 
+/*
+ * vvp_fun_scalar_gate is the compact form of the AND, OR and XOR
+ * gates (and their inverted forms) for the common case where the gate
+ * is a single bit wide. The four inputs are kept as 2-bit vvp_bit4_t
+ * codes packed into a byte, and the output is looked up in a 256 entry
+ * truth table that all the gates of the same type share. This avoids
+ * the four vvp_vector4_t inputs that vvp_fun_boolean_ carries.
+ *
+ * The output is always one bit wide, the result of bit 0 of each
+ * input. The vector gates would instead widen their output to match a
+ * wider port 0 input, so this form is only for gates whose inputs are
+ * one bit wide, which is what the code generator emits.
+ */
+class vvp_fun_scalar_gate : public vvp_net_fun_t, protected vvp_gen_event_s {
+
+    public:
+      enum op_t { AND, OR, XOR };
+
+      explicit vvp_fun_scalar_gate(op_t op, bool invert);
+      ~vvp_fun_scalar_gate();
+
+      void recv_vec4(vvp_net_ptr_t p, const vvp_vector4_t&bit,
+                     vvp_context_t);
+      void recv_vec4_pv(vvp_net_ptr_t p, const vvp_vector4_t&bit,
+			unsigned base, unsigned wid, unsigned vwid,
+                        vvp_context_t);
+
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+      vvp_gen_event_t checkpoint_event();
+
+    private:
+      void recv_bit_(vvp_net_ptr_t p, vvp_bit4_t bit);
+      void run_run();
+
+    private:
+      const unsigned char*table_;
+      vvp_net_t*net_;
+      unsigned char inputs_;
+};
+
 /*
  * The buffer functor is a very primitive functor that takes the input
  * from port-0 (and only port-0) and retransmits it as a vvp_vector4_t.
@@ -72,6 +117,10 @@ class vvp_fun_buf: public vvp_net_fun_t, private vvp_gen_event_s {
 			unsigned base, unsigned wid, unsigned vwid,
                         vvp_context_t);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+      vvp_gen_event_t checkpoint_event();
+
     private:
       void run_run();
 
@@ -99,6 +148,8 @@ class vvp_fun_bufz: public vvp_net_fun_t {
       void recv_real(vvp_net_ptr_t p, double bit,
                      vvp_context_t);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+
     private:
 };
 
@@ -138,6 +189,10 @@ class vvp_fun_muxz : public vvp_net_fun_t, private vvp_gen_event_s {
 			unsigned base, unsigned wid, unsigned vwid,
                         vvp_context_t);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+      vvp_gen_event_t checkpoint_event();
+
     private:
       void run_run();
 
@@ -160,6 +215,10 @@ class vvp_fun_muxr : public vvp_net_fun_t, private vvp_gen_event_s {
       void recv_real(vvp_net_ptr_t p, double bit,
                      vvp_context_t);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+      vvp_gen_event_t checkpoint_event();
+
     private:
       void run_run();
 
@@ -182,6 +241,10 @@ class vvp_fun_not: public vvp_net_fun_t, private vvp_gen_event_s {
 			unsigned base, unsigned wid, unsigned vwid,
                         vvp_context_t);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+      vvp_gen_event_t checkpoint_event();
+
     private:
       void run_run();
 
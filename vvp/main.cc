@@ -25,6 +25,10 @@
 # include  "schedule.h"
 # include  "vpi_priv.h"
 # include  "statistics.h"
+# include  "checkpoint.h"
+# include  "cycle.h"
+# include  "lazy.h"
+# include  "logic.h"
 # include  "vvp_cleanup.h"
 # include  <cstdio>
 # include  <cstdlib>
@@ -54,6 +58,7 @@ extern "C" const char*optarg;
 
 bool verbose_flag = false;
 bool version_flag = false;
+static bool async_files_flag = false;
 static int vvp_return_value = 0;
 
 void vpip_set_return_value(int value)
@@ -243,6 +248,8 @@ int main(int argc, char*argv[])
       const char*design_path = 0;
       struct rusage cycles[3];
       const char *logfile_name = 0x0;
+      bool cycle_flag = false;
+      bool lazy_flag = false;
       FILE *logfile = 0x0;
       extern void vpi_set_vlog_info(int, char**);
       extern bool stop_is_finish;
@@ -280,22 +287,35 @@ int main(int argc, char*argv[])
         /* For non-interactive runs we do not want to run the interactive
          * debugger, so make $stop just execute a $finish. */
       stop_is_finish = false;
-      while ((opt = getopt(argc, argv, "+hl:M:m:nNsvV")) != EOF) switch (opt) {
+      while ((opt = getopt(argc, argv, "+achLl:M:m:nNr:svV")) != EOF) switch (opt) {
+	  case 'a':
+	    async_files_flag = true;
+	    break;
          case 'h':
            fprintf(stderr,
                    "Usage: vvp [options] input-file [+plusargs...]\n"
                    "Options:\n"
+                   " -a             Write output files from a separate thread.\n"
+		   " -c             Cycle based simulation of synchronous logic.\n"
                    " -h             Print this help message.\n"
+		   " -L             Evaluate unobserved logic only on demand.\n"
                    " -l file        Logfile, '-' for <stderr>\n"
                    " -M path        VPI module directory\n"
 		   " -M -           Clear VPI module path\n"
                    " -m module      Load vpi module.\n"
 		   " -n             Non-interactive ($stop = $finish).\n"
                    " -N             Same as -n, but exit code is 1 instead of 0\n"
+		   " -r file        Restart from a $save checkpoint.\n"
 		   " -s             $stop right away.\n"
                    " -v             Verbose progress messages.\n"
                    " -V             Print the version information.\n" );
            exit(0);
+	  case 'c':
+	    cycle_flag = true;
+	    break;
+	  case 'L':
+	    lazy_flag = true;
+	    break;
 	  case 'l':
 	    logfile_name = optarg;
 	    break;
@@ -317,6 +337,9 @@ int main(int argc, char*argv[])
             stop_is_finish = true;
             stop_is_finish_exit_code = 1;
             break;
+	  case 'r':
+	    checkpoint_request_restart(optarg);
+	    break;
 	  case 's':
 	    schedule_stop(0);
 	    break;
@@ -387,6 +410,8 @@ int main(int argc, char*argv[])
       }
 
       vpip_mcd_init(logfile);
+      if (async_files_flag)
+	    vpip_mcd_async_init();
 
       if (verbose_flag) {
 	    my_getrusage(cycles+0);
@@ -427,6 +452,12 @@ int main(int argc, char*argv[])
 	    return compile_errors;
       }
 
+      if (cycle_flag)
+	    vvp_cycle_setup();
+
+      if (lazy_flag)
+	    vvp_lazy_setup();
+
       if (verbose_flag) {
 #ifdef __MINGW32__  /* MinGW does not know about z. */
 	    vpi_mcd_printf(1, " ... %8lu functors (net_fun pool=%u bytes)\n",
@@ -435,6 +466,10 @@ int main(int argc, char*argv[])
 #endif
 			   count_functors, vvp_net_fun_t::heap_total());
 	    vpi_mcd_printf(1, "           %8lu logic\n",  count_functors_logic);
+	    vpi_mcd_printf(1, "           %8lu scalar gates (%u bytes each,"
+			   " %u as vectors)\n", count_functors_scalar,
+			   (unsigned)sizeof(vvp_fun_scalar_gate),
+			   (unsigned)sizeof(vvp_fun_and));
 	    vpi_mcd_printf(1, "           %8lu bufif\n",  count_functors_bufif);
 	    vpi_mcd_printf(1, "           %8lu resolv\n",count_functors_resolv);
 	    vpi_mcd_printf(1, "           %8lu signals\n", count_functors_sig);
@@ -457,6 +492,12 @@ int main(int argc, char*argv[])
 	    vpi_mcd_printf(1, " ... %8lu vvp_nets (%zu bytes)\n",
 #endif
 			   count_vvp_nets, size_vvp_nets);
+#ifdef __MINGW32__  /* MinGW does not know about z. */
+	    vpi_mcd_printf(1, " ... %8lu udp tables (%u bytes)\n",
+#else
+	    vpi_mcd_printf(1, " ... %8lu udp tables (%zu bytes)\n",
+#endif
+			   count_udp_tables, size_udp_tables);
 	    vpi_mcd_printf(1, " ... %8lu arrays (%lu words)\n",
 			   count_net_arrays, count_net_array_words);
 	    vpi_mcd_printf(1, " ... %8lu memories\n",
@@ -477,6 +518,9 @@ int main(int argc, char*argv[])
 
       schedule_simulate();
 
+	/* Wait for the file output thread to write everything. */
+      vpip_mcd_async_suspend();
+
       if (verbose_flag) {
 	    my_getrusage(cycles+2);
 	    print_rusage(cycles+2, cycles+1);
@@ -490,6 +534,13 @@ int main(int argc, char*argv[])
 		    count_assign_events);
 	    vpi_mcd_printf(1, "             ...assign(vec4) pool=%lu\n",
 			   count_assign4_pool());
+	    vpi_mcd_printf(1, "             ...nbassign(vec4) batches=%lu"
+			   " assigns=%lu\n", count_nbassign_batches,
+			   count_nbassign_batched);
+	    vpi_mcd_printf(1, "             ...nbassign(vec4) %lu bytes"
+			   " batched, %lu bytes as events\n",
+			   (unsigned long)size_nbassign_batched,
+			   (unsigned long)size_nbassign_events);
 	    vpi_mcd_printf(1, "             ...assign(vec8) pool=%lu\n",
 			   count_assign8_pool());
 	    vpi_mcd_printf(1, "             ...assign(real) pool=%lu\n",
@@ -500,6 +551,7 @@ int main(int argc, char*argv[])
 			   count_assign_arword_pool());
 	    vpi_mcd_printf(1, "    %8lu other events (pool=%lu)\n",
 			   count_gen_events, count_gen_pool());
+	    vpip_mcd_async_stats();
       }
 
       final_cleanup();
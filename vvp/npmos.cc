@@ -18,12 +18,26 @@
  */
 
 # include  "npmos.h"
+# include  "checkpoint.h"
 
 vvp_fun_pmos_::vvp_fun_pmos_(bool enable_invert)
 {
       inv_en_ = enable_invert;
 }
 
+bool vvp_fun_pmos_::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_vec8(bit_);
+      out.put_vec4(en_);
+      return true;
+}
+
+void vvp_fun_pmos_::restore_state(vvp_checkpoint_in&in)
+{
+      bit_ = in.get_vec8();
+      en_ = in.get_vec4();
+}
+
 
 void vvp_fun_pmos_::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
                               vvp_context_t)
@@ -126,6 +140,21 @@ vvp_fun_cmos_::vvp_fun_cmos_()
 {
 }
 
+bool vvp_fun_cmos_::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_vec8(bit_);
+      out.put_vec4(n_en_);
+      out.put_vec4(p_en_);
+      return true;
+}
+
+void vvp_fun_cmos_::restore_state(vvp_checkpoint_in&in)
+{
+      bit_ = in.get_vec8();
+      n_en_ = in.get_vec4();
+      p_en_ = in.get_vec4();
+}
+
 void vvp_fun_cmos_::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t &bit,
                               vvp_context_t)
 {
@@ -51,6 +51,9 @@ class vvp_fun_pmos_ : public vvp_net_fun_t {
       void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                      vvp_context_t);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
     protected:
       void generate_output_(vvp_net_ptr_t port);
 
@@ -108,6 +111,9 @@ class vvp_fun_cmos_ : public vvp_net_fun_t {
       void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t &bit,
                      vvp_context_t);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
     protected:
       void generate_output_(vvp_net_ptr_t port);
 
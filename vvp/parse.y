@@ -22,6 +22,7 @@
 # include  "parse_misc.h"
 # include  "compile.h"
 # include  "delay.h"
+# include  "checkpoint.h"
 # include  <list>
 # include  <cstdio>
 # include  <cstdlib>
@@ -89,7 +90,7 @@ static struct __vpiModPath*modpath_dst = 0;
 %token K_REDUCE_NAND K_REDUCE_NOR K_REDUCE_XNOR K_REPEAT
 %token K_RESOLV K_SCOPE K_SFUNC K_SFUNC_E K_SHIFTL K_SHIFTR K_SHIFTRS
 %token K_THREAD K_TIMESCALE K_TRAN K_TRANIF0 K_TRANIF1 K_TRANVP
-%token K_UFUNC K_UFUNC_E K_UDP K_UDP_C K_UDP_S
+%token K_UFUNC K_UFUNC_E K_UFUNC_P K_UDP K_UDP_C K_UDP_S
 %token K_VAR K_VAR_S K_VAR_I K_VAR_R K_VAR_2S K_VAR_2U
 %token K_vpi_call K_vpi_call_w K_vpi_call_i
 %token K_vpi_func K_vpi_func_r
@@ -237,14 +238,21 @@ statement
 		{ compile_ufunc($1, $3, $5,
 				$7.cnt, $7.vect,
 				$9.cnt, $9.vect,
-				$11, $12, 0); }
+				$11, $12, 0, false); }
+
+	| T_LABEL K_UFUNC_P T_SYMBOL ',' T_NUMBER ','
+	  symbols '(' symbols ')' symbol T_SYMBOL ';'
+		{ compile_ufunc($1, $3, $5,
+				$7.cnt, $7.vect,
+				$9.cnt, $9.vect,
+				$11, $12, 0, true); }
 
 	| T_LABEL K_UFUNC_E T_SYMBOL ',' T_NUMBER ',' T_SYMBOL ','
 	  symbols '(' symbols ')' symbol T_SYMBOL ';'
 		{ compile_ufunc($1, $3, $5,
 				$9.cnt, $9.vect,
 				$11.cnt, $11.vect,
-				$13, $14, $7); }
+				$13, $14, $7, false); }
 
   /* Resolver statements are very much like functors. They are
      compiled to functors of a different mode. */
@@ -1097,6 +1105,7 @@ int compile_design(const char*path)
 	    return -1;
       }
 
+      checkpoint_hash_design(yyin);
       int rc = yyparse();
       fclose(yyin);
       return rc;
@@ -19,10 +19,17 @@
 
 # include  "compile.h"
 # include  "part.h"
+# include  "checkpoint.h"
+# include  "statistics.h"
 # include  <cstdlib>
+# include  <cstdio>
 # include  <climits>
 # include  <iostream>
 # include  <cassert>
+# include  <algorithm>
+# include  <map>
+# include  <set>
+# include  <vector>
 
 struct vvp_fun_part_state_s {
       vvp_fun_part_state_s() : bitsr(0.0) {}
@@ -50,14 +57,33 @@ vvp_fun_part_sa::~vvp_fun_part_sa()
 {
 }
 
+bool vvp_fun_part_sa::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_vec4(val_);
+      return true;
+}
+
+void vvp_fun_part_sa::restore_state(vvp_checkpoint_in&in)
+{
+      val_ = in.get_vec4();
+}
+
+vvp_gen_event_t vvp_fun_part_sa::checkpoint_event()
+{
+      return this;
+}
+
 void vvp_fun_part_sa::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                                 vvp_context_t)
 {
       assert(port.port() == 0);
 
-      vvp_vector4_t tmp (wid_, BIT4_X);
-      for (unsigned idx = 0 ;  idx < wid_ ;  idx += 1) {
-	    if (idx + base_ < bit.size())
+      vvp_vector4_t tmp;
+      if (base_ + wid_ <= bit.size()) {
+	    tmp = vvp_vector4_t(bit, base_, wid_);
+      } else {
+	    tmp = vvp_vector4_t(wid_, BIT4_X);
+	    for (unsigned idx = 0 ;  idx + base_ < bit.size() ;  idx += 1)
 		  tmp.set_bit(idx, bit.value(base_+idx));
       }
       if (val_ .eeq( tmp ))
@@ -107,6 +133,15 @@ vvp_fun_part_aa::~vvp_fun_part_aa()
 {
 }
 
+/*
+ * The automatic part selects keep their state in the scope contexts,
+ * and a checkpoint is only taken when there are no live contexts.
+ */
+bool vvp_fun_part_aa::save_state(vvp_checkpoint_out&) const
+{
+      return true;
+}
+
 void vvp_fun_part_aa::alloc_instance(vvp_context_t context)
 {
       vvp_set_context_item(context, context_idx_, new vvp_vector4_t);
@@ -194,6 +229,11 @@ vvp_fun_part_pv::~vvp_fun_part_pv()
 {
 }
 
+bool vvp_fun_part_pv::save_state(vvp_checkpoint_out&) const
+{
+      return true;
+}
+
 void vvp_fun_part_pv::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                                 vvp_context_t context)
 {
@@ -225,6 +265,165 @@ void vvp_fun_part_pv::recv_vec8(vvp_net_ptr_t port, const vvp_vector8_t&bit)
       port.ptr()->send_vec8_pv(bit, base_, wid_, vwid_);
 }
 
+vvp_fun_route::vvp_fun_route(unsigned wid)
+: val_(wid, BIT4_Z), pv_base_(0), pv_vwid_(0), sent_(false)
+{
+}
+
+vvp_fun_route::~vvp_fun_route()
+{
+}
+
+void vvp_fun_route::add_run(unsigned port, unsigned src,
+			    unsigned dst, unsigned wid)
+{
+      assert(port < 4);
+      assert(dst + wid <= val_.size());
+      run_s run;
+      run.src = src;
+      run.dst = dst;
+      run.wid = wid;
+      runs_[port].push_back(run);
+}
+
+void vvp_fun_route::set_const(unsigned dst, vvp_bit4_t val)
+{
+      val_.set_bit(dst, val);
+}
+
+void vvp_fun_route::send_as_part(unsigned base, unsigned vwid)
+{
+      pv_base_ = base;
+      pv_vwid_ = vwid;
+}
+
+bool vvp_fun_route::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_vec4(val_);
+      out.put_bool(sent_);
+      return true;
+}
+
+void vvp_fun_route::restore_state(vvp_checkpoint_in&in)
+{
+      val_ = in.get_vec4();
+      sent_ = in.get_bool();
+}
+
+/*
+ * Copy the bits of a run into the result, and return true if that
+ * changed the result.
+ */
+bool vvp_fun_route::route_(const run_s&run, const vvp_vector4_t&bit)
+{
+      const unsigned word_bits = 8*sizeof(unsigned long);
+      bool changed = false;
+
+	// Most runs are a few bits wide, so compare and copy them a
+	// word at a time in place instead of building temporaries.
+      for (unsigned off = 0 ;  off < run.wid ;  off += word_bits) {
+	    unsigned cnt = run.wid - off;
+	    if (cnt > word_bits)
+		  cnt = word_bits;
+	    unsigned src = run.src + off;
+	    unsigned dst = run.dst + off;
+
+	    if (src + cnt > bit.size()) {
+		    // Input bits past the end of the source are X.
+		  for (unsigned idx = 0 ;  idx < cnt ;  idx += 1) {
+			vvp_bit4_t b = src+idx < bit.size()
+			      ? bit.value(src+idx) : BIT4_X;
+			if (val_.value(dst+idx) == b)
+			      continue;
+			val_.set_bit(dst+idx, b);
+			changed = true;
+		  }
+		  continue;
+	    }
+
+	    unsigned long abits, bbits, cur_a, cur_b;
+	    bit.subword(src, cnt, abits, bbits);
+	    val_.subword(dst, cnt, cur_a, cur_b);
+	    if (abits == cur_a && bbits == cur_b)
+		  continue;
+	    val_.setword(dst, cnt, abits, bbits);
+	    changed = true;
+      }
+
+      return changed;
+}
+
+void vvp_fun_route::send_(vvp_net_t*net)
+{
+      sent_ = true;
+      if (pv_vwid_ > 0)
+	    net->send_vec4_pv(val_, pv_base_, val_.size(), pv_vwid_, 0);
+      else
+	    net->send_vec4(val_, 0);
+}
+
+void vvp_fun_route::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+			      vvp_context_t)
+{
+      const std::vector<run_s>&runs = runs_[port.port()];
+      bool changed = false;
+      bool same = false;
+      for (unsigned idx = 0 ;  idx < runs.size() ;  idx += 1) {
+	      // A folded .repeat leaves runs that copy the same source
+	      // bits, and those always hold the same value. If the
+	      // first copy did not change, neither did the rest.
+	    if (idx > 0 && runs[idx].src == runs[idx-1].src
+		&& runs[idx].wid == runs[idx-1].wid) {
+		  if (same)
+			continue;
+	    } else {
+		  same = false;
+	    }
+
+	    if (route_(runs[idx], bit))
+		  changed = true;
+	    else
+		  same = true;
+      }
+
+      if (changed || ! sent_)
+	    send_(port.ptr());
+}
+
+/*
+ * Only the routed bits that are in the written part change. As with
+ * vvp_fun_part_sa, bits past the end of the vector are x.
+ */
+void vvp_fun_route::recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+				 unsigned base, unsigned wid, unsigned vwid,
+				 vvp_context_t)
+{
+      assert(bit.size() == wid);
+
+      const std::vector<run_s>&runs = runs_[port.port()];
+      bool changed = false;
+      for (unsigned idx = 0 ;  idx < runs.size() ;  idx += 1) {
+	    const run_s&run = runs[idx];
+	    for (unsigned bdx = 0 ;  bdx < run.wid ;  bdx += 1) {
+		  unsigned sdx = run.src + bdx;
+		  vvp_bit4_t val;
+		  if (sdx >= vwid)
+			val = BIT4_X;
+		  else if (sdx >= base && sdx < base+wid)
+			val = bit.value(sdx-base);
+		  else
+			continue;
+		  if (val_.value(run.dst+bdx) == val)
+			continue;
+		  val_.set_bit(run.dst+bdx, val);
+		  changed = true;
+	    }
+      }
+
+      if (changed || ! sent_)
+	    send_(port.ptr());
+}
+
 vvp_fun_part_var::vvp_fun_part_var(unsigned w, bool is_signed)
 : wid_(w), is_signed_(is_signed)
 {
@@ -283,6 +482,21 @@ vvp_fun_part_var_sa::~vvp_fun_part_var_sa()
 {
 }
 
+bool vvp_fun_part_var_sa::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_u32(base_);
+      out.put_vec4(source_);
+      out.put_vec4(ref_);
+      return true;
+}
+
+void vvp_fun_part_var_sa::restore_state(vvp_checkpoint_in&in)
+{
+      base_ = in.get_u32();
+      source_ = in.get_vec4();
+      ref_ = in.get_vec4();
+}
+
 void vvp_fun_part_var_sa::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                                     vvp_context_t)
 {
@@ -325,6 +539,11 @@ vvp_fun_part_var_aa::~vvp_fun_part_var_aa()
 {
 }
 
+bool vvp_fun_part_var_aa::save_state(vvp_checkpoint_out&) const
+{
+      return true;
+}
+
 void vvp_fun_part_var_aa::alloc_instance(vvp_context_t context)
 {
       vvp_set_context_item(context, context_idx_, new vvp_fun_part_var_state_s);
@@ -447,3 +666,309 @@ void compile_part_select_var(char*label, char*source, char*var,
       input_connect(net, 0, source);
       input_connect(net, 1, var);
 }
+
+/*
+ * Return the only node that the net drives, or nil if it drives
+ * more or less than one node.
+ */
+static vvp_net_ptr_t only_fanout(vvp_net_t*net)
+{
+      vvp_net_ptr_t out = net->fanout();
+      if (out.nil() || ! out.ptr()->port[out.port()].nil())
+	    return vvp_net_ptr_t(0,0);
+      return out;
+}
+
+/*
+ * Return the number of inputs of a node that compile_fuse_parts can
+ * route, or 0 if the node is something else.
+ */
+static unsigned route_inputs(vvp_net_fun_t*fun)
+{
+      if (dynamic_cast<vvp_fun_part_sa*>(fun))
+	    return 1;
+      if (dynamic_cast<vvp_fun_concat*>(fun))
+	    return 4;
+      if (dynamic_cast<vvp_fun_repeat*>(fun))
+	    return 1;
+      if (dynamic_cast<vvp_fun_part_pv*>(fun))
+	    return 1;
+      return 0;
+}
+
+/*
+ * A bit of a routed vector is a bit of a source net, or a constant.
+ */
+struct route_bit_s {
+      vvp_net_t*src;
+      unsigned bit;
+      vvp_bit4_t val;
+};
+
+/*
+ * This collects the tree of routing nodes that feeds a root node.
+ */
+struct route_tree_s {
+      std::map<vvp_net_t*,std::vector<vvp_net_t*> > drivers;
+	// The nodes absorbed into the root, and the sources of the
+	// tree, which become the inputs of the route.
+      std::vector<vvp_net_t*> absorbed;
+      std::vector<vvp_net_t*> srcs;
+	// Nodes that could not be absorbed for lack of inputs are the
+	// roots of their own trees.
+      std::vector<vvp_net_t*> roots;
+      std::set<vvp_net_t*> busy;
+
+      vvp_net_t* driver(vvp_net_t*net, unsigned port);
+      bool absorbable(vvp_net_t*net, unsigned port);
+      bool expand(vvp_net_t*net, unsigned limit, std::vector<route_bit_s>&out);
+
+    private:
+      static route_bit_s input_bit_(vvp_net_t*leaf, vvp_net_t*drv,
+				    const std::vector<route_bit_s>&in,
+				    unsigned idx);
+};
+
+vvp_net_t* route_tree_s::driver(vvp_net_t*net, unsigned port)
+{
+      std::map<vvp_net_t*,std::vector<vvp_net_t*> >::iterator cur = drivers.find(net);
+      if (cur == drivers.end())
+	    return 0;
+      return cur->second[port];
+}
+
+/*
+ * Get bit idx of an input, which is either a source (leaf) or the
+ * bits of an absorbed node. An input that is not connected is z, and
+ * bits past the end of an absorbed node are x.
+ */
+route_bit_s route_tree_s::input_bit_(vvp_net_t*leaf, vvp_net_t*drv,
+				     const std::vector<route_bit_s>&in,
+				     unsigned idx)
+{
+      if (leaf) {
+	    route_bit_s res;
+	    res.src = leaf;
+	    res.bit = idx;
+	    res.val = BIT4_X;
+	    return res;
+      }
+      if (drv && idx < in.size())
+	    return in[idx];
+
+      route_bit_s res;
+      res.src = 0;
+      res.bit = 0;
+      res.val = drv? BIT4_X : BIT4_Z;
+      return res;
+}
+
+/*
+ * The node that drives the input can be absorbed if it is a routing
+ * node that drives only this input. A .part/pv sends only part of a
+ * vector, so it can only be the root. A node that is a net (has a
+ * filter) must keep its value.
+ */
+bool route_tree_s::absorbable(vvp_net_t*net, unsigned port)
+{
+      vvp_net_t*drv = driver(net, port);
+      if (drv == 0 || drv->fil || busy.count(drv))
+	    return false;
+      if (route_inputs(drv->fun) == 0 || dynamic_cast<vvp_fun_part_pv*>(drv->fun))
+	    return false;
+      vvp_net_ptr_t out = only_fanout(drv);
+      return out.ptr() == net && out.port() == port;
+}
+
+/*
+ * Work out the bits of the output of the node, absorbing the nodes
+ * that feed it where possible. The inputs that are not absorbed are
+ * sources. Fail if the tree would need more than limit sources,
+ * because a node only has four inputs.
+ */
+bool route_tree_s::expand(vvp_net_t*net, unsigned limit,
+			  std::vector<route_bit_s>&out)
+{
+      unsigned ninputs = route_inputs(net->fun);
+      busy.insert(net);
+
+      std::vector<route_bit_s> in[4];
+      vvp_net_t*leaf[4];
+      for (unsigned pdx = 0 ;  pdx < ninputs ;  pdx += 1) {
+	    leaf[pdx] = 0;
+	    vvp_net_t*drv = driver(net, pdx);
+	    if (drv == 0)
+		  continue;
+
+	      // Keep a source for each later input.
+	    unsigned later = 0;
+	    for (unsigned idx = pdx+1 ;  idx < ninputs ;  idx += 1)
+		  if (driver(net, idx)) later += 1;
+	    if (later >= limit) {
+		  busy.erase(net);
+		  return false;
+	    }
+
+	    bool absorb = absorbable(net, pdx);
+	    if (absorb) {
+		  size_t nabsorbed = absorbed.size();
+		  size_t nsrcs = srcs.size();
+		  size_t nroots = roots.size();
+		  if (expand(drv, limit-later, in[pdx])) {
+			absorbed.push_back(drv);
+			continue;
+		  }
+		  absorbed.resize(nabsorbed);
+		  srcs.resize(nsrcs);
+		  roots.resize(nroots);
+		  in[pdx].clear();
+	    }
+
+	    leaf[pdx] = drv;
+	    if (absorb)
+		  roots.push_back(drv);
+	    if (std::find(srcs.begin(), srcs.end(), drv) == srcs.end())
+		  srcs.push_back(drv);
+	    if (srcs.size() > limit-later) {
+		  busy.erase(net);
+		  return false;
+	    }
+      }
+
+      busy.erase(net);
+
+      if (vvp_fun_part_sa*sel = dynamic_cast<vvp_fun_part_sa*>(net->fun)) {
+	    out.resize(sel->width());
+	    for (unsigned idx = 0 ;  idx < out.size() ;  idx += 1)
+		  out[idx] = input_bit_(leaf[0], driver(net, 0), in[0], sel->base()+idx);
+
+      } else if (vvp_fun_concat*cat = dynamic_cast<vvp_fun_concat*>(net->fun)) {
+	    for (unsigned pdx = 0 ;  pdx < 4 ;  pdx += 1) {
+		  unsigned off = out.size();
+		  out.resize(off + cat->input_width(pdx));
+		  for (unsigned idx = 0 ;  idx < cat->input_width(pdx) ;  idx += 1)
+			out[off+idx] = input_bit_(leaf[pdx], driver(net, pdx), in[pdx], idx);
+	    }
+
+      } else if (vvp_fun_repeat*rep = dynamic_cast<vvp_fun_repeat*>(net->fun)) {
+	    unsigned wid = rep->width() / rep->repeat();
+	    out.resize(rep->width());
+	    for (unsigned idx = 0 ;  idx < out.size() ;  idx += 1)
+		  out[idx] = input_bit_(leaf[0], driver(net, 0), in[0], idx % wid);
+
+      } else if (vvp_fun_part_pv*pv = dynamic_cast<vvp_fun_part_pv*>(net->fun)) {
+	    out.resize(pv->width());
+	    for (unsigned idx = 0 ;  idx < out.size() ;  idx += 1)
+		  out[idx] = input_bit_(leaf[0], driver(net, 0), in[0], idx);
+
+      } else {
+	    assert(0);
+      }
+
+      return true;
+}
+
+/*
+ * Port connections and bus rearrangements make trees of part
+ * selects, concatenations and replications. Each node in such a tree
+ * holds a copy of its value, and the part selects propagate through
+ * the scheduler. Once the netlist is linked, replace each tree with
+ * a single vvp_fun_route node at the root of the tree. The root
+ * keeps its place in the netlist, and the sources of the tree are
+ * connected to its inputs. The absorbed nodes are left with no inputs
+ * or outputs.
+ */
+void compile_fuse_parts(void)
+{
+      route_tree_s tree;
+
+	// Find the driver of each input of every routing node.
+      for (unsigned long idx = 0 ;  idx < count_vvp_nets ;  idx += 1) {
+	    vvp_net_t*net = vvp_net_from_index(idx);
+	    vvp_net_ptr_t cur = net->fanout();
+	    while (! cur.nil()) {
+		  vvp_net_t*dst = cur.ptr();
+		  if (route_inputs(dst->fun)) {
+			std::vector<vvp_net_t*>&drv = tree.drivers[dst];
+			drv.resize(4, 0);
+			drv[cur.port()] = net;
+		  }
+		  cur = dst->port[cur.port()];
+	    }
+      }
+
+	// The roots are the routing nodes that do not feed (only) a
+	// node that they can be absorbed into.
+      std::vector<vvp_net_t*> roots;
+      for (unsigned long idx = 0 ;  idx < count_vvp_nets ;  idx += 1) {
+	    vvp_net_t*net = vvp_net_from_index(idx);
+	    if (route_inputs(net->fun) == 0)
+		  continue;
+	    vvp_net_ptr_t out = only_fanout(net);
+	    if (! out.nil() && route_inputs(out.ptr()->fun)
+		&& tree.absorbable(out.ptr(), out.port()))
+		  continue;
+	    roots.push_back(net);
+      }
+
+      unsigned long nroutes = 0, nabsorbed = 0;
+      while (! roots.empty()) {
+	    vvp_net_t*root = roots.back();
+	    roots.pop_back();
+	    if (route_inputs(root->fun) == 0)
+		  continue;
+
+	    std::vector<route_bit_s> bits;
+	    tree.absorbed.clear();
+	    tree.srcs.clear();
+	    tree.roots.clear();
+	    bool ok = tree.expand(root, 4, bits);
+	    assert(ok);
+	    roots.insert(roots.end(), tree.roots.begin(), tree.roots.end());
+	    if (tree.absorbed.empty())
+		  continue;
+
+	    vvp_fun_route*fun = new vvp_fun_route(bits.size());
+	    for (unsigned idx = 0 ;  idx < bits.size() ; ) {
+		  const route_bit_s&bit = bits[idx];
+		  if (bit.src == 0) {
+			fun->set_const(idx, bit.val);
+			idx += 1;
+			continue;
+		  }
+		  unsigned wid = 1;
+		  while (idx+wid < bits.size() && bits[idx+wid].src == bit.src
+			 && bits[idx+wid].bit == bit.bit+wid)
+			wid += 1;
+		  unsigned port = std::find(tree.srcs.begin(), tree.srcs.end(), bit.src)
+			- tree.srcs.begin();
+		  fun->add_run(port, bit.bit, idx, wid);
+		  idx += wid;
+	    }
+	    if (vvp_fun_part_pv*pv = dynamic_cast<vvp_fun_part_pv*>(root->fun))
+		  fun->send_as_part(pv->base(), pv->vector_width());
+
+	    tree.absorbed.push_back(root);
+	    for (unsigned idx = 0 ;  idx < tree.absorbed.size() ;  idx += 1) {
+		  vvp_net_t*net = tree.absorbed[idx];
+		  for (unsigned pdx = 0 ;  pdx < 4 ;  pdx += 1) {
+			vvp_net_t*drv = tree.driver(net, pdx);
+			if (drv) drv->unlink(vvp_net_ptr_t(net,pdx));
+		  }
+	    }
+	    for (unsigned idx = 0 ;  idx < tree.srcs.size() ;  idx += 1)
+		  tree.srcs[idx]->link(vvp_net_ptr_t(root,idx));
+
+	      // The functors are allocated from a pool that is never
+	      // freed, so the old functor is simply dropped.
+	    root->fun = fun;
+	    nroutes += 1;
+	    nabsorbed += tree.absorbed.size() - 1;
+      }
+
+      if (verbose_flag && nroutes > 0) {
+	    fprintf(stderr, " ... Routed %lu part/concat nodes into %lu nodes\n",
+		    nabsorbed + nroutes, nroutes);
+	    fflush(stderr);
+      }
+}
@@ -21,6 +21,7 @@
 
 # include  "schedule.h"
 # include  "config.h"
+# include  <vector>
 
 /* vvp_fun_part
  * This node takes a part select of the input vector. Input 0 is the
@@ -34,6 +35,9 @@ class vvp_fun_part  : public vvp_net_fun_t {
       vvp_fun_part(unsigned base, unsigned wid);
       ~vvp_fun_part();
 
+      unsigned base() const { return base_; }
+      unsigned width() const { return wid_; }
+
     protected:
       unsigned base_;
       unsigned wid_;
@@ -56,6 +60,10 @@ class vvp_fun_part_sa  : public vvp_fun_part, public vvp_gen_event_s {
 			unsigned, unsigned, unsigned,
                         vvp_context_t);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+      vvp_gen_event_t checkpoint_event();
+
     private:
       void run_run();
 
@@ -87,6 +95,8 @@ class vvp_fun_part_aa  : public vvp_fun_part, public automatic_hooks_s {
 			unsigned, unsigned, unsigned,
                         vvp_context_t context);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+
     private:
       struct __vpiScope*context_scope_;
       unsigned context_idx_;
@@ -111,12 +121,70 @@ class vvp_fun_part_pv  : public vvp_net_fun_t {
 
       void recv_vec8(vvp_net_ptr_t port, const vvp_vector8_t&bit);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+
+      unsigned base() const { return base_; }
+      unsigned width() const { return wid_; }
+      unsigned vector_width() const { return vwid_; }
+
     private:
       unsigned base_;
       unsigned wid_;
       unsigned vwid_;
 };
 
+/* vvp_fun_route
+ * The loader replaces a tree of static part selects, concatenations
+ * and replications with this node (see compile_fuse_parts). Every
+ * bit of the result is a fixed bit of one of the inputs, or a
+ * constant, so the map is kept as runs of consecutive bits and the
+ * whole tree is evaluated in one step. As with vvp_fun_part, input
+ * bits past the end of the received vector are x. The result is only
+ * propagated when it changes. If the tree ends in a .part/pv, the
+ * result is sent as that part of the wider vector.
+ */
+class vvp_fun_route  : public vvp_net_fun_t {
+
+    public:
+      explicit vvp_fun_route(unsigned wid);
+      ~vvp_fun_route();
+
+	// Route wid bits of the input port, starting at bit src, to
+	// the result starting at bit dst.
+      void add_run(unsigned port, unsigned src, unsigned dst, unsigned wid);
+	// Make a bit of the result a constant.
+      void set_const(unsigned dst, vvp_bit4_t val);
+	// Send the result as the part at base of a vwid vector.
+      void send_as_part(unsigned base, unsigned vwid);
+
+      void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+                     vvp_context_t context);
+
+      void recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+			unsigned base, unsigned wid, unsigned vwid,
+                        vvp_context_t context);
+
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
+    private:
+      struct run_s {
+	    unsigned src;
+	    unsigned dst;
+	    unsigned wid;
+      };
+      bool route_(const run_s&run, const vvp_vector4_t&bit);
+      void send_(vvp_net_t*net);
+
+    private:
+      std::vector<run_s> runs_[4];
+      vvp_vector4_t val_;
+      unsigned pv_base_;
+      unsigned pv_vwid_;
+	// The first result is always sent.
+      bool sent_;
+};
+
 /*
  * This part select is more flexible in that it takes the vector to
  * part in port 0, and the base of the part in port 1. The width of
@@ -154,6 +222,9 @@ class vvp_fun_part_var_sa  : public vvp_fun_part_var {
 			unsigned, unsigned, unsigned,
                         vvp_context_t);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
     private:
       int base_;
       vvp_vector4_t source_;
@@ -184,6 +255,8 @@ class vvp_fun_part_var_aa  : public vvp_fun_part_var, public automatic_hooks_s {
 			unsigned, unsigned, unsigned,
                         vvp_context_t context);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+
     private:
       struct __vpiScope*context_scope_;
       unsigned context_idx_;
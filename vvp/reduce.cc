@@ -19,6 +19,7 @@
 
 # include  "compile.h"
 # include  "schedule.h"
+# include  "checkpoint.h"
 # include  <climits>
 # include  <cstdio>
 # include  <cassert>
@@ -45,6 +46,9 @@ class vvp_reduce_base : public vvp_net_fun_t {
 
       virtual vvp_bit4_t calculate_result() const =0;
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
     protected:
       vvp_vector4_t bits_;
 };
@@ -57,6 +61,17 @@ vvp_reduce_base::~vvp_reduce_base()
 {
 }
 
+bool vvp_reduce_base::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_vec4(bits_);
+      return true;
+}
+
+void vvp_reduce_base::restore_state(vvp_checkpoint_in&in)
+{
+      bits_ = in.get_vec4();
+}
+
 void vvp_reduce_base::recv_vec4(vvp_net_ptr_t prt, const vvp_vector4_t&bit,
                                 vvp_context_t context)
 {
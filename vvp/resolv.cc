@@ -21,29 +21,51 @@
 # include  "schedule.h"
 # include  "compile.h"
 # include  "statistics.h"
+# include  "checkpoint.h"
 # include  <iostream>
 # include  <cassert>
 
 
-resolv_functor::resolv_functor(vvp_scalar_t hiz_value, const char*debug_l)
-: hiz_(hiz_value), debug_label_(debug_l)
+resolv_core::resolv_core(vvp_net_t*net, unsigned nports)
+: net_(net), nports_(nports)
 {
-      count_functors_resolv += 1;
 }
 
-resolv_functor::~resolv_functor()
+resolv_core::~resolv_core()
+{
+}
+
+void resolv_core::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+			    vvp_context_t)
+{
+      recv_vec4_from_inputs(port.port(), bit);
+}
+
+void resolv_core::recv_vec8(vvp_net_ptr_t port, const vvp_vector8_t&bit)
+{
+      recv_vec8_from_inputs(port.port(), bit);
+}
+
+void resolv_core::recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+			       unsigned base, unsigned wid, unsigned vwid,
+			       vvp_context_t)
+{
+      recv_vec4_pv_from_inputs(port.port(), bit, base, wid, vwid);
+}
+
+void resolv_core::recv_vec8_pv(vvp_net_ptr_t port, const vvp_vector8_t&bit,
+			       unsigned base, unsigned wid, unsigned vwid)
 {
+      recv_vec8_pv_from_inputs(port.port(), bit, base, wid, vwid);
 }
 
-void resolv_functor::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
-                               vvp_context_t)
+void resolv_core::recv_vec8_from_inputs(unsigned port, const vvp_vector8_t&bit)
 {
-      recv_vec8(port, vvp_vector8_t(bit, 6,6 /* STRONG */));
+      recv_vec4_from_inputs(port, reduce4(bit));
 }
 
-void resolv_functor::recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
-				  unsigned base, unsigned wid, unsigned vwid,
-                                  vvp_context_t)
+void resolv_core::recv_vec4_pv_from_inputs(unsigned port, const vvp_vector4_t&bit,
+					   unsigned base, unsigned wid, unsigned vwid)
 {
       assert(bit.size() == wid);
       vvp_vector4_t res (vwid);
@@ -57,22 +79,144 @@ void resolv_functor::recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
       for (unsigned idx = base+wid ;  idx < vwid ;  idx += 1)
 	    res.set_bit(idx, BIT4_Z);
 
-      recv_vec4(port, res, 0);
+      recv_vec4_from_inputs(port, res);
 }
 
-void resolv_functor::recv_vec8(vvp_net_ptr_t port, const vvp_vector8_t&bit)
+void resolv_core::recv_vec8_pv_from_inputs(unsigned port, const vvp_vector8_t&bit,
+					   unsigned base, unsigned wid, unsigned vwid)
 {
-      unsigned pdx = port.port();
-      vvp_net_t*ptr = port.ptr();
+      assert(bit.size() == wid);
+      vvp_vector8_t res (vwid);
 
-      if (val_[pdx].eeq(bit))
-	    return;
+      for (unsigned idx = 0 ;  idx < base ;  idx += 1)
+	    res.set_bit(idx, vvp_scalar_t());
 
-      val_[pdx] = bit;
+      for (unsigned idx = 0 ;  idx < wid && idx+base < vwid;  idx += 1)
+	    res.set_bit(idx+base, bit.value(idx));
+
+      for (unsigned idx = base+wid ;  idx < vwid ;  idx += 1)
+	    res.set_bit(idx, vvp_scalar_t());
+
+      recv_vec8_from_inputs(port, res);
+}
+
+resolv_extend::resolv_extend(resolv_core*core, unsigned port_base)
+: core_(core), port_base_(port_base)
+{
+}
+
+resolv_extend::~resolv_extend()
+{
+}
+
+bool resolv_extend::save_state(vvp_checkpoint_out&) const
+{
+      return true;
+}
+
+void resolv_extend::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+			      vvp_context_t)
+{
+      core_->recv_vec4_from_inputs(port_base_ + port.port(), bit);
+}
+
+void resolv_extend::recv_vec8(vvp_net_ptr_t port, const vvp_vector8_t&bit)
+{
+      core_->recv_vec8_from_inputs(port_base_ + port.port(), bit);
+}
+
+void resolv_extend::recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+				 unsigned base, unsigned wid, unsigned vwid,
+				 vvp_context_t)
+{
+      core_->recv_vec4_pv_from_inputs(port_base_ + port.port(), bit,
+				      base, wid, vwid);
+}
+
+void resolv_extend::recv_vec8_pv(vvp_net_ptr_t port, const vvp_vector8_t&bit,
+				 unsigned base, unsigned wid, unsigned vwid)
+{
+      core_->recv_vec8_pv_from_inputs(port_base_ + port.port(), bit,
+				      base, wid, vwid);
+}
+
+resolv_functor::resolv_functor(vvp_net_t*net, unsigned nports,
+			       vvp_scalar_t hiz_value, const char*debug_l)
+: resolv_core(net, nports), hiz_(hiz_value), debug_label_(debug_l)
+{
+      count_functors_resolv += 1;
+      val_ = new vvp_vector8_t[nports];
+
+      leaves_ = 1;
+      while (leaves_ < nports)
+	    leaves_ *= 2;
+      tree_ = 0;
+      unsliced_ = new bool[nports];
+      for (unsigned idx = 0 ;  idx < nports ;  idx += 1)
+	    unsliced_[idx] = false;
+      unsliced_count_ = 0;
+      tree_stale_ = true;
+}
+
+resolv_functor::~resolv_functor()
+{
+      delete[]val_;
+      delete[]tree_;
+      delete[]unsliced_;
+}
+
+bool resolv_functor::save_state(vvp_checkpoint_out&out) const
+{
+      for (unsigned idx = 0 ;  idx < port_count() ;  idx += 1)
+	    out.put_vec8(val_[idx]);
+      return true;
+}
+
+void resolv_functor::restore_state(vvp_checkpoint_in&in)
+{
+      for (unsigned idx = 0 ;  idx < port_count() ;  idx += 1)
+	    val_[idx] = in.get_vec8();
+
+	// The tree is built again from the inputs by the next change.
+      delete[]tree_;
+      tree_ = 0;
+}
+
+/*
+ * Make the tree for inputs of the given width, and load the leaves
+ * from the inputs that have that width. The interior nodes are not
+ * resolved until they are needed.
+ */
+void resolv_functor::build_tree_(unsigned wid)
+{
+      delete[]tree_;
+      tree_ = new vvp_vector8_sliced_t[2*leaves_];
+      for (unsigned idx = 1 ;  idx < 2*leaves_ ;  idx += 1)
+	    tree_[idx] = vvp_vector8_sliced_t(wid);
+
+      unsliced_count_ = 0;
+      for (unsigned idx = 0 ;  idx < port_count() ;  idx += 1) {
+	    unsliced_[idx] = false;
+	    if (val_[idx].size() != wid)
+		  continue;
+	    if (! tree_[leaves_+idx].set_vec8(val_[idx])) {
+		  unsliced_[idx] = true;
+		  unsliced_count_ += 1;
+	    }
+      }
+
+      tree_stale_ = true;
+}
 
-      vvp_vector8_t out (bit);
+/*
+ * This is the bit at a time resolution of all the inputs, starting
+ * with the input that changed.
+ */
+vvp_vector8_t resolv_functor::resolve_all_(unsigned pdx) const
+{
+      vvp_vector8_t out (val_[pdx]);
 
-      for (unsigned idx = 0 ;  idx < 4 ;  idx += 1) {
+      for (unsigned idx = 0 ;  idx < port_count() ;  idx += 1) {
 	    if (idx == pdx)
 		  continue;
 	    if (val_[idx].size() == 0)
@@ -90,46 +234,97 @@ void resolv_functor::recv_vec8(vvp_net_ptr_t port, const vvp_vector8_t&bit)
 	    }
       }
 
-      if (debug_label_ && debug_file.is_open())
-	    debug_file << "[" << schedule_simtime() << "] "
-		       << debug_label_ << ": Resolv out=" << out
-		       << " in=" << val_[0] << ", " << val_[1]
-		       << ", " << val_[2] << ", " << val_[3] << endl;
+      return out;
+}
 
-      ptr->send_vec8(out);
+void resolv_functor::recv_vec4_from_inputs(unsigned port, const vvp_vector4_t&bit)
+{
+      recv_vec8_from_inputs(port, vvp_vector8_t(bit, 6,6 /* STRONG */));
 }
 
-void resolv_functor::recv_vec8_pv(vvp_net_ptr_t port, const vvp_vector8_t&bit,
-				  unsigned base, unsigned wid, unsigned vwid)
+void resolv_functor::recv_vec8_from_inputs(unsigned pdx, const vvp_vector8_t&bit)
 {
-      assert(bit.size() == wid);
-      vvp_vector8_t res (vwid);
+      assert(pdx < port_count());
 
-      for (unsigned idx = 0 ;  idx < base ;  idx += 1)
-	    res.set_bit(idx, vvp_scalar_t());
+      if (val_[pdx].eeq(bit))
+	    return;
 
-      for (unsigned idx = 0 ;  idx < wid && idx+base < vwid;  idx += 1)
-	    res.set_bit(idx+base, bit.value(idx));
+      val_[pdx] = bit;
 
-      for (unsigned idx = base+wid ;  idx < vwid ;  idx += 1)
-	    res.set_bit(idx, vvp_scalar_t());
+      if (tree_ == 0 || tree_[1].size() != bit.size()) {
+	    build_tree_(bit.size());
+
+      } else {
+	    vvp_vector8_sliced_t&leaf = tree_[leaves_+pdx];
+	    bool unsliced = ! leaf.set_vec8(bit);
+	    if (unsliced != unsliced_[pdx]) {
+		  unsliced_[pdx] = unsliced;
+		  if (unsliced)
+			unsliced_count_ += 1;
+		  else
+			unsliced_count_ -= 1;
+	    }
+
+	      /* Resolve the nodes from this leaf up to the root. */
+	    if (unsliced_count_ == 0 && ! tree_stale_) {
+		  for (unsigned node = (leaves_+pdx)/2 ;  node > 0 ;  node /= 2)
+			tree_[node].resolve(tree_[2*node], tree_[2*node+1]);
+	    } else {
+		  tree_stale_ = true;
+	    }
+      }
 
-      recv_vec8(port, res);
+      vvp_vector8_t out;
+      if (unsliced_count_ == 0) {
+	    if (tree_stale_) {
+		  for (unsigned node = leaves_-1 ;  node > 0 ;  node -= 1)
+			tree_[node].resolve(tree_[2*node], tree_[2*node+1]);
+		  tree_stale_ = false;
+	    }
+	    out = tree_[1].vector8(hiz_);
+      } else {
+	    out = resolve_all_(pdx);
+      }
+
+      if (debug_label_ && debug_file.is_open()) {
+	    debug_file << "[" << schedule_simtime() << "] "
+		       << debug_label_ << ": Resolv out=" << out
+		       << " in=" << val_[0];
+	    for (unsigned idx = 1 ;  idx < port_count() ;  idx += 1)
+		  debug_file << ", " << val_[idx];
+	    debug_file << endl;
+      }
+
+      net()->send_vec8(out);
 }
 
-resolv_wired_logic::resolv_wired_logic()
+resolv_wired_logic::resolv_wired_logic(vvp_net_t*net, unsigned nports)
+: resolv_core(net, nports)
 {
+      val_ = new vvp_vector4_t[nports];
 }
 
 resolv_wired_logic::~resolv_wired_logic()
 {
+      delete[]val_;
+}
+
+bool resolv_wired_logic::save_state(vvp_checkpoint_out&out) const
+{
+      for (unsigned idx = 0 ;  idx < port_count() ;  idx += 1)
+	    out.put_vec4(val_[idx]);
+      return true;
+}
+
+void resolv_wired_logic::restore_state(vvp_checkpoint_in&in)
+{
+      for (unsigned idx = 0 ;  idx < port_count() ;  idx += 1)
+	    val_[idx] = in.get_vec4();
 }
 
-void resolv_wired_logic::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
-                                   vvp_context_t)
+void resolv_wired_logic::recv_vec4_from_inputs(unsigned pdx, const vvp_vector4_t&bit)
 {
-      unsigned pdx = port.port();
-      vvp_net_t*ptr = port.ptr();
+      assert(pdx < port_count());
 
       if (val_[pdx].eeq(bit))
 	    return;
@@ -137,7 +332,7 @@ void resolv_wired_logic::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
       val_[pdx] = bit;
 
       vvp_vector4_t out (bit);
-      for (unsigned idx = 0 ; idx < 4 ; idx += 1) {
+      for (unsigned idx = 0 ; idx < port_count() ; idx += 1) {
 	    if (idx == pdx)
 		  continue;
 	    if (val_[idx].size() == 0)
@@ -146,7 +341,7 @@ void resolv_wired_logic::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 	    out = wired_logic_math_(out, val_[idx]);
       }
 
-      ptr->send_vec4(out, 0);
+      net()->send_vec4(out, 0);
 }
 
 vvp_vector4_t resolv_triand::wired_logic_math_(vvp_vector4_t&a, vvp_vector4_t&b)
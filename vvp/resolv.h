@@ -22,6 +22,78 @@
 # include  "config.h"
 # include  "vvp_net.h"
 
+/*
+ * The resolver functors take any number of inputs. The first 4 inputs
+ * are the ports of the resolver net itself, as for any other functor,
+ * but if there are more than that, then the remaining inputs are the
+ * ports of resolv_extend functors that pass the values on to the
+ * resolver. The resolv_core class carries the port numbering and
+ * the part select handling, and the derived class does the actual
+ * resolution of the input values.
+ */
+class resolv_core : public vvp_net_fun_t {
+
+    public:
+      resolv_core(vvp_net_t*net, unsigned nports);
+      virtual ~resolv_core();
+
+      void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+                     vvp_context_t);
+      void recv_vec8(vvp_net_ptr_t port, const vvp_vector8_t&bit);
+
+      void recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+			unsigned base, unsigned wid, unsigned vwid,
+                        vvp_context_t);
+      void recv_vec8_pv(vvp_net_ptr_t port, const vvp_vector8_t&bit,
+			unsigned base, unsigned wid, unsigned vwid);
+
+    protected:
+      unsigned port_count() const { return nports_; }
+      vvp_net_t* net() const { return net_; }
+
+    private:
+      friend class resolv_extend;
+      virtual void recv_vec4_from_inputs(unsigned port, const vvp_vector4_t&bit) =0;
+      virtual void recv_vec8_from_inputs(unsigned port, const vvp_vector8_t&bit);
+      void recv_vec4_pv_from_inputs(unsigned port, const vvp_vector4_t&bit,
+				    unsigned base, unsigned wid, unsigned vwid);
+      void recv_vec8_pv_from_inputs(unsigned port, const vvp_vector8_t&bit,
+				    unsigned base, unsigned wid, unsigned vwid);
+
+    private:
+	// The net that carries the resolved output.
+      vvp_net_t*net_;
+      unsigned nports_;
+};
+
+/*
+ * This functor passes the values on its 4 ports to the ports of a
+ * resolver, starting with the port_base.
+ */
+class resolv_extend : public vvp_net_fun_t {
+
+    public:
+      resolv_extend(resolv_core*core, unsigned port_base);
+      ~resolv_extend();
+
+      void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+                     vvp_context_t);
+      void recv_vec8(vvp_net_ptr_t port, const vvp_vector8_t&bit);
+
+      void recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+			unsigned base, unsigned wid, unsigned vwid,
+                        vvp_context_t);
+      void recv_vec8_pv(vvp_net_ptr_t port, const vvp_vector8_t&bit,
+			unsigned base, unsigned wid, unsigned vwid);
+
+	// The resolver saves the input values.
+      bool save_state(vvp_checkpoint_out&out) const;
+
+    private:
+      resolv_core*core_;
+      unsigned port_base_;
+};
+
 /*
  * This functor type resolves its inputs using the Verilog method of
  * combining signals, and outputs that resolved value. The puller
@@ -33,51 +105,76 @@
  * value. It also takes in vvp_vector4_t values, which it treats as
  * strong values (or HiZ) for the sake of resolution. In any case, the
  * propagated value is a vvp_vector8_t value.
+ *
+ * The input values are also kept in their vvp_vector8_sliced_t form
+ * as the leaves of a balanced binary tree, where each interior node
+ * holds the resolution of its children. When an input changes, only
+ * the nodes from that leaf to the root need be resolved again, so a
+ * net with many drivers (a bus) does not resolve all the other
+ * drivers for every change. If any input has a value without the
+ * sliced form, then the resolver falls back to resolving all the
+ * inputs a bit at a time until that input changes again.
  */
-class resolv_functor : public vvp_net_fun_t {
+class resolv_functor : public resolv_core {
 
     public:
-      explicit resolv_functor(vvp_scalar_t hiz_value, const char* debug =0);
+      explicit resolv_functor(vvp_net_t*net, unsigned nports,
+			      vvp_scalar_t hiz_value, const char* debug =0);
       ~resolv_functor();
 
-      void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
-                     vvp_context_t);
-      void recv_vec8(vvp_net_ptr_t port, const vvp_vector8_t&bit);
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
 
-      void recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
-			unsigned base, unsigned wid, unsigned vwid,
-                        vvp_context_t);
-      void recv_vec8_pv(vvp_net_ptr_t port, const vvp_vector8_t&bit,
-			unsigned base, unsigned wid, unsigned vwid);
+    private:
+      void recv_vec4_from_inputs(unsigned port, const vvp_vector4_t&bit);
+      void recv_vec8_from_inputs(unsigned port, const vvp_vector8_t&bit);
+
+      void build_tree_(unsigned wid);
+      vvp_vector8_t resolve_all_(unsigned port) const;
 
     private:
-      vvp_vector8_t val_[4];
+      vvp_vector8_t*val_;
 	// Bit value to emit for HiZ bits.
       vvp_scalar_t hiz_;
 	// True if debugging is enabled
       const char* debug_label_;
+
+	// The tree has 2*leaves_ nodes. Node 1 is the root, and the
+	// children of node N are 2*N and 2*N+1. The inputs are the
+	// nodes starting at leaves_. Node 0 is not used.
+      unsigned leaves_;
+      vvp_vector8_sliced_t*tree_;
+	// The inputs that do not have the sliced form.
+      bool*unsliced_;
+      unsigned unsliced_count_;
+	// True if the interior nodes need to be resolved again.
+      bool tree_stale_;
 };
 
-class resolv_wired_logic : public vvp_net_fun_t {
+class resolv_wired_logic : public resolv_core {
 
     public:
-      explicit resolv_wired_logic(void);
+      explicit resolv_wired_logic(vvp_net_t*net, unsigned nports);
       ~resolv_wired_logic();
 
-      void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
-                     vvp_context_t);
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
 
     protected:
       virtual vvp_vector4_t wired_logic_math_(vvp_vector4_t&a, vvp_vector4_t&b) =0;
 
     private:
-      vvp_vector4_t val_[4];
+      void recv_vec4_from_inputs(unsigned port, const vvp_vector4_t&bit);
+
+    private:
+      vvp_vector4_t*val_;
 };
 
 class resolv_triand : public resolv_wired_logic {
 
     public:
-      explicit resolv_triand(void) { }
+      explicit resolv_triand(vvp_net_t*net, unsigned nports)
+      : resolv_wired_logic(net, nports) { }
       ~resolv_triand() { }
 
     private:
@@ -87,7 +184,8 @@ class resolv_triand : public resolv_wired_logic {
 class resolv_trior : public resolv_wired_logic {
 
     public:
-      explicit resolv_trior(void) { }
+      explicit resolv_trior(vvp_net_t*net, unsigned nports)
+      : resolv_wired_logic(net, nports) { }
       ~resolv_trior() { }
 
     private:
@@ -22,8 +22,12 @@
 # include  "vpi_priv.h"
 # include  "slab.h"
 # include  "compile.h"
+# include  "checkpoint.h"
+# include  "cycle.h"
+# include  "lazy.h"
 # include  <new>
 # include  <typeinfo>
+# include  <vector>
 # include  <csignal>
 # include  <cstdlib>
 # include  <cassert>
@@ -35,6 +39,11 @@ unsigned long count_gen_events = 0;
 unsigned long count_thread_events = 0;
   // Count the time events (A time cell created)
 unsigned long count_time_events = 0;
+  // Count the non-blocking assign batches and what they hold
+unsigned long count_nbassign_batches = 0;
+unsigned long count_nbassign_batched = 0;
+size_t size_nbassign_batched = 0;
+size_t size_nbassign_events = 0;
 
 
 
@@ -56,6 +65,9 @@ struct event_s {
 	// Write something about the event to stderr
       virtual void single_step_display(void);
 
+	// Write the event to a checkpoint. The default refuses.
+      virtual void save_state(vvp_checkpoint_out&out) const;
+
 	// Fallback new/delete
       static void*operator new (size_t size) { return ::new char[size]; }
       static void operator delete(void*ptr)  { ::delete[]( (char*)ptr ); }
@@ -66,12 +78,15 @@ void event_s::single_step_display(void)
       cerr << "event_s: Step into event " << typeid(*this).name() << endl;
 }
 
+struct assign_vector4_batch_s;
+
 struct event_time_s {
       event_time_s() {
 	    count_time_events += 1;
 	    start = 0;
 	    active = 0;
 	    nbassign = 0;
+	    nbbatch = 0;
 	    rwsync = 0;
 	    rosync = 0;
 	    del_thr = 0;
@@ -86,6 +101,10 @@ struct event_time_s {
       struct event_s*rosync;
       struct event_s*del_thr;
 
+	// The batch at the end of the nbassign list, if any. Vector
+	// assigns are added to it until some other event ends it.
+      struct assign_vector4_batch_s*nbbatch;
+
       struct event_time_s*next;
 
       static void* operator new (size_t);
@@ -101,12 +120,18 @@ void vvp_gen_event_s::single_step_display(void)
       cerr << "vvp_gen_event_s: Step into event " << typeid(*this).name() << endl;
 }
 
+vvp_net_t* vvp_gen_event_s::checkpoint_net(void) const
+{
+      return 0;
+}
+
 /*
  * Derived event types
  */
 struct vthread_event_s : public event_s {
       vthread_t thr;
       void run_run(void);
+      void save_state(vvp_checkpoint_out&out) const;
       void single_step_display(void);
 
       static void* operator new(size_t);
@@ -144,6 +169,7 @@ void vthread_event_s::operator delete(void*ptr)
 struct del_thr_event_s : public event_s {
       vthread_t thr;
       void run_run(void);
+      void save_state(vvp_checkpoint_out&out) const;
       void single_step_display(void);
 };
 
@@ -181,6 +207,7 @@ struct assign_vector4_event_s  : public event_s {
 	/* Width of the destination vector. */
       unsigned vwid;
       void run_run(void);
+      void save_state(vvp_checkpoint_out&out) const;
       void single_step_display(void);
 
       static void* operator new(size_t);
@@ -218,10 +245,191 @@ void assign_vector4_event_s::operator delete(void*ptr)
 
 unsigned long count_assign4_pool(void) { return assign4_heap.pool; }
 
+/*
+ * Non-blocking vector assigns are most of the NBA region of an RTL
+ * design, so the consecutive ones of a time step are collected into
+ * a batch instead of each getting an assign_vector4_event_s. The
+ * batch is a single event in the nbassign list. It holds a contiguous
+ * buffer of records (the destination, the part to assign, and the
+ * value as pairs of abits/bbits words) and applies them in order when
+ * it runs. Any other event put into the nbassign list ends the batch,
+ * so the order of the non-blocking assigns is kept. The buffers are
+ * kept for reuse, so a batch allocates nothing once the simulation
+ * has warmed up.
+ */
+struct assign_vector4_batch_s  : public event_s {
+      assign_vector4_batch_s();
+      ~assign_vector4_batch_s();
+
+      void append(vvp_net_ptr_t ptr, unsigned base, unsigned vwid,
+		  const vvp_vector4_t&src, unsigned adr, unsigned wid);
+
+      void run_run(void);
+      void save_state(vvp_checkpoint_out&out) const;
+      void single_step_display(void);
+
+      static void* operator new(size_t);
+      static void operator delete(void*);
+
+    private:
+      struct record_s {
+	    vvp_net_ptr_t ptr;
+	    unsigned base;
+	    unsigned vwid;
+	    unsigned wid;
+      };
+      enum { WORD_BITS = 8*sizeof(unsigned long),
+	     RECORD_WORDS = (sizeof(record_s) + sizeof(unsigned long) - 1)
+			    / sizeof(unsigned long) };
+
+      const unsigned long* get_record_(const unsigned long*cur,
+				       const record_s*&rec,
+				       vvp_vector4_t&val) const;
+
+	// The buffer only grows, and fill_ is the part that is in use.
+      std::vector<unsigned long>*buf_;
+      size_t fill_;
+      unsigned long count_;
+	// The value words of the records wider than a word, which an
+	// assign_vector4_event_s would keep on the heap.
+      size_t wide_words_;
+
+      static std::vector< std::vector<unsigned long>* > free_bufs_;
+};
+
+std::vector< std::vector<unsigned long>* > assign_vector4_batch_s::free_bufs_;
+
+static const size_t BATCH_CHUNK_COUNT = 8192 / sizeof(struct assign_vector4_batch_s);
+static slab_t<sizeof(assign_vector4_batch_s),BATCH_CHUNK_COUNT> batch_heap;
+
+inline void* assign_vector4_batch_s::operator new(size_t size)
+{
+      assert(size == sizeof(assign_vector4_batch_s));
+      return batch_heap.alloc_slab();
+}
+
+void assign_vector4_batch_s::operator delete(void*ptr)
+{
+      batch_heap.free_slab(ptr);
+}
+
+assign_vector4_batch_s::assign_vector4_batch_s()
+{
+      if (free_bufs_.empty()) {
+	    buf_ = new std::vector<unsigned long>;
+      } else {
+	    buf_ = free_bufs_.back();
+	    free_bufs_.pop_back();
+      }
+      fill_ = 0;
+      count_ = 0;
+      wide_words_ = 0;
+}
+
+assign_vector4_batch_s::~assign_vector4_batch_s()
+{
+      free_bufs_.push_back(buf_);
+}
+
+void assign_vector4_batch_s::append(vvp_net_ptr_t ptr,
+				    unsigned base, unsigned vwid,
+				    const vvp_vector4_t&src,
+				    unsigned adr, unsigned wid)
+{
+      assert(adr + wid <= src.size());
+
+      unsigned nword = (wid + WORD_BITS - 1) / WORD_BITS;
+      size_t need = fill_ + RECORD_WORDS + 2*nword;
+      if (need > buf_->size())
+	    buf_->resize(need > 2*buf_->size()? need : 2*buf_->size());
+
+      unsigned long*cur = &(*buf_)[fill_];
+      fill_ = need;
+      record_s*rec = reinterpret_cast<record_s*>(cur);
+      rec->ptr  = ptr;
+      rec->base = base;
+      rec->vwid = vwid;
+      rec->wid  = wid;
+      cur += RECORD_WORDS;
+
+      for (unsigned idx = 0 ;  idx < nword ;  idx += 1) {
+	    unsigned trans = wid - idx*WORD_BITS;
+	    if (trans > WORD_BITS)
+		  trans = WORD_BITS;
+	    src.subword(adr + idx*WORD_BITS, trans, cur[0], cur[1]);
+	    cur += 2;
+      }
+
+      count_ += 1;
+      if (nword > 1)
+	    wide_words_ += 2*nword;
+}
+
+/*
+ * Get the record at cur into rec and val, and return the position of
+ * the next record. The val is only resized when the width changes.
+ */
+const unsigned long* assign_vector4_batch_s::get_record_(const unsigned long*cur,
+							  const record_s*&rec,
+							  vvp_vector4_t&val) const
+{
+      rec = reinterpret_cast<const record_s*>(cur);
+      cur += RECORD_WORDS;
+
+      if (val.size() != rec->wid)
+	    val = vvp_vector4_t(rec->wid);
+
+      unsigned nword = (rec->wid + WORD_BITS - 1) / WORD_BITS;
+      for (unsigned idx = 0 ;  idx < nword ;  idx += 1) {
+	    unsigned trans = rec->wid - idx*WORD_BITS;
+	    if (trans > WORD_BITS)
+		  trans = WORD_BITS;
+	    val.setword(idx*WORD_BITS, trans, cur[0], cur[1]);
+	    cur += 2;
+      }
+
+      return cur;
+}
+
+/*
+ * The batch is off the nbassign list by the time it runs, so the
+ * assigns that its sends cause go to a new batch and the buffer does
+ * not move under this loop.
+ */
+void assign_vector4_batch_s::run_run(void)
+{
+      count_assign_events += count_;
+      count_nbassign_batches += 1;
+      count_nbassign_batched += count_;
+      size_nbassign_batched += fill_ * sizeof(unsigned long);
+      size_nbassign_events += count_ * sizeof(assign_vector4_event_s)
+			    + wide_words_ * sizeof(unsigned long);
+
+      vvp_vector4_t val;
+      const unsigned long*cur = fill_? &(*buf_)[0] : 0;
+
+      for (unsigned long idx = 0 ;  idx < count_ ;  idx += 1) {
+	    const record_s*rec;
+	    cur = get_record_(cur, rec, val);
+
+	    if (rec->vwid > 0)
+		  vvp_send_vec4_pv(rec->ptr, val, rec->base, rec->wid, rec->vwid, 0);
+	    else
+		  vvp_send_vec4(rec->ptr, val, 0);
+      }
+}
+
+void assign_vector4_batch_s::single_step_display(void)
+{
+      cerr << "assign_vector4_batch: Propagate " << count_
+	   << " non-blocking assigns" << endl;
+}
+
 struct assign_vector8_event_s  : public event_s {
       vvp_net_ptr_t ptr;
       vvp_vector8_t val;
       void run_run(void);
+      void save_state(vvp_checkpoint_out&out) const;
       void single_step_display(void);
 
       static void* operator new(size_t);
@@ -259,6 +467,7 @@ struct assign_real_event_s  : public event_s {
       vvp_net_ptr_t ptr;
       double val;
       void run_run(void);
+      void save_state(vvp_checkpoint_out&out) const;
       void single_step_display(void);
 
       static void* operator new(size_t);
@@ -298,6 +507,7 @@ struct assign_array_word_s  : public event_s {
       vvp_vector4_t val;
       unsigned off;
       void run_run(void);
+      void save_state(vvp_checkpoint_out&out) const;
 
       static void* operator new(size_t);
       static void operator delete(void*);
@@ -346,6 +556,7 @@ struct propagate_vector4_event_s : public event_s {
       vvp_vector4_t val;
 	/* Action */
       void run_run(void);
+      void save_state(vvp_checkpoint_out&out) const;
       void single_step_display(void);
 };
 
@@ -370,6 +581,7 @@ struct propagate_real_event_s : public event_s {
       double val;
 	/* Action */
       void run_run(void);
+      void save_state(vvp_checkpoint_out&out) const;
       void single_step_display(void);
 };
 
@@ -388,6 +600,7 @@ struct assign_array_r_word_s  : public event_s {
       unsigned adr;
       double val;
       void run_run(void);
+      void save_state(vvp_checkpoint_out&out) const;
 
       static void* operator new(size_t);
       static void operator delete(void*);
@@ -418,6 +631,7 @@ struct generic_event_s : public event_s {
       vvp_gen_event_t obj;
       bool delete_obj_when_done;
       void run_run(void);
+      void save_state(vvp_checkpoint_out&out) const;
       void single_step_display(void);
 
       static void* operator new(size_t);
@@ -568,11 +782,8 @@ static void schedule_init_event(struct event_s*cur)
 typedef enum event_queue_e { SEQ_START, SEQ_ACTIVE, SEQ_NBASSIGN,
 			     SEQ_RWSYNC, SEQ_ROSYNC, DEL_THREAD } event_queue_t;
 
-static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
-			    event_queue_t select_queue)
+static struct event_time_s* schedule_event_time_(vvp_time64_t delay)
 {
-      cur->next = cur;
-
       struct event_time_s*ctim = sched_list;
 
       if (sched_list == 0) {
@@ -625,9 +836,18 @@ static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
 	    }
       }
 
-	/* By this point, ctim is the event_time structure that is to
-	   receive the event at hand. Put the event in to the
-	   appropriate list for the kind of assign we have at hand. */
+      return ctim;
+}
+
+/*
+ * Put the event in to the appropriate list of the event_time
+ * structure for the kind of assign we have at hand.
+ */
+static void schedule_event_queue_(struct event_time_s*ctim,
+				  struct event_s*cur,
+				  event_queue_t select_queue)
+{
+      cur->next = cur;
 
       switch (select_queue) {
 
@@ -654,6 +874,7 @@ static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
 	    break;
 
 	  case SEQ_NBASSIGN:
+	    ctim->nbbatch = 0;
 	    if (ctim->nbassign == 0) {
 		  ctim->nbassign = cur;
 
@@ -703,6 +924,33 @@ static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
       }
 }
 
+static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
+			    event_queue_t select_queue)
+{
+      schedule_event_queue_(schedule_event_time_(delay), cur, select_queue);
+}
+
+/*
+ * Add a non-blocking vector assign to the batch at the end of the
+ * nbassign list for the time, starting a new batch if there is none.
+ */
+static inline void schedule_nbassign_vector_(vvp_net_ptr_t ptr,
+					     unsigned base, unsigned vwid,
+					     const vvp_vector4_t&src,
+					     unsigned adr, unsigned wid,
+					     vvp_time64_t delay)
+{
+      struct event_time_s*ctim = schedule_event_time_(delay);
+
+      if (ctim->nbbatch == 0) {
+	    struct assign_vector4_batch_s*cur = new assign_vector4_batch_s;
+	    schedule_event_queue_(ctim, cur, SEQ_NBASSIGN);
+	    ctim->nbbatch = cur;
+      }
+
+      ctim->nbbatch->append(ptr, base, vwid, src, adr, wid);
+}
+
 static void schedule_event_push_(struct event_s*cur)
 {
       if ((sched_list == 0) || (sched_list->delay > 0)) {
@@ -746,11 +994,7 @@ void schedule_assign_vector(vvp_net_ptr_t ptr,
 			    const vvp_vector4_t&bit,
 			    vvp_time64_t delay)
 {
-      struct assign_vector4_event_s*cur = new struct assign_vector4_event_s(bit);
-      cur->ptr = ptr;
-      cur->base = base;
-      cur->vwid = vwid;
-      schedule_event_(cur, delay, SEQ_NBASSIGN);
+      schedule_nbassign_vector_(ptr, base, vwid, bit, 0, bit.size(), delay);
 }
 
 void schedule_assign_plucked_vector(vvp_net_ptr_t ptr,
@@ -758,12 +1002,7 @@ void schedule_assign_plucked_vector(vvp_net_ptr_t ptr,
 				    const vvp_vector4_t&src,
 				    unsigned adr, unsigned wid)
 {
-      struct assign_vector4_event_s*cur
-	    = new struct assign_vector4_event_s(src,adr,wid);
-      cur->ptr = ptr;
-      cur->vwid = 0;
-      cur->base = 0;
-      schedule_event_(cur, delay, SEQ_NBASSIGN);
+      schedule_nbassign_vector_(ptr, 0, 0, src, adr, wid, delay);
 }
 
 void schedule_propagate_plucked_vector(vvp_net_t*net,
@@ -895,6 +1134,11 @@ static bool sim_started;
 
 void schedule_functor(vvp_gen_event_t obj)
 {
+      if (cycle_mode && cycle_schedule_functor(obj))
+	    return;
+      if (lazy_mode && lazy_schedule_functor(obj))
+	    return;
+
       struct generic_event_s*cur = new generic_event_s;
 
       cur->obj = obj;
@@ -972,6 +1216,8 @@ void schedule_simulate(void)
 
       schedule_time = 0;
 
+      checkpoint_design_complete();
+
       if (verbose_flag) {
 	    vpi_mcd_printf(1, " ...execute EndOfCompile callbacks\n");
       }
@@ -1004,6 +1250,11 @@ void schedule_simulate(void)
 
       sim_started = true;
 
+	// A checkpoint restart requested on the command line replaces
+	// the initial state of the design.
+      if (checkpoint_pending())
+	    schedule_checkpoints();
+
       signals_capture();
 
       if (verbose_flag) {
@@ -1058,6 +1309,7 @@ void schedule_simulate(void)
 	    if (ctim->active == 0) {
 		  ctim->active = ctim->nbassign;
 		  ctim->nbassign = 0;
+		  ctim->nbbatch = 0;
 
 		  if (ctim->active == 0) {
 			ctim->active = ctim->rwsync;
@@ -1070,6 +1322,10 @@ void schedule_simulate(void)
 			      run_rosync(ctim);
 			      sched_list = ctim->next;
 			      delete ctim;
+				// The time step is complete, so this
+				// is where $save and $restart happen.
+			      if (checkpoint_pending() && schedule_runnable)
+				    schedule_checkpoints();
 			      continue;
 			}
 		  }
@@ -1106,3 +1362,376 @@ void schedule_simulate(void)
       // Execute post-simulation callbacks
       vpiPostsim();
 }
+
+/*
+ * Checkpoint support. The event queue is saved as the list of time
+ * steps, each with its delay (relative to the previous step) and the
+ * events of each region. The events are tagged with their type and
+ * written with the design objects they refer to. Events that belong
+ * to VPI applications cannot be saved, and neither can the time step
+ * in progress, which is why checkpoints are taken only between time
+ * steps.
+ */
+enum checkpoint_event_tag_e {
+      CKPT_EV_VTHREAD = 1,
+      CKPT_EV_DEL_THR,
+      CKPT_EV_ASSIGN4,
+      CKPT_EV_ASSIGN8,
+      CKPT_EV_ASSIGNR,
+      CKPT_EV_ARRAY_WORD,
+      CKPT_EV_PROPAGATE4,
+      CKPT_EV_PROPAGATER,
+      CKPT_EV_ARRAY_R_WORD,
+      CKPT_EV_GENERIC,
+      CKPT_EV_ASSIGN4_BATCH
+};
+
+void event_s::save_state(vvp_checkpoint_out&out) const
+{
+      out.refuse("an event of type %s is scheduled", typeid(*this).name());
+}
+
+void vthread_event_s::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_u8(CKPT_EV_VTHREAD);
+      out.put_thread(thr);
+}
+
+void del_thr_event_s::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_u8(CKPT_EV_DEL_THR);
+      out.put_thread(thr);
+}
+
+void assign_vector4_event_s::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_u8(CKPT_EV_ASSIGN4);
+      out.put_ptr(ptr);
+      out.put_vec4(val);
+      out.put_u32(base);
+      out.put_u32(vwid);
+}
+
+void assign_vector4_batch_s::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_u8(CKPT_EV_ASSIGN4_BATCH);
+      out.put_u32(count_);
+
+      vvp_vector4_t val;
+      const unsigned long*cur = fill_? &(*buf_)[0] : 0;
+      for (unsigned long idx = 0 ;  idx < count_ ;  idx += 1) {
+	    const record_s*rec;
+	    cur = get_record_(cur, rec, val);
+	    out.put_ptr(rec->ptr);
+	    out.put_vec4(val);
+	    out.put_u32(rec->base);
+	    out.put_u32(rec->vwid);
+      }
+}
+
+void assign_vector8_event_s::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_u8(CKPT_EV_ASSIGN8);
+      out.put_ptr(ptr);
+      out.put_vec8(val);
+}
+
+void assign_real_event_s::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_u8(CKPT_EV_ASSIGNR);
+      out.put_ptr(ptr);
+      out.put_double(val);
+}
+
+void assign_array_word_s::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_u8(CKPT_EV_ARRAY_WORD);
+      out.put_array(mem);
+      out.put_u32(adr);
+      out.put_vec4(val);
+      out.put_u32(off);
+}
+
+void propagate_vector4_event_s::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_u8(CKPT_EV_PROPAGATE4);
+      out.put_net(net);
+      out.put_vec4(val);
+}
+
+void propagate_real_event_s::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_u8(CKPT_EV_PROPAGATER);
+      out.put_net(net);
+      out.put_double(val);
+}
+
+void assign_array_r_word_s::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_u8(CKPT_EV_ARRAY_R_WORD);
+      out.put_array(mem);
+      out.put_u32(adr);
+      out.put_double(val);
+}
+
+/*
+ * Generic events can be saved only if the object is the functor of
+ * a net, so that the restored event can find the same object in the
+ * new design. Everything else (VPI callbacks, system task events,
+ * delayed vpi_put_value, etc.) is owned by code that does not know
+ * how to save itself.
+ */
+void generic_event_s::save_state(vvp_checkpoint_out&out) const
+{
+      vvp_net_t*net = obj? obj->checkpoint_net() : 0;
+      if (net == 0 || delete_obj_when_done) {
+	    out.refuse("a VPI callback or system task event is pending");
+	    return;
+      }
+
+      out.put_u8(CKPT_EV_GENERIC);
+      out.put_net(net);
+}
+
+static struct event_s* restore_event(vvp_checkpoint_in&in)
+{
+      switch (in.get_u8()) {
+
+	  case CKPT_EV_VTHREAD: {
+		struct vthread_event_s*cur = new vthread_event_s;
+		cur->thr = in.get_thread();
+		return cur;
+	  }
+
+	  case CKPT_EV_DEL_THR: {
+		struct del_thr_event_s*cur = new del_thr_event_s;
+		cur->thr = in.get_thread();
+		return cur;
+	  }
+
+	  case CKPT_EV_ASSIGN4: {
+		vvp_net_ptr_t ptr = in.get_ptr();
+		struct assign_vector4_event_s*cur
+		      = new assign_vector4_event_s(in.get_vec4());
+		cur->ptr = ptr;
+		cur->base = in.get_u32();
+		cur->vwid = in.get_u32();
+		return cur;
+	  }
+
+	  case CKPT_EV_ASSIGN4_BATCH: {
+		struct assign_vector4_batch_s*cur = new assign_vector4_batch_s;
+		unsigned long count = in.get_u32();
+		for (unsigned long idx = 0 ;  idx < count && !in.failed() ;  idx += 1) {
+		      vvp_net_ptr_t ptr = in.get_ptr();
+		      vvp_vector4_t val = in.get_vec4();
+		      unsigned base = in.get_u32();
+		      unsigned vwid = in.get_u32();
+		      cur->append(ptr, base, vwid, val, 0, val.size());
+		}
+		return cur;
+	  }
+
+	  case CKPT_EV_ASSIGN8: {
+		struct assign_vector8_event_s*cur = new assign_vector8_event_s;
+		cur->ptr = in.get_ptr();
+		cur->val = in.get_vec8();
+		return cur;
+	  }
+
+	  case CKPT_EV_ASSIGNR: {
+		struct assign_real_event_s*cur = new assign_real_event_s;
+		cur->ptr = in.get_ptr();
+		cur->val = in.get_double();
+		return cur;
+	  }
+
+	  case CKPT_EV_ARRAY_WORD: {
+		struct assign_array_word_s*cur = new assign_array_word_s;
+		cur->mem = in.get_array();
+		cur->adr = in.get_u32();
+		cur->val = in.get_vec4();
+		cur->off = in.get_u32();
+		return cur;
+	  }
+
+	  case CKPT_EV_PROPAGATE4: {
+		vvp_net_t*net = in.get_net();
+		struct propagate_vector4_event_s*cur
+		      = new propagate_vector4_event_s(in.get_vec4());
+		cur->net = net;
+		return cur;
+	  }
+
+	  case CKPT_EV_PROPAGATER: {
+		struct propagate_real_event_s*cur = new propagate_real_event_s;
+		cur->net = in.get_net();
+		cur->val = in.get_double();
+		return cur;
+	  }
+
+	  case CKPT_EV_ARRAY_R_WORD: {
+		struct assign_array_r_word_s*cur = new assign_array_r_word_s;
+		cur->mem = in.get_array();
+		cur->adr = in.get_u32();
+		cur->val = in.get_double();
+		return cur;
+	  }
+
+	  case CKPT_EV_GENERIC: {
+		vvp_net_t*net = in.get_net();
+		vvp_gen_event_t obj = (net && net->fun)? net->fun->checkpoint_event() : 0;
+		if (obj == 0) {
+		      in.error("scheduled event refers to the wrong functor");
+		      return 0;
+		}
+		struct generic_event_s*cur = new generic_event_s;
+		cur->obj = obj;
+		cur->delete_obj_when_done = false;
+		return cur;
+	  }
+
+	  default:
+	    in.error("invalid event record");
+	    return 0;
+      }
+}
+
+static void save_event_list(vvp_checkpoint_out&out, const struct event_s*list)
+{
+      unsigned long count = 0;
+      if (list) {
+	    const struct event_s*cur = list;
+	    do {
+		  count += 1;
+		  cur = cur->next;
+	    } while (cur != list);
+      }
+
+      out.put_u32(count);
+      if (list == 0)
+	    return;
+
+	// The list pointer is the last event, so start from its next.
+      const struct event_s*cur = list;
+      do {
+	    cur = cur->next;
+	    cur->save_state(out);
+      } while (cur != list && !out.refused());
+}
+
+static struct event_s* restore_event_list(vvp_checkpoint_in&in)
+{
+      struct event_s*list = 0;
+      unsigned long count = in.get_u32();
+
+      for (unsigned long idx = 0 ;  idx < count && !in.failed() ;  idx += 1) {
+	    struct event_s*cur = restore_event(in);
+	    if (cur == 0)
+		  break;
+
+	    if (list == 0) {
+		  cur->next = cur;
+	    } else {
+		  cur->next = list->next;
+		  list->next = cur;
+	    }
+	    list = cur;
+      }
+
+      return list;
+}
+
+void schedule_save_state(vvp_checkpoint_out&out)
+{
+      if (schedule_init_list)
+	    out.refuse("initialization events are pending");
+
+      out.put_u64(schedule_time);
+
+      unsigned long count = 0;
+      for (struct event_time_s*ctim = sched_list ; ctim ; ctim = ctim->next)
+	    count += 1;
+
+      out.put_u32(count);
+      for (struct event_time_s*ctim = sched_list ; ctim ; ctim = ctim->next) {
+	    out.put_u64(ctim->delay);
+	    save_event_list(out, ctim->start);
+	    save_event_list(out, ctim->active);
+	    save_event_list(out, ctim->nbassign);
+	    save_event_list(out, ctim->rwsync);
+	    save_event_list(out, ctim->rosync);
+	    save_event_list(out, ctim->del_thr);
+	    if (out.refused())
+		  break;
+      }
+}
+
+/*
+ * The queue must be empty (see schedule_clear_state) before this is
+ * called. The events are put back exactly as they were saved, so the
+ * is_scheduled flags of the threads, which are restored with the
+ * threads, are already right.
+ */
+void schedule_restore_state(vvp_checkpoint_in&in)
+{
+      assert(sched_list == 0);
+
+      schedule_time = in.get_u64();
+
+      unsigned long count = in.get_u32();
+      struct event_time_s*last = 0;
+      for (unsigned long idx = 0 ;  idx < count && !in.failed() ;  idx += 1) {
+	    struct event_time_s*ctim = new struct event_time_s;
+	    ctim->delay = in.get_u64();
+	    ctim->start    = restore_event_list(in);
+	    ctim->active   = restore_event_list(in);
+	    ctim->nbassign = restore_event_list(in);
+	    ctim->rwsync   = restore_event_list(in);
+	    ctim->rosync   = restore_event_list(in);
+	    ctim->del_thr  = restore_event_list(in);
+
+	    if (last)
+		  last->next = ctim;
+	    else
+		  sched_list = ctim;
+	    last = ctim;
+      }
+}
+
+static void clear_event_list(struct event_s*&list, std::set<vthread_t>&threads)
+{
+      while (list) {
+	    struct event_s*cur = list->next;
+	    if (cur->next == cur)
+		  list = 0;
+	    else
+		  list->next = cur->next;
+
+	    if (vthread_event_s*vev = dynamic_cast<vthread_event_s*>(cur))
+		  threads.insert(vev->thr);
+	    else if (del_thr_event_s*dev = dynamic_cast<del_thr_event_s*>(cur))
+		  threads.insert(dev->thr);
+	    else if (generic_event_s*gev = dynamic_cast<generic_event_s*>(cur)) {
+		  if (gev->delete_obj_when_done)
+			delete gev->obj;
+	    }
+
+	    delete cur;
+      }
+}
+
+void schedule_clear_state(std::set<vthread_t>&threads)
+{
+      while (sched_list) {
+	    struct event_time_s*ctim = sched_list;
+	    clear_event_list(ctim->start, threads);
+	    clear_event_list(ctim->active, threads);
+	    clear_event_list(ctim->nbassign, threads);
+	    clear_event_list(ctim->rwsync, threads);
+	    clear_event_list(ctim->rosync, threads);
+	    clear_event_list(ctim->del_thr, threads);
+	    sched_list = ctim->next;
+	    delete ctim;
+      }
+}
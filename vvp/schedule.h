@@ -142,6 +142,10 @@ struct vvp_gen_event_s
       virtual ~vvp_gen_event_s() =0;
       virtual void run_run() =0;
       virtual void single_step_display(void);
+	// A functor that schedules itself as a generic event returns
+	// its net here, so that a checkpoint can save the pending
+	// event. Other generic events cannot be saved.
+      virtual vvp_net_t* checkpoint_net(void) const;
 };
 
 /*
@@ -26,6 +26,7 @@ unsigned long count_opcodes = 0;
 
 unsigned long count_functors = 0;
 unsigned long count_functors_logic = 0;
+unsigned long count_functors_scalar= 0;
 unsigned long count_functors_bufif = 0;
 unsigned long count_functors_resolv= 0;
 unsigned long count_functors_sig   = 0;
@@ -37,3 +38,9 @@ unsigned long count_vpi_scopes = 0;
 
 size_t size_opcodes = 0;
 
+/*
+ * These are the direct-indexed UDP truth tables, and their total
+ * size in bytes.
+ */
+unsigned long count_udp_tables = 0;
+size_t size_udp_tables = 0;
@@ -29,6 +29,7 @@
 extern unsigned long count_opcodes;
 extern unsigned long count_functors;
 extern unsigned long count_functors_logic;
+extern unsigned long count_functors_scalar;
 extern unsigned long count_functors_bufif;
 extern unsigned long count_functors_resolv;
 extern unsigned long count_functors_sig;
@@ -44,11 +45,18 @@ extern unsigned long count_var_array_words;
 extern unsigned long count_real_arrays;
 extern unsigned long count_real_array_words;
 
+extern unsigned long count_udp_tables;
+extern size_t size_udp_tables;
+
 
 extern unsigned long count_time_events;
 extern unsigned long count_time_pool(void);
 
 extern unsigned long count_assign_events;
+extern unsigned long count_nbassign_batches;
+extern unsigned long count_nbassign_batched;
+extern size_t size_nbassign_batched;
+extern size_t size_nbassign_events;
 extern unsigned long count_assign4_pool(void);
 extern unsigned long count_assign8_pool(void);
 extern unsigned long count_assign_real_pool(void);
@@ -25,6 +25,8 @@
 #include "symbols.h"
 #include "compile.h"
 #include "config.h"
+#include "statistics.h"
+#include "checkpoint.h"
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
@@ -62,6 +64,61 @@ void udp_defns_delete()
 
 static symbol_table_t udp_table;
 
+/*
+ * UDP definitions with at most this many inputs are expanded into
+ * direct-indexed lookup tables. A combinational table has 3**N
+ * entries, a sequential device needs 3**(N+1) level entries plus
+ * 3**(N+1)*N*3 edge entries, so the limits keep each definition to a
+ * few tens of kilobytes. Wider devices scan the compiled rows.
+ */
+static const unsigned UDP_COMB_LOOKUP_MAX = 8;
+static const unsigned UDP_SEQ_LOOKUP_MAX = 6;
+
+static const unsigned long udp_pow3[] = {
+      1, 3, 9, 27, 81, 243, 729, 2187, 6561, 19683
+};
+
+/*
+ * Convert a base-3 input index back to the levels table that the row
+ * scanning methods expect.
+ */
+static udp_levels_table udp_index_to_levels(unsigned long idx,
+					    unsigned nports)
+{
+      udp_levels_table cur;
+      cur.mask0 = 0;
+      cur.mask1 = 0;
+      cur.maskx = 0;
+      for (unsigned pp = 0 ;  pp < nports ;  pp += 1) {
+	    unsigned long mask_bit = 1UL << pp;
+	    switch (idx % 3) {
+		case 0:
+		  cur.mask0 |= mask_bit;
+		  break;
+		case 1:
+		  cur.mask1 |= mask_bit;
+		  break;
+		default:
+		  cur.maskx |= mask_bit;
+		  break;
+	    }
+	    idx /= 3;
+      }
+      return cur;
+}
+
+static inline unsigned udp_bit_digit(vvp_bit4_t bit)
+{
+      switch (bit) {
+	  case BIT4_0:
+	    return 0;
+	  case BIT4_1:
+	    return 1;
+	  default:
+	    return 2;
+      }
+}
+
 void delete_udp_symbols()
 {
       delete_symbol_table(udp_table);
@@ -83,7 +140,7 @@ ostream& operator <<(ostream&o, const struct udp_levels_table&table)
 }
 
 vvp_udp_s::vvp_udp_s(char*label, unsigned ports, vvp_bit4_t init, bool type)
-: ports_(ports), init_(init), seq_(type)
+: lookup_(false), ports_(ports), init_(init), seq_(type)
 {
       if (!udp_table)
 	    udp_table = new_symbol_table();
@@ -124,12 +181,14 @@ vvp_udp_comb_s::vvp_udp_comb_s(char*label, char*name, unsigned ports)
       levels1_ = 0;
       nlevels0_ = 0;
       nlevels1_ = 0;
+      lookup_levels_ = 0;
 }
 
 vvp_udp_comb_s::~vvp_udp_comb_s()
 {
       delete[] levels0_;
       delete[] levels1_;
+      delete[] lookup_levels_;
 }
 
 /*
@@ -190,6 +249,12 @@ vvp_bit4_t vvp_udp_comb_s::calculate_output(const udp_levels_table&cur,
       return test_levels(cur);
 }
 
+vvp_bit4_t vvp_udp_comb_s::lookup_output(unsigned long cur_idx,
+					 unsigned, unsigned, vvp_bit4_t)
+{
+      return (vvp_bit4_t) lookup_levels_[cur_idx];
+}
+
 static void or_based_on_char(udp_levels_table&cur, char flag,
 			     unsigned long mask_bit)
 {
@@ -293,6 +358,21 @@ void vvp_udp_comb_s::compile_table(char**tab)
 
       assert(nrows0 == nlevels0_);
       assert(nrows1 == nlevels1_);
+
+	/* Narrow devices get every input combination evaluated now
+	   so that the instances can look up their output directly. */
+      if (port_count() > UDP_COMB_LOOKUP_MAX)
+	    return;
+
+      unsigned long nstates = udp_pow3[port_count()];
+      lookup_levels_ = new unsigned char[nstates];
+      for (unsigned long idx = 0 ;  idx < nstates ;  idx += 1) {
+	    udp_levels_table cur = udp_index_to_levels(idx, port_count());
+	    lookup_levels_[idx] = test_levels(cur);
+      }
+      lookup_ = true;
+      count_udp_tables += 1;
+      size_udp_tables += nstates;
 }
 
 vvp_udp_seq_s::vvp_udp_seq_s(char*label, char*name,
@@ -317,6 +397,9 @@ vvp_udp_seq_s::vvp_udp_seq_s(char*label, char*name,
       nedges0_ = 0;
       nedges1_ = 0;
       nedgesL_ = 0;
+
+      lookup_levels_ = 0;
+      lookup_edges_ = 0;
 }
 
 vvp_udp_seq_s::~vvp_udp_seq_s()
@@ -328,6 +411,8 @@ vvp_udp_seq_s::~vvp_udp_seq_s()
       delete[] edges0_;
       delete[] edges1_;
       delete[] edgesL_;
+      delete[] lookup_levels_;
+      delete[] lookup_edges_;
 }
 
 void edge_based_on_char(struct udp_edges_table&cur, char chr, unsigned pos)
@@ -674,6 +759,65 @@ void vvp_udp_seq_s::compile_table(char**tab)
       assert(idx_edg1 == nedges1_);
       assert(idx_edgL == nedgesL_);
 
+      if (port_count() <= UDP_SEQ_LOOKUP_MAX)
+	    compile_lookup_();
+}
+
+/*
+ * Expand the compiled rows into the lookup tables. The state index is
+ * the base-3 input index with the current output appended as the
+ * least significant digit. The edge table is only filled in for
+ * states where no level row matches, and for each input it holds the
+ * result of a transition into this state from each of the other two
+ * levels of that input. The entry for "no change" is never used.
+ */
+void vvp_udp_seq_s::compile_lookup_()
+{
+      unsigned nports = port_count();
+      unsigned long nstates = udp_pow3[nports+1];
+      unsigned long mask_out = 1UL << nports;
+
+      lookup_levels_ = new unsigned char[nstates];
+      lookup_edges_ = new unsigned char[nstates*nports*3];
+
+      for (unsigned long state = 0 ;  state < nstates ;  state += 1) {
+	    unsigned long in_idx = state / 3;
+	    udp_levels_table cur = udp_index_to_levels(in_idx, nports);
+	    switch (state % 3) {
+		case 0:
+		  cur.mask0 |= mask_out;
+		  break;
+		case 1:
+		  cur.mask1 |= mask_out;
+		  break;
+		default:
+		  cur.maskx |= mask_out;
+		  break;
+	    }
+
+	    vvp_bit4_t lev = test_levels_(cur);
+	    lookup_levels_[state] = lev;
+
+	    unsigned char*edges = lookup_edges_ + state*nports*3;
+	    for (unsigned pp = 0 ;  pp < nports ;  pp += 1) {
+		  unsigned cur_lev = (in_idx / udp_pow3[pp]) % 3;
+		  for (unsigned prev_lev = 0 ; prev_lev < 3 ; prev_lev += 1) {
+			if (lev != BIT4_Z || prev_lev == cur_lev) {
+			      edges[pp*3 + prev_lev] = BIT4_X;
+			      continue;
+			}
+			unsigned long prev_idx = in_idx
+			      - cur_lev*udp_pow3[pp] + prev_lev*udp_pow3[pp];
+			udp_levels_table prev
+			      = udp_index_to_levels(prev_idx, nports);
+			edges[pp*3 + prev_lev] = test_edges_(cur, prev);
+		  }
+	    }
+      }
+
+      lookup_ = true;
+      count_udp_tables += 1;
+      size_udp_tables += nstates + nstates*nports*3;
 }
 
 bool operator == (const udp_levels_table&a, const udp_levels_table&b)
@@ -717,6 +861,20 @@ vvp_bit4_t vvp_udp_seq_s::calculate_output(const udp_levels_table&cur,
       return lev;
 }
 
+vvp_bit4_t vvp_udp_seq_s::lookup_output(unsigned long cur_idx,
+					unsigned port, unsigned prev_lev,
+					vvp_bit4_t cur_out)
+{
+      unsigned long state = cur_idx*3 + udp_bit_digit(cur_out);
+
+      vvp_bit4_t lev = (vvp_bit4_t) lookup_levels_[state];
+      if (lev != BIT4_Z)
+	    return lev;
+
+      unsigned long edge = (state*port_count() + port)*3 + prev_lev;
+      return (vvp_bit4_t) lookup_edges_[edge];
+}
+
 /*
  * This function tests the levels of the input with the additional
  * check match for the current output. It uses this to calculate a
@@ -910,6 +1068,8 @@ vvp_udp_fun_core::vvp_udp_fun_core(vvp_net_t*net, vvp_udp_s*def)
       current_.mask0 = 0;
       current_.mask1 = 0;
       current_.maskx = ~ ((-1UL) << port_count());
+      index_ = def_->has_lookup()? udp_pow3[port_count()] - 1 : 0;
+      evaluated_ = false;
 
       if (cur_out_ != BIT4_X)
 	    schedule_functor(this);
@@ -919,6 +1079,29 @@ vvp_udp_fun_core::~vvp_udp_fun_core()
 {
 }
 
+bool vvp_udp_fun_core::save_state(vvp_checkpoint_out&out) const
+{
+      vvp_wide_fun_core::save_state(out);
+      out.put_u8(cur_out_);
+      out.put_u64(current_.mask0);
+      out.put_u64(current_.mask1);
+      out.put_u64(current_.maskx);
+      out.put_u64(index_);
+      return true;
+}
+
+void vvp_udp_fun_core::restore_state(vvp_checkpoint_in&in)
+{
+      vvp_wide_fun_core::restore_state(in);
+      cur_out_ = (vvp_bit4_t)in.get_u8();
+      current_.mask0 = in.get_u64();
+      current_.mask1 = in.get_u64();
+      current_.maskx = in.get_u64();
+      index_ = in.get_u64();
+	// Not saved. Looking the output up again is always safe.
+      evaluated_ = false;
+}
+
 /*
  * This method is used to propagate the initial value on startup.
  */
@@ -937,6 +1120,7 @@ void vvp_udp_fun_core::recv_vec4_from_inputs(unsigned port)
       unsigned long mask = 1UL << port;
 
       udp_levels_table prev = current_;
+      unsigned prev_lev = (prev.mask0 & mask)? 0 : (prev.mask1 & mask)? 1 : 2;
 
       switch (value(port).value(0)) {
 
@@ -957,7 +1141,24 @@ void vvp_udp_fun_core::recv_vec4_from_inputs(unsigned port)
 	    break;
       }
 
-      vvp_bit4_t out_bit = def_->calculate_output(current_, prev, cur_out_);
+      vvp_bit4_t out_bit;
+      if (def_->has_lookup()) {
+	    unsigned cur_lev = udp_bit_digit(value(port).value(0));
+	      // A change that does not change the level (i.e. x <-> z)
+	      // cannot change the output of a sequential UDP, nor of a
+	      // combinational UDP once the output has been looked up.
+	      // Before that, cur_out_ is still the X that the all-x
+	      // inputs of the constructor assume, and the all-x row of
+	      // the table may say otherwise.
+	    if (cur_lev == prev_lev
+		&& (evaluated_ || def_->is_sequential()))
+		  return;
+	    index_ = index_ - prev_lev*udp_pow3[port] + cur_lev*udp_pow3[port];
+	    out_bit = def_->lookup_output(index_, port, prev_lev, cur_out_);
+	    evaluated_ = true;
+      } else {
+	    out_bit = def_->calculate_output(current_, prev, cur_out_);
+      }
 
       if (out_bit == cur_out_)
 	    return;
@@ -47,6 +47,20 @@ struct vvp_udp_s {
 					  const udp_levels_table&prev,
 					  vvp_bit4_t cur_out) =0;
 
+	// Narrow definitions are expanded by compile_table into
+	// direct-indexed tables. The instance then keeps its input
+	// levels as a base-3 index (digit 0, 1 or 2 for 0, 1 and x/z,
+	// the first port is the least significant digit) and calls
+	// lookup_output instead of calculate_output. PORT is the
+	// input that changed and PREV_LEV is its previous digit.
+      bool has_lookup() const { return lookup_; }
+      virtual vvp_bit4_t lookup_output(unsigned long cur_idx,
+				       unsigned port, unsigned prev_lev,
+				       vvp_bit4_t cur_out) =0;
+
+    protected:
+      bool lookup_;
+
     private:
       unsigned ports_;
       vvp_bit4_t init_;
@@ -124,6 +138,10 @@ class vvp_udp_comb_s : public vvp_udp_s {
 				  const udp_levels_table&prev,
 				  vvp_bit4_t cur_out);
 
+      vvp_bit4_t lookup_output(unsigned long cur_idx,
+			       unsigned port, unsigned prev_lev,
+			       vvp_bit4_t cur_out);
+
     private:
       char*name_;
 
@@ -131,6 +149,10 @@ class vvp_udp_comb_s : public vvp_udp_s {
       struct udp_levels_table*levels0_;
       struct udp_levels_table*levels1_;
       unsigned nlevels0_, nlevels1_;
+
+	// Output for every combination of input levels, indexed by
+	// the base-3 input index. Only built for narrow devices.
+      unsigned char*lookup_levels_;
 };
 
 /*
@@ -189,9 +211,15 @@ class vvp_udp_seq_s : public vvp_udp_s {
 				  const udp_levels_table&prev,
 				  vvp_bit4_t cur_out);
 
+      vvp_bit4_t lookup_output(unsigned long cur_idx,
+			       unsigned port, unsigned prev_lev,
+			       vvp_bit4_t cur_out);
+
     private:
       char*name_;
 
+      void compile_lookup_();
+
       vvp_bit4_t test_levels_(const udp_levels_table&cur);
 
 	// Level sensitive rows of the device.
@@ -210,6 +238,13 @@ class vvp_udp_seq_s : public vvp_udp_s {
       struct udp_edges_table*edgesL_;
       unsigned nedges0_, nedges1_, nedgesL_;
 
+	// For narrow devices, the result of the level rows for every
+	// state, indexed by (input index)*3 + (current output digit).
+	// A BIT4_Z entry means no level row matched, and the edge
+	// table is consulted at ((state)*port_count() + port)*3 +
+	// (previous digit of port).
+      unsigned char*lookup_levels_;
+      unsigned char*lookup_edges_;
 };
 
 /*
@@ -232,12 +267,19 @@ class vvp_udp_fun_core  : public vvp_wide_fun_core, private vvp_gen_event_s {
 
       void recv_vec4_from_inputs(unsigned);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
     private:
       void run_run();
 
       vvp_udp_s*def_;
       vvp_bit4_t cur_out_;
       udp_levels_table current_;
+	// Base-3 index of the current inputs if def_ has a lookup table.
+      unsigned long index_;
+	// The output has been looked up from the inputs at least once.
+      bool evaluated_;
 };
 
 #endif
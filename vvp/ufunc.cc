@@ -25,6 +25,7 @@
 # include  "vvp_net_sig.h"
 # include  "vthread.h"
 # include  "schedule.h"
+# include  "checkpoint.h"
 #ifdef CHECK_WITH_VALGRIND
 # include  "vvp_cleanup.h"
 #endif
@@ -41,7 +42,7 @@
 ufunc_core::ufunc_core(unsigned owid, vvp_net_t*ptr,
 		       unsigned nports, vvp_net_t**ports,
 		       vvp_code_t sa, struct __vpiScope*call_scope__,
-		       char*result_label, char*scope_label)
+		       char*result_label, char*scope_label, bool pure)
 : vvp_wide_fun_core(ptr, nports)
 {
       owid_ = owid;
@@ -50,6 +51,18 @@ ufunc_core::ufunc_core(unsigned owid, vvp_net_t*ptr,
       thread_ = 0;
       call_scope_ = call_scope__;
 
+      pure_ = pure;
+      cache_fill_ = 0;
+      cache_next_ = 0;
+      cache_key_ = 0;
+      for (unsigned idx = 0 ;  idx < CACHE_SIZE ;  idx += 1)
+	    cache_[idx].key = 0;
+      if (pure_) {
+	    cache_key_ = new vvp_vector4_t[nports];
+	    for (unsigned idx = 0 ;  idx < CACHE_SIZE ;  idx += 1)
+		  cache_[idx].key = new vvp_vector4_t[nports];
+      }
+
       functor_ref_lookup(&result_, result_label);
 
 	/* A __vpiScope starts with a __vpiHandle structure so this is
@@ -61,6 +74,55 @@ ufunc_core::ufunc_core(unsigned owid, vvp_net_t*ptr,
 ufunc_core::~ufunc_core()
 {
       delete [] ports_;
+      delete [] cache_key_;
+      for (unsigned idx = 0 ;  idx < CACHE_SIZE ;  idx += 1)
+	    delete [] cache_[idx].key;
+}
+
+bool ufunc_core::save_state(vvp_checkpoint_out&out) const
+{
+      vvp_wide_fun_core::save_state(out);
+      out.put_thread(thread_);
+      return true;
+}
+
+void ufunc_core::restore_state(vvp_checkpoint_in&in)
+{
+      vvp_wide_fun_core::restore_state(in);
+      thread_ = in.get_thread();
+      cache_clear_();
+}
+
+void ufunc_core::cache_clear_()
+{
+      cache_fill_ = 0;
+      cache_next_ = 0;
+}
+
+/*
+ * If the current input values are in the cache of a pure function,
+ * propagate the saved result and return true. A thread that is
+ * already scheduled will pick up the new inputs anyhow, so don't
+ * race it with an older result.
+ */
+bool ufunc_core::cache_lookup_()
+{
+      if (! pure_ || thread_ != 0)
+	    return false;
+
+      for (unsigned idx = 0 ;  idx < cache_fill_ ;  idx += 1) {
+	    const vvp_vector4_t*key = cache_[idx].key;
+	    unsigned pdx = 0;
+	    while (pdx < port_count() && value(pdx).eeq(key[pdx]))
+		  pdx += 1;
+
+	    if (pdx == port_count()) {
+		  propagate_vec4(cache_[idx].res);
+		  return true;
+	    }
+      }
+
+      return false;
 }
 
 /*
@@ -75,9 +137,15 @@ void ufunc_core::assign_bits_to_ports(vvp_context_t context)
 	    vvp_net_ptr_t pp (net, 0);
 
 	      // If the port is a real variable, then simply copy the
-	      // propagated input to the port variable.
-	    if (vvp_fun_signal_real*tmp = dynamic_cast<vvp_fun_signal_real*>(net->fun))
+	      // propagated input to the port variable. Real inputs
+	      // are not part of the cache key, so don't cache.
+	    if (vvp_fun_signal_real*tmp = dynamic_cast<vvp_fun_signal_real*>(net->fun)) {
 		  tmp->recv_real(pp, value_r(idx), context);
+		  pure_ = false;
+	    }
+
+	    if (pure_)
+		  cache_key_[idx] = value(idx);
 
 	      // If the port is a bit4 vector, then copy the
 	      // propagated input to the port variable. Detect the
@@ -110,8 +178,18 @@ void ufunc_core::finish_thread()
       if (vvp_fun_signal_real*sig = dynamic_cast<vvp_fun_signal_real*>(result_->fun))
 	    propagate_real(sig->real_unfiltered_value());
 
-      if (vvp_fun_signal_vec*sig = dynamic_cast<vvp_fun_signal_vec*>(result_->fun))
+      if (vvp_fun_signal_vec*sig = dynamic_cast<vvp_fun_signal_vec*>(result_->fun)) {
+	    if (pure_) {
+		  struct cache_entry_s&ent = cache_[cache_next_];
+		  for (unsigned idx = 0 ;  idx < port_count() ;  idx += 1)
+			ent.key[idx] = cache_key_[idx];
+		  ent.res = sig->vec4_unfiltered_value();
+		  cache_next_ = (cache_next_ + 1) % CACHE_SIZE;
+		  if (cache_fill_ < CACHE_SIZE)
+			cache_fill_ += 1;
+	    }
 	    propagate_vec4(sig->vec4_unfiltered_value());
+      }
 }
 
 /*
@@ -131,6 +209,8 @@ void ufunc_core::recv_vec4(vvp_net_ptr_t, const vvp_vector4_t&,
  */
 void ufunc_core::recv_vec4_from_inputs(unsigned)
 {
+      if (cache_lookup_())
+	    return;
       invoke_thread_();
 }
 
@@ -161,7 +241,7 @@ void compile_ufunc(char*label, char*code, unsigned wid,
 		   unsigned argc,  struct symb_s*argv,
 		   unsigned portc, struct symb_s*portv,
 		   struct symb_s retv, char*scope_label,
-                   char*trigger_label)
+                   char*trigger_label, bool pure)
 {
 	/* The input argument list and port list must have the same
 	   sizes, since internally we will be mapping the inputs list
@@ -205,7 +285,7 @@ void compile_ufunc(char*label, char*code, unsigned wid,
       vvp_net_t*ptr = new vvp_net_t;
       ufunc_core*fcore = new ufunc_core(wid, ptr, portc, ports,
 					start_code, call_scope,
-					retv.text, scope_label);
+					retv.text, scope_label, pure);
       ptr->fun = fcore;
       define_functor_symbol(label, ptr);
       free(label);
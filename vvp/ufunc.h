@@ -45,6 +45,14 @@
  * netlist.
  *
  * This class relies to the vvp_wide_fun_* classes in vvp_net.h.
+ *
+ * If the function is pure (.ufunc/p) the result depends only on the
+ * input values, so the core remembers the last few input values and
+ * their results. When the inputs change to values that are already
+ * in the cache, the saved result is propagated at once and no thread
+ * is created. This is a big win for functions in the netlist that see
+ * a small set of input values (decoders, table lookups and the like.)
+ * Only 4-value inputs and results are cached.
  */
 
 class ufunc_core : public vvp_wide_fun_core {
@@ -55,7 +63,8 @@ class ufunc_core : public vvp_wide_fun_core {
 		 vvp_code_t start_address,
 		 struct __vpiScope*call_scope,
 		 char*result_label,
-		 char*scope_label);
+		 char*scope_label,
+		 bool pure);
       ~ufunc_core();
 
       struct __vpiScope*call_scope() { return call_scope_; }
@@ -67,12 +76,18 @@ class ufunc_core : public vvp_wide_fun_core {
       void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                      vvp_context_t context);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
     private:
       void recv_vec4_from_inputs(unsigned port);
       void recv_real_from_inputs(unsigned port);
 
       void invoke_thread_(void);
 
+      bool cache_lookup_(void);
+      void cache_clear_(void);
+
 
     private:
 	// output width of the function node.
@@ -91,6 +106,21 @@ class ufunc_core : public vvp_wide_fun_core {
 
 	// Where the result will be.
       vvp_net_t*result_;
+
+	// The result cache of a pure function. The key of each entry
+	// is the input values for the call, and the entries are
+	// replaced round robin. The inputs of the running thread are
+	// held in cache_key_ until the result is ready.
+      enum { CACHE_SIZE = 8 };
+      struct cache_entry_s {
+	    vvp_vector4_t*key;
+	    vvp_vector4_t res;
+      };
+      bool pure_;
+      struct cache_entry_s cache_[CACHE_SIZE];
+      unsigned cache_fill_;
+      unsigned cache_next_;
+      vvp_vector4_t*cache_key_;
 };
 
 #endif
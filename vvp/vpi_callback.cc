@@ -30,10 +30,16 @@
 # include  "schedule.h"
 # include  "event.h"
 # include  "vvp_net_sig.h"
+# include  "checkpoint.h"
+# include  "lazy.h"
 # include  "config.h"
 # include  <cstdio>
 # include  <cassert>
 # include  <cstdlib>
+# include  <cstring>
+# include  <vector>
+# include  <map>
+# include  <string>
 
 /*
 * The vpi_free_object() call to a callback doesn't actually delete
@@ -156,6 +162,7 @@ static struct __vpiCallback* make_value_change(p_cb_data data)
 	    vvp_net_fil_t*sig_fil;
 	    sig_fil = dynamic_cast<vvp_net_fil_t*>(sig->node->fil);
 	    assert(sig_fil);
+	    lazy_observe(sig->node);
 
 	      /* Attach the __vpiCallback object to the signal. */
 	    sig_fil->add_vpi_callback(obj);
@@ -320,6 +327,10 @@ static struct __vpiCallback*NextSimTime = 0;
 static struct __vpiCallback*EndOfCompile = NULL;
 static struct __vpiCallback*StartOfSimulation = NULL;
 static struct __vpiCallback*EndOfSimulation = NULL;
+static struct __vpiCallback*StartOfSave = NULL;
+static struct __vpiCallback*EndOfSave = NULL;
+static struct __vpiCallback*StartOfRestart = NULL;
+static struct __vpiCallback*EndOfRestart = NULL;
 
 void vpiEndOfCompile(void) {
       struct __vpiCallback* cur;
@@ -383,6 +394,119 @@ void vpiPostsim(void) {
       vpi_mode_flag = VPI_MODE_NONE;
 }
 
+/*
+ * The checkpoint callbacks are not removed when they are called,
+ * because a simulation may be saved or restarted many times. A
+ * callback removed with vpi_remove_cb is reaped when its list is
+ * next run.
+ */
+static void run_checkpoint_callbacks(struct __vpiCallback*&list)
+{
+      assert(vpi_mode_flag == VPI_MODE_NONE);
+      vpi_mode_flag = VPI_MODE_RWSYNC;
+
+      struct __vpiCallback**ptr = &list;
+      while (*ptr) {
+	    struct __vpiCallback*cur = *ptr;
+	    if (cur->cb_data.cb_rtn == 0) {
+		  *ptr = cur->next;
+		  delete_vpi_callback(cur);
+		  continue;
+	    }
+	    (cur->cb_data.cb_rtn)(&cur->cb_data);
+	    ptr = &cur->next;
+      }
+
+      vpi_mode_flag = VPI_MODE_NONE;
+}
+
+void vpiStartOfSave(void)
+{
+      run_checkpoint_callbacks(StartOfSave);
+}
+
+void vpiEndOfSave(void)
+{
+      run_checkpoint_callbacks(EndOfSave);
+}
+
+void vpiStartOfRestart(void)
+{
+      run_checkpoint_callbacks(StartOfRestart);
+}
+
+void vpiEndOfRestart(void)
+{
+      run_checkpoint_callbacks(EndOfRestart);
+}
+
+/*
+ * The data that applications save with vpi_put_data is collected
+ * here during a save, and written to the checkpoint after the
+ * callbacks are done. A restart loads it before it calls the
+ * callbacks, and vpi_get_data reads it back in order.
+ */
+static std::map<PLI_INT32,std::string> checkpoint_data;
+static std::map<PLI_INT32,size_t> checkpoint_data_pos;
+
+PLI_INT32 vpi_put_data(PLI_INT32 id, PLI_BYTE8*dataLoc, PLI_INT32 numOfBytes)
+{
+      if (id <= 0 || numOfBytes < 0 || (numOfBytes > 0 && dataLoc == 0))
+	    return 0;
+
+      checkpoint_data[id].append(dataLoc, numOfBytes);
+      return numOfBytes;
+}
+
+PLI_INT32 vpi_get_data(PLI_INT32 id, PLI_BYTE8*dataLoc, PLI_INT32 numOfBytes)
+{
+      std::map<PLI_INT32,std::string>::const_iterator cur = checkpoint_data.find(id);
+      if (cur == checkpoint_data.end() || numOfBytes <= 0 || dataLoc == 0)
+	    return 0;
+
+      size_t&pos = checkpoint_data_pos[id];
+      size_t cnt = cur->second.size() - pos;
+      if (cnt > (size_t)numOfBytes)
+	    cnt = numOfBytes;
+
+      memcpy(dataLoc, cur->second.data()+pos, cnt);
+      pos += cnt;
+      return cnt;
+}
+
+void vpip_data_save_state(vvp_checkpoint_out&out)
+{
+      out.put_u32(checkpoint_data.size());
+      for (std::map<PLI_INT32,std::string>::const_iterator cur = checkpoint_data.begin()
+		 ; cur != checkpoint_data.end() ; ++ cur) {
+	    out.put_u32(cur->first);
+	    out.put_u32(cur->second.size());
+	    out.put_bytes(cur->second.data(), cur->second.size());
+      }
+
+      checkpoint_data.clear();
+}
+
+void vpip_data_restore_state(vvp_checkpoint_in&in)
+{
+      checkpoint_data.clear();
+      checkpoint_data_pos.clear();
+
+      unsigned long count = in.get_u32();
+      for (unsigned long idx = 0 ;  idx < count && !in.failed() ;  idx += 1) {
+	    PLI_INT32 id = in.get_u32();
+	    size_t size = in.get_u32();
+	    if (size > in.remaining()) {
+		  in.error("invalid VPI data record");
+		  break;
+	    }
+	    std::string&data = checkpoint_data[id];
+	    data.resize(size);
+	    if (size > 0)
+		  in.get_bytes(&data[0], size);
+      }
+}
+
 /*
  * The scheduler invokes this to clear out callbacks for the next
  * simulation time.
@@ -422,6 +546,27 @@ static struct __vpiCallback* make_prepost(p_cb_data data)
 	  case cbNextSimTime:
 	    obj->next = NextSimTime;
 	    NextSimTime = obj;
+	    break;
+	  case cbStartOfSave:
+	  case cbEndOfSave:
+	  case cbStartOfRestart:
+	  case cbEndOfRestart: {
+		  /* These lists are kept in the order of registration,
+		     and the callbacks are numbered in that order. */
+		struct __vpiCallback**list = &StartOfSave;
+		if (data->reason == cbEndOfSave) list = &EndOfSave;
+		if (data->reason == cbStartOfRestart) list = &StartOfRestart;
+		if (data->reason == cbEndOfRestart) list = &EndOfRestart;
+		PLI_INT32 index = 1;
+		while (*list) {
+		      list = &(*list)->next;
+		      index += 1;
+		}
+		obj->cb_data.index = index;
+		obj->next = 0;
+		*list = obj;
+		break;
+	  }
       }
 
       return obj;
@@ -458,6 +603,10 @@ vpiHandle vpi_register_cb(p_cb_data data)
 	  case cbStartOfSimulation:
 	  case cbEndOfSimulation:
 	  case cbNextSimTime:
+	  case cbStartOfSave:
+	  case cbEndOfSave:
+	  case cbStartOfRestart:
+	  case cbEndOfRestart:
 	    obj = make_prepost(data);
 	    break;
 
@@ -471,10 +620,14 @@ vpiHandle vpi_register_cb(p_cb_data data)
       return obj? &obj->base : 0;
 }
 
+static PLI_INT32 batch_value_change(p_cb_data data);
+static void batch_remove(struct __vpiCallback*master);
+
 /*
  * Removing a callback doesn't really delete it right away. Instead,
  * it clears the reference to the user callback function. This causes
- * the callback to quietly reap itself.
+ * the callback to quietly reap itself. The master of a batch callback
+ * (see below) has no object, and removing it removes the batch.
  */
 PLI_INT32 vpi_remove_cb(vpiHandle ref)
 {
@@ -483,11 +636,260 @@ PLI_INT32 vpi_remove_cb(vpiHandle ref)
       assert(ref->vpi_type->type_code == vpiCallback);
 
       struct __vpiCallback*obj = (struct __vpiCallback*)ref;
+      if (obj->cb_data.cb_rtn == &batch_value_change && obj->cb_data.obj == 0)
+	    batch_remove(obj);
       obj->cb_data.cb_rtn = 0;
 
       return 1;
 }
 
+/*
+ * A batch callback watches a list of signals on behalf of a single
+ * user routine. Each signal gets an ordinary value change callback
+ * that suppresses the value and time, and only marks the index of the
+ * signal as changed. The first change in a time step schedules the
+ * batch itself as a ReadOnlySynch event, and when that runs the
+ * values of all the changed signals are collected into one array and
+ * passed to the user routine in one call.
+ *
+ * The handle returned to the user is the master callback. Removing it
+ * with vpi_remove_cb removes the member callbacks and deletes the
+ * batch. If the batch is scheduled, or is in the user routine, the
+ * delete is left to run_run.
+ */
+struct batch_cb : public vvp_gen_event_s {
+      struct __vpiCallback*master;
+      vpip_batch_routine routine;
+      PLI_BYTE8*user_data;
+
+      std::vector<vpiHandle> handles;
+      std::vector<vpiHandle> members;
+	// Per handle flag and list of the handles that changed in
+	// this time step.
+      std::vector<bool> dirty;
+      std::vector<PLI_INT32> changed;
+      bool sync_pending;
+      bool running;
+      bool removed;
+
+	// Storage for the values passed to the routine, reused
+	// from step to step.
+      std::vector<s_vpip_batch_change> changes;
+      std::vector<s_vpi_vecval> words;
+
+      void run_run();
+      void remove_members();
+
+    private:
+      unsigned get_words_(vpiHandle ref, unsigned off);
+};
+
+static PLI_INT32 batch_value_change(p_cb_data data)
+{
+      struct batch_cb*batch = (struct batch_cb*)data->user_data;
+
+      PLI_INT32 idx = data->index;
+      if (batch->dirty[idx])
+	    return 0;
+
+      batch->dirty[idx] = true;
+      batch->changed.push_back(idx);
+
+      if (! batch->sync_pending) {
+	    batch->sync_pending = true;
+	    schedule_generic(batch, 0, true, true);
+      }
+
+      return 0;
+}
+
+void batch_cb::remove_members()
+{
+      if (removed)
+	    return;
+
+      for (unsigned idx = 0 ;  idx < members.size() ;  idx += 1)
+	    vpi_remove_cb(members[idx]);
+
+      changed.clear();
+      removed = true;
+}
+
+static void batch_remove(struct __vpiCallback*master)
+{
+      struct batch_cb*batch = (struct batch_cb*)master->cb_data.user_data;
+      master->cb_data.user_data = 0;
+
+      batch->remove_members();
+      if (! (batch->sync_pending || batch->running))
+	    delete batch;
+}
+
+/*
+ * Pack the 4-state value of the handle into words starting at
+ * off. Signals are read directly from their filter, without going
+ * through the value formatting of vpi_get_value. Anything else (array
+ * words and part selects) uses vpi_get_value with vpiVectorVal.
+ */
+unsigned batch_cb::get_words_(vpiHandle ref, unsigned off)
+{
+      __vpiSignal*sig = vpip_signal_from_handle(ref);
+      vvp_signal_value*val = sig? dynamic_cast<vvp_signal_value*>(sig->node->fil) : 0;
+
+      if (val) {
+	    vvp_vector4_t vec;
+	    val->vec4_value(vec);
+
+	    unsigned wid = vec.size();
+	    unsigned hwid = (wid + 31) / 32;
+	    words.resize(off + hwid);
+
+	      /* The abits/bbits encoding of the vector is the same as
+		 the aval/bval encoding of VPI, so copy whole words. */
+	    for (unsigned word = 0 ;  word < hwid ;  word += 1) {
+		  unsigned base = word * 32;
+		  unsigned trans = wid - base;
+		  if (trans > 32) trans = 32;
+
+		  unsigned long abits, bbits;
+		  vec.subword(base, trans, abits, bbits);
+		  words[off+word].aval = abits;
+		  words[off+word].bval = bbits;
+	    }
+
+	    return wid;
+      }
+
+      unsigned wid = vpi_get(vpiSize, ref);
+      unsigned hwid = (wid + 31) / 32;
+      words.resize(off + hwid);
+
+      s_vpi_value tmp;
+      tmp.format = vpiVectorVal;
+      vpi_get_value(ref, &tmp);
+      for (unsigned word = 0 ;  word < hwid ;  word += 1)
+	    words[off+word] = tmp.value.vector[word];
+
+      return wid;
+}
+
+void batch_cb::run_run()
+{
+      sync_pending = false;
+
+      if (removed) {
+	    delete this;
+	    return;
+      }
+
+      if (changed.empty())
+	    return;
+
+	/* Collect all the values first, because the words vector
+	   may move while it grows. */
+      changes.resize(changed.size());
+      unsigned off = 0;
+      for (unsigned idx = 0 ;  idx < changed.size() ;  idx += 1) {
+	    PLI_INT32 cur = changed[idx];
+	    dirty[cur] = false;
+	    changes[idx].index = cur;
+	    changes[idx].size = get_words_(handles[cur], off);
+	    changes[idx].value = 0;
+	    off += (changes[idx].size + 31) / 32;
+      }
+
+      off = 0;
+      for (unsigned idx = 0 ;  idx < changes.size() ;  idx += 1) {
+	    changes[idx].value = &words[off];
+	    off += (changes[idx].size + 31) / 32;
+      }
+
+      s_vpi_time now;
+      now.type = vpiSimTime;
+      vpip_time_to_timestruct(&now, schedule_simtime());
+
+      PLI_INT32 count = changed.size();
+      changed.clear();
+
+      assert(vpi_mode_flag == VPI_MODE_NONE);
+      vpi_mode_flag = VPI_MODE_ROSYNC;
+      running = true;
+      (routine)(&now, count, &changes[0], user_data);
+      running = false;
+      vpi_mode_flag = VPI_MODE_NONE;
+
+	/* The routine may have removed the batch. */
+      if (removed)
+	    delete this;
+}
+
+extern "C" vpiHandle vpip_register_batch_cb(vpiHandle*handles, PLI_INT32 count,
+					    vpip_batch_routine routine,
+					    PLI_BYTE8*user_data)
+{
+      assert(routine);
+
+      for (PLI_INT32 idx = 0 ;  idx < count ;  idx += 1) {
+	    assert(handles[idx] && handles[idx]->vpi_type);
+	    switch (handles[idx]->vpi_type->type_code) {
+		case vpiReg:
+		case vpiNet:
+		case vpiIntegerVar:
+		case vpiMemoryWord:
+		case vpiPartSelect:
+		  break;
+		default:
+		  fprintf(stderr, "vpi error: vpip_register_batch_cb: "
+			  "handle %d has unsupported type code=%d\n",
+			  (int)idx, (int)handles[idx]->vpi_type->type_code);
+		  return 0;
+	    }
+      }
+
+      struct batch_cb*batch = new batch_cb;
+      batch->routine = routine;
+      batch->user_data = user_data;
+      batch->handles.assign(handles, handles+count);
+      batch->dirty.assign(count, false);
+      batch->sync_pending = false;
+      batch->running = false;
+      batch->removed = false;
+
+	/* The master is never scheduled or deleted, it only carries
+	   the batch for vpi_remove_cb. */
+      struct __vpiCallback*master = new_vpi_callback();
+      master->cb_data.reason = cbValueChange;
+      master->cb_data.cb_rtn = &batch_value_change;
+      master->cb_data.obj = 0;
+      master->cb_data.time = 0;
+      master->cb_data.value = 0;
+      master->cb_data.index = 0;
+      master->cb_data.user_data = (PLI_BYTE8*)batch;
+      batch->master = master;
+
+      s_vpi_time suppress_time;
+      suppress_time.type = vpiSuppressTime;
+      s_vpi_value suppress_value;
+      suppress_value.format = vpiSuppressVal;
+
+      for (PLI_INT32 idx = 0 ;  idx < count ;  idx += 1) {
+	    s_cb_data cb;
+	    cb.reason = cbValueChange;
+	    cb.cb_rtn = &batch_value_change;
+	    cb.obj = handles[idx];
+	    cb.time = &suppress_time;
+	    cb.value = &suppress_value;
+	    cb.index = idx;
+	    cb.user_data = (PLI_BYTE8*)batch;
+
+	    struct __vpiCallback*obj = make_value_change(&cb);
+	    if (obj)
+		  batch->members.push_back(&obj->base);
+      }
+
+      return &master->base;
+}
+
 void callback_execute(struct __vpiCallback*cur)
 {
       const vpi_mode_t save_mode = vpi_mode_flag;
@@ -538,6 +940,13 @@ void vvp_vpi_callback::attach_as_word(vvp_array_t arr, unsigned long addr)
       array_word_ = addr;
 }
 
+bool vvp_vpi_callback::has_vpi_callbacks() const
+{
+      if (vpi_callbacks_ != 0)
+	    return true;
+      return array_ != 0 && array_is_watched(array_);
+}
+
 void vvp_vpi_callback::add_vpi_callback(__vpiCallback*cb)
 {
       cb->next = vpi_callbacks_;
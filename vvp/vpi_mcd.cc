@@ -18,6 +18,7 @@
  */
 
 # include  "vpi_priv.h"
+# include  "checkpoint.h"
 # include  "config.h"
 #ifdef CHECK_WITH_VALGRIND
 # include  "vvp_cleanup.h"
@@ -27,6 +28,11 @@
 # include  <cstdio>
 # include  <cstdlib>
 # include  <cstring>
+# include  <csignal>
+# include  <ctime>
+# include  <unistd.h>
+# include  <pthread.h>
+# include  <sys/time.h>
 # include  "ivl_alloc.h"
 
 extern FILE* vpi_trace;
@@ -45,9 +51,22 @@ extern FILE* vpi_trace;
 #define FD_IDX(fd)	((fd)&~(1U<<31))
 #define FD_INCR		32
 
+/*
+ * Files opened by $fopen get a larger stdio buffer than the default,
+ * so that log heavy simulations make fewer write system calls. The
+ * buffers are still flushed by $fflush, $fclose and at exit.
+ */
+#define FILE_BUF_SIZE	(64*1024)
+
+struct async_file_s;
+
 typedef struct mcd_entry {
 	FILE *fp;
 	char *filename;
+	  // The fopen mode, needed to reopen the file on restart.
+	char *mode;
+	  // Non-nil if the writes are passed to the I/O thread.
+	struct async_file_s *async;
 } mcd_entry_s;
 static mcd_entry_s mcd_table[31];
 static mcd_entry_s *fd_table = NULL;
@@ -55,6 +74,449 @@ static unsigned fd_table_len = 0;
 
 static FILE* logfile;
 
+  /* In a child of vpip_fork_tests this is the index of the child. */
+static unsigned fork_index = 0;
+
+/*
+ * Return the name to use for a file that is opened with the given
+ * mode. This is the name itself, except in the children of a fork,
+ * which write to their own copies of the output files.
+ */
+static char* fork_file_name(const char*name, const char*mode)
+{
+      if (fork_index == 0 || mode[0] == 'r')
+	    return strdup(name);
+
+      size_t len = strlen(name) + 16;
+      char*res = (char*)malloc(len);
+      snprintf(res, len, "%s.%u", name, fork_index);
+      return res;
+}
+
+/*
+ * Asynchronous file output (the -a flag). The files opened by $fopen
+ * for writing are then written by a separate I/O thread, so that a
+ * slow file system does not stall the simulation. Each such file has
+ * a ring buffer. The simulation copies the output into the ring
+ * buffer and the I/O thread writes it to the stdio stream. The
+ * simulation only waits if the ring buffer is full.
+ *
+ * The I/O thread owns the stdio stream while there is data in the
+ * ring buffer. Anything other than writing that needs the stream
+ * ($fseek, $ftell, reading, and so on all get it by vpi_get_file)
+ * first waits for the ring buffer to drain, so the operations happen
+ * in order. $fflush and $fclose are passed to the I/O thread, which
+ * does them after it has written the data that came before them.
+ *
+ * The standard output and the log file are always written directly.
+ */
+#define ASYNC_BUF_SIZE	(128*1024)
+
+struct async_file_s {
+      FILE*fp;
+      char*buf;
+	// The ring buffer holds fill bytes starting at head.
+      size_t head;
+      size_t fill;
+	// The I/O thread is working on this file.
+      bool busy;
+	// Written since the stdio stream was last flushed.
+      bool dirty;
+      bool flush_req;
+      bool close_req;
+      struct async_file_s*next;
+};
+
+static bool async_enabled = false;
+static bool async_running = false;
+static bool async_stop = false;
+static struct async_file_s*async_list = 0;
+static pthread_t async_thread;
+static pthread_mutex_t async_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  async_work_sig = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  async_done_sig = PTHREAD_COND_INITIALIZER;
+
+/*
+ * Set by the I/O thread when it goes to sleep with every stream
+ * written and flushed, and cleared when more work is queued. This is
+ * the only state that the fatal signal handler looks at.
+ */
+static volatile sig_atomic_t async_quiet = 1;
+
+static uint64_t async_bytes_written = 0;
+static unsigned long async_stall_count = 0;
+static double async_stall_time = 0.0;
+
+static double async_now(void)
+{
+      struct timeval tv;
+      gettimeofday(&tv, 0);
+      return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static bool async_idle(const struct async_file_s*cur)
+{
+      return cur->fill == 0 && !cur->busy && !cur->flush_req &&
+	     !cur->close_req;
+}
+
+/*
+ * Wait (with the mutex held) for the I/O thread to signal progress,
+ * and count the time as time that the simulation was stalled.
+ */
+static void async_wait_done(void)
+{
+      double start = async_now();
+      pthread_cond_wait(&async_done_sig, &async_mutex);
+      async_stall_time += async_now() - start;
+}
+
+static void* async_thread_main(void*)
+{
+      pthread_mutex_lock(&async_mutex);
+      for (;;) {
+	    struct async_file_s*cur = async_list;
+	    while (cur && async_idle(cur))
+		  cur = cur->next;
+
+	    if (cur == 0) {
+		    /* Everything is written, so push it out of the stdio
+		       buffers as well before going to sleep. Then a fatal
+		       signal loses nothing that the I/O thread had. */
+		  cur = async_list;
+		  while (cur && !cur->dirty)
+			cur = cur->next;
+		  if (cur) {
+			cur->busy = true;
+			cur->dirty = false;
+			pthread_mutex_unlock(&async_mutex);
+			fflush(cur->fp);
+			pthread_mutex_lock(&async_mutex);
+			cur->busy = false;
+			pthread_cond_broadcast(&async_done_sig);
+			continue;
+		  }
+		  async_quiet = 1;
+		  if (async_stop)
+			break;
+		  pthread_cond_wait(&async_work_sig, &async_mutex);
+		  continue;
+	    }
+
+	    cur->busy = true;
+	    if (cur->fill > 0) {
+		    /* Write the contiguous part at the head of the ring
+		       buffer. The simulation may add more to the tail
+		       while the mutex is released. */
+		  size_t cnt = cur->fill;
+		  if (cnt > ASYNC_BUF_SIZE - cur->head)
+			cnt = ASYNC_BUF_SIZE - cur->head;
+		  pthread_mutex_unlock(&async_mutex);
+		  fwrite(cur->buf + cur->head, 1, cnt, cur->fp);
+		  pthread_mutex_lock(&async_mutex);
+		  cur->head = (cur->head + cnt) % ASYNC_BUF_SIZE;
+		  cur->fill -= cnt;
+		  cur->dirty = true;
+		  async_bytes_written += cnt;
+
+	    } else if (cur->flush_req) {
+		  cur->flush_req = false;
+		  pthread_mutex_unlock(&async_mutex);
+		  fflush(cur->fp);
+		  pthread_mutex_lock(&async_mutex);
+
+	    } else {
+		  assert(cur->close_req);
+		  struct async_file_s**pp = &async_list;
+		  while (*pp != cur) pp = &(*pp)->next;
+		  *pp = cur->next;
+		  pthread_mutex_unlock(&async_mutex);
+		  fclose(cur->fp);
+		  free(cur->buf);
+		  delete cur;
+		  pthread_mutex_lock(&async_mutex);
+		  pthread_cond_broadcast(&async_done_sig);
+		  continue;
+	    }
+	    cur->busy = false;
+	    pthread_cond_broadcast(&async_done_sig);
+
+	      /* Move the file to the end of the list, so that one busy
+		 file does not keep the others waiting. */
+	    if (cur->next) {
+		  struct async_file_s**pp = &async_list;
+		  while (*pp != cur) pp = &(*pp)->next;
+		  *pp = cur->next;
+		  while (*pp) pp = &(*pp)->next;
+		  *pp = cur;
+		  cur->next = 0;
+	    }
+      }
+      pthread_mutex_unlock(&async_mutex);
+      return 0;
+}
+
+static void async_write(struct async_file_s*af, const char*buf, size_t cnt)
+{
+      pthread_mutex_lock(&async_mutex);
+      bool stalled = false;
+      while (cnt > 0) {
+	    if (af->fill == ASYNC_BUF_SIZE) {
+		  stalled = true;
+		  async_wait_done();
+		  continue;
+	    }
+
+	    size_t tail = (af->head + af->fill) % ASYNC_BUF_SIZE;
+	    size_t use = ASYNC_BUF_SIZE - af->fill;
+	    if (use > ASYNC_BUF_SIZE - tail)
+		  use = ASYNC_BUF_SIZE - tail;
+	    if (use > cnt)
+		  use = cnt;
+
+	    memcpy(af->buf + tail, buf, use);
+	    async_quiet = 0;
+	    if (af->fill == 0)
+		  pthread_cond_signal(&async_work_sig);
+	    af->fill += use;
+	    buf += use;
+	    cnt -= use;
+      }
+      if (stalled) async_stall_count += 1;
+      pthread_mutex_unlock(&async_mutex);
+}
+
+/*
+ * Wait for the I/O thread to finish everything that was queued for
+ * this file. After this the simulation may use the stream directly.
+ */
+static void async_drain(struct async_file_s*af)
+{
+      pthread_mutex_lock(&async_mutex);
+      if (! async_idle(af)) {
+	    async_stall_count += 1;
+	    while (! async_idle(af))
+		  async_wait_done();
+      }
+      pthread_mutex_unlock(&async_mutex);
+}
+
+static void async_flush(struct async_file_s*af)
+{
+      pthread_mutex_lock(&async_mutex);
+      af->flush_req = true;
+      async_quiet = 0;
+      pthread_cond_signal(&async_work_sig);
+      pthread_mutex_unlock(&async_mutex);
+}
+
+/*
+ * Give the stream to the I/O thread to close after the data that is
+ * still queued. The mcd/fd slot is free as soon as this returns.
+ */
+static void async_close(struct async_file_s*af)
+{
+      pthread_mutex_lock(&async_mutex);
+      af->close_req = true;
+      async_quiet = 0;
+      pthread_cond_signal(&async_work_sig);
+      pthread_mutex_unlock(&async_mutex);
+}
+
+/*
+ * A file that is being closed by the I/O thread may be opened again
+ * (for example to read back what was written), so wait for the
+ * pending closes to finish before opening a file.
+ */
+static void async_wait_closes(void)
+{
+      if (! async_running)
+	    return;
+
+      pthread_mutex_lock(&async_mutex);
+      for (;;) {
+	    struct async_file_s*cur = async_list;
+	    while (cur && !cur->close_req)
+		  cur = cur->next;
+	    if (cur == 0)
+		  break;
+	    async_wait_done();
+      }
+      pthread_mutex_unlock(&async_mutex);
+}
+
+static void async_attach(mcd_entry_s&ent)
+{
+      if (! async_running || ent.fp == NULL || ent.async)
+	    return;
+	// Files that are only read are not written by the I/O thread.
+      if (ent.mode == NULL || ent.mode[0] == 'r')
+	    return;
+
+      struct async_file_s*af = new struct async_file_s;
+      af->fp = ent.fp;
+      af->buf = (char*)malloc(ASYNC_BUF_SIZE);
+      af->head = 0;
+      af->fill = 0;
+      af->busy = false;
+      af->dirty = false;
+      af->flush_req = false;
+      af->close_req = false;
+
+      pthread_mutex_lock(&async_mutex);
+      af->next = async_list;
+      async_list = af;
+      pthread_mutex_unlock(&async_mutex);
+
+      ent.async = af;
+}
+
+static void async_detach(mcd_entry_s&ent)
+{
+      struct async_file_s*af = ent.async;
+      if (af == NULL)
+	    return;
+
+      assert(async_idle(af));
+      struct async_file_s**pp = &async_list;
+      while (*pp != af) pp = &(*pp)->next;
+      *pp = af->next;
+      free(af->buf);
+      delete af;
+      ent.async = NULL;
+}
+
+/*
+ * The signals that the handler below catches. They are blocked in
+ * the I/O thread, so the handler never runs there. A fault in the
+ * I/O thread itself just takes the default action.
+ */
+static void async_fatal_sigset(sigset_t*set)
+{
+      sigemptyset(set);
+      sigaddset(set, SIGTERM);
+      sigaddset(set, SIGSEGV);
+      sigaddset(set, SIGFPE);
+      sigaddset(set, SIGABRT);
+#ifdef SIGBUS
+      sigaddset(set, SIGBUS);
+#endif
+#ifdef SIGHUP
+      sigaddset(set, SIGHUP);
+#endif
+}
+
+/*
+ * On a fatal signal, give the I/O thread up to a second to write out
+ * and flush what is queued, then let the signal do its job. Only
+ * async-signal-safe calls are made here. The I/O thread may never get
+ * quiet (the simulation may have died holding the mutex, or with the
+ * ring buffer half full), so the wait is bounded.
+ */
+static void async_fatal_signal(int sig)
+{
+      for (unsigned cnt = 0 ;  cnt < 100 && !async_quiet ;  cnt += 1) {
+	    struct timespec ts;
+	    ts.tv_sec = 0;
+	    ts.tv_nsec = 10000000;
+	    nanosleep(&ts, 0);
+      }
+
+      signal(sig, SIG_DFL);
+      raise(sig);
+}
+
+/*
+ * Start the I/O thread and hand it the files that are already open
+ * for writing.
+ */
+void vpip_mcd_async_resume(void)
+{
+      if (! async_enabled || async_running)
+	    return;
+
+      async_stop = false;
+
+	/* The I/O thread inherits the signal mask, so block the fatal
+	   signals while it is created. */
+      sigset_t fatal_set, save_set;
+      async_fatal_sigset(&fatal_set);
+      pthread_sigmask(SIG_BLOCK, &fatal_set, &save_set);
+      int rc = pthread_create(&async_thread, 0, async_thread_main, 0);
+      pthread_sigmask(SIG_SETMASK, &save_set, 0);
+      if (rc != 0) {
+	    vpi_mcd_printf(1, "Warning: Unable to start the file output "
+			   "thread, writing files directly.\n");
+	    async_enabled = false;
+	    return;
+      }
+      async_running = true;
+
+      for (unsigned idx = 1 ;  idx < 31 ;  idx += 1)
+	    async_attach(mcd_table[idx]);
+      for (unsigned idx = 3 ;  idx < fd_table_len ;  idx += 1)
+	    async_attach(fd_table[idx]);
+}
+
+/*
+ * Wait for the I/O thread to write everything and stop it. The files
+ * are then written directly until vpip_mcd_async_resume.
+ */
+void vpip_mcd_async_suspend(void)
+{
+      if (! async_running)
+	    return;
+
+      pthread_mutex_lock(&async_mutex);
+      async_stop = true;
+      pthread_cond_signal(&async_work_sig);
+      pthread_mutex_unlock(&async_mutex);
+      pthread_join(async_thread, 0);
+      async_running = false;
+
+      for (unsigned idx = 1 ;  idx < 31 ;  idx += 1)
+	    async_detach(mcd_table[idx]);
+      for (unsigned idx = 3 ;  idx < fd_table_len ;  idx += 1)
+	    async_detach(fd_table[idx]);
+      assert(async_list == 0);
+}
+
+static void async_atexit(void)
+{
+      vpip_mcd_async_suspend();
+}
+
+void vpip_mcd_async_init(void)
+{
+      async_enabled = true;
+      vpip_mcd_async_resume();
+      if (! async_running)
+	    return;
+
+      atexit(&async_atexit);
+      signal(SIGTERM, &async_fatal_signal);
+      signal(SIGSEGV, &async_fatal_signal);
+      signal(SIGFPE,  &async_fatal_signal);
+      signal(SIGABRT, &async_fatal_signal);
+#ifdef SIGBUS
+      signal(SIGBUS,  &async_fatal_signal);
+#endif
+#ifdef SIGHUP
+      signal(SIGHUP,  &async_fatal_signal);
+#endif
+}
+
+void vpip_mcd_async_stats(void)
+{
+      if (! async_enabled)
+	    return;
+
+      vpi_mcd_printf(1, " ... %8llu bytes written by the file output thread\n",
+		     (unsigned long long)async_bytes_written);
+      vpi_mcd_printf(1, "           %8lu stalls (%.3f seconds)\n",
+		     async_stall_count, async_stall_time);
+}
+
 /* Initialize mcd portion of vpi.  Must be called before
  * any vpi_mcd routines can be used.
  */
@@ -65,6 +527,8 @@ void vpip_mcd_init(FILE *log)
       for (unsigned idx = 0; idx < fd_table_len; idx += 1) {
 	    fd_table[idx].fp = NULL;
 	    fd_table[idx].filename = NULL;
+	    fd_table[idx].mode = NULL;
+	    fd_table[idx].async = NULL;
       }
 
       mcd_table[0].fp = stdout;
@@ -115,10 +579,17 @@ extern "C" PLI_UINT32 vpi_mcd_close(PLI_UINT32 mcd)
 	if (IS_MCD(mcd)) {
 		for(int i = 1; i < 31; i++) {
 			if(((mcd>>i) & 1) && mcd_table[i].fp) {
-				if(fclose(mcd_table[i].fp)) rc |= 1<<i;
+				if (mcd_table[i].async) {
+					async_close(mcd_table[i].async);
+					mcd_table[i].async = NULL;
+				} else if(fclose(mcd_table[i].fp)) {
+					rc |= 1<<i;
+				}
 				free(mcd_table[i].filename);
+				free(mcd_table[i].mode);
 				mcd_table[i].fp = NULL;
 				mcd_table[i].filename = NULL;
+				mcd_table[i].mode = NULL;
 			} else {
 				rc |= 1<<i;
 			}
@@ -126,10 +597,17 @@ extern "C" PLI_UINT32 vpi_mcd_close(PLI_UINT32 mcd)
 	} else {
 		unsigned idx = FD_IDX(mcd);
 		if (idx > 2 && idx < fd_table_len && fd_table[idx].fp) {
-			rc = fclose(fd_table[idx].fp);
+			if (fd_table[idx].async) {
+				async_close(fd_table[idx].async);
+				fd_table[idx].async = NULL;
+			} else {
+				rc = fclose(fd_table[idx].fp);
+			}
 			free(fd_table[idx].filename);
+			free(fd_table[idx].mode);
 			fd_table[idx].fp = NULL;
 			fd_table[idx].filename = NULL;
+			fd_table[idx].mode = NULL;
 		}
 	}
 	return rc;
@@ -161,10 +639,17 @@ extern "C" PLI_UINT32 vpi_mcd_open(char *name)
 	return 0;  /* too many open mcd's */
 
 got_entry:
-	mcd_table[i].fp = fopen(name, "w");
-	if(mcd_table[i].fp == NULL)
+	async_wait_closes();
+	char*path = fork_file_name(name, "w");
+	mcd_table[i].fp = fopen(path, "w");
+	if(mcd_table[i].fp == NULL) {
+		free(path);
 		return 0;
-	mcd_table[i].filename = strdup(name);
+	}
+	setvbuf(mcd_table[i].fp, NULL, _IOFBF, FILE_BUF_SIZE);
+	mcd_table[i].filename = path;
+	mcd_table[i].mode = strdup("w");
+	async_attach(mcd_table[i]);
 
 	if (vpi_trace) {
 	      fprintf(vpi_trace, "vpi_mcd_open(%s) --> 0x%08x\n",
@@ -203,7 +688,11 @@ vpi_mcd_vprintf(PLI_UINT32 mcd, const char*fmt, va_list ap)
 			  // echo to logfile
 			if (i == 0 && logfile)
 			      fputs(buffer, logfile);
-			fputs(buffer, mcd_table[i].fp);
+			if (mcd_table[i].async)
+			      async_write(mcd_table[i].async,
+					  buffer, strlen(buffer));
+			else
+			      fputs(buffer, mcd_table[i].fp);
 		  } else {
 			rc = EOF;
 		  }
@@ -222,6 +711,45 @@ extern "C" PLI_INT32 vpi_mcd_printf(PLI_UINT32 mcd, const char *fmt, ...)
       return r;
 }
 
+/*
+ * Write a block of characters to a MCD or FD. This does not go
+ * through a format, so the block may contain NULL characters (from
+ * %u or %z) and is not limited to the size of the vpi_mcd_vprintf
+ * buffer.
+ */
+extern "C" PLI_INT32 vpip_mcd_write(PLI_UINT32 mcd, const char*buf,
+				    PLI_INT32 cnt)
+{
+      if (!IS_MCD(mcd)) {
+	    unsigned idx = FD_IDX(mcd);
+	    if (idx >= fd_table_len || fd_table[idx].fp == NULL) return EOF;
+	    if (fd_table[idx].async) {
+		  async_write(fd_table[idx].async, buf, cnt);
+		  return cnt;
+	    }
+	    return fwrite(buf, 1, cnt, fd_table[idx].fp);
+      }
+
+      int rc = cnt;
+      for(int i = 0; i < 31; i++) {
+	    if((mcd>>i) & 1) {
+		  if(mcd_table[i].fp) {
+			  // echo to logfile
+			if (i == 0 && logfile)
+			      fwrite(buf, 1, cnt, logfile);
+			if (mcd_table[i].async)
+			      async_write(mcd_table[i].async, buf, cnt);
+			else
+			      fwrite(buf, 1, cnt, mcd_table[i].fp);
+		  } else {
+			rc = EOF;
+		  }
+	    }
+      }
+
+      return rc;
+}
+
 extern "C" PLI_INT32 vpi_mcd_flush(PLI_UINT32 mcd)
 {
 	int rc = 0;
@@ -230,16 +758,36 @@ extern "C" PLI_INT32 vpi_mcd_flush(PLI_UINT32 mcd)
 		for(int i = 0; i < 31; i++) {
 			if((mcd>>i) & 1) {
 				if (i == 0 && logfile) fflush(logfile);
-				if (fflush(mcd_table[i].fp)) rc |= 1<<i;
+				if (mcd_table[i].async)
+				      async_flush(mcd_table[i].async);
+				else if (fflush(mcd_table[i].fp))
+				      rc |= 1<<i;
 			}
 		}
 	} else {
 		unsigned idx = FD_IDX(mcd);
-		if (idx < fd_table_len) rc = fflush(fd_table[idx].fp);
+		if (idx < fd_table_len && fd_table[idx].async)
+		      async_flush(fd_table[idx].async);
+		else if (idx < fd_table_len)
+		      rc = fflush(fd_table[idx].fp);
 	}
 	return rc;
 }
 
+/*
+ * Flush all the open files. The files written by the I/O thread are
+ * flushed by that thread once it has written what is queued.
+ */
+extern "C" PLI_INT32 vpip_mcd_flush_all(void)
+{
+      for (unsigned idx = 1 ;  idx < 31 ;  idx += 1)
+	    if (mcd_table[idx].async) async_flush(mcd_table[idx].async);
+      for (unsigned idx = 3 ;  idx < fd_table_len ;  idx += 1)
+	    if (fd_table[idx].async) async_flush(fd_table[idx].async);
+
+      return fflush(NULL);
+}
+
 /*
  * MCD/FD Extensions
  */
@@ -269,12 +817,22 @@ extern "C" PLI_INT32 vpi_fopen(const char*name, const char*mode)
       for (unsigned idx = i; idx < fd_table_len; idx += 1) {
 	    fd_table[idx].fp = NULL;
 	    fd_table[idx].filename = NULL;
+	    fd_table[idx].mode = NULL;
+	    fd_table[idx].async = NULL;
       }
 
 got_entry:
-      fd_table[i].fp = fopen(name, mode);
-      if (fd_table[i].fp == NULL) return 0;
-      fd_table[i].filename = strdup(name);
+      async_wait_closes();
+      char*path = fork_file_name(name, mode);
+      fd_table[i].fp = fopen(path, mode);
+      if (fd_table[i].fp == NULL) {
+	    free(path);
+	    return 0;
+      }
+      setvbuf(fd_table[i].fp, NULL, _IOFBF, FILE_BUF_SIZE);
+      fd_table[i].filename = path;
+      fd_table[i].mode = strdup(mode);
+      async_attach(fd_table[i]);
       return ((1U<<31)|i);
 }
 
@@ -286,5 +844,215 @@ extern "C" FILE *vpi_get_file(PLI_INT32 fd)
 	// Only know about fd_table_len indices
       if (FD_IDX(fd) >= fd_table_len) return NULL;
 
+	// The caller may do anything with the stream, so first let
+	// the I/O thread finish what is queued for it.
+      if (fd_table[FD_IDX(fd)].async)
+	    async_drain(fd_table[FD_IDX(fd)].async);
+
       return fd_table[FD_IDX(fd)].fp;
 }
+
+/*
+ * Give a forked child its own copies of the open files. The parent
+ * flushed all the streams before the fork, so closing the inherited
+ * output streams writes nothing. The child's copy of an output file
+ * starts with what was written before the fork, so that it looks as
+ * if the child had run alone. Input files are reopened so that the
+ * child has its own file position. The inherited input streams are
+ * not closed, because closing an input stream may move the file
+ * offset that the child shares with its parent.
+ */
+static void fork_remap_entry(mcd_entry_s&ent)
+{
+      long pos = ftell(ent.fp);
+      const char*mode = ent.mode? ent.mode : "r";
+
+      if (mode[0] == 'r') {
+	    FILE*fp = fopen(ent.filename, mode);
+	    if (fp && pos > 0) fseek(fp, pos, SEEK_SET);
+	    if (fp) setvbuf(fp, NULL, _IOFBF, FILE_BUF_SIZE);
+	    ent.fp = fp;
+	    if (fp == NULL) {
+		  free(ent.filename);
+		  free(ent.mode);
+		  ent.filename = NULL;
+		  ent.mode = NULL;
+	    }
+	    return;
+      }
+
+      fclose(ent.fp);
+      char*path = fork_file_name(ent.filename, mode);
+	// Start the copy afresh, even if it was opened for append.
+      FILE*fp = fopen(path, mode[0] == 'a'? "w" : mode);
+      if (fp && pos > 0) {
+	    FILE*src = fopen(ent.filename, "rb");
+	    char buf[8192];
+	    size_t cnt;
+	    while (src && pos > 0 &&
+		   (cnt = fread(buf, 1, (size_t)pos < sizeof buf? pos : sizeof buf,
+				src)) > 0) {
+		  fwrite(buf, 1, cnt, fp);
+		  pos -= cnt;
+	    }
+	    if (src) fclose(src);
+      }
+
+      if (fp) setvbuf(fp, NULL, _IOFBF, FILE_BUF_SIZE);
+      free(ent.filename);
+      ent.fp = fp;
+      ent.filename = fp? path : NULL;
+      if (fp == NULL) {
+	    free(path);
+	    free(ent.mode);
+	    ent.mode = NULL;
+      }
+}
+
+void vpip_mcd_fork_remap(unsigned index)
+{
+      fork_index = index;
+
+      for (unsigned idx = 1 ;  idx < 31 ;  idx += 1)
+	    if (mcd_table[idx].fp) fork_remap_entry(mcd_table[idx]);
+      for (unsigned idx = 3 ;  idx < fd_table_len ;  idx += 1)
+	    if (fd_table[idx].fp) fork_remap_entry(fd_table[idx]);
+}
+
+/*
+ * Checkpoint support. The open files (other than the standard
+ * streams) are saved by name, mode and position. On restart they are
+ * reopened in the same slots, so the MCD and FD values held by the
+ * design remain valid. Files that were opened for writing are not
+ * truncated again; they are reopened for update and cut back to the
+ * saved position, so that the output continues where the checkpoint
+ * left it.
+ */
+static void save_entry(vvp_checkpoint_out&out, unsigned idx,
+		       const mcd_entry_s&ent)
+{
+      if (ent.async) async_drain(ent.async);
+      fflush(ent.fp);
+      long pos = ftell(ent.fp);
+      if (pos < 0)
+	    out.refuse("cannot find the position of file %s", ent.filename);
+
+      out.put_u32(idx);
+      out.put_str(ent.filename);
+      out.put_str(ent.mode? ent.mode : "r");
+      out.put_u64(pos < 0? 0 : pos);
+}
+
+void vpip_mcd_save_state(vvp_checkpoint_out&out)
+{
+      unsigned count = 0;
+      for (unsigned idx = 1 ;  idx < 31 ;  idx += 1)
+	    if (mcd_table[idx].fp) count += 1;
+
+      out.put_u32(count);
+      for (unsigned idx = 1 ;  idx < 31 ;  idx += 1)
+	    if (mcd_table[idx].fp) save_entry(out, idx, mcd_table[idx]);
+
+      count = 0;
+      for (unsigned idx = 3 ;  idx < fd_table_len ;  idx += 1)
+	    if (fd_table[idx].fp) count += 1;
+
+      out.put_u32(count);
+      for (unsigned idx = 3 ;  idx < fd_table_len ;  idx += 1)
+	    if (fd_table[idx].fp) save_entry(out, idx, fd_table[idx]);
+}
+
+static void restore_entry(vvp_checkpoint_in&in, mcd_entry_s&ent)
+{
+      char*name = in.get_str();
+      char*mode = in.get_str();
+      uint64_t pos = in.get_u64();
+      if (in.failed()) {
+	    free(name);
+	    free(mode);
+	    return;
+      }
+
+      bool binary = strchr(mode, 'b') != 0;
+      FILE*fp;
+      switch (mode[0]) {
+	  case 'w':
+	    fp = fopen(name, binary? "r+b" : "r+");
+	    if (fp && ftruncate(fileno(fp), pos) != 0) {
+		  fclose(fp);
+		  fp = NULL;
+	    }
+	    break;
+	  case 'a':
+	    fp = fopen(name, mode);
+	    if (fp && ftruncate(fileno(fp), pos) != 0) {
+		  fclose(fp);
+		  fp = NULL;
+	    }
+	    break;
+	  default:
+	    fp = fopen(name, mode);
+	    break;
+      }
+
+      if (fp && fseek(fp, pos, SEEK_SET) != 0) {
+	    fclose(fp);
+	    fp = NULL;
+      }
+
+      if (fp == NULL) {
+	    vpi_mcd_printf(1, "Warning: Unable to reopen file %s "
+			   "for the restarted simulation.\n", name);
+	    free(name);
+	    free(mode);
+	    return;
+      }
+
+      setvbuf(fp, NULL, _IOFBF, FILE_BUF_SIZE);
+      ent.fp = fp;
+      ent.filename = name;
+      ent.mode = mode;
+      async_attach(ent);
+}
+
+void vpip_mcd_restore_state(vvp_checkpoint_in&in)
+{
+	// Close the files that the new simulation has opened so far.
+      for (unsigned idx = 1 ;  idx < 31 ;  idx += 1)
+	    if (mcd_table[idx].fp) vpi_mcd_close(1U << idx);
+      for (unsigned idx = 3 ;  idx < fd_table_len ;  idx += 1)
+	    if (fd_table[idx].fp) vpi_mcd_close((1U<<31) | idx);
+      async_wait_closes();
+
+      unsigned long count = in.get_u32();
+      for (unsigned long cnt = 0 ;  cnt < count && !in.failed() ;  cnt += 1) {
+	    unsigned long idx = in.get_u32();
+	    if (idx == 0 || idx >= 31) {
+		  in.error("invalid MCD record");
+		  break;
+	    }
+	    restore_entry(in, mcd_table[idx]);
+      }
+
+      count = in.get_u32();
+      for (unsigned long cnt = 0 ;  cnt < count && !in.failed() ;  cnt += 1) {
+	    unsigned long idx = in.get_u32();
+	    if (idx < 3 || idx >= 1024) {
+		  in.error("invalid file descriptor record");
+		  break;
+	    }
+	    if (idx >= fd_table_len) {
+		  unsigned len = (idx/FD_INCR + 1) * FD_INCR;
+		  fd_table = (mcd_entry_s *) realloc(fd_table,
+						     len*sizeof(mcd_entry_s));
+		  for (unsigned tmp = fd_table_len; tmp < len; tmp += 1) {
+			fd_table[tmp].fp = NULL;
+			fd_table[tmp].filename = NULL;
+			fd_table[tmp].mode = NULL;
+			fd_table[tmp].async = NULL;
+		  }
+		  fd_table_len = len;
+	    }
+	    restore_entry(in, fd_table[idx]);
+      }
+}
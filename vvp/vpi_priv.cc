@@ -20,13 +20,25 @@
 # include  "version_base.h"
 # include  "vpi_priv.h"
 # include  "schedule.h"
+# include  "statistics.h"
+# include  "checkpoint.h"
 # include  <cstdio>
+# include  <cerrno>
 # include  <cstdarg>
 # include  <cstring>
 # include  <cassert>
 # include  <cstdlib>
 # include  <cmath>
 # include  <iostream>
+# include  <map>
+# include  <string>
+# include  <vector>
+#ifndef __MINGW32__
+# include  <unistd.h>
+#endif
+#ifdef HAVE_SYS_WAIT_H
+# include  <sys/wait.h>
+#endif
 
 vpi_mode_t vpi_mode_flag = VPI_MODE_NONE;
 FILE*vpi_trace = 0;
@@ -1098,71 +1110,152 @@ vpiHandle vpi_handle_by_index(vpiHandle ref, PLI_INT32 idx)
       return (ref->vpi_type->index_)(ref, idx);
 }
 
-static vpiHandle find_name(const char *name, vpiHandle handle)
+/*
+ * The vpi_handle_by_name function is used heavily by some VPI
+ * applications to bind to design objects, so the names of the items in
+ * each scope are indexed the first time the scope is searched, and the
+ * full names of all the scopes are indexed the first time a full path
+ * is searched. The indices are rebuilt if items or scopes are added.
+ */
+struct scope_name_index_s {
+      unsigned nintern;
+      std::map<std::string,vpiHandle> names;
+};
+
+static std::map<struct __vpiScope*,scope_name_index_s> scope_name_index;
+static std::map<std::string,vpiHandle> scope_path_index;
+static unsigned long scope_path_index_count = 0;
+
+static const std::map<std::string,vpiHandle>&
+scope_names(struct __vpiScope*ref)
 {
-      vpiHandle rtn = 0;
-      struct __vpiScope*ref = (struct __vpiScope*)handle;
+      scope_name_index_s&idx = scope_name_index[ref];
+      if (idx.nintern == ref->nintern && ! idx.names.empty())
+	    return idx.names;
 
-      /* check module names */
-      if (!strcmp(name, vpi_get_str(vpiName, handle)))
-	    rtn = handle;
+      idx.names.clear();
+      idx.nintern = ref->nintern;
 
-      /* brute force search for the name in all objects in this scope */
+	/* If the same name appears more than once, the first item
+	   wins, as it did for the linear search. */
       for (unsigned i = 0 ;  i < ref->nintern ;  i += 1) {
 	    char *nm = vpi_get_str(vpiName, ref->intern[i]);
-	    if (!strcmp(name, nm)) {
-		  rtn = ref->intern[i];
-		  break;
-	    } else if (vpi_get(vpiType, ref->intern[i]) == vpiMemory ||
-	               vpi_get(vpiType, ref->intern[i]) == vpiNetArray) {
-		  /* We need to iterate on the words */
-		  vpiHandle word_i, word_h;
-		  word_i = vpi_iterate(vpiMemoryWord, ref->intern[i]);
-		  while (word_i && (word_h = vpi_scan(word_i))) {
-			nm = vpi_get_str(vpiName, word_h);
-			if (!strcmp(name, nm)) {
-			      rtn = word_h;
-			      break;
-			}
-		  }
-	    }
-	    /* found it yet? */
-	    if (rtn) break;
+	    if (nm)
+		  idx.names.insert(std::make_pair(std::string(nm),
+						  ref->intern[i]));
       }
 
-      return rtn;
+      return idx.names;
 }
 
-static vpiHandle find_scope(const char *name, vpiHandle handle, int depth)
+/*
+ * Look for an array word name of the form "name[index]". The word is
+ * located by its index instead of by comparing the name of every word
+ * in the array.
+ */
+static vpiHandle find_array_word(const char*name,
+				 const std::map<std::string,vpiHandle>&names)
 {
-      vpiHandle iter, hand, rtn = 0;
+      size_t len = strlen(name);
+      if (len < 4 || name[len-1] != ']')
+	    return 0;
+
+      const char*open = strrchr(name, '[');
+      if (open == 0 || open == name)
+	    return 0;
+
+      char*end;
+      long index = strtol(open+1, &end, 10);
+      if (end == open+1 || end != name+len-1)
+	    return 0;
+
+      std::map<std::string,vpiHandle>::const_iterator cur
+	    = names.find(std::string(name, open-name));
+      if (cur == names.end())
+	    return 0;
+
+      int type = vpi_get(vpiType, cur->second);
+      if (type != vpiMemory && type != vpiNetArray)
+	    return 0;
+
+      vpiHandle word = vpi_handle_by_index(cur->second, index);
+      if (word == 0)
+	    return 0;
+
+	/* Make sure the word really has the name that was asked for,
+	   i.e. that the index was written the way the word names it. */
+      char*nm = vpi_get_str(vpiName, word);
+      if (nm == 0 || strcmp(name, nm) != 0)
+	    return 0;
+
+      return word;
+}
+
+static vpiHandle find_name(const char *name, vpiHandle handle)
+{
+      struct __vpiScope*ref = (struct __vpiScope*)handle;
+      const std::map<std::string,vpiHandle>&names = scope_names(ref);
+
+      std::map<std::string,vpiHandle>::const_iterator cur
+	    = names.find(std::string(name));
+      if (cur != names.end())
+	    return cur->second;
+
+      if (vpiHandle word = find_array_word(name, names))
+	    return word;
+
+      /* check module names */
+      if (!strcmp(name, vpi_get_str(vpiName, handle)))
+	    return handle;
+
+      return 0;
+}
+
+static void scope_path_index_add(vpiHandle handle)
+{
+      vpiHandle iter, hand;
 
       iter = !handle ? vpi_iterate(vpiModule, NULL) :
 		       vpi_iterate(vpiInternalScope, handle);
 
       while (iter && (hand = vpi_scan(iter))) {
-	    char *nm = vpi_get_str(vpiName, hand);
-	    int len = strlen(nm);
-	    const char *cp = name + len;	/* hier separator */
-
-	    if (!handle && !strcmp(name, nm)) {
-		  /* root module */
-		  rtn = hand;
-	    } else if (!strncmp(name, nm, len) && *(cp) == '.')
-		  /* recurse deeper */
-		  rtn = find_scope(cp+1, hand, depth + 1);
-
-	    /* found it yet ? */
-	    if (rtn) {
-		  vpi_free_object(iter);
-		  break;
-	    }
+	    char *nm = vpi_get_str(vpiFullName, hand);
+	    scope_path_index.insert(std::make_pair(std::string(nm), hand));
+	    scope_path_index_add(hand);
+      }
+}
+
+/*
+ * Find the deepest scope whose full name is a prefix of the
+ * hierarchical name.
+ */
+static vpiHandle find_scope(const char *name)
+{
+      if (scope_path_index_count != count_vpi_scopes) {
+	    scope_path_index.clear();
+	    scope_path_index_add(0);
+	    scope_path_index_count = count_vpi_scopes;
       }
 
-      /* matched up to here */
-      if (!rtn) rtn = handle;
+      std::string path (name);
+      std::map<std::string,vpiHandle>::const_iterator cur;
 
-      return rtn;
+	/* A simple name can only be a root module. */
+      if (path.find('.') == std::string::npos) {
+	    cur = scope_path_index.find(path);
+	    return cur != scope_path_index.end()? cur->second : 0;
+      }
+
+	/* Otherwise, only the parts that are followed by a '.' are
+	   scope names. The tail is looked up in the scope. */
+      for (size_t dot = path.rfind('.') ; dot != std::string::npos && dot > 0
+		 ; dot = path.rfind('.', dot-1)) {
+	    cur = scope_path_index.find(path.substr(0, dot));
+	    if (cur != scope_path_index.end())
+		  return cur->second;
+      }
+
+      return 0;
 }
 
 vpiHandle vpi_handle_by_name(const char *name, vpiHandle scope)
@@ -1192,7 +1285,7 @@ vpiHandle vpi_handle_by_name(const char *name, vpiHandle scope)
 	          return 0;
 	    }
       } else {
-	    hand = find_scope(name, NULL, 0);
+	    hand = find_scope(name);
       }
 
       if (hand) {
@@ -1311,6 +1404,14 @@ extern "C" void vpi_sim_vcontrol(int operation, va_list ap)
 	    schedule_stop(diag_msg);
 	    break;
 
+	  case vpiSaveCheckpoint:
+	    checkpoint_request_save(va_arg(ap, const char*));
+	    break;
+
+	  case vpiRestartCheckpoint:
+	    checkpoint_request_restart(va_arg(ap, const char*));
+	    break;
+
 	  default:
 	    fprintf(stderr, "Unsupported operation %d.\n", operation);
 	    assert(0);
@@ -1333,6 +1434,103 @@ extern "C" void vpi_control(PLI_INT32 operation, ...)
       va_end(ap);
 }
 
+/*
+ * Add a plusarg to the command line arguments that the VPI
+ * applications see. This is how a forked child learns its index.
+ */
+static void vpip_add_plusarg(const char*arg)
+{
+      int argc = vpi_vlog_info.argc;
+      char**argv = (char**)malloc((argc+2) * sizeof(char*));
+      for (int idx = 0 ;  idx < argc ;  idx += 1)
+	    argv[idx] = vpi_vlog_info.argv[idx];
+      argv[argc] = strdup(arg);
+      argv[argc+1] = 0;
+      vpi_vlog_info.argc = argc + 1;
+      vpi_vlog_info.argv = argv;
+}
+
+/*
+ * Fork the running simulation into count children. Each child
+ * continues from this point with the return value set to its index
+ * (1 to count), the plusarg +ivl_fork_index=<index> and its own
+ * copies of the output files. The children share the memory of the
+ * parent copy-on-write, so the state that the parent built up is
+ * paid for only once. The parent waits for all the children and
+ * reports their exit status, then returns 0. If any child failed,
+ * the exit status of the parent is 1. The return value is -1 if the
+ * fork is not possible at all.
+ */
+extern "C" PLI_INT32 vpip_fork_tests(PLI_INT32 count)
+{
+#if defined(__MINGW32__) || !defined(HAVE_SYS_WAIT_H)
+      (void)count;
+      vpi_mcd_printf(1, "Error: Fork tests are not supported on this "
+		     "platform.\n");
+      return -1;
+#else
+      if (count <= 0)
+	    return 0;
+
+	// Flush everything, or the children inherit and write out
+	// the buffered data again. The file output thread does not
+	// survive the fork, so stop it first.
+      vpip_mcd_async_suspend();
+      fflush(0);
+
+      std::vector<pid_t> pids;
+      for (PLI_INT32 idx = 1 ;  idx <= count ;  idx += 1) {
+	    pid_t pid = fork();
+	    if (pid < 0) {
+		  vpi_mcd_printf(1, "Error: Unable to fork test %d: %s\n",
+				 (int)idx, strerror(errno));
+		  break;
+	    }
+
+	    if (pid == 0) {
+		  char buf[64];
+		  snprintf(buf, sizeof buf, "+ivl_fork_index=%d", (int)idx);
+		  vpip_add_plusarg(buf);
+		  vpip_mcd_fork_remap(idx);
+		  vpip_mcd_async_resume();
+		  return idx;
+	    }
+
+	    pids.push_back(pid);
+      }
+
+      vpip_mcd_async_resume();
+      if (pids.empty())
+	    return -1;
+
+      unsigned fail = 0;
+      for (unsigned idx = 0 ;  idx < pids.size() ;  idx += 1) {
+	    int rc;
+	    if (waitpid(pids[idx], &rc, 0) < 0)
+		  rc = -1;
+
+	    if (rc == 0) {
+		  vpi_mcd_printf(1, "Fork test %u (pid %ld): ok\n",
+				 idx+1, (long)pids[idx]);
+		  continue;
+	    }
+
+	    fail += 1;
+	    vpi_mcd_printf(1, "Fork test %u (pid %ld): FAILED (%s %d)\n",
+			   idx+1, (long)pids[idx],
+			   WIFEXITED(rc)? "exit code" : "status",
+			   WIFEXITED(rc)? WEXITSTATUS(rc) : rc);
+      }
+
+      vpi_mcd_printf(1, "%u fork tests, %u failed\n",
+		     (unsigned)pids.size(), fail);
+      if (fail > 0 || (PLI_INT32)pids.size() < count)
+	    vpip_set_return_value(1);
+
+      return 0;
+#endif
+}
+
 /*
  * This routine calculated the return value for $clog2.
  * It is easier to do it here vs trying to to use the VPI interface.
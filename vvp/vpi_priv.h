@@ -24,6 +24,7 @@
 # include  "config.h"
 
 # include  <set>
+# include  <vector>
 
 /*
  * Added to use some "vvp_fun_modpath_src"
@@ -232,6 +233,11 @@ extern unsigned vpip_add_item_to_context(automatic_hooks_s*item,
 extern vpiHandle vpip_make_root_iterator(void);
 extern void vpip_make_root_iterator(struct __vpiHandle**&table,
 				    unsigned&ntable);
+/*
+ * Collect all the scopes of the design, parents before children, in
+ * the order they appear in the scope tree.
+ */
+extern void vpip_collect_scopes(std::vector<struct __vpiScope*>&scopes);
 
 /*
  * Signals include the variable types (reg, integer, time) and are
@@ -610,6 +616,9 @@ extern unsigned vpip_vec4_to_dec_str(const vvp_vector4_t&vec4,
 extern void vpip_vec4_to_hex_str(const vvp_vector4_t&bits, char*buf,
 				 unsigned nbuf);
 
+extern void vpip_vec4_to_bin_str(const vvp_vector4_t&bits, char*buf,
+				 unsigned nbuf);
+
 extern void vpip_vec4_to_oct_str(const vvp_vector4_t&bits, char*buf,
 				 unsigned nbuf);
 
@@ -647,6 +656,26 @@ extern char *generic_get_str(int code, vpiHandle ref, const char *name, const ch
 /* A routine to find the enclosing module. */
 extern vpiHandle vpip_module(struct __vpiScope*scope);
 
+/*
+ * A child made by vpip_fork_tests calls this to give itself private
+ * copies of the open files. Output files are replaced by files with
+ * ".<index>" appended to the name, and so are the output files that
+ * are opened later.
+ */
+extern void vpip_mcd_fork_remap(unsigned index);
+
+/*
+ * With the -a flag, the files opened for writing by $fopen are
+ * written by a separate I/O thread. The suspend function waits for
+ * the thread to write out everything and stops it, the resume
+ * function starts it again. The stats function prints the -v
+ * statistics of the thread.
+ */
+extern void vpip_mcd_async_init(void);
+extern void vpip_mcd_async_suspend(void);
+extern void vpip_mcd_async_resume(void);
+extern void vpip_mcd_async_stats(void);
+
 extern int vpip_delay_selection;
 
 #endif
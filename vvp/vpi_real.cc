@@ -21,6 +21,7 @@
 # include  "vpi_priv.h"
 # include  "vvp_net_sig.h"
 # include  "schedule.h"
+# include  "lazy.h"
 #ifdef CHECK_WITH_VALGRIND
 # include  "vvp_cleanup.h"
 #endif
@@ -133,6 +134,7 @@ static void real_var_get_value(vpiHandle ref, s_vpi_value*vp)
 
       struct __vpiRealVar*rfp
 	    = (struct __vpiRealVar*)ref;
+      lazy_demand(rfp->net);
       vvp_signal_value*fil
 	    = dynamic_cast<vvp_signal_value*>(rfp->net->fil);
 
@@ -173,6 +175,7 @@ void vpip_real_value_change(struct __vpiCallback*cbh,
 {
       struct __vpiRealVar*rfp
 	    = (struct __vpiRealVar*)ref;
+      lazy_observe(rfp->net);
       vvp_vpi_callback*obj = dynamic_cast<vvp_vpi_callback*>(rfp->net->fil);
       assert(obj);
 
@@ -123,6 +123,23 @@ static bool handle_is_scope(vpiHandle obj)
 	    || (obj->vpi_type->type_code == vpiNamedFork);
 }
 
+static void collect_scopes(struct __vpiScope*scope,
+			   std::vector<struct __vpiScope*>&scopes)
+{
+      scopes.push_back(scope);
+      for (unsigned idx = 0 ;  idx < scope->nintern ;  idx += 1) {
+	    vpiHandle item = scope->intern[idx];
+	    if (handle_is_scope(item))
+		  collect_scopes((struct __vpiScope*)item, scopes);
+      }
+}
+
+void vpip_collect_scopes(std::vector<struct __vpiScope*>&scopes)
+{
+      for (unsigned idx = 0 ;  idx < vpip_root_table_cnt ;  idx += 1)
+	    collect_scopes((struct __vpiScope*)vpip_root_table_ptr[idx], scopes);
+}
+
 static int scope_get(int code, vpiHandle obj)
 {
       struct __vpiScope*ref = (struct __vpiScope*)obj;
@@ -27,6 +27,7 @@
 # include  "vvp_net_sig.h"
 # include  "schedule.h"
 # include  "statistics.h"
+# include  "lazy.h"
 # include  "config.h"
 #ifdef CHECK_WITH_VALGRIND
 # include  "vvp_cleanup.h"
@@ -136,6 +137,29 @@ char *generic_get_str(int code, vpiHandle ref, const char *name, const char *ind
  * They work with full or partial signals.
  */
 
+/*
+ * Get the part of the signal value that the formatters need as a
+ * vector, so that the word at a time conversions in the vpip_*
+ * functions can be used. Return false if the part is not entirely
+ * within the signal.
+ */
+static bool signal_part_vec4(vvp_signal_value*sig, int base, unsigned wid,
+                             vvp_vector4_t&vec4)
+{
+      long end = base + (signed)wid;
+      if (base < 0 || end > (signed)sig->value_size())
+	    return false;
+
+      if (base == 0 && wid == sig->value_size()) {
+	    sig->vec4_value(vec4);
+      } else {
+	    vvp_vector4_t tmp;
+	    sig->vec4_value(tmp);
+	    vec4 = tmp.subvalue(base, wid);
+      }
+      return true;
+}
+
 static void format_vpiBinStrVal(vvp_signal_value*sig, int base, unsigned wid,
                                 s_vpi_value*vp)
 {
@@ -144,6 +168,13 @@ static void format_vpiBinStrVal(vvp_signal_value*sig, int base, unsigned wid,
       long offset = end - 1;
       long ssize = (signed)sig->value_size();
 
+      vvp_vector4_t vec4;
+      if (signal_part_vec4(sig, base, wid, vec4)) {
+	    vpip_vec4_to_bin_str(vec4, rbuf, wid+1);
+	    vp->value.str = rbuf;
+	    return;
+      }
+
       for (long idx = base ;  idx < end ;  idx += 1) {
 	    if (idx < 0 || idx >= ssize) {
                   rbuf[offset-idx] = 'x';
@@ -165,6 +196,13 @@ static void format_vpiOctStrVal(vvp_signal_value*sig, int base, unsigned wid,
       long ssize = (signed)sig->value_size();
       unsigned val = 0;
 
+      vvp_vector4_t vec4;
+      if (signal_part_vec4(sig, base, wid, vec4)) {
+	    vpip_vec4_to_oct_str(vec4, rbuf, dwid+1);
+	    vp->value.str = rbuf;
+	    return;
+      }
+
       rbuf[dwid] = 0;
       for (long idx = base ;  idx < end ;  idx += 1) {
 	    unsigned bit = 0;
@@ -221,6 +259,13 @@ static void format_vpiHexStrVal(vvp_signal_value*sig, int base, unsigned wid,
       long ssize = (signed)sig->value_size();
       unsigned val = 0;
 
+      vvp_vector4_t vec4;
+      if (signal_part_vec4(sig, base, wid, vec4)) {
+	    vpip_vec4_to_hex_str(vec4, rbuf, dwid+1);
+	    vp->value.str = rbuf;
+	    return;
+      }
+
       rbuf[dwid] = 0;
       for (long idx = base ;  idx < end ;  idx += 1) {
 	    unsigned bit = 0;
@@ -304,13 +349,7 @@ static void format_vpiDecStrVal(vvp_signal_value*sig, int base, unsigned wid,
       }
 
       vvp_vector4_t vec4;
-      if (base == 0 && end == ssize) {
-	    sig->vec4_value(vec4);
-      } else {
-	    vvp_vector4_t tmp;
-	    sig->vec4_value(tmp);
-	    vec4 = tmp.subvalue(base, wid);
-      }
+      signal_part_vec4(sig, base, wid, vec4);
 
       vpip_vec4_to_dec_str(vec4, rbuf, hwid, signed_flag);
 
@@ -667,6 +706,7 @@ static void signal_get_value(vpiHandle ref, s_vpi_value*vp)
 
       unsigned wid = signal_width(rfp);
 
+      lazy_demand(rfp->node);
       vvp_signal_value*vsig = dynamic_cast<vvp_signal_value*>(rfp->node->fil);
       assert(vsig);
 
@@ -1266,6 +1306,7 @@ static void PV_get_value(vpiHandle ref, p_vpi_value vp)
       assert(ref->vpi_type->type_code == vpiPartSelect);
       struct __vpiPV*rfp = (struct __vpiPV*)ref;
 
+      lazy_demand(rfp->net);
       vvp_signal_value*sig = dynamic_cast<vvp_signal_value*>(rfp->net->fil);
       assert(sig);
 
@@ -1472,6 +1513,7 @@ void vpip_part_select_value_change(struct __vpiCallback*cbh, vpiHandle ref)
 {
       struct __vpiPV*obj = vpip_PV_from_handle(ref);
       assert(obj);
+      lazy_observe(obj->net);
 
       vvp_vpi_callback*sig_fil;
       sig_fil = dynamic_cast<vvp_vpi_callback*>(obj->net->fil);
@@ -49,6 +49,12 @@ vvp_bit4_t get_bit(struct __vpiVThrVec *rfp, unsigned idx)
       return vthread_get_bit(vpip_current_vthread, rfp->bas+idx);
 }
 
+inline static
+vvp_vector4_t get_vec4(struct __vpiVThrVec *rfp)
+{
+      return vthread_get_vec4(vpip_current_vthread, rfp->bas, rfp->wid);
+}
+
 inline static
 void set_bit(struct __vpiVThrVec *rfp, unsigned idx, vvp_bit4_t bit)
 {
@@ -56,22 +62,6 @@ void set_bit(struct __vpiVThrVec *rfp, unsigned idx, vvp_bit4_t bit)
 }
 
 
-/*
- * Hex digits that represent 4-value bits of Verilog are not as
- * trivially obvious to display as if the bits were the usual 2-value
- * bits. So, although it is possible to write a function that
- * generates a correct character for 4*4-value bits, it is easier to
- * just perform the lookup in a table. This only takes 256 bytes,
- * which is not many executable instructions:-)
- *
- * The table is calculated as compile time, therefore, by the
- * draw_tt.c program.
- */
-
-extern const char hex_digits[256];
-
-extern const char oct_digits[64];
-
 /*
  *  vpi_get
  */
@@ -126,11 +116,7 @@ static void vthr_vec_DecStrVal(struct __vpiVThrVec*rfp, s_vpi_value*vp)
       int nbuf = (rfp->wid+2)/3 + 1;
       char *rbuf = need_result_buf(nbuf, RBUF_VAL);
 
-      vvp_vector4_t tmp (rfp->wid);
-      for (unsigned idx = 0 ;  idx < rfp->wid ;  idx += 1)
-	    tmp.set_bit(idx, get_bit(rfp, idx));
-
-      vpip_vec4_to_dec_str(tmp, rbuf, nbuf, rfp->signed_flag);
+      vpip_vec4_to_dec_str(get_vec4(rfp), rbuf, nbuf, rfp->signed_flag);
       vp->value.str = rbuf;
 
       return;
@@ -190,89 +176,22 @@ static void vthr_vec_get_value(vpiHandle ref, s_vpi_value*vp)
 
 	  case vpiBinStrVal:
 	    rbuf = need_result_buf(wid+1, RBUF_VAL);
-	    for (unsigned idx = 0 ;  idx < wid ;  idx += 1) {
-		  rbuf[wid-idx-1] = vvp_bit4_to_ascii(get_bit(rfp, idx));
-	    }
-	    rbuf[wid] = 0;
+	    vpip_vec4_to_bin_str(get_vec4(rfp), rbuf, wid+1);
 	    vp->value.str = rbuf;
 	    break;
 
 	  case vpiHexStrVal: {
-		unsigned hval, hwid;
-		hwid = (wid + 3) / 4;
+		unsigned hwid = (wid + 3) / 4;
 		rbuf = need_result_buf(hwid+1, RBUF_VAL);
-		rbuf[hwid] = 0;
-		hval = 0;
-		for (unsigned idx = 0 ;  idx < wid ;  idx += 1) {
-		      unsigned tmp = 0;
-		      switch (get_bit(rfp, idx)) {
-			  case BIT4_0:
-			    tmp = 0;
-			    break;
-			  case BIT4_1:
-			    tmp = 1;
-			    break;
-			  case BIT4_X:
-			    tmp = 2;
-			    break;
-			  case BIT4_Z:
-			    tmp = 3;
-			    break;
-		      }
-		      hval = hval | (tmp << 2*(idx % 4));
-
-		      if (idx%4 == 3) {
-			    hwid -= 1;
-			    rbuf[hwid] = hex_digits[hval];
-			    hval = 0;
-		      }
-		}
-
-		if (hwid > 0) {
-		      hwid -= 1;
-		      rbuf[hwid] = hex_digits[hval];
-		      hval = 0;
-		}
+		vpip_vec4_to_hex_str(get_vec4(rfp), rbuf, hwid+1);
 		vp->value.str = rbuf;
 		break;
 	  }
 
 	  case vpiOctStrVal: {
-		unsigned hval, hwid;
-		hwid = (wid + 2) / 3;
+		unsigned hwid = (wid + 2) / 3;
 		rbuf = need_result_buf(hwid+1, RBUF_VAL);
-		rbuf[hwid] = 0;
-		hval = 0;
-		for (unsigned idx = 0 ;  idx < wid ;  idx += 1) {
-		      unsigned tmp = 0;
-		      switch (get_bit(rfp, idx)) {
-			  case BIT4_0:
-			    tmp = 0;
-			    break;
-			  case BIT4_1:
-			    tmp = 1;
-			    break;
-			  case BIT4_X:
-			    tmp = 2;
-			    break;
-			  case BIT4_Z:
-			    tmp = 3;
-			    break;
-		      }
-		      hval = hval | (tmp << 2*(idx % 3));
-
-		      if (idx%3 == 2) {
-			    hwid -= 1;
-			    rbuf[hwid] = oct_digits[hval];
-			    hval = 0;
-		      }
-		}
-
-		if (hwid > 0) {
-		      hwid -= 1;
-		      rbuf[hwid] = oct_digits[hval];
-		      hval = 0;
-		}
+		vpip_vec4_to_oct_str(get_vec4(rfp), rbuf, hwid+1);
 		vp->value.str = rbuf;
 		break;
 	  }
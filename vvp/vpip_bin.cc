@@ -111,3 +111,29 @@ void vpip_bin_str_to_vec4(vvp_vector4_t&vec4, const char*buf)
 	    else vec4.set_bit(jdx, pad);
       }
 }
+
+void vpip_vec4_to_bin_str(const vvp_vector4_t&bits, char*buf, unsigned nbuf)
+{
+      const unsigned CHUNK = 8*sizeof(unsigned long);
+	/* Indexed by (bbit<<1)|abit. */
+      static const char bin_digit[4] = { '0', '1', 'z', 'x' };
+      unsigned slen = bits.size();
+      assert(slen < nbuf);
+
+      buf[slen] = 0;
+
+      for (unsigned adr = 0 ;  adr < bits.size() ;  adr += CHUNK) {
+	    unsigned wid = bits.size() - adr;
+	    if (wid > CHUNK) wid = CHUNK;
+
+	    unsigned long abits, bbits;
+	    bits.subword(adr, wid, abits, bbits);
+
+	    for (unsigned idx = 0 ;  idx < wid ;  idx += 1) {
+		  slen -= 1;
+		  buf[slen] = bin_digit[((bbits&1) << 1) | (abits&1)];
+		  abits >>= 1;
+		  bbits >>= 1;
+	    }
+      }
+}
@@ -139,55 +139,64 @@ void vpip_hex_str_to_vec4(vvp_vector4_t&val, const char*str)
       }
 }
 
+/*
+ * The hex_nibble table maps the abits and bbits of a hex digit, packed
+ * as (bbits<<4)|abits, to the same character that hex_digits[] gives
+ * for the digit. This lets the conversion work on whole words of the
+ * vector instead of a bit at a time.
+ */
+static char hex_nibble[256];
+
+static void build_hex_nibble(void)
+{
+      for (unsigned ab = 0 ;  ab < 256 ;  ab += 1) {
+	    unsigned val = 0;
+	    for (unsigned bit = 0 ;  bit < 4 ;  bit += 1) {
+		  unsigned abit = (ab >> bit) & 1;
+		  unsigned bbit = (ab >> (bit+4)) & 1;
+		    /* 0->0, 1->1, X->2, Z->3 as in hex_digits[]. */
+		  unsigned code = bbit? (abit? 2 : 3) : abit;
+		  val |= code << 2*bit;
+	    }
+	    hex_nibble[ab] = hex_digits[val];
+      }
+}
+
 void vpip_vec4_to_hex_str(const vvp_vector4_t&bits, char*buf, unsigned nbuf)
 {
+      const unsigned CHUNK = 8*sizeof(unsigned long);
       unsigned slen = (bits.size() + 3) / 4;
       assert(slen < nbuf);
 
+      if (hex_nibble[0] == 0)
+	    build_hex_nibble();
+
       buf[slen] = 0;
 
-      unsigned val = 0;
-      for (unsigned idx = 0 ;  idx < bits.size() ;  idx += 1) {
-	    unsigned vs = (idx%4) * 2;
+      for (unsigned adr = 0 ;  adr < bits.size() ;  adr += CHUNK) {
+	    unsigned wid = bits.size() - adr;
+	    if (wid > CHUNK) wid = CHUNK;
 
-	    switch (bits.value(idx)) {
-		case BIT4_0:
-		  break;
-		case BIT4_1:
-		  val |= 1 << vs;
-		  break;
-		case BIT4_X:
-		  val |= 2 << vs;
-		  break;
-		case BIT4_Z:
-		  val |= 3 << vs;
-	    }
+	    unsigned long abits, bbits;
+	    bits.subword(adr, wid, abits, bbits);
 
-	    if (vs == 6) {
-		  slen -= 1;
-		  buf[slen] = hex_digits[val];
-		  val = 0;
-	    }
-      }
+	    for (unsigned idx = 0 ;  idx < wid ;  idx += 4) {
+		  unsigned ab = ((bbits & 0xf) << 4) | (abits & 0xf);
 
-	/* Fill in X or Z if they are the only thing in the value. */
-      switch (bits.size() % 4) {
-	  case 1:
-	    if (val == 2) val = 170;
-	    else if (val == 3) val = 255;
-	    break;
-	  case 2:
-	    if (val == 10) val = 170;
-	    else if (val == 15) val = 255;
-	    break;
-	  case 3:
-	    if (val == 42) val = 170;
-	    else if (val == 63) val = 255;
-	    break;
-      }
+		    /* Fill in X or Z if they are the only thing in a
+		       partial top digit. */
+		  if (wid-idx < 4) {
+			unsigned mask = (1U << (wid-idx)) - 1;
+			if ((ab>>4) == mask && (ab&15) == mask)
+			      ab = 0xff;
+			else if ((ab>>4) == mask && (ab&15) == 0)
+			      ab = 0xf0;
+		  }
 
-      if (slen > 0) {
-	    slen -= 1;
-	    buf[slen] = hex_digits[val];
+		  slen -= 1;
+		  buf[slen] = hex_nibble[ab];
+		  abits >>= 4;
+		  bbits >>= 4;
+	    }
       }
 }
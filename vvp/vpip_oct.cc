@@ -120,51 +120,64 @@ void vpip_oct_str_to_vec4(vvp_vector4_t&val, const char*str)
 
 }
 
+/*
+ * The oct_triple table maps the abits and bbits of an octal digit,
+ * packed as (bbits<<3)|abits, to the same character that oct_digits[]
+ * gives for the digit.
+ */
+static char oct_triple[64];
+
+static void build_oct_triple(void)
+{
+      for (unsigned ab = 0 ;  ab < 64 ;  ab += 1) {
+	    unsigned val = 0;
+	    for (unsigned bit = 0 ;  bit < 3 ;  bit += 1) {
+		  unsigned abit = (ab >> bit) & 1;
+		  unsigned bbit = (ab >> (bit+3)) & 1;
+		    /* 0->0, 1->1, X->2, Z->3 as in oct_digits[]. */
+		  unsigned code = bbit? (abit? 2 : 3) : abit;
+		  val |= code << 2*bit;
+	    }
+	    oct_triple[ab] = oct_digits[val];
+      }
+}
+
 void vpip_vec4_to_oct_str(const vvp_vector4_t&bits, char*buf, unsigned nbuf)
 {
+	/* Use chunks that hold a whole number of digits. */
+      const unsigned CHUNK = 3 * (8*sizeof(unsigned long) / 3);
       unsigned slen = (bits.size() + 2) / 3;
       assert(slen < nbuf);
 
+      if (oct_triple[0] == 0)
+	    build_oct_triple();
+
       buf[slen] = 0;
 
-      unsigned val = 0;
-      for (unsigned idx = 0 ;  idx < bits.size() ;  idx += 1) {
-	    unsigned vs = (idx%3) * 2;
+      for (unsigned adr = 0 ;  adr < bits.size() ;  adr += CHUNK) {
+	    unsigned wid = bits.size() - adr;
+	    if (wid > CHUNK) wid = CHUNK;
 
-	    switch (bits.value(idx)) {
-		case BIT4_0:
-		  break;
-		case BIT4_1:
-		  val |= 1 << vs;
-		  break;
-		case BIT4_X:
-		  val |= 2 << vs;
-		  break;
-		case BIT4_Z:
-		  val |= 3 << vs;
-	    }
+	    unsigned long abits, bbits;
+	    bits.subword(adr, wid, abits, bbits);
 
-	    if (vs == 4) {
-		  slen -= 1;
-		  buf[slen] = oct_digits[val];
-		  val = 0;
-	    }
-      }
+	    for (unsigned idx = 0 ;  idx < wid ;  idx += 3) {
+		  unsigned ab = ((bbits & 7) << 3) | (abits & 7);
 
-	/* Fill in X or Z if they are the only thing in the value. */
-      switch (bits.size() % 3) {
-	  case 1:
-	    if (val == 2) val = 42;
-	    else if (val == 3) val = 63;
-	    break;
-	  case 2:
-	    if (val == 10) val = 42;
-	    else if (val == 15) val = 63;
-	    break;
-      }
+		    /* Fill in X or Z if they are the only thing in a
+		       partial top digit. */
+		  if (wid-idx < 3) {
+			unsigned mask = (1U << (wid-idx)) - 1;
+			if ((ab>>3) == mask && (ab&7) == mask)
+			      ab = 0x3f;
+			else if ((ab>>3) == mask && (ab&7) == 0)
+			      ab = 0x38;
+		  }
 
-      if (slen > 0) {
-	    slen -= 1;
-	    buf[slen] = oct_digits[val];
+		  slen -= 1;
+		  buf[slen] = oct_triple[ab];
+		  abits >>= 3;
+		  bbits >>= 3;
+	    }
       }
 }
@@ -61,24 +61,35 @@
 /* The program works by building a base BASE representation of the number
  * in the valv array.  BBITS bits of the number can be put in at a time.
  * Previous values of each valv element are always less than BASE, the
- * input val is less than or equal to 2^BBITS, so (valv[i]<<BBITS)+val
- * is guaranteed less than or equal to BASE<<BBITS, which is configured
- * less than ULONG_MAX.  When this number divided by BASE, to get the amount
- * propagated as a "carry" to the next array element, the result is again
- * less than or equal to 2^BBITS.  BBITS and BASE are configured above
- * to depend on the "unsigned long" length of the host, for efficiency.
+ * input val is less than 2^BBITS, so (valv[i]<<BBITS)+val is guaranteed
+ * less than BASE<<BBITS, which is configured less than ULONG_MAX.  When
+ * this number divided by BASE, to get the amount propagated as a "carry"
+ * to the next array element, the result is again less than 2^BBITS.
+ * BBITS and BASE are configured above to depend on the "unsigned long"
+ * length of the host, for efficiency.
+ *
+ * Only the vused elements that are already non-zero are visited, and
+ * the carry out of the top extends the array. The array grows with the
+ * number, so the leading zero elements of a wide vector with a small
+ * value cost nothing.
  */
-static inline void shift_in(unsigned long *valv, unsigned int vlen, unsigned long val)
+static inline void shift_in(unsigned long *valv, unsigned int &vused,
+			    unsigned int vlen, unsigned long val)
 {
 	unsigned int i;
-	/* printf("shift in %u\n",val); */
-	for (i=0; i<vlen; i++) {
+	for (i=0; i<vused; i++) {
 		val=(valv[i]<<BBITS)+val;
 		valv[i]=val%BASE;
 		val=val/BASE;
 	}
-	if (val!=0)
-	      fprintf(stderr,"internal error: carry out %lu in " __FILE__ "\n",val);
+	while (val!=0) {
+		if (vused >= vlen) {
+			fprintf(stderr,"internal error: carry out %lu in " __FILE__ "\n",val);
+			return;
+		}
+		valv[vused++]=val%BASE;
+		val=val/BASE;
+	}
 }
 
 /* Since BASE is a power of ten, conversion of each element of the
@@ -117,113 +128,119 @@ void dec_str_delete(void)
 }
 #endif
 
+/*
+ * X and Z bits are detected a word at a time. The result is 'x' or
+ * 'z' if all the bits are X or Z, and 'X' or 'Z' if only some of them
+ * are. Return false if there are no X or Z bits.
+ */
+static bool xz_to_dec_str(const vvp_vector4_t&vec4, char *buf)
+{
+      const unsigned CHUNK = 8*sizeof(unsigned long);
+      bool any_x = false, any_z = false;
+      bool all_x = true, all_z = true;
+
+      for (unsigned adr = 0 ;  adr < vec4.size() ;  adr += CHUNK) {
+	    unsigned wid = vec4.size() - adr;
+	    if (wid > CHUNK) wid = CHUNK;
+	    unsigned long mask = wid < CHUNK? (1UL << wid) - 1 : -1UL;
+
+	    unsigned long abits, bbits;
+	    vec4.subword(adr, wid, abits, bbits);
+
+	    unsigned long xbits = abits & bbits;
+	    unsigned long zbits = ~abits & bbits;
+	    if (xbits) any_x = true;
+	    if (zbits) any_z = true;
+	    if (xbits != mask) all_x = false;
+	    if (zbits != mask) all_z = false;
+      }
+
+      if (all_x) {
+	    buf[0] = 'x';
+      } else if (any_x) {
+	    buf[0] = 'X';
+      } else if (all_z) {
+	    buf[0] = 'z';
+      } else if (any_z) {
+	    buf[0] = 'Z';
+      } else {
+	    return false;
+      }
+      buf[1] = 0;
+      return true;
+}
+
 unsigned vpip_vec4_to_dec_str(const vvp_vector4_t&vec4,
 			      char *buf, unsigned int nbuf,
 			      int signed_flag)
 {
-      unsigned int idx, len, vlen;
-      unsigned int mbits=vec4.size();   /* number of non-sign bits */
-      unsigned count_x = 0, count_z = 0;
+	/* An empty vector has nothing but X bits. */
+      if (vec4.size() == 0) {
+	    buf[0] = 'x';
+	    buf[1] = 0;
+	    return 0;
+      }
 
-      unsigned long val=0;
-      int comp=0;
-      if (signed_flag) {
-	    switch (vec4.value(vec4.size()-1)) {
-		case BIT4_X:
-		  count_x += 1;
-		  break;
-		case BIT4_Z:
-		  count_z += 1;
-		  break;
-		case BIT4_1:
-		  comp=1;
-		  break;
-		case BIT4_0:
-		  break;
-	    }
-	    mbits -= 1;
+      if (vec4.has_xz()) {
+	    bool rc = xz_to_dec_str(vec4, buf);
+	    assert(rc);
+	    return 0;
       }
+
+	/* A negative value is converted as its magnitude. The
+	   magnitude of the most negative value still fits in the
+	   unsigned vector. */
+      int comp = 0;
+      const vvp_vector4_t*val = &vec4;
+      vvp_vector4_t mag;
+      if (signed_flag && vec4.size() > 0
+	  && vec4.value(vec4.size()-1) == BIT4_1) {
+	    comp = 1;
+	    mag = vvp_vector4_t(vec4, true);
+	    mag += (int64_t) 1;
+	    val = &mag;
+      }
+
+      unsigned int mbits = val->size();
       assert(mbits<(UINT_MAX-92)/28);
-      vlen = ((mbits*28+92)/93+BDIGITS-1)/BDIGITS;
-	/* printf("vlen=%d\n",vlen); */
+      unsigned int vlen = ((mbits*28+92)/93+BDIGITS-1)/BDIGITS;
+      unsigned int vused = 0;
 
 #define ALLOC_MARGIN 4
       if (!valv || vlen > vlen_alloc) {
 	    if (valv) free(valv);
 	    valv = (unsigned long*) calloc(vlen+ALLOC_MARGIN, sizeof (*valv));
 	    vlen_alloc=vlen+ALLOC_MARGIN;
-      } else {
-	    memset(valv,0,vlen*sizeof(valv[0]));
       }
 
-      for (idx = 0; idx < mbits; idx += 1) {
-	      /* printf("%c ",bits[mbits-idx-1]); */
-	    switch (vec4.value(mbits-idx-1)) {
-		case BIT4_Z:
-		  count_z += 1;
-		  break;
-		case BIT4_X:
-		  count_x += 1;
-		  break;
-		case BIT4_1:
-		  if (! comp)
-			val += 1;
-		  break;
-		case BIT4_0:
-		  if (comp)
-			val += 1;
-		  break;
-	    }
-
-	    if ((mbits-idx-1)%BBITS==0) {
-		    /* make negative 2's complement, not 1's complement */
-		  if (comp && idx==mbits-1) ++val;
-		  shift_in(valv,vlen,val);
-		  val=0;
-	    } else {
-		  val=val+val;
+	/* Shift the value in BBITS at a time, most significant bits
+	   first. The chunks are aligned to the LSB, so the first one
+	   may be short. */
+      if (mbits > 0) {
+	    unsigned adr = ((mbits-1)/BBITS)*BBITS;
+	    for (;;) {
+		  unsigned wid = mbits - adr;
+		  if (wid > BBITS) wid = BBITS;
+		  unsigned long abits, bbits;
+		  val->subword(adr, wid, abits, bbits);
+		  shift_in(valv, vused, vlen, abits);
+		  if (adr == 0) break;
+		  adr -= BBITS;
 	    }
       }
 
-	if (count_x == vec4.size()) {
-	      len = 1;
-	      buf[0] = 'x';
-	      buf[1] = 0;
-	} else if (count_x > 0) {
-	      len = 1;
-	      buf[0] = 'X';
-	      buf[1] = 0;
-	} else if (count_z == vec4.size()) {
-	      len = 1;
-	      buf[0] = 'z';
-	      buf[1] = 0;
-	} else if (count_z > 0) {
-	      len = 1;
-	      buf[0] = 'Z';
-	      buf[1] = 0;
-	} else {
-	      int i;
-	      int zero_suppress=1;
-	      if (comp) {
-		    *buf++='-';
-		    nbuf--;
-		      /* printf("-"); */
-	      }
-	      for (i=vlen-1; i>=0; i--) {
-		    zero_suppress = write_digits(valv[i],
-						 &buf,&nbuf,zero_suppress);
-		      /* printf(",%.4u",valv[i]); */
-	      }
-		/* Awkward special case, since we don't want to
-		 * zero suppress down to nothing at all.  The only
-		 * way we can still have zero_suppress on in the
-		 * comp=1 case is if mbits==0, and therefore vlen==0.
-		 * We represent 1'sb1 as "-1". */
-	      if (zero_suppress) *buf++='0'+comp;
-		/* printf("\n"); */
-	      *buf='\0';
-	}
-	return 0;
+      int zero_suppress=1;
+      if (comp) {
+	    *buf++='-';
+	    nbuf--;
+      }
+      for (int i=vused-1; i>=0; i--) {
+	    zero_suppress = write_digits(valv[i], &buf, &nbuf, zero_suppress);
+      }
+	/* Don't zero suppress down to nothing at all. */
+      if (zero_suppress) *buf++='0';
+      *buf='\0';
+      return 0;
 }
 
 void vpip_dec_str_to_vec4(vvp_vector4_t&vec, const char*buf)
@@ -267,69 +284,80 @@ void vpip_dec_str_to_vec4(vvp_vector4_t&vec, const char*buf)
 	    return;
       }
 
-	/* The str string is the decimal value with the least
-	   significant digit first. This loop creates that string by
-	   reversing the order of the buf string. For example, if the
-	   input is "1234", str gets "4321". */
+	/* Check the digits from the least significant end. A "-" is
+	   only allowed at the head of the string. */
       unsigned slen = strlen(buf);
-      char*str = new char[slen + 1];
       bool is_negative = false;
-      for (unsigned idx = 0 ;  idx < slen ;  idx += 1) {
-	    if (idx == slen-1 && buf[slen-idx-1] == '-') {
-	          is_negative = true;
-		  slen--;
+      unsigned ndigits = 0;
+      for (unsigned idx = slen ;  idx > 0 ;  idx -= 1) {
+	    char ch = buf[idx-1];
+	    if (ch == '_')
+		  continue;
+	    if (idx == 1 && ch == '-') {
+		  is_negative = true;
 		  continue;
 	    }
-	    while (buf[slen-idx-1] == '_') {
-		  slen--;
-	    }
-	    if (isdigit(buf[slen-idx-1]))
-		  str[idx] = buf[slen-idx-1];
-            else {
+	    if (! isdigit(ch)) {
 		    /* Return "x" if there are invalid digits in the string. */
 		  fprintf(stderr, "Warning: Invalid decimal digit %c(%d) in "
-		          "\"%s.\"\n", buf[slen-idx-1], buf[slen-idx-1], buf);
+		          "\"%s.\"\n", ch, ch, buf);
 		  for (unsigned jdx = 0 ;  jdx < vec.size() ;  jdx += 1) {
 			vec.set_bit(jdx, BIT4_X);
 		  }
 		  return;
-            }
+	    }
+	    ndigits += 1;
       }
 
-      str[slen] = 0;
-
-      for (unsigned idx = 0 ;  idx < vec.size() ;  idx += 1) {
-	    vvp_bit4_t val4 = BIT4_0;
+	/* Accumulate the value into 32bit limbs, up to 9 decimal
+	   digits at a time. Only the low vec.size() bits are needed,
+	   so carries out of the top limb are dropped. */
+      const unsigned LIMB_BITS = 32;
+      const unsigned long WORD_BITS = 8*sizeof(unsigned long);
+      unsigned nlimbs = (vec.size() + LIMB_BITS - 1) / LIMB_BITS;
+      if (nlimbs == 0) nlimbs = 1;
+      uint32_t*limbs = new uint32_t[nlimbs];
+      for (unsigned idx = 0 ;  idx < nlimbs ;  idx += 1)
+	    limbs[idx] = 0;
 
-	    switch (str[0]) {
-		case '1':
-		case '3':
-		case '5':
-		case '7':
-		case '9':
-		  val4 = BIT4_1;
-		  break;
+      const char*cp = buf;
+      while (ndigits > 0) {
+	    uint32_t chunk = 0, mul = 1;
+	    for (unsigned cnt = 0 ;  cnt < 9 && ndigits > 0 ;  cp += 1) {
+		  if (! isdigit(*cp))
+			continue;
+		  chunk = chunk*10 + (*cp - '0');
+		  mul *= 10;
+		  cnt += 1;
+		  ndigits -= 1;
 	    }
 
-	    vec.set_bit(idx, val4);
-
-	      /* Divide the str string by 2 in decimal. */
-	    char*cp = str;
-	    while (*cp) {
-		  unsigned val = cp[0] - '0';
-		  if ((val&1) && (cp > str))
-			cp[-1] += 5;
-
-		  cp[0] = '0' + val/2;
-		  cp += 1;
+	    uint64_t carry = chunk;
+	    for (unsigned idx = 0 ;  idx < nlimbs ;  idx += 1) {
+		  uint64_t tmp = (uint64_t)limbs[idx] * mul + carry;
+		  limbs[idx] = (uint32_t) tmp;
+		  carry = tmp >> LIMB_BITS;
 	    }
+      }
 
+	/* Pack the limbs into words of the vector. */
+      unsigned nwords = (nlimbs*LIMB_BITS + WORD_BITS - 1) / WORD_BITS;
+      unsigned long*words = new unsigned long[nwords];
+      for (unsigned idx = 0 ;  idx < nwords ;  idx += 1)
+	    words[idx] = 0;
+      for (unsigned idx = 0 ;  idx < nlimbs ;  idx += 1) {
+	    unsigned long tmp = limbs[idx];
+	    words[idx*LIMB_BITS/WORD_BITS] |= tmp << (idx*LIMB_BITS%WORD_BITS);
       }
 
+      if (vec.size() > 0)
+	    vec.setarray(0, vec.size(), words);
+
+      delete[]words;
+      delete[]limbs;
+
       if (is_negative) {
             vec.invert();
             vec += (int64_t) 1;
       }
-
-      delete[]str;
 }
@@ -25,6 +25,8 @@
 # include  "event.h"
 # include  "vpi_priv.h"
 # include  "vvp_net_sig.h"
+# include  "checkpoint.h"
+# include  "lazy.h"
 #ifdef CHECK_WITH_VALGRIND
 # include  "vvp_cleanup.h"
 #endif
@@ -37,6 +39,7 @@
 
 # include  <iostream>
 # include  <cstdio>
+# include  <vector>
 
 /* This is the size of an unsigned long in bits. This is just a
    convenience macro. */
@@ -119,6 +122,13 @@ struct vthread_s {
       struct __vpiScope*parent_scope;
 	/* This is used for keeping wait queues. */
       struct vthread_s*wait_next;
+	/* The event of my %wait/p, and the link in its list of
+	   persistent waiters. The pwait_armed flag is set while I am
+	   actually waiting at the %wait/p. */
+      waitable_hooks_s*pwait_hooks;
+      vvp_net_t*pwait_net;
+      struct vthread_s*pwait_next;
+      unsigned pwait_armed :1;
 	/* These are used to access automatically allocated items. */
       vvp_context_t wt_context, rd_context;
 	/* These are used to pass non-blocking event control information. */
@@ -156,6 +166,33 @@ static inline void thr_put_bit(struct vthread_s*thr,
       thr->bits4.set_bit(addr, val);
 }
 
+/*
+ * The bitwise, reduction and compare instructions work on the thread
+ * bits a word at a time. This gets the wid (no more than a CPU word)
+ * bits starting at addr into the low bits of the abits and bbits
+ * words, encoded as in vvp_vector4_t. The addresses 0-3 are the
+ * constant bits, which are replicated across the word.
+ */
+static inline unsigned long word_mask(unsigned wid)
+{
+      return wid < CPU_WORD_BITS? (1UL << wid) - 1 : -1UL;
+}
+
+static inline void thr_get_word(struct vthread_s*thr, unsigned addr,
+				unsigned wid, unsigned long&abits,
+				unsigned long&bbits)
+{
+      if (addr >= 4) {
+	    thr->bits4.subword(addr, wid, abits, bbits);
+	    return;
+      }
+
+      unsigned long mask = word_mask(wid);
+      vvp_bit4_t val = thr_index_to_bit4[addr];
+      abits = (val == BIT4_1 || val == BIT4_X)? mask : 0;
+      bbits = bit4_is_xz(val)? mask : 0;
+}
+
 // REMOVE ME
 static inline void thr_clr_bit_(struct vthread_s*thr, unsigned addr)
 {
@@ -242,6 +279,13 @@ static vvp_vector4_t vthread_bits_to_vector(struct vthread_s*thr,
       }
 }
 
+vvp_vector4_t vthread_get_vec4(struct vthread_s*thr,
+			       unsigned addr, unsigned wid)
+{
+      if (vpi_mode_flag == VPI_MODE_COMPILETF) return vvp_vector4_t(wid, BIT4_X);
+      else return vthread_bits_to_vector(thr, addr, wid);
+}
+
 /*
  * Some of the instructions do wide addition to arrays of long. They
  * use this add_with_cary function to help.
@@ -406,6 +450,10 @@ vthread_t vthread_new(vvp_code_t pc, struct __vpiScope*scope)
       thr->wait_next = 0;
       thr->wt_context = 0;
       thr->rd_context = 0;
+      thr->pwait_hooks = 0;
+      thr->pwait_net = 0;
+      thr->pwait_next = 0;
+      thr->pwait_armed = 0;
 
       thr->schedule_parent_on_end = 0;
       thr->is_scheduled = 0;
@@ -501,10 +549,119 @@ static void vthread_reap(vthread_t thr)
 
 void vthread_delete(vthread_t thr)
 {
+      if (waitable_hooks_s*ep = thr->pwait_hooks) {
+	    vthread_t*cur = &ep->persistent_threads;
+	    while (*cur != thr)
+		  cur = &(*cur)->pwait_next;
+	    *cur = thr->pwait_next;
+      }
+
       thr->bits4 = vvp_vector4_t();
       delete thr;
 }
 
+/*
+ * Checkpoint support. A thread is saved with all its registers and
+ * links. Threads that are running in automatic scopes cannot be
+ * saved because the contexts are not saved.
+ */
+void vthread_save_state(vvp_checkpoint_out&out, vthread_t thr)
+{
+      if (thr->wt_context || thr->rd_context)
+	    out.refuse("a thread is using an automatic task or function");
+
+      out.put_code(thr->pc);
+      out.put_vec4(thr->bits4);
+      for (unsigned idx = 0 ;  idx < 16 ;  idx += 1)
+	    out.put_u64(thr->words[idx].w_uint);
+
+      out.put_u8(thr->schedule_parent_on_end
+		 | thr->i_have_ended << 1
+		 | thr->waiting_for_event << 2
+		 | thr->is_scheduled << 3
+		 | thr->delay_delete << 4);
+      out.put_u8(thr->fork_count);
+
+      out.put_thread(thr->child);
+      out.put_thread(thr->parent);
+      out.put_scope(thr->parent_scope);
+      out.put_thread(thr->wait_next);
+      out.put_net(thr->event);
+      out.put_u64(thr->ecount);
+}
+
+vthread_t vthread_restore_new(void)
+{
+      vthread_t thr = new struct vthread_s;
+      thr->pc = codespace_null();
+      for (unsigned idx = 0 ;  idx < 16 ;  idx += 1)
+	    thr->words[idx].w_uint = 0;
+      thr->schedule_parent_on_end = 0;
+      thr->i_have_ended = 0;
+      thr->waiting_for_event = 0;
+      thr->is_scheduled = 0;
+      thr->delay_delete = 0;
+      thr->fork_count = 0;
+      thr->child = 0;
+      thr->parent = 0;
+      thr->parent_scope = 0;
+      thr->wait_next = 0;
+      thr->wt_context = 0;
+      thr->rd_context = 0;
+      thr->event = 0;
+      thr->ecount = 0;
+      return thr;
+}
+
+void vthread_restore_state(vvp_checkpoint_in&in, vthread_t thr)
+{
+      thr->pc = in.get_code();
+      thr->bits4 = in.get_vec4();
+      for (unsigned idx = 0 ;  idx < 16 ;  idx += 1)
+	    thr->words[idx].w_uint = in.get_u64();
+
+      unsigned flags = in.get_u8();
+      thr->schedule_parent_on_end = (flags & 1)? 1 : 0;
+      thr->i_have_ended      = (flags & 2)? 1 : 0;
+      thr->waiting_for_event = (flags & 4)? 1 : 0;
+      thr->is_scheduled      = (flags & 8)? 1 : 0;
+      thr->delay_delete      = (flags & 16)? 1 : 0;
+      thr->fork_count = in.get_u8();
+
+      thr->child = in.get_thread();
+      thr->parent = in.get_thread();
+      thr->parent_scope = in.get_scope();
+      thr->wait_next = in.get_thread();
+      thr->event = in.get_net();
+      thr->ecount = in.get_u64();
+
+      if (thr->pc == 0 || thr->parent_scope == 0)
+	    in.error("invalid thread record");
+}
+
+/*
+ * Remove all the threads from the scopes, collecting them into the
+ * threads set so that the caller can delete them. The set may already
+ * hold threads taken from the event queue, and those may be the heads
+ * of lists of threads that were woken together, so follow the
+ * wait_next links as well.
+ */
+void vthreads_clear(const std::vector<struct __vpiScope*>&scopes,
+		    std::set<vthread_t>&threads)
+{
+      for (unsigned idx = 0 ;  idx < scopes.size() ;  idx += 1) {
+	    struct __vpiScope*scope = scopes[idx];
+	    threads.insert(scope->threads.begin(), scope->threads.end());
+	    scope->threads.clear();
+      }
+
+      std::vector<vthread_t> heads (threads.begin(), threads.end());
+      for (unsigned idx = 0 ;  idx < heads.size() ;  idx += 1) {
+	    for (vthread_t thr = heads[idx]->wait_next ; thr ; thr = thr->wait_next)
+		  threads.insert(thr);
+      }
+}
+
 void vthread_mark_scheduled(vthread_t thr)
 {
       while (thr != 0) {
@@ -579,6 +736,46 @@ void vthread_schedule_list(vthread_t thr)
       schedule_vthread(thr, 0);
 }
 
+/*
+ * The events that have persistent waiters, so that they can all be
+ * flushed before a checkpoint.
+ */
+static std::vector<waitable_hooks_s*> persistent_hooks;
+
+vthread_t vthread_wake_persistent(vthread_t persist, vthread_t list)
+{
+      for (vthread_t cur = persist ;  cur ;  cur = cur->pwait_next) {
+	    if (! cur->pwait_armed)
+		  continue;
+	    cur->pwait_armed = 0;
+	    cur->wait_next = list;
+	    list = cur;
+      }
+
+      return list;
+}
+
+void vthread_flush_persistent(void)
+{
+      for (unsigned idx = 0 ;  idx < persistent_hooks.size() ;  idx += 1) {
+	    waitable_hooks_s*ep = persistent_hooks[idx];
+	    vthread_t thr = ep->persistent_threads;
+	    ep->persistent_threads = 0;
+
+	    while (thr) {
+		  vthread_t next = thr->pwait_next;
+		  if (thr->pwait_armed)
+			thr->wait_next = ep->add_waiting_thread(thr);
+		  thr->pwait_hooks = 0;
+		  thr->pwait_net = 0;
+		  thr->pwait_next = 0;
+		  thr->pwait_armed = 0;
+		  thr = next;
+	    }
+      }
+      persistent_hooks.clear();
+}
+
 vvp_context_t vthread_get_wt_context()
 {
       if (running_thread)
@@ -628,47 +825,112 @@ bool of_ALLOC(vthread_t thr, vvp_code_t cp)
       return true;
 }
 
-static bool of_AND_wide(vthread_t thr, vvp_code_t cp)
+/*
+ * The bitwise instructions combine the operands a word at a time with
+ * this loop. The OP class supplies the operation on the abits/bbits
+ * words of the operands. The left operand is also the destination.
+ */
+template <class OP> static bool of_bitwise_(vthread_t thr, vvp_code_t cp)
 {
       unsigned idx1 = cp->bit_idx[0];
       unsigned idx2 = cp->bit_idx[1];
       unsigned wid = cp->number;
 
-      vvp_vector4_t val = vthread_bits_to_vector(thr, idx1, wid);
-      val &= vthread_bits_to_vector(thr, idx2, wid);
-      thr->bits4.set_vec(idx1, val);
+      assert(idx1 >= 4);
+      if (wid == 0)
+	    return true;
+      thr_check_addr(thr, idx1+wid-1);
+
+      for (unsigned off = 0 ;  off < wid ;  off += CPU_WORD_BITS) {
+	    unsigned cnt = wid - off;
+	    if (cnt > CPU_WORD_BITS)
+		  cnt = CPU_WORD_BITS;
+
+	    unsigned long la, lb, ra, rb;
+	    thr->bits4.subword(idx1+off, cnt, la, lb);
+	    thr_get_word(thr, idx2 < 4? idx2 : idx2+off, cnt, ra, rb);
+	    OP::op(la, lb, ra, rb);
+	    thr->bits4.setword(idx1+off, cnt, la, lb);
+      }
 
       return true;
 }
 
-static bool of_AND_narrow(vthread_t thr, vvp_code_t cp)
+/*
+ * Make the result words from the masks of the bits that are 1 and
+ * the bits that are 0. All the other bits are X.
+ */
+static inline void bit4_word_result(unsigned long&abits, unsigned long&bbits,
+				    unsigned long one, unsigned long zero)
 {
-      unsigned idx1 = cp->bit_idx[0];
-      unsigned idx2 = cp->bit_idx[1];
-      unsigned wid = cp->number;
+      unsigned long xz = ~(one | zero);
+      abits = one | xz;
+      bbits = xz;
+}
 
-      for (unsigned idx = 0 ; idx < wid ; idx += 1) {
-	    vvp_bit4_t lb = thr_get_bit(thr, idx1);
-	    vvp_bit4_t rb = thr_get_bit(thr, idx2);
-	    thr_put_bit(thr, idx1, lb&rb);
-	    idx1 += 1;
-	    if (idx2 >= 4)
-		  idx2 += 1;
+struct bit4_and_op {
+      static void op(unsigned long&la, unsigned long&lb,
+		     unsigned long ra, unsigned long rb)
+      {
+	    unsigned long one  = (la & ~lb) & (ra & ~rb);
+	    unsigned long zero = (~la & ~lb) | (~ra & ~rb);
+	    bit4_word_result(la, lb, one, zero);
       }
+};
 
-      return true;
-}
+struct bit4_nand_op {
+      static void op(unsigned long&la, unsigned long&lb,
+		     unsigned long ra, unsigned long rb)
+      {
+	    unsigned long zero = (la & ~lb) & (ra & ~rb);
+	    unsigned long one  = (~la & ~lb) | (~ra & ~rb);
+	    bit4_word_result(la, lb, one, zero);
+      }
+};
 
-bool of_AND(vthread_t thr, vvp_code_t cp)
-{
-      assert(cp->bit_idx[0] >= 4);
+struct bit4_or_op {
+      static void op(unsigned long&la, unsigned long&lb,
+		     unsigned long ra, unsigned long rb)
+      {
+	    unsigned long one  = (la & ~lb) | (ra & ~rb);
+	    unsigned long zero = (~la & ~lb) & (~ra & ~rb);
+	    bit4_word_result(la, lb, one, zero);
+      }
+};
 
-      if (cp->number <= 4)
-	    cp->opcode = &of_AND_narrow;
-      else
-	    cp->opcode = &of_AND_wide;
+struct bit4_nor_op {
+      static void op(unsigned long&la, unsigned long&lb,
+		     unsigned long ra, unsigned long rb)
+      {
+	    unsigned long zero = (la & ~lb) | (ra & ~rb);
+	    unsigned long one  = (~la & ~lb) & (~ra & ~rb);
+	    bit4_word_result(la, lb, one, zero);
+      }
+};
+
+struct bit4_xor_op {
+      static void op(unsigned long&la, unsigned long&lb,
+		     unsigned long ra, unsigned long rb)
+      {
+	    unsigned long xz = lb | rb;
+	    la = (la ^ ra) | xz;
+	    lb = xz;
+      }
+};
 
-      return cp->opcode(thr, cp);
+struct bit4_xnor_op {
+      static void op(unsigned long&la, unsigned long&lb,
+		     unsigned long ra, unsigned long rb)
+      {
+	    unsigned long xz = lb | rb;
+	    la = ~(la ^ ra) | xz;
+	    lb = xz;
+      }
+};
+
+bool of_AND(vthread_t thr, vvp_code_t cp)
+{
+      return of_bitwise_<bit4_and_op>(thr, cp);
 }
 
 
@@ -1284,6 +1546,7 @@ bool of_CASSIGN_LINK(vthread_t, vvp_code_t cp)
 {
       vvp_net_t*dst = cp->net;
       vvp_net_t*src = cp->net2;
+      lazy_observe(src);
 
       vvp_fun_signal_base*sig
 	    = dynamic_cast<vvp_fun_signal_base*>(dst->fun);
@@ -1413,67 +1676,125 @@ bool of_CAST2(vthread_t thr, vvp_code_t cp)
       return true;
 }
 
-bool of_CMPS(vthread_t thr, vvp_code_t cp)
-{
-      vvp_bit4_t eq  = BIT4_1;
-      vvp_bit4_t eeq = BIT4_1;
-      vvp_bit4_t lt  = BIT4_0;
+/*
+ * The vector compare instructions scan the operands a word at a time
+ * and collect the summary of the differences here. The diff member
+ * collects the bits that are known (0 or 1) in both operands but are
+ * different, and the xz member the bits that are x or z in either
+ * operand. The neq flag is set if any bits are not identical, and
+ * the lt flag is the unsigned compare of the abits, which is only
+ * meaningful if there are no xz bits.
+ */
+struct cmp_scan_s {
+      unsigned long diff, xz;
+      bool neq, lt;
+};
 
-      unsigned idx1 = cp->bit_idx[0];
-      unsigned idx2 = cp->bit_idx[1];
+static inline void cmp_scan_init(struct cmp_scan_s&res)
+{
+      res.diff = 0;
+      res.xz = 0;
+      res.neq = false;
+      res.lt = false;
+}
 
-      const unsigned end1 = (idx1 < 4)? idx1 : idx1 + cp->number - 1;
-      const unsigned end2 = (idx2 < 4)? idx2 : idx2 + cp->number - 1;
+static inline void cmp_scan_word(struct cmp_scan_s&res,
+				 unsigned long la, unsigned long lb,
+				 unsigned long ra, unsigned long rb)
+{
+      res.diff |= (la ^ ra) & ~(lb | rb);
+      res.xz |= lb | rb;
+      if (la != ra || lb != rb)
+	    res.neq = true;
+	/* The words are scanned from the LSB up, so the most
+	   significant word that differs sets the lt flag last. */
+      if (la != ra)
+	    res.lt = la < ra;
+}
 
-      if (end1 > end2)
-	    thr_check_addr(thr, end1);
-      else
-	    thr_check_addr(thr, end2);
+static void thr_cmp_scan(vthread_t thr, unsigned idx1, unsigned idx2,
+			 unsigned wid, struct cmp_scan_s&res)
+{
+      cmp_scan_init(res);
+      for (unsigned off = 0 ;  off < wid ;  off += CPU_WORD_BITS) {
+	    unsigned cnt = wid - off;
+	    if (cnt > CPU_WORD_BITS)
+		  cnt = CPU_WORD_BITS;
 
-      const vvp_bit4_t sig1 = thr_get_bit(thr, end1);
-      const vvp_bit4_t sig2 = thr_get_bit(thr, end2);
+	    unsigned long la, lb, ra, rb;
+	    thr_get_word(thr, idx1 < 4? idx1 : idx1+off, cnt, la, lb);
+	    thr_get_word(thr, idx2 < 4? idx2 : idx2+off, cnt, ra, rb);
+	    cmp_scan_word(res, la, lb, ra, rb);
+      }
+}
 
-      for (unsigned idx = 0 ;  idx < cp->number ;  idx += 1) {
-	    vvp_bit4_t lv = thr_get_bit(thr, idx1);
-	    vvp_bit4_t rv = thr_get_bit(thr, idx2);
-
-	    if (lv > rv) {
-		  lt  = BIT4_0;
-		  eeq = BIT4_0;
-	    } else if (lv < rv) {
-		  lt  = BIT4_1;
-		  eeq = BIT4_0;
-	    }
-	    if (eq != BIT4_X) {
-		  if ((lv == BIT4_0) && (rv != BIT4_0))
-			eq = BIT4_0;
-		  if ((lv == BIT4_1) && (rv != BIT4_1))
-			eq = BIT4_0;
-		  if (bit4_is_xz(lv) || bit4_is_xz(rv))
-			eq = BIT4_X;
-	    }
+/*
+ * The immediate value of the %cmpi instructions is unsigned, so it
+ * only fills the first word of the compare.
+ */
+static void thr_cmpi_scan(vthread_t thr, unsigned idx1, unsigned long imm,
+			  unsigned wid, struct cmp_scan_s&res)
+{
+      cmp_scan_init(res);
+      for (unsigned off = 0 ;  off < wid ;  off += CPU_WORD_BITS) {
+	    unsigned cnt = wid - off;
+	    if (cnt > CPU_WORD_BITS)
+		  cnt = CPU_WORD_BITS;
 
-	    if (idx1 >= 4) idx1 += 1;
-	    if (idx2 >= 4) idx2 += 1;
+	    unsigned long la, lb;
+	    thr_get_word(thr, idx1 < 4? idx1 : idx1+off, cnt, la, lb);
+	    unsigned long ra = off == 0? imm & word_mask(cnt) : 0;
+	    cmp_scan_word(res, la, lb, ra, 0);
       }
+}
 
-      if (eq == BIT4_X)
-	    lt = BIT4_X;
-      else if ((sig1 == BIT4_1) && (sig2 == BIT4_0))
-	    lt = BIT4_1;
-      else if ((sig1 == BIT4_0) && (sig2 == BIT4_1))
-	    lt = BIT4_0;
+static inline void thr_cmp_check_addr(vthread_t thr, unsigned idx,
+				      unsigned wid)
+{
+      if (idx >= 4 && wid > 0)
+	    thr_check_addr(thr, idx+wid-1);
+}
 
-	/* Correct the lt bit to account for the sign of the parameters. */
-      if (lt != BIT4_X) {
-	      /* If the first is negative and the last positive, then
-		 a < b for certain. */
+/*
+ * Get the sign bit of a vector operand.
+ */
+static inline vvp_bit4_t thr_cmp_sign(vthread_t thr, unsigned idx,
+				      unsigned wid)
+{
+      if (idx < 4 || wid == 0)
+	    return thr_index_to_bit4[idx < 4? idx : 0];
+      return thr_get_bit(thr, idx+wid-1);
+}
+
+bool of_CMPS(vthread_t thr, vvp_code_t cp)
+{
+      unsigned idx1 = cp->bit_idx[0];
+      unsigned idx2 = cp->bit_idx[1];
+      unsigned wid  = cp->number;
+
+      thr_cmp_check_addr(thr, idx1, wid);
+      thr_cmp_check_addr(thr, idx2, wid);
+
+      struct cmp_scan_s res;
+      thr_cmp_scan(thr, idx1, idx2, wid, res);
+
+      vvp_bit4_t eq  = res.xz? BIT4_X : res.diff? BIT4_0 : BIT4_1;
+      vvp_bit4_t eeq = res.neq? BIT4_0 : BIT4_1;
+      vvp_bit4_t lt  = res.lt? BIT4_1 : BIT4_0;
+
+      if (eq == BIT4_X) {
+	    lt = BIT4_X;
+      } else {
+	      /* Correct the lt bit to account for the sign of the
+		 parameters. If the first is negative and the last
+		 positive, then a < b for certain. If the first is
+		 positive and the last negative, then a > b for
+		 certain. */
+	    const vvp_bit4_t sig1 = thr_cmp_sign(thr, idx1, wid);
+	    const vvp_bit4_t sig2 = thr_cmp_sign(thr, idx2, wid);
 	    if ((sig1 == BIT4_1) && (sig2 == BIT4_0))
 		  lt = BIT4_1;
-
-	      /* If the first is positive and the last negative, then
-		 a > b for certain. */
-	    if ((sig1 == BIT4_0) && (sig2 == BIT4_1))
+	    else if ((sig1 == BIT4_0) && (sig2 == BIT4_1))
 		  lt = BIT4_0;
       }
 
@@ -1486,44 +1807,24 @@ bool of_CMPS(vthread_t thr, vvp_code_t cp)
 
 bool of_CMPIS(vthread_t thr, vvp_code_t cp)
 {
-      vvp_bit4_t eq  = BIT4_1;
-      vvp_bit4_t eeq = BIT4_1;
-      vvp_bit4_t lt  = BIT4_0;
-
       unsigned idx1 = cp->bit_idx[0];
-      unsigned imm  = cp->bit_idx[1];
-
-      const unsigned end1 = (idx1 < 4)? idx1 : idx1 + cp->number - 1;
-      thr_check_addr(thr, end1);
-      const vvp_bit4_t sig1 = thr_get_bit(thr, end1);
+      unsigned long imm = cp->bit_idx[1];
+      unsigned wid  = cp->number;
 
-      for (unsigned idx = 0 ;  idx < cp->number ;  idx += 1) {
-	    vvp_bit4_t lv = thr_get_bit(thr, idx1);
-	    vvp_bit4_t rv = (imm & 1)? BIT4_1 : BIT4_0;
-	    imm >>= 1;
+      thr_cmp_check_addr(thr, idx1, wid);
 
-	    if (lv > rv) {
-		  lt = BIT4_0;
-		  eeq = BIT4_0;
-	    } else if (lv < rv) {
-		  lt = BIT4_1;
-		  eeq = BIT4_0;
-	    }
-	    if (eq != BIT4_X) {
-		  if ((lv == BIT4_0) && (rv != BIT4_0))
-			eq = BIT4_0;
-		  if ((lv == BIT4_1) && (rv != BIT4_1))
-			eq = BIT4_0;
-		  if (bit4_is_xz(lv) || bit4_is_xz(rv))
-			eq = BIT4_X;
-	    }
+      struct cmp_scan_s res;
+      thr_cmpi_scan(thr, idx1, imm, wid, res);
 
-	    if (idx1 >= 4) idx1 += 1;
-      }
+      vvp_bit4_t eq  = res.xz? BIT4_X : res.diff? BIT4_0 : BIT4_1;
+      vvp_bit4_t eeq = res.neq? BIT4_0 : BIT4_1;
+      vvp_bit4_t lt  = res.lt? BIT4_1 : BIT4_0;
 
+	/* The immediate value is positive, so if the vector is
+	   negative it is certainly less. */
       if (eq == BIT4_X)
 	    lt = BIT4_X;
-      else if (sig1 == BIT4_1)
+      else if (thr_cmp_sign(thr, idx1, wid) == BIT4_1)
 	    lt = BIT4_1;
 
       thr_put_bit(thr, 4, eq);
@@ -1534,155 +1835,63 @@ bool of_CMPIS(vthread_t thr, vvp_code_t cp)
 }
 
 /*
- * The of_CMPIU below punts to this function if there are any xz bits
- * in the vector part of the instruction. In this case we know that
- * there is at least 1 xz bit in the left expression (and there are
- * none in the imm value) so the eeq result must be false. Otherwise,
- * the eq result may me 0 or x, and the lt bit is x.
+ * If there are xz bits in the vector part of %cmpi/u, then we know
+ * that the eeq result must be false (the imm value cannot have xz
+ * bits). The eq result may be 0 or x, and the lt bit is x.
  */
-static bool of_CMPIU_the_hard_way(vthread_t thr, vvp_code_t cp)
-{
-
-      unsigned idx1 = cp->bit_idx[0];
-      unsigned long imm  = cp->bit_idx[1];
-      unsigned wid  = cp->number;
-      if (idx1 >= 4)
-	    thr_check_addr(thr, idx1+wid-1);
-
-      vvp_bit4_t lv = thr_get_bit(thr, idx1);
-      vvp_bit4_t eq  = BIT4_1;
-      for (unsigned idx = 0 ;  idx < wid ;  idx += 1) {
-	    vvp_bit4_t rv = (imm & 1UL)? BIT4_1 : BIT4_0;
-	    imm >>= 1UL;
-
-	    if (bit4_is_xz(lv)) {
-		  eq = BIT4_X;
-	    } else if (lv != rv) {
-		  eq = BIT4_0;
-		  break;
-	    }
-
-	    if (idx1 >= 4) {
-		  idx1 += 1;
-		  if ((idx+1) < wid)
-			lv = thr_get_bit(thr, idx1);
-	    }
-      }
-
-      thr_put_bit(thr, 4, eq);
-      thr_put_bit(thr, 5, BIT4_X);
-      thr_put_bit(thr, 6, BIT4_0);
-
-      return true;
-}
-
 bool of_CMPIU(vthread_t thr, vvp_code_t cp)
 {
-      unsigned addr = cp->bit_idx[0];
-      unsigned long imm  = cp->bit_idx[1];
+      unsigned idx1 = cp->bit_idx[0];
+      unsigned long imm = cp->bit_idx[1];
       unsigned wid  = cp->number;
 
-      unsigned long*array = vector_to_array(thr, addr, wid);
-	// If there are xz bits in the right hand expression, then we
-	// have to do the compare the hard way. That is because even
-	// though we know that eeq must be false (the immediate value
-	// cannot have x or z bits) we don't know what the EQ or LT
-	// bits will be.
-      if (array == 0)
-	    return of_CMPIU_the_hard_way(thr, cp);
+      thr_cmp_check_addr(thr, idx1, wid);
 
-      unsigned words = (wid+CPU_WORD_BITS-1) / CPU_WORD_BITS;
-      vvp_bit4_t eq  = BIT4_1;
-      vvp_bit4_t lt  = BIT4_0;
-      for (unsigned idx = 0 ; idx < words ; idx += 1, imm = 0UL) {
-	    if (array[idx] == imm)
-		  continue;
+      struct cmp_scan_s res;
+      thr_cmpi_scan(thr, idx1, imm, wid, res);
 
-	    eq = BIT4_0;
-	    lt = (array[idx] < imm) ? BIT4_1 : BIT4_0;
+      if (res.xz) {
+	    thr_put_bit(thr, 4, res.diff? BIT4_0 : BIT4_X);
+	    thr_put_bit(thr, 5, BIT4_X);
+	    thr_put_bit(thr, 6, BIT4_0);
+	    return true;
       }
 
-      delete[]array;
-
+      vvp_bit4_t eq = res.diff? BIT4_0 : BIT4_1;
       thr_put_bit(thr, 4, eq);
-      thr_put_bit(thr, 5, lt);
+      thr_put_bit(thr, 5, res.lt? BIT4_1 : BIT4_0);
       thr_put_bit(thr, 6, eq);
-      return true;
-}
-
-bool of_CMPU_the_hard_way(vthread_t thr, vvp_code_t cp)
-{
-      vvp_bit4_t eq = BIT4_1;
-      vvp_bit4_t eeq = BIT4_1;
-
-      unsigned idx1 = cp->bit_idx[0];
-      unsigned idx2 = cp->bit_idx[1];
-
-      for (unsigned idx = 0 ;  idx < cp->number ;  idx += 1) {
-	    vvp_bit4_t lv = thr_get_bit(thr, idx1);
-	    vvp_bit4_t rv = thr_get_bit(thr, idx2);
-
-	    if (lv != rv)
-		  eeq = BIT4_0;
-
-	    if (eq==BIT4_1 && (bit4_is_xz(lv) || bit4_is_xz(rv)))
-		  eq = BIT4_X;
-	    if ((lv == BIT4_0) && (rv==BIT4_1))
-		  eq = BIT4_0;
-	    if ((lv == BIT4_1) && (rv==BIT4_0))
-		  eq = BIT4_0;
-
-	    if (eq == BIT4_0)
-		  break;
-
-	    if (idx1 >= 4) idx1 += 1;
-	    if (idx2 >= 4) idx2 += 1;
-
-      }
-
-      thr_put_bit(thr, 4, eq);
-      thr_put_bit(thr, 5, BIT4_X);
-      thr_put_bit(thr, 6, eeq);
 
       return true;
 }
 
+/*
+ * If there are xz bits in either operand of %cmp/u, then the eq
+ * result is 0 if some other bits are certainly different, and x
+ * otherwise. The lt result is x.
+ */
 bool of_CMPU(vthread_t thr, vvp_code_t cp)
 {
-      vvp_bit4_t eq = BIT4_1;
-      vvp_bit4_t lt = BIT4_0;
-
       unsigned idx1 = cp->bit_idx[0];
       unsigned idx2 = cp->bit_idx[1];
       unsigned wid  = cp->number;
 
-      unsigned long*larray = vector_to_array(thr, idx1, wid);
-      if (larray == 0) return of_CMPU_the_hard_way(thr, cp);
-
-      unsigned long*rarray = vector_to_array(thr, idx2, wid);
-      if (rarray == 0) {
-	    delete[]larray;
-	    return of_CMPU_the_hard_way(thr, cp);
-      }
-
-      unsigned words = (wid+CPU_WORD_BITS-1) / CPU_WORD_BITS;
+      thr_cmp_check_addr(thr, idx1, wid);
+      thr_cmp_check_addr(thr, idx2, wid);
 
-      for (unsigned wdx = 0 ; wdx < words ; wdx += 1) {
-	    if (larray[wdx] == rarray[wdx])
-		  continue;
+      struct cmp_scan_s res;
+      thr_cmp_scan(thr, idx1, idx2, wid, res);
 
-	    eq = BIT4_0;
-	    if (larray[wdx] < rarray[wdx])
-		  lt = BIT4_1;
-	    else
-		  lt = BIT4_0;
+      if (res.xz) {
+	    thr_put_bit(thr, 4, res.diff? BIT4_0 : BIT4_X);
+	    thr_put_bit(thr, 5, BIT4_X);
+	    thr_put_bit(thr, 6, res.neq? BIT4_0 : BIT4_1);
+	    return true;
       }
 
-      delete[]larray;
-      delete[]rarray;
-
+      vvp_bit4_t eq = res.diff? BIT4_0 : BIT4_1;
       thr_put_bit(thr, 4, eq);
-      thr_put_bit(thr, 5, lt);
+      thr_put_bit(thr, 5, res.lt? BIT4_1 : BIT4_0);
       thr_put_bit(thr, 6, eq);
 
       return true;
@@ -1690,25 +1899,18 @@ bool of_CMPU(vthread_t thr, vvp_code_t cp)
 
 bool of_CMPX(vthread_t thr, vvp_code_t cp)
 {
-      vvp_bit4_t eq = BIT4_1;
-
       unsigned idx1 = cp->bit_idx[0];
       unsigned idx2 = cp->bit_idx[1];
+      unsigned wid  = cp->number;
 
-      for (unsigned idx = 0 ;  idx < cp->number ;  idx += 1) {
-	    vvp_bit4_t lv = thr_get_bit(thr, idx1);
-	    vvp_bit4_t rv = thr_get_bit(thr, idx2);
+      thr_cmp_check_addr(thr, idx1, wid);
+      thr_cmp_check_addr(thr, idx2, wid);
 
-	    if ((lv != rv) && !bit4_is_xz(lv) && !bit4_is_xz(rv)) {
-		  eq = BIT4_0;
-		  break;
-	    }
+	/* x and z bits match anything. */
+      struct cmp_scan_s res;
+      thr_cmp_scan(thr, idx1, idx2, wid, res);
 
-	    if (idx1 >= 4) idx1 += 1;
-	    if (idx2 >= 4) idx2 += 1;
-      }
-
-      thr_put_bit(thr, 4, eq);
+      thr_put_bit(thr, 4, res.diff? BIT4_0 : BIT4_1);
 
       return true;
 }
@@ -1757,22 +1959,29 @@ bool of_CMPWU(vthread_t thr, vvp_code_t cp)
 
 bool of_CMPZ(vthread_t thr, vvp_code_t cp)
 {
-      vvp_bit4_t eq = BIT4_1;
-
       unsigned idx1 = cp->bit_idx[0];
       unsigned idx2 = cp->bit_idx[1];
+      unsigned wid  = cp->number;
 
-      for (unsigned idx = 0 ;  idx < cp->number ;  idx += 1) {
-	    vvp_bit4_t lv = thr_get_bit(thr, idx1);
-	    vvp_bit4_t rv = thr_get_bit(thr, idx2);
+      thr_cmp_check_addr(thr, idx1, wid);
+      thr_cmp_check_addr(thr, idx2, wid);
 
-	    if ((lv != BIT4_Z) && (rv != BIT4_Z) && (lv != rv)) {
+	/* z bits match anything, x bits only match x. */
+      vvp_bit4_t eq = BIT4_1;
+      for (unsigned off = 0 ;  off < wid ;  off += CPU_WORD_BITS) {
+	    unsigned cnt = wid - off;
+	    if (cnt > CPU_WORD_BITS)
+		  cnt = CPU_WORD_BITS;
+
+	    unsigned long la, lb, ra, rb;
+	    thr_get_word(thr, idx1 < 4? idx1 : idx1+off, cnt, la, lb);
+	    thr_get_word(thr, idx2 < 4? idx2 : idx2+off, cnt, ra, rb);
+	    unsigned long lz = ~la & lb;
+	    unsigned long rz = ~ra & rb;
+	    if (((la ^ ra) | (lb ^ rb)) & ~(lz | rz)) {
 		  eq = BIT4_0;
 		  break;
 	    }
-
-	    if (idx1 >= 4) idx1 += 1;
-	    if (idx2 >= 4) idx2 += 1;
       }
 
       thr_put_bit(thr, 4, eq);
@@ -2427,6 +2636,7 @@ bool of_FORCE_LINK(vthread_t, vvp_code_t cp)
 {
       vvp_net_t*dst = cp->net;
       vvp_net_t*src = cp->net2;
+      lazy_observe(src);
 
       assert(dst->fil);
       dst->fil->force_link(dst, src);
@@ -2570,43 +2780,30 @@ bool of_FREE(vthread_t thr, vvp_code_t cp)
       return true;
 }
 
-static bool of_INV_wide(vthread_t thr, vvp_code_t cp)
+bool of_INV(vthread_t thr, vvp_code_t cp)
 {
       unsigned idx1 = cp->bit_idx[0];
       unsigned wid = cp->bit_idx[1];
 
-      vvp_vector4_t val = vthread_bits_to_vector(thr, idx1, wid);
-      thr->bits4.set_vec(idx1, ~val);
-
-      return true;
-}
+      assert(idx1 >= 4);
+      if (wid == 0)
+	    return true;
+      thr_check_addr(thr, idx1+wid-1);
 
-static bool of_INV_narrow(vthread_t thr, vvp_code_t cp)
-{
-      unsigned idx1 = cp->bit_idx[0];
-      unsigned wid = cp->bit_idx[1];
+	/* ~0 is 1, ~1 is 0 and ~x and ~z are both x. */
+      for (unsigned off = 0 ;  off < wid ;  off += CPU_WORD_BITS) {
+	    unsigned cnt = wid - off;
+	    if (cnt > CPU_WORD_BITS)
+		  cnt = CPU_WORD_BITS;
 
-      for (unsigned idx = 0 ; idx < wid ; idx += 1) {
-	    vvp_bit4_t lb = thr_get_bit(thr, idx1);
-	    thr_put_bit(thr, idx1, ~lb);
-	    idx1 += 1;
+	    unsigned long abits, bbits;
+	    thr->bits4.subword(idx1+off, cnt, abits, bbits);
+	    thr->bits4.setword(idx1+off, cnt, ~abits | bbits, bbits);
       }
 
       return true;
 }
 
-bool of_INV(vthread_t thr, vvp_code_t cp)
-{
-      assert(cp->bit_idx[0] >= 4);
-
-      if (cp->number <= 4)
-	    cp->opcode = &of_INV_narrow;
-      else
-	    cp->opcode = &of_INV_wide;
-
-      return cp->opcode(thr, cp);
-}
-
 
 /*
  * Index registers, arithmetic.
@@ -2724,6 +2921,7 @@ bool of_IX_GETV(vthread_t thr, vvp_code_t cp)
       unsigned index = cp->bit_idx[0];
       vvp_net_t*net = cp->net;
 
+      lazy_demand(net);
       vvp_signal_value*sig = dynamic_cast<vvp_signal_value*>(net->fil);
       if (sig == 0) {
 	    assert(net->fil);
@@ -2753,6 +2951,7 @@ bool of_IX_GETV_S(vthread_t thr, vvp_code_t cp)
       unsigned index = cp->bit_idx[0];
       vvp_net_t*net = cp->net;
 
+      lazy_demand(net);
       vvp_signal_value*sig = dynamic_cast<vvp_signal_value*>(net->fil);
       if (sig == 0) {
 	    assert(net->fil);
@@ -3104,6 +3303,7 @@ bool of_LOAD_AVX_P(vthread_t thr, vvp_code_t cp)
 static void load_base(vvp_code_t cp, vvp_vector4_t&dst)
 {
       vvp_net_t*net = cp->net;
+      lazy_demand(net);
 
 	/* For the %load to work, the functor must actually be a
 	   signal functor. Only signals save their vector value. */
@@ -3211,6 +3411,7 @@ bool of_LOAD_X1P(vthread_t thr, vvp_code_t cp)
 	// <functor> is converted to a vvp_net_t pointer from which we
 	// read our value.
       vvp_net_t*net = cp->net;
+      lazy_demand(net);
 
 	// For the %load to work, the functor must actually be a
 	// signal functor. Only signals save their vector value.
@@ -3715,74 +3916,61 @@ bool of_MULI(vthread_t thr, vvp_code_t cp)
       return true;
 }
 
-static bool of_NAND_wide(vthread_t thr, vvp_code_t cp)
+bool of_NAND(vthread_t thr, vvp_code_t cp)
 {
-      unsigned idx1 = cp->bit_idx[0];
-      unsigned idx2 = cp->bit_idx[1];
-      unsigned wid = cp->number;
-
-      vvp_vector4_t val = vthread_bits_to_vector(thr, idx1, wid);
-      val &= vthread_bits_to_vector(thr, idx2, wid);
-      thr->bits4.set_vec(idx1, ~val);
-
-      return true;
+      return of_bitwise_<bit4_nand_op>(thr, cp);
 }
 
-static bool of_NAND_narrow(vthread_t thr, vvp_code_t cp)
-{
-      unsigned idx1 = cp->bit_idx[0];
-      unsigned idx2 = cp->bit_idx[1];
-      unsigned wid = cp->number;
-
-      for (unsigned idx = 0 ; idx < wid ; idx += 1) {
-	    vvp_bit4_t lb = thr_get_bit(thr, idx1);
-	    vvp_bit4_t rb = thr_get_bit(thr, idx2);
-	    thr_put_bit(thr, idx1, ~(lb&rb));
-	    idx1 += 1;
-	    if (idx2 >= 4)
-		  idx2 += 1;
-      }
 
+bool of_NOOP(vthread_t, vvp_code_t)
+{
       return true;
 }
 
-bool of_NAND(vthread_t thr, vvp_code_t cp)
-{
-      assert(cp->bit_idx[0] >= 4);
+/*
+ * The reduction instructions scan the operand a word at a time and
+ * collect the summary of its bits here. The one, zero and xz members
+ * are the OR of the masks of the bits with those values, and par is
+ * the XOR of all the abits words.
+ */
+struct reduce_scan_s {
+      unsigned long one, zero, xz, par;
+};
 
-      if (cp->number <= 4)
-	    cp->opcode = &of_NAND_narrow;
-      else
-	    cp->opcode = &of_NAND_wide;
+static void thr_reduce_scan(vthread_t thr, unsigned addr, unsigned wid,
+			    struct reduce_scan_s&res)
+{
+      res.one = res.zero = res.xz = res.par = 0;
+      for (unsigned off = 0 ;  off < wid ;  off += CPU_WORD_BITS) {
+	    unsigned cnt = wid - off;
+	    if (cnt > CPU_WORD_BITS)
+		  cnt = CPU_WORD_BITS;
 
-      return cp->opcode(thr, cp);
+	    unsigned long abits, bbits;
+	    thr_get_word(thr, addr < 4? addr : addr+off, cnt, abits, bbits);
+	    unsigned long mask = word_mask(cnt);
+	    res.one  |= abits & ~bbits;
+	    res.zero |= ~abits & ~bbits & mask;
+	    res.xz   |= bbits;
+	    res.par  ^= abits;
+      }
 }
 
-
-bool of_NOOP(vthread_t, vvp_code_t)
+static inline bool word_parity(unsigned long val)
 {
-      return true;
+      for (unsigned sh = CPU_WORD_BITS/2 ;  sh > 0 ;  sh >>= 1)
+	    val ^= val >> sh;
+      return val & 1;
 }
 
 bool of_NORR(vthread_t thr, vvp_code_t cp)
 {
       assert(cp->bit_idx[0] >= 4);
 
-      vvp_bit4_t lb = BIT4_1;
-      unsigned idx2 = cp->bit_idx[1];
-
-      for (unsigned idx = 0 ;  idx < cp->number ;  idx += 1) {
-
-	    vvp_bit4_t rb = thr_get_bit(thr, idx2+idx);
-	    if (rb == BIT4_1) {
-		  lb = BIT4_0;
-		  break;
-	    }
-
-	    if (rb != BIT4_0)
-		  lb = BIT4_X;
-      }
+      struct reduce_scan_s res;
+      thr_reduce_scan(thr, cp->bit_idx[1], cp->number, res);
 
+      vvp_bit4_t lb = res.one? BIT4_0 : res.xz? BIT4_X : BIT4_1;
       thr_put_bit(thr, cp->bit_idx[0], lb);
 
       return true;
@@ -3792,21 +3980,10 @@ bool of_ANDR(vthread_t thr, vvp_code_t cp)
 {
       assert(cp->bit_idx[0] >= 4);
 
-      vvp_bit4_t lb = BIT4_1;
-      unsigned idx2 = cp->bit_idx[1];
-
-      for (unsigned idx = 0 ;  idx < cp->number ;  idx += 1) {
-
-	    vvp_bit4_t rb = thr_get_bit(thr, idx2+idx);
-	    if (rb == BIT4_0) {
-		  lb = BIT4_0;
-		  break;
-	    }
-
-	    if (rb != BIT4_1)
-		  lb = BIT4_X;
-      }
+      struct reduce_scan_s res;
+      thr_reduce_scan(thr, cp->bit_idx[1], cp->number, res);
 
+      vvp_bit4_t lb = res.zero? BIT4_0 : res.xz? BIT4_X : BIT4_1;
       thr_put_bit(thr, cp->bit_idx[0], lb);
 
       return true;
@@ -3816,21 +3993,10 @@ bool of_NANDR(vthread_t thr, vvp_code_t cp)
 {
       assert(cp->bit_idx[0] >= 4);
 
-      vvp_bit4_t lb = BIT4_0;
-      unsigned idx2 = cp->bit_idx[1];
-
-      for (unsigned idx = 0 ;  idx < cp->number ;  idx += 1) {
-
-	    vvp_bit4_t rb = thr_get_bit(thr, idx2+idx);
-	    if (rb == BIT4_0) {
-		  lb = BIT4_1;
-		  break;
-	    }
-
-	    if (rb != BIT4_1)
-		  lb = BIT4_X;
-      }
+      struct reduce_scan_s res;
+      thr_reduce_scan(thr, cp->bit_idx[1], cp->number, res);
 
+      vvp_bit4_t lb = res.zero? BIT4_1 : res.xz? BIT4_X : BIT4_0;
       thr_put_bit(thr, cp->bit_idx[0], lb);
 
       return true;
@@ -3840,21 +4006,10 @@ bool of_ORR(vthread_t thr, vvp_code_t cp)
 {
       assert(cp->bit_idx[0] >= 4);
 
-      vvp_bit4_t lb = BIT4_0;
-      unsigned idx2 = cp->bit_idx[1];
-
-      for (unsigned idx = 0 ;  idx < cp->number ;  idx += 1) {
-
-	    vvp_bit4_t rb = thr_get_bit(thr, idx2+idx);
-	    if (rb == BIT4_1) {
-		  lb = BIT4_1;
-		  break;
-	    }
-
-	    if (rb != BIT4_0)
-		  lb = BIT4_X;
-      }
+      struct reduce_scan_s res;
+      thr_reduce_scan(thr, cp->bit_idx[1], cp->number, res);
 
+      vvp_bit4_t lb = res.one? BIT4_1 : res.xz? BIT4_X : BIT4_0;
       thr_put_bit(thr, cp->bit_idx[0], lb);
 
       return true;
@@ -3864,20 +4019,10 @@ bool of_XORR(vthread_t thr, vvp_code_t cp)
 {
       assert(cp->bit_idx[0] >= 4);
 
-      vvp_bit4_t lb = BIT4_0;
-      unsigned idx2 = cp->bit_idx[1];
-
-      for (unsigned idx = 0 ;  idx < cp->number ;  idx += 1) {
-
-	    vvp_bit4_t rb = thr_get_bit(thr, idx2+idx);
-	    if (rb == BIT4_1)
-		  lb = ~lb;
-	    else if (rb != BIT4_0) {
-		  lb = BIT4_X;
-		  break;
-	    }
-      }
+      struct reduce_scan_s res;
+      thr_reduce_scan(thr, cp->bit_idx[1], cp->number, res);
 
+      vvp_bit4_t lb = res.xz? BIT4_X : word_parity(res.par)? BIT4_1 : BIT4_0;
       thr_put_bit(thr, cp->bit_idx[0], lb);
 
       return true;
@@ -3887,111 +4032,23 @@ bool of_XNORR(vthread_t thr, vvp_code_t cp)
 {
       assert(cp->bit_idx[0] >= 4);
 
-      vvp_bit4_t lb = BIT4_1;
-      unsigned idx2 = cp->bit_idx[1];
-
-      for (unsigned idx = 0 ;  idx < cp->number ;  idx += 1) {
-
-	    vvp_bit4_t rb = thr_get_bit(thr, idx2+idx);
-	    if (rb == BIT4_1)
-		  lb = ~lb;
-	    else if (rb != BIT4_0) {
-		  lb = BIT4_X;
-		  break;
-	    }
-      }
+      struct reduce_scan_s res;
+      thr_reduce_scan(thr, cp->bit_idx[1], cp->number, res);
 
+      vvp_bit4_t lb = res.xz? BIT4_X : word_parity(res.par)? BIT4_0 : BIT4_1;
       thr_put_bit(thr, cp->bit_idx[0], lb);
 
       return true;
 }
 
-static bool of_OR_wide(vthread_t thr, vvp_code_t cp)
-{
-      unsigned idx1 = cp->bit_idx[0];
-      unsigned idx2 = cp->bit_idx[1];
-      unsigned wid = cp->number;
-
-      vvp_vector4_t val = vthread_bits_to_vector(thr, idx1, wid);
-      val |= vthread_bits_to_vector(thr, idx2, wid);
-      thr->bits4.set_vec(idx1, val);
-
-      return true;
-}
-
-static bool of_OR_narrow(vthread_t thr, vvp_code_t cp)
-{
-      unsigned idx1 = cp->bit_idx[0];
-      unsigned idx2 = cp->bit_idx[1];
-      unsigned wid = cp->number;
-
-      for (unsigned idx = 0 ; idx < wid ; idx += 1) {
-	    vvp_bit4_t lb = thr_get_bit(thr, idx1);
-	    vvp_bit4_t rb = thr_get_bit(thr, idx2);
-	    thr_put_bit(thr, idx1, lb|rb);
-	    idx1 += 1;
-	    if (idx2 >= 4)
-		  idx2 += 1;
-      }
-
-      return true;
-}
-
 bool of_OR(vthread_t thr, vvp_code_t cp)
 {
-      assert(cp->bit_idx[0] >= 4);
-
-      if (cp->number <= 4)
-	    cp->opcode = &of_OR_narrow;
-      else
-	    cp->opcode = &of_OR_wide;
-
-      return cp->opcode(thr, cp);
-}
-
-static bool of_NOR_wide(vthread_t thr, vvp_code_t cp)
-{
-      assert(cp->bit_idx[0] >= 4);
-
-      unsigned idx1 = cp->bit_idx[0];
-      unsigned idx2 = cp->bit_idx[1];
-      unsigned wid = cp->number;
-
-      vvp_vector4_t val = vthread_bits_to_vector(thr, idx1, wid);
-      val |= vthread_bits_to_vector(thr, idx2, wid);
-      thr->bits4.set_vec(idx1, ~val);
-
-      return true;
-}
-
-static bool of_NOR_narrow(vthread_t thr, vvp_code_t cp)
-{
-      unsigned idx1 = cp->bit_idx[0];
-      unsigned idx2 = cp->bit_idx[1];
-      unsigned wid = cp->number;
-
-      for (unsigned idx = 0 ; idx < wid ; idx += 1) {
-	    vvp_bit4_t lb = thr_get_bit(thr, idx1);
-	    vvp_bit4_t rb = thr_get_bit(thr, idx2);
-	    thr_put_bit(thr, idx1, ~(lb|rb));
-	    idx1 += 1;
-	    if (idx2 >= 4)
-		  idx2 += 1;
-      }
-
-      return true;
+      return of_bitwise_<bit4_or_op>(thr, cp);
 }
 
 bool of_NOR(vthread_t thr, vvp_code_t cp)
 {
-      assert(cp->bit_idx[0] >= 4);
-
-      if (cp->number <= 4)
-	    cp->opcode = &of_NOR_narrow;
-      else
-	    cp->opcode = &of_NOR_wide;
-
-      return cp->opcode(thr, cp);
+      return of_bitwise_<bit4_nor_op>(thr, cp);
 }
 
 bool of_POW(vthread_t thr, vvp_code_t cp)
@@ -4536,63 +4593,48 @@ bool of_WAIT(vthread_t thr, vvp_code_t cp)
       return false;
 }
 
-
-bool of_XNOR(vthread_t thr, vvp_code_t cp)
+/*
+ * The %wait/p is the %wait at the top of an always block. The first
+ * time the thread executes it, the thread is put in the persistent
+ * list of the event, where it stays. After that, waiting only marks
+ * the thread, and the event wakes all the marked threads in its list
+ * together, without any per-thread list building in the %wait.
+ */
+bool of_WAIT_P(vthread_t thr, vvp_code_t cp)
 {
-      assert(cp->bit_idx[0] >= 4);
+      if (thr->pwait_net != cp->net) {
+	      /* A thread keeps only one persistent wait. */
+	    if (thr->pwait_net)
+		  return of_WAIT(thr, cp);
 
-      unsigned idx1 = cp->bit_idx[0];
-      unsigned idx2 = cp->bit_idx[1];
+	    waitable_hooks_s*ep = dynamic_cast<waitable_hooks_s*> (cp->net->fun);
+	    assert(ep);
+	    if (ep->persistent_threads == 0)
+		  persistent_hooks.push_back(ep);
+	    thr->pwait_hooks = ep;
+	    thr->pwait_net = cp->net;
+	    thr->pwait_next = ep->persistent_threads;
+	    ep->persistent_threads = thr;
+      }
 
-      for (unsigned idx = 0 ;  idx < cp->number ;  idx += 1) {
+      assert(! thr->waiting_for_event);
+      thr->waiting_for_event = 1;
+      thr->pwait_armed = 1;
 
-	    vvp_bit4_t lb = thr_get_bit(thr, idx1);
-	    vvp_bit4_t rb = thr_get_bit(thr, idx2);
-	    thr_put_bit(thr, idx1, ~(lb ^ rb));
+	/* Return false to suspend this thread. */
+      return false;
+}
 
-	    idx1 += 1;
-	    if (idx2 >= 4)
-		  idx2 += 1;
-      }
 
-      return true;
+bool of_XNOR(vthread_t thr, vvp_code_t cp)
+{
+      return of_bitwise_<bit4_xnor_op>(thr, cp);
 }
 
 
 bool of_XOR(vthread_t thr, vvp_code_t cp)
 {
-      assert(cp->bit_idx[0] >= 4);
-
-      unsigned idx1 = cp->bit_idx[0];
-      unsigned idx2 = cp->bit_idx[1];
-
-      for (unsigned idx = 0 ;  idx < cp->number ;  idx += 1) {
-
-	    vvp_bit4_t lb = thr_get_bit(thr, idx1);
-	    vvp_bit4_t rb = thr_get_bit(thr, idx2);
-
-	    if ((lb == BIT4_1) && (rb == BIT4_1)) {
-		  thr_put_bit(thr, idx1, BIT4_0);
-
-	    } else if ((lb == BIT4_0) && (rb == BIT4_0)) {
-		  thr_put_bit(thr, idx1, BIT4_0);
-
-	    } else if ((lb == BIT4_1) && (rb == BIT4_0)) {
-		  thr_put_bit(thr, idx1, BIT4_1);
-
-	    } else if ((lb == BIT4_0) && (rb == BIT4_1)) {
-		  thr_put_bit(thr, idx1, BIT4_1);
-
-	    } else {
-		  thr_put_bit(thr, idx1, BIT4_X);
-	    }
-
-	    idx1 += 1;
-	    if (idx2 >= 4)
-		  idx2 += 1;
-      }
-
-      return true;
+      return of_bitwise_<bit4_xor_op>(thr, cp);
 }
 
 
@@ -70,6 +70,21 @@ extern void vthread_run(vthread_t thr);
  */
 extern void vthread_schedule_list(vthread_t thr);
 
+/*
+ * A thread that waits with %wait/p stays in the persistent list of
+ * the event. When the event triggers, vthread_wake_persistent adds
+ * the threads in the persistent list that are actually waiting to
+ * the front of the list, and returns the new head. The caller then
+ * schedules the whole list at once as usual.
+ *
+ * The persistent lists are not part of a checkpoint, so
+ * vthread_flush_persistent moves the waiting threads into the
+ * ordinary lists and empties all the persistent lists. The threads
+ * put themselves back in the next time they execute the %wait/p.
+ */
+extern vthread_t vthread_wake_persistent(vthread_t persist, vthread_t list);
+extern void vthread_flush_persistent(void);
+
 extern struct __vpiScope*vthread_scope(vthread_t thr);
 
 /*
@@ -113,6 +128,8 @@ extern vvp_context_item_t vthread_get_rd_context_item(unsigned context_idx);
  */
 extern vvp_bit4_t vthread_get_bit(struct vthread_s*thr, unsigned addr);
 extern void vthread_put_bit(struct vthread_s*thr, unsigned addr, vvp_bit4_t bit);
+extern vvp_vector4_t vthread_get_vec4(struct vthread_s*thr,
+				      unsigned addr, unsigned wid);
 
 extern double vthread_get_real(struct vthread_s*thr, unsigned addr);
 extern void vthread_put_real(struct vthread_s*thr, unsigned addr, double val);
@@ -22,6 +22,7 @@
 # include  "vpi_priv.h"
 # include  "schedule.h"
 # include  "statistics.h"
+# include  "checkpoint.h"
 # include  <cstdio>
 # include  <cstring>
 # include  <cstdlib>
@@ -52,6 +53,9 @@ static size_t vvp_net_alloc_remaining = 0;
 // chunks allocated.
 unsigned long count_vvp_nets = 0;
 size_t size_vvp_nets = 0;
+// Keep the list of chunks so that a net can be converted to and from
+// its allocation index. Checkpoints refer to nets by that index.
+static vector<vvp_net_t*> vvp_net_chunks;
 
 void* vvp_net_t::operator new (size_t size)
 {
@@ -60,6 +64,7 @@ void* vvp_net_t::operator new (size_t size)
 	    vvp_net_alloc_table = ::new vvp_net_t[VVP_NET_CHUNK];
 	    vvp_net_alloc_remaining = VVP_NET_CHUNK;
 	    size_vvp_nets += size*VVP_NET_CHUNK;
+	    vvp_net_chunks.push_back(vvp_net_alloc_table);
 #ifdef CHECK_WITH_VALGRIND
 	    VALGRIND_MAKE_MEM_NOACCESS(vvp_net_alloc_table, size*VVP_NET_CHUNK);
 	    VALGRIND_CREATE_MEMPOOL(vvp_net_alloc_table, 0, 0);
@@ -82,6 +87,25 @@ void* vvp_net_t::operator new (size_t size)
       return return_this;
 }
 
+unsigned long vvp_net_to_index(const vvp_net_t*net)
+{
+      for (unsigned idx = 0 ; idx < vvp_net_chunks.size() ; idx += 1) {
+	    const vvp_net_t*base = vvp_net_chunks[idx];
+	    if (net >= base && net < base+VVP_NET_CHUNK) {
+		  unsigned long res = idx*VVP_NET_CHUNK + (net-base);
+		  return res < count_vvp_nets? res : ULONG_MAX;
+	    }
+      }
+      return ULONG_MAX;
+}
+
+vvp_net_t* vvp_net_from_index(unsigned long idx)
+{
+      if (idx >= count_vvp_nets)
+	    return 0;
+      return vvp_net_chunks[idx/VVP_NET_CHUNK] + idx%VVP_NET_CHUNK;
+}
+
 #ifdef CHECK_WITH_VALGRIND
 static map<vvp_net_t*, bool> vvp_net_map;
 static map<sfunc_core*, bool> sfunc_map;
@@ -240,6 +264,35 @@ vvp_net_fil_t::prop_t vvp_net_fil_t::filter_long(long&)
       return PROP;
 }
 
+bool vvp_net_fil_t::save_filter_state(vvp_checkpoint_out&) const
+{
+      return false;
+}
+
+void vvp_net_fil_t::restore_filter_state(vvp_checkpoint_in&)
+{
+}
+
+/*
+ * The force link net is created at run time, so it is not part of
+ * the checkpoint. An active force cannot be saved, but the force
+ * mask of a released (or never forced) filter can.
+ */
+void vvp_net_fil_t::save_force_state_(vvp_checkpoint_out&out) const
+{
+      if (force_link_ && ! force_link_->port[2].nil())
+	    out.refuse("a net is forced by a continuous force");
+      out.put_vec2(force_mask_);
+      out.put_bool(force_propagate_);
+}
+
+void vvp_net_fil_t::restore_force_state_(vvp_checkpoint_in&in)
+{
+      force_unlink();
+      force_mask_ = in.get_vec2();
+      force_propagate_ = in.get_bool();
+}
+
 void vvp_net_fil_t::force_mask(vvp_vector2_t mask)
 {
       if (force_mask_.size() == 0)
@@ -2898,6 +2951,20 @@ void vvp_net_fun_t::force_flag(void)
 {
 }
 
+bool vvp_net_fun_t::save_state(vvp_checkpoint_out&) const
+{
+      return false;
+}
+
+void vvp_net_fun_t::restore_state(vvp_checkpoint_in&)
+{
+}
+
+vvp_gen_event_t vvp_net_fun_t::checkpoint_event()
+{
+      return 0;
+}
+
 /* **** vvp_fun_drive methods **** */
 
 vvp_fun_drive::vvp_fun_drive(unsigned str0, unsigned str1)
@@ -2920,6 +2987,11 @@ void vvp_fun_drive::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
       port.ptr()->send_vec8(vvp_vector8_t(bit, drive0_, drive1_));
 }
 
+bool vvp_fun_drive::save_state(vvp_checkpoint_out&) const
+{
+      return true;
+}
+
 
 /* **** vvp_wide_fun_* methods **** */
 
@@ -2981,6 +3053,35 @@ void vvp_wide_fun_core::recv_real_from_inputs(unsigned)
       assert(0);
 }
 
+bool vvp_wide_fun_core::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_bool(port_values_ != 0);
+      if (port_values_) {
+	    for (unsigned idx = 0 ; idx < nports_ ; idx += 1)
+		  out.put_vec4(port_values_[idx]);
+      }
+      out.put_bool(port_rvalues_ != 0);
+      if (port_rvalues_) {
+	    for (unsigned idx = 0 ; idx < nports_ ; idx += 1)
+		  out.put_double(port_rvalues_[idx]);
+      }
+      return true;
+}
+
+void vvp_wide_fun_core::restore_state(vvp_checkpoint_in&in)
+{
+      if (in.get_bool()) {
+	    if (port_values_ == 0) port_values_ = new vvp_vector4_t [nports_];
+	    for (unsigned idx = 0 ; idx < nports_ ; idx += 1)
+		  port_values_[idx] = in.get_vec4();
+      }
+      if (in.get_bool()) {
+	    if (port_rvalues_ == 0) port_rvalues_ = new double[nports_];
+	    for (unsigned idx = 0 ; idx < nports_ ; idx += 1)
+		  port_rvalues_[idx] = in.get_double();
+      }
+}
+
 void vvp_wide_fun_core::dispatch_vec4_from_input_(unsigned port,
 						   vvp_vector4_t bit)
 {
@@ -3022,6 +3123,14 @@ void vvp_wide_fun_t::recv_real(vvp_net_ptr_t port, double bit,
       core_->dispatch_real_from_input_(pidx, bit);
 }
 
+/*
+ * The input values are kept (and saved) by the core.
+ */
+bool vvp_wide_fun_t::save_state(vvp_checkpoint_out&) const
+{
+      return true;
+}
+
 /* **** vvp_scalar_t methods **** */
 
 /*
@@ -3258,6 +3367,171 @@ vvp_vector4_t reduce4(const vvp_vector8_t&that)
       return out;
 }
 
+/* **** vvp_vector8_sliced_t methods **** */
+
+static const unsigned SLICE_WORD_BITS = 8 * sizeof(unsigned long);
+
+vvp_vector8_sliced_t::vvp_vector8_sliced_t(unsigned size__)
+: size_(size__), words_(0)
+{
+      if (size_ > 0) {
+	    words_ = new word_s[(size_+SLICE_WORD_BITS-1) / SLICE_WORD_BITS];
+	    set_hiz();
+      }
+}
+
+vvp_vector8_sliced_t::~vvp_vector8_sliced_t()
+{
+      delete[]words_;
+}
+
+vvp_vector8_sliced_t::vvp_vector8_sliced_t(const vvp_vector8_sliced_t&that)
+: size_(that.size_), words_(0)
+{
+      if (size_ > 0) {
+	    unsigned nwords = (size_+SLICE_WORD_BITS-1) / SLICE_WORD_BITS;
+	    words_ = new word_s[nwords];
+	    memcpy(words_, that.words_, nwords*sizeof(word_s));
+      }
+}
+
+vvp_vector8_sliced_t& vvp_vector8_sliced_t::operator= (const vvp_vector8_sliced_t&that)
+{
+      if (this == &that)
+	    return *this;
+
+      unsigned nwords = (that.size_+SLICE_WORD_BITS-1) / SLICE_WORD_BITS;
+      if (size_ != that.size_) {
+	    delete[]words_;
+	    words_ = nwords? new word_s[nwords] : 0;
+	    size_ = that.size_;
+      }
+      if (nwords > 0)
+	    memcpy(words_, that.words_, nwords*sizeof(word_s));
+
+      return *this;
+}
+
+void vvp_vector8_sliced_t::set_hiz()
+{
+      unsigned nwords = (size_+SLICE_WORD_BITS-1) / SLICE_WORD_BITS;
+      for (unsigned idx = 0 ;  idx < nwords ;  idx += 1) {
+	    words_[idx].abits = 0;
+	    words_[idx].bbits = -1UL;
+	    words_[idx].str[0] = 0;
+	    words_[idx].str[1] = 0;
+	    words_[idx].str[2] = 0;
+      }
+}
+
+bool vvp_vector8_sliced_t::set_vec8(const vvp_vector8_t&that)
+{
+      assert(that.size() == size_);
+
+      for (unsigned base = 0 ;  base < size_ ;  base += SLICE_WORD_BITS) {
+	    word_s tmp = { 0, 0, { 0, 0, 0 } };
+	    unsigned cnt = size_ - base;
+	    if (cnt > SLICE_WORD_BITS)
+		  cnt = SLICE_WORD_BITS;
+
+	    for (unsigned idx = 0 ;  idx < cnt ;  idx += 1) {
+		  unsigned char raw = that.value(base+idx).raw();
+		  if (! is_sliced(raw))
+			return false;
+
+		  unsigned long mask = 1UL << idx;
+		  if (raw == 0) {
+			tmp.bbits |= mask;
+			continue;
+		  }
+		  if (raw & 0x80)
+			tmp.abits |= mask;
+		  if ((raw & 0x88) == 0x80)
+			tmp.bbits |= mask;
+		  if (raw & 0x01)
+			tmp.str[0] |= mask;
+		  if (raw & 0x02)
+			tmp.str[1] |= mask;
+		  if (raw & 0x04)
+			tmp.str[2] |= mask;
+	    }
+
+	    words_[base / SLICE_WORD_BITS] = tmp;
+      }
+
+      return true;
+}
+
+/*
+ * Resolve the values a word at a time. The strength planes are
+ * compared as 3-bit numbers to find the bits where a is stronger and
+ * where b is stronger. HiZ bits have strength 0, so the other value
+ * always wins over them, and two HiZ bits resolve to HiZ. Where the
+ * strengths are equal, the values either match or make an x.
+ */
+void vvp_vector8_sliced_t::resolve(const vvp_vector8_sliced_t&a,
+				   const vvp_vector8_sliced_t&b)
+{
+      assert(a.size_ == size_ && b.size_ == size_);
+
+      unsigned nwords = (size_+SLICE_WORD_BITS-1) / SLICE_WORD_BITS;
+      for (unsigned idx = 0 ;  idx < nwords ;  idx += 1) {
+	    const word_s&aw = a.words_[idx];
+	    const word_s&bw = b.words_[idx];
+
+	    unsigned long eq2 = ~(aw.str[2] ^ bw.str[2]);
+	    unsigned long eq1 = ~(aw.str[1] ^ bw.str[1]);
+	    unsigned long a_gt = (aw.str[2] & ~bw.str[2])
+		  | (eq2 & aw.str[1] & ~bw.str[1])
+		  | (eq2 & eq1 & aw.str[0] & ~bw.str[0]);
+	    unsigned long b_gt = (bw.str[2] & ~aw.str[2])
+		  | (eq2 & bw.str[1] & ~aw.str[1])
+		  | (eq2 & eq1 & bw.str[0] & ~aw.str[0]);
+
+	    unsigned long use_b = b_gt;
+	    unsigned long use_a = ~b_gt;
+	    unsigned long conflict = ~(a_gt | b_gt)
+		  & ((aw.abits ^ bw.abits) | (aw.bbits ^ bw.bbits));
+
+	    word_s&res = words_[idx];
+	    res.abits = (aw.abits & use_a) | (bw.abits & use_b) | conflict;
+	    res.bbits = (aw.bbits & use_a) | (bw.bbits & use_b) | conflict;
+	    res.str[0] = (aw.str[0] & use_a) | (bw.str[0] & use_b);
+	    res.str[1] = (aw.str[1] & use_a) | (bw.str[1] & use_b);
+	    res.str[2] = (aw.str[2] & use_a) | (bw.str[2] & use_b);
+      }
+}
+
+vvp_vector8_t vvp_vector8_sliced_t::vector8(vvp_scalar_t hiz) const
+{
+      vvp_vector8_t out (size_);
+
+      for (unsigned base = 0 ;  base < size_ ;  base += SLICE_WORD_BITS) {
+	    const word_s&cur = words_[base / SLICE_WORD_BITS];
+	    unsigned cnt = size_ - base;
+	    if (cnt > SLICE_WORD_BITS)
+		  cnt = SLICE_WORD_BITS;
+
+	    for (unsigned idx = 0 ;  idx < cnt ;  idx += 1) {
+		  unsigned str = ((cur.str[0] >> idx) & 1)
+			| (((cur.str[1] >> idx) & 1) << 1)
+			| (((cur.str[2] >> idx) & 1) << 2);
+		  if (str == 0) {
+			if (! hiz.is_hiz())
+			      out.set_bit(base+idx, hiz);
+			continue;
+		  }
+
+		  unsigned char raw = str | (str << 4);
+		  if ((cur.abits >> idx) & 1)
+			raw |= ((cur.bbits >> idx) & 1)? 0x80 : 0x88;
+		  out.set_bit(base+idx, vvp_scalar_t(raw));
+	    }
+      }
+
+      return out;
+}
+
 vvp_bit4_t compare_gtge(const vvp_vector4_t&lef, const vvp_vector4_t&rig,
 			vvp_bit4_t out_if_equal)
 {
@@ -59,6 +59,11 @@ class  vvp_fun_part;
 
 class  vvp_delay_t;
 
+/* Checkpoint (save/restart) support. */
+class  vvp_checkpoint_out;
+class  vvp_checkpoint_in;
+typedef struct vvp_gen_event_s *vvp_gen_event_t;
+
 /*
  * Storage for items declared in automatically allocated scopes (i.e. automatic
  * tasks and functions). The first two slots in each context are reserved for
@@ -233,6 +238,18 @@ class vvp_vector4_t {
 	// in the array.
       unsigned long*subarray(unsigned idx, unsigned size) const;
       void setarray(unsigned idx, unsigned size, const unsigned long*val);
+	// Get the abits and bbits of the wid bits starting at adr,
+	// in the low bits of the words. The wid may be no more than
+	// the number of bits in a long, and the bits must be within
+	// the vector. This is for code that converts whole words of
+	// the vector at a time.
+      void subword(unsigned adr, unsigned wid,
+		   unsigned long&abits, unsigned long&bbits) const;
+	// Set the wid bits starting at adr from the low bits of the
+	// abits and bbits words. This is the reverse of subword, but
+	// the bits must be within the vector.
+      void setword(unsigned adr, unsigned wid,
+		   unsigned long abits, unsigned long bbits);
 
       void set_bit(unsigned idx, vvp_bit4_t val);
       void set_vec(unsigned idx, const vvp_vector4_t&that);
@@ -372,6 +389,72 @@ inline vvp_vector4_t& vvp_vector4_t::operator= (const vvp_vector4_t&that)
 }
 
 
+inline void vvp_vector4_t::subword(unsigned adr, unsigned wid,
+				   unsigned long&abits,
+				   unsigned long&bbits) const
+{
+      assert(wid > 0 && wid <= BITS_PER_WORD);
+      assert(adr+wid <= size_);
+
+      if (size_ <= BITS_PER_WORD) {
+	    abits = abits_val_ >> adr;
+	    bbits = bbits_val_ >> adr;
+      } else {
+	    unsigned wdx = adr / BITS_PER_WORD;
+	    unsigned off = adr % BITS_PER_WORD;
+	    abits = abits_ptr_[wdx] >> off;
+	    bbits = bbits_ptr_[wdx] >> off;
+	      /* The bits may continue in the next word. */
+	    if (off > 0 && off+wid > BITS_PER_WORD) {
+		  abits |= abits_ptr_[wdx+1] << (BITS_PER_WORD-off);
+		  bbits |= bbits_ptr_[wdx+1] << (BITS_PER_WORD-off);
+	    }
+      }
+
+	/* Clear the bits past wid. */
+      if (wid < BITS_PER_WORD) {
+	    unsigned long mask = (1UL << wid) - 1;
+	    abits &= mask;
+	    bbits &= mask;
+      }
+}
+
+inline void vvp_vector4_t::setword(unsigned adr, unsigned wid,
+				   unsigned long abits,
+				   unsigned long bbits)
+{
+      assert(wid > 0 && wid <= BITS_PER_WORD);
+      assert(adr+wid <= size_);
+
+      unsigned long mask = -1UL;
+      if (wid < BITS_PER_WORD) {
+	    mask = (1UL << wid) - 1;
+	    abits &= mask;
+	    bbits &= mask;
+      }
+
+      if (size_ <= BITS_PER_WORD) {
+	    abits_val_ = (abits_val_ & ~(mask << adr)) | (abits << adr);
+	    bbits_val_ = (bbits_val_ & ~(mask << adr)) | (bbits << adr);
+	    return;
+      }
+
+      unsigned wdx = adr / BITS_PER_WORD;
+      unsigned off = adr % BITS_PER_WORD;
+      abits_ptr_[wdx] = (abits_ptr_[wdx] & ~(mask << off)) | (abits << off);
+      bbits_ptr_[wdx] = (bbits_ptr_[wdx] & ~(mask << off)) | (bbits << off);
+
+	/* The bits may continue in the next word. */
+      if (off > 0 && off+wid > BITS_PER_WORD) {
+	    unsigned shift = BITS_PER_WORD - off;
+	    wdx += 1;
+	    abits_ptr_[wdx] = (abits_ptr_[wdx] & ~(mask >> shift))
+		  | (abits >> shift);
+	    bbits_ptr_[wdx] = (bbits_ptr_[wdx] & ~(mask >> shift))
+		  | (bbits >> shift);
+      }
+}
+
 inline vvp_bit4_t vvp_vector4_t::value(unsigned idx) const
 {
       if (idx >= size_)
@@ -763,8 +846,12 @@ class vvp_scalar_t {
     private:
 	// This class and the vvp_vector8_t class are closely related,
 	// so allow vvp_vector8_t access to the raw encoding so that
-	// it can do compact vectoring of vvp_scalar_t objects.
+	// it can do compact vectoring of vvp_scalar_t objects. The
+	// checkpoint code also saves and restores the raw encoding.
       friend class vvp_vector8_t;
+      friend class vvp_vector8_sliced_t;
+      friend class vvp_checkpoint_out;
+      friend class vvp_checkpoint_in;
       explicit vvp_scalar_t(unsigned char val) : value_(val) { }
       unsigned char raw() const { return value_; }
 
@@ -905,6 +992,70 @@ inline vvp_vector8_t resolve(const vvp_vector8_t&a, const vvp_vector8_t&b)
       return out;
 }
 
+/*
+ * This is a bit-sliced form of a vvp_vector8_t, for resolving many
+ * drivers a word at a time. Each word of bits is held as the abits and
+ * bbits of its vvp_vector4_t value (with HiZ bits as z) and three
+ * planes with the bits of its strength (with HiZ bits strength 0).
+ *
+ * Only unambiguous values, and x values with the same strength at
+ * both ends, have this form. These are the values that gates and
+ * continuous assignments drive, and the resolution of these values is
+ * simple: The stronger value wins, and equally strong but different
+ * values make an x of that strength. This makes the resolution of
+ * many drivers independent of the order that they are combined.
+ */
+class vvp_vector8_sliced_t {
+
+    public:
+      explicit vvp_vector8_sliced_t(unsigned size =0);
+      ~vvp_vector8_sliced_t();
+
+      vvp_vector8_sliced_t(const vvp_vector8_sliced_t&that);
+      vvp_vector8_sliced_t& operator= (const vvp_vector8_sliced_t&that);
+
+      unsigned size() const { return size_; }
+
+	// Set all the bits to HiZ.
+      void set_hiz();
+
+	// Set the value from a vvp_vector8_t of the same size. If any
+	// bit of the value does not have the sliced form, then return
+	// false and leave the value undefined.
+      bool set_vec8(const vvp_vector8_t&that);
+
+	// Set this value to the resolution of a and b.
+      void resolve(const vvp_vector8_sliced_t&a, const vvp_vector8_sliced_t&b);
+
+	// Make the vvp_vector8_t of this value, replacing HiZ bits
+	// with the hiz value.
+      vvp_vector8_t vector8(vvp_scalar_t hiz) const;
+
+	// Return true if this raw vvp_scalar_t encoding has the sliced
+	// form.
+      static bool is_sliced(unsigned char raw);
+
+    private:
+      struct word_s {
+	    unsigned long abits, bbits;
+	    unsigned long str[3];
+      };
+
+      unsigned size_;
+      word_s*words_;
+};
+
+inline bool vvp_vector8_sliced_t::is_sliced(unsigned char raw)
+{
+      if (raw == 0)
+	    return true;
+	// The strengths of the two ends must be the same, and not 0.
+      if ((raw & 0x07) == 0 || (raw & 0x07) != ((raw >> 4) & 0x07))
+	    return false;
+	// The value is 0 (0x00), 1 (0x88) or x (0x80).
+      return (raw & 0x88) != 0x08;
+}
+
   /* This function implements the strength reduction implied by
      Verilog standard resistive devices. */
 extern vvp_vector8_t resistive_reduction(const vvp_vector8_t&a);
@@ -1074,6 +1225,9 @@ class vvp_net_t {
       void link(vvp_net_ptr_t port);
 	// Disconnect the port from the output of this net.
       void unlink(vvp_net_ptr_t port);
+	// The head of the fan-out list. The loader uses this to look
+	// at the netlist once it is linked.
+      vvp_net_ptr_t fanout() const { return out_; }
 
     public: // Methods to propagate output from this node.
       void send_vec4(const vvp_vector4_t&val, vvp_context_t context);
@@ -1170,6 +1324,19 @@ class vvp_net_fun_t {
 	// do something about it.
       virtual void force_flag(void);
 
+    public: // Checkpoint support.
+	// Write the run time state of the functor to the checkpoint
+	// and return true. A functor that cannot be saved returns
+	// false. The restore_state method reads back exactly what
+	// save_state wrote.
+      virtual bool save_state(vvp_checkpoint_out&out) const;
+      virtual void restore_state(vvp_checkpoint_in&in);
+	// A functor that schedules itself as a generic event returns
+	// that event object here, so that a restarted simulation can
+	// put pending events back into the event queue, and so that
+	// the cycle based engine (cycle.h) can order the gates.
+      virtual vvp_gen_event_t checkpoint_event();
+
     public: // These objects are only permallocated.
       static void* operator new(std::size_t size) { return heap_.alloc(size); }
       static void operator delete(void*); // not implemented
@@ -1242,6 +1409,12 @@ class vvp_net_fil_t  : public vvp_vpi_callback {
       virtual void force_fil_vec8(const vvp_vector8_t&val, vvp_vector2_t mask) =0;
       virtual void force_fil_real(double val, vvp_vector2_t mask) =0;
 
+    public: // Checkpoint support, see vvp_net_fun_t. These have
+	// different names from the functor methods because some
+	// objects are both the functor and the filter of a net.
+      virtual bool save_filter_state(vvp_checkpoint_out&out) const;
+      virtual void restore_filter_state(vvp_checkpoint_in&in);
+
     public: // These objects are only permallocated.
       static void* operator new(std::size_t size) { return heap_.alloc(size); }
       static void operator delete(void*); // not implemented
@@ -1284,6 +1457,11 @@ class vvp_net_fil_t  : public vvp_vpi_callback {
 	// arbitrary values against the force mask.
       template <class T> prop_t filter_input_mask_(const T&val, const T&force, T&rep) const;
 
+	// Derived classes call these from their save_state and
+	// restore_state methods to save the force mask and link.
+      void save_force_state_(vvp_checkpoint_out&out) const;
+      void restore_force_state_(vvp_checkpoint_in&in);
+
     private:
 	// Mask of forced bits
       vvp_vector2_t force_mask_;
@@ -1320,8 +1498,16 @@ class vvp_fun_concat  : public vvp_net_fun_t {
       void recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 			unsigned base, unsigned wid, unsigned vwid,
                         vvp_context_t);
+
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
+      unsigned input_width(unsigned port) const { return wid_[port]; }
+
     private:
       unsigned wid_[4];
+	// The offset of each input in the result.
+      unsigned off_[4];
       vvp_vector4_t val_;
 };
 
@@ -1344,6 +1530,8 @@ class vvp_fun_force : public vvp_net_fun_t {
       void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 		     vvp_context_t context);
       void recv_real(vvp_net_ptr_t port, double bit, vvp_context_t);
+
+      bool save_state(vvp_checkpoint_out&out) const;
 };
 
 /* vvp_fun_repeat
@@ -1361,6 +1549,11 @@ class vvp_fun_repeat  : public vvp_net_fun_t {
       void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                      vvp_context_t context);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+
+      unsigned width() const { return wid_; }
+      unsigned repeat() const { return rep_; }
+
     private:
       unsigned wid_;
       unsigned rep_;
@@ -1387,6 +1580,8 @@ class vvp_fun_drive  : public vvp_net_fun_t {
                      vvp_context_t context);
 	//void recv_long(vvp_net_ptr_t port, long bit);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+
     private:
       unsigned char drive0_;
       unsigned char drive1_;
@@ -1407,6 +1602,8 @@ class vvp_fun_extend_signed  : public vvp_net_fun_t {
       void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                      vvp_context_t context);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+
     private:
       unsigned width_;
 };
@@ -1444,6 +1641,11 @@ class vvp_wide_fun_core : public vvp_net_fun_t {
       void* operator new(std::size_t size) { return ::new char[size]; }
       void operator delete(void* ptr) { ::delete[]((char*)ptr); }
 
+	// Derived classes that have state of their own should save
+	// it in addition to the input values saved here.
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
     protected:
       void propagate_vec4(const vvp_vector4_t&bit, vvp_time64_t delay =0);
       void propagate_real(double bit, vvp_time64_t delay =0);
@@ -1488,6 +1690,8 @@ class vvp_wide_fun_t : public vvp_net_fun_t {
       void recv_real(vvp_net_ptr_t port, double bit,
                      vvp_context_t context);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+
     private:
       vvp_wide_fun_core*core_;
       unsigned port_base_;
@@ -22,6 +22,7 @@
 # include  "vvp_net_sig.h"
 # include  "statistics.h"
 # include  "vpi_priv.h"
+# include  "checkpoint.h"
 # include  <cassert>
 #ifdef CHECK_WITH_VALGRIND
 # include  <valgrind/memcheck.h>
@@ -131,6 +132,33 @@ vvp_fun_signal_base::vvp_fun_signal_base()
       count_functors_sig += 1;
 }
 
+/*
+ * A %cassign/link is a link from the source net into port-1 of this
+ * node. The link is saved with the signal and made again on restore.
+ */
+bool vvp_fun_signal_base::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_net(cassign_link);
+      out.put_bool(continuous_assign_active_);
+      out.put_vec2(assign_mask_);
+      out.put_bool(needs_init_);
+      return true;
+}
+
+void vvp_fun_signal_base::restore_state(vvp_checkpoint_in&in)
+{
+      vvp_net_t*src = in.get_net();
+      if (cassign_link != src) {
+	    vvp_net_ptr_t dst (in.net(), 1);
+	    if (cassign_link) cassign_link->unlink(dst);
+	    if (src) src->link(dst);
+	    cassign_link = src;
+      }
+      continuous_assign_active_ = in.get_bool();
+      assign_mask_ = in.get_vec2();
+      needs_init_ = in.get_bool();
+}
+
 vvp_fun_signal4_sa::vvp_fun_signal4_sa(unsigned wid, vvp_bit4_t init)
 : bits4_(wid, init)
 {
@@ -286,6 +314,11 @@ unsigned automatic_signal_base::filter_size() const
       assert(0);
       return(0);
 }
+
+bool automatic_signal_base::save_filter_state(vvp_checkpoint_out&) const
+{
+      return true;
+}
 void automatic_signal_base::force_fil_vec4(const vvp_vector4_t&, vvp_vector2_t)
 {
       assert(0);
@@ -308,6 +341,19 @@ const vvp_vector4_t& vvp_fun_signal4_sa::vec4_unfiltered_value() const
       return bits4_;
 }
 
+bool vvp_fun_signal4_sa::save_state(vvp_checkpoint_out&out) const
+{
+      vvp_fun_signal_base::save_state(out);
+      out.put_vec4(bits4_);
+      return true;
+}
+
+void vvp_fun_signal4_sa::restore_state(vvp_checkpoint_in&in)
+{
+      vvp_fun_signal_base::restore_state(in);
+      bits4_ = in.get_vec4();
+}
+
 vvp_fun_signal4_aa::vvp_fun_signal4_aa(unsigned wid, vvp_bit4_t init)
 {
 	/* To make init work we would need to save it and then use the
@@ -445,6 +491,19 @@ double vvp_fun_signal_real_sa::real_unfiltered_value() const
       return bits_;
 }
 
+bool vvp_fun_signal_real_sa::save_state(vvp_checkpoint_out&out) const
+{
+      vvp_fun_signal_base::save_state(out);
+      out.put_double(bits_);
+      return true;
+}
+
+void vvp_fun_signal_real_sa::restore_state(vvp_checkpoint_in&in)
+{
+      vvp_fun_signal_base::restore_state(in);
+      bits_ = in.get_double();
+}
+
 void vvp_fun_signal_real_sa::recv_real(vvp_net_ptr_t ptr, double bit,
                                        vvp_context_t)
 {
@@ -576,6 +635,11 @@ vvp_fun_force::~vvp_fun_force()
 {
 }
 
+bool vvp_fun_force::save_state(vvp_checkpoint_out&) const
+{
+      return true;
+}
+
 void vvp_fun_force::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 			      vvp_context_t)
 {
@@ -664,6 +728,23 @@ unsigned vvp_wire_vec4::filter_size() const
       return bits4_.size();
 }
 
+bool vvp_wire_vec4::save_filter_state(vvp_checkpoint_out&out) const
+{
+      save_force_state_(out);
+      out.put_bool(needs_init_);
+      out.put_vec4(bits4_);
+      out.put_vec4(force4_);
+      return true;
+}
+
+void vvp_wire_vec4::restore_filter_state(vvp_checkpoint_in&in)
+{
+      restore_force_state_(in);
+      needs_init_ = in.get_bool();
+      bits4_ = in.get_vec4();
+      force4_ = in.get_vec4();
+}
+
 void vvp_wire_vec4::force_fil_vec4(const vvp_vector4_t&val, vvp_vector2_t mask)
 {
       force_mask(mask);
@@ -822,6 +903,23 @@ unsigned vvp_wire_vec8::filter_size() const
       return bits8_.size();
 }
 
+bool vvp_wire_vec8::save_filter_state(vvp_checkpoint_out&out) const
+{
+      save_force_state_(out);
+      out.put_bool(needs_init_);
+      out.put_vec8(bits8_);
+      out.put_vec8(force8_);
+      return true;
+}
+
+void vvp_wire_vec8::restore_filter_state(vvp_checkpoint_in&in)
+{
+      restore_force_state_(in);
+      needs_init_ = in.get_bool();
+      bits8_ = in.get_vec8();
+      force8_ = in.get_vec8();
+}
+
 void vvp_wire_vec8::force_fil_vec4(const vvp_vector4_t&val, vvp_vector2_t mask)
 {
       force_fil_vec8(vvp_vector8_t(val,6,6), mask);
@@ -944,6 +1042,21 @@ unsigned vvp_wire_real::filter_size() const
       return 0;
 }
 
+bool vvp_wire_real::save_filter_state(vvp_checkpoint_out&out) const
+{
+      save_force_state_(out);
+      out.put_double(bit_);
+      out.put_double(force_);
+      return true;
+}
+
+void vvp_wire_real::restore_filter_state(vvp_checkpoint_in&in)
+{
+      restore_force_state_(in);
+      bit_ = in.get_double();
+      force_ = in.get_double();
+}
+
 void vvp_wire_real::force_fil_vec4(const vvp_vector4_t&, vvp_vector2_t)
 {
       assert(0);
@@ -73,6 +73,9 @@ class vvp_fun_signal_base : public vvp_net_fun_t {
       void deassign();
       void deassign_pv(unsigned base, unsigned wid);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
     public:
 
 	/* The %cassign/link instruction needs a place to write the
@@ -127,6 +130,10 @@ class automatic_signal_base : public vvp_signal_value, public vvp_net_fil_t {
       virtual void force_fil_vec8(const vvp_vector8_t&val, vvp_vector2_t mask);
       virtual void force_fil_real(double val, vvp_vector2_t mask);
       virtual void get_value(struct t_vpi_value*value);
+
+	// The values are in the automatic contexts, which are not
+	// saved, so there is no filter state.
+      bool save_filter_state(vvp_checkpoint_out&out) const;
 };
 
 /*
@@ -151,6 +158,9 @@ class vvp_fun_signal4_sa : public vvp_fun_signal_vec {
 	// Get information about the vector value.
       const vvp_vector4_t& vec4_unfiltered_value() const;
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
     private:
       vvp_vector4_t bits4_;
 };
@@ -219,6 +229,9 @@ class vvp_fun_signal_real_sa : public vvp_fun_signal_real {
 	// Get information about the vector value.
       double real_unfiltered_value() const;
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_checkpoint_in&in);
+
     private:
       double bits_;
 };
@@ -304,6 +317,10 @@ class vvp_wire_vec4 : public vvp_wire_base {
       vvp_scalar_t scalar_value(unsigned idx) const;
       void vec4_value(vvp_vector4_t&) const;
 
+
+      bool save_filter_state(vvp_checkpoint_out&out) const;
+      void restore_filter_state(vvp_checkpoint_in&in);
+
     private:
       vvp_bit4_t filtered_value_(unsigned idx) const;
 
@@ -347,6 +364,10 @@ class vvp_wire_vec8 : public vvp_wire_base {
 	// This is new to vvp_wire_vec8
       vvp_vector8_t vec8_value() const;
 
+
+      bool save_filter_state(vvp_checkpoint_out&out) const;
+      void restore_filter_state(vvp_checkpoint_in&in);
+
     private:
       vvp_scalar_t filtered_value_(unsigned idx) const;
 
@@ -383,6 +404,10 @@ class vvp_wire_real : public vvp_wire_base {
 
       void get_signal_value(struct t_vpi_value*vp);
 
+
+      bool save_filter_state(vvp_checkpoint_out&out) const;
+      void restore_filter_state(vvp_checkpoint_in&in);
+
     private:
       double bit_;
       double force_;
@@ -39,6 +39,9 @@ class vvp_vpi_callback {
       void attach_as_word(class __vpiArray* arr, unsigned long addr);
 
       void add_vpi_callback(struct __vpiCallback*);
+	// True if callbacks are attached, or if this is the word of an
+	// array that has callbacks or ports of its own.
+      bool has_vpi_callbacks() const;
 #ifdef CHECK_WITH_VALGRIND
 	/* This has only been tested at EOS. */
       void clear_all_callbacks(void);